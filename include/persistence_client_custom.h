@@ -336,6 +336,90 @@ typedef struct _plugin_info_s
  */
 int plugin_get_info(plugin_info_s* pInfo_out);
 
+/**
+ * @brief item of a vectored data access
+ */
+typedef struct _plugin_item_s
+{
+    const char* path ;           /*!< The path to the resource */
+    char*       buffer ;         /*!< The buffer to read to or the data to write */
+    int         size ;           /*!< The size of the buffer or of the data to write */
+    int         result ;         /*!< Output: like the return value of ::plugin_get_data or ::plugin_set_data */
+}plugin_item_s ;
+
+/**
+ * @brief get the data of several resources with one call (optional)
+ *
+ * @param items the resources to read, the result of each resource is stored in the item
+ * @param count the number of items
+ *
+ * @return positive value or 0 if the items have been processed; negative value: error code (\ref PCCL_RETURNS),
+ *         the results of the items are not valid then
+ *
+ * @note
+ *       - This function is optional, ::plugin_get_data is used for every item if it is not available
+ */
+int plugin_get_data_multi(plugin_item_s* items, int count);
+
+/**
+ * @brief set the data of several resources with one call (optional)
+ *
+ * @param items the resources to write, the result of each resource is stored in the item
+ * @param count the number of items
+ *
+ * @return positive value or 0 if the items have been processed; negative value: error code (\ref PCCL_RETURNS),
+ *         the results of the items are not valid then
+ *
+ * @note
+ *       - This function is optional, ::plugin_set_data is used for every item if it is not available
+ */
+int plugin_set_data_multi(plugin_item_s* items, int count);
+
+/**
+ * @brief typdef of the completion callback of \ref plugin_get_data_async and \ref plugin_set_data_async
+ *
+ * @param result the result of the request, see \ref plugin_get_data and \ref plugin_set_data
+ * @param user_data the user data passed with the request
+ */
+typedef void (*plugin_callback_io_t) (int result, void* user_data);
+
+/**
+ * @brief get data without blocking the caller (optional)
+ *
+ * @param path the path to the resource to get
+ * @param buffer the buffer to store the data, stays valid until the callback has been called
+ * @param size the size of the buffer
+ * @param pfDoneCB the callback to be called when the request is complete
+ * @param user_data passed to the callback
+ *
+ * @return 0 if the request has been accepted, the callback is called exactly once then;
+ *         negative value: error code (\ref PCCL_RETURNS), the callback will not be called
+ *
+ * @note
+ *       - This function is optional, \ref plugin_get_data is used if it is not available
+ *       - The callback may be called from any thread, even before this function returns
+ *       - The library never issues a request for a path before the previous request for this path has completed
+ */
+int plugin_get_data_async(const char* path, char* buffer, int size, plugin_callback_io_t pfDoneCB, void* user_data);
+
+/**
+ * @brief set data without blocking the caller (optional)
+ *
+ * @param path the path to the resource to set
+ * @param buffer the data to write, stays valid until the callback has been called
+ * @param size the number of bytes to write
+ * @param pfDoneCB the callback to be called when the request is complete
+ * @param user_data passed to the callback
+ *
+ * @return 0 if the request has been accepted, the callback is called exactly once then;
+ *         negative value: error code (\ref PCCL_RETURNS), the callback will not be called
+ *
+ * @note
+ *       - This function is optional, \ref plugin_set_data is used if it is not available
+ *       - See \ref plugin_get_data_async
+ */
+int plugin_set_data_async(const char* path, char* buffer, int size, plugin_callback_io_t pfDoneCB, void* user_data);
+
 /** \} */
 /** \} */
 
@@ -151,6 +151,119 @@ extern "C" {
 /** \} */
 
 
+/** \defgroup INIT_FLAGS init flag definitions
+ * The flags can be combined (bitwise or) with the shutdown mode parameter of ::pclInitLibrary
+ * \{
+ */
+
+/**
+ * @brief open the resource configuration table and the databases of the application
+ *        in the background, after ::pclInitLibrary has returned.
+ *        The first data access does not need to open them anymore.
+ *        Use ::pclWaitInitReady to wait until all of them have been opened.
+ */
+#define PCL_INIT_PREOPEN         0x0100
+
+/**
+ * @brief skip writes of local key values which are identical to the value written last by the application,
+ *        the database will not be touched. Writes of shared keys are never skipped, other applications
+ *        may have changed them. Values are compared by size and crc32, see ::pclKeyGetWriteElisionStats.
+ */
+#define PCL_INIT_WRITE_ELISION   0x0200
+
+/**
+ * @brief read shared public and group keys from a cache in shared memory.
+ *        The cache is kept up to date by the writing application, so reading a cached
+ *        value does not need a system call. Values bigger than 256 bytes are not cached.
+ *        The cache is writable by the user of the first writing application only, all
+ *        applications writing a shared database must run with the same user.
+ *        Change notifications are still sent and received as before.
+ */
+#define PCL_INIT_SHARED_CACHE    0x0400
+
+/**
+ * @brief load the custom plugins configured to be loaded on demand ("od") in the background,
+ *        after ::pclInitLibrary has returned.
+ *        The first access to data of such a plugin does not need to load it anymore.
+ *        Use ::pclWaitInitReady to wait until all of them have been loaded.
+ */
+#define PCL_INIT_PRELOAD_PLUGINS 0x0800
+
+/**
+ * @brief set up the dbus mainloop, register to the administration service and the lifecycle
+ *        and load the custom plugins in the background.
+ *        The default database plugin is loaded by ::pclInitLibrary, so it returns
+ *        as soon as the local databases can be accessed.
+ *        Access to data of custom plugins waits until the plugins have been loaded.
+ *        Errors of the background initialization are returned by ::pclWaitInitReady,
+ *        further data access is not possible in this case.
+ */
+#define PCL_INIT_ASYNC           0x1000
+
+/**
+ * @brief write a snapshot of the resolved state at a full shutdown and use it at the next start:
+ *        the resource configuration table indexes, the values of the first local keys read
+ *        in the lifecycle and the parsed backup blacklist.
+ *        The snapshot is only used if the databases, the resource configuration tables and the
+ *        blacklist have not been changed since it has been written, the first reads of these
+ *        keys don't need to open a database in this case.
+ */
+#define PCL_INIT_WARM_START      0x2000
+/** \} */
+
+
+/** \defgroup FLUSH_PRIO flush priority definitions
+ * Order of the write back when the data is flushed at shutdown or on request of the
+ * administration service, see ::pclSetFlushPriority
+ * \{
+ */
+#define PCL_FLUSH_PRIO_CRITICAL  0     /// flushed first, e.g. odometer or last position
+#define PCL_FLUSH_PRIO_HIGH      1     /// flushed before data with normal priority
+#define PCL_FLUSH_PRIO_NORMAL    2     /// default priority
+#define PCL_FLUSH_PRIO_LOW       3     /// best effort, flushed last, e.g. caches
+#define PCL_FLUSH_PRIO_LAST      4     /// number of priorities
+/** \} */
+
+
+/** number of buckets of the latency histogram of the plugin statistics */
+#define PCL_PLUGIN_LATENCY_BUCKETS  24
+
+/**
+* operations of a custom plugin, see ::pclGetPluginStats
+*/
+typedef enum _pclPluginOp_e
+{
+   PCL_PLUGIN_OP_INIT = 0,                   /// plugin_init or plugin_init_async
+   PCL_PLUGIN_OP_DEINIT,                     /// plugin_deinit
+   PCL_PLUGIN_OP_GET,                        /// plugin_get_data and plugin_get_data_multi
+   PCL_PLUGIN_OP_SET,                        /// plugin_set_data and plugin_set_data_multi
+   PCL_PLUGIN_OP_GET_SIZE,                   /// plugin_get_size
+   PCL_PLUGIN_OP_DELETE,                     /// plugin_delete_data
+   PCL_PLUGIN_OP_LAST                        /// number of operations
+} pclPluginOp_e;
+
+/**
+* statistics of the calls of one operation of a custom plugin
+*/
+typedef struct _pclPluginOpStats_s
+{
+   unsigned int calls;                       /// number of calls
+   unsigned int errors;                      /// number of calls returning an error
+   unsigned long long total_us;              /// sum of the latencies [us]
+   unsigned int max_us;                      /// max latency [us]
+   unsigned int histogram[PCL_PLUGIN_LATENCY_BUCKETS];   /// bucket 0: calls faster than 1us, bucket i: faster than 2^i us, last bucket: all slower calls
+} pclPluginOpStats_s;
+
+/**
+* statistics of a custom plugin
+*/
+typedef struct _pclPluginStats_s
+{
+   const char* name;                         /// library name of the plugin
+   pclPluginOpStats_s op[PCL_PLUGIN_OP_LAST];   /// statistics of the operations, see ::pclPluginOp_e
+} pclPluginStats_s;
+
+
 /** \defgroup PCL_USERDEF specific defines for user parameters 
  * The valid user value range:
  *  - 0: NODE data access
@@ -215,7 +328,8 @@ extern "C" {
  *        It is not allowed call this function within a process using different appnames!
  *
  * @param appname application name, the name must be a unique name in the system
- * @param shutdownMode shutdown mode ::PCL_SHUTDOWN_TYPE_FAST or ::PCL_SHUTDOWN_TYPE_NORMAL ::PCL_SHUTDOWN_TYPE_NONE
+ * @param shutdownMode shutdown mode ::PCL_SHUTDOWN_TYPE_FAST or ::PCL_SHUTDOWN_TYPE_NORMAL ::PCL_SHUTDOWN_TYPE_NONE,
+ *        optionally combined with the init flags, e.g. ::PCL_INIT_PREOPEN
  *
  * @return positive value: success;
  *   On error a negative value will be returned with the following error codes:
@@ -271,6 +385,67 @@ int pclDeinitLibrary(void);
 int pclLifecycleSet(int shutdown);
 
 
+
+/**
+ * @brief wait until the background initialization requested with ::PCL_INIT_ASYNC, ::PCL_INIT_PREOPEN
+ *        or ::PCL_INIT_PRELOAD_PLUGINS has finished.
+ *        If the library has been initialized without these flags it is ready immediately.
+ *
+ * @param timeout_ms the max time to wait in milliseconds, 0 to only check the state, -1 to wait without timeout
+ *
+ * @return 1 if ready, 0 if the timeout has expired;
+ *   On error a negative value will be returned with the following error codes:
+ *   ::EPERS_NOT_INITIALIZED, the error ::pclInitLibrary would have returned without ::PCL_INIT_ASYNC
+ */
+int pclWaitInitReady(int timeout_ms);
+
+
+
+/**
+ * @brief get a file descriptor which becomes readable when the background initialization
+ *        has finished, to be used with poll or select in the main loop of the application.
+ *        Use ::pclWaitInitReady to get the result. The descriptor is closed by ::pclDeinitLibrary.
+ *
+ * @return the file descriptor;
+ *   On error a negative value will be returned with the following error codes:
+ *   ::EPERS_NOT_INITIALIZED, ::EPERS_COMMON
+ */
+int pclGetInitReadyFd(void);
+
+
+
+/**
+ * @brief get the latency and error statistics of the calls into a custom plugin.
+ *        Asynchronous plugin requests are not counted.
+ *
+ * @param plugin the number of the plugin, starting with 0
+ * @param stats pointer to store the statistics
+ *
+ * @return 1 if the plugin is configured, 0 if it is not configured (stats not valid);
+ *   On error a negative value will be returned with the following error codes:
+ *   ::EPERS_NOT_INITIALIZED, ::EPERS_COMMON if there is no plugin with the given number
+ */
+int pclGetPluginStats(int plugin, pclPluginStats_s* stats);
+
+
+
+/**
+ * @brief set the flush priority of a key or file resource.
+ *        When there is not enough time at shutdown, the databases written with a resource
+ *        of a higher priority and the files of such a resource are flushed and synced first.
+ *        The priority applies to databases written and files opened after the call.
+ *
+ * @param resource_id the resource ID
+ * @param priority the priority, see ::PCL_FLUSH_PRIO_CRITICAL ... ::PCL_FLUSH_PRIO_LOW
+ *
+ * @return positive value: success;
+ *   On error a negative value will be returned with the following error codes:
+ *   ::EPERS_NOT_INITIALIZED, ::EPERS_COMMON if the resource or priority is invalid
+ *   or too many priorities have been set
+ */
+int pclSetFlushPriority(const char* resource_id, int priority);
+
+
 /** \} */
 
 #ifdef __cplusplus
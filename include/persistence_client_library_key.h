@@ -72,6 +72,40 @@ typedef struct _pclNotification_s
 } pclNotification_s;
 
 
+/**
+* statistics of the writes skipped by the write elision, see ::PCL_INIT_WRITE_ELISION
+*/
+typedef struct _pclWriteElisionStats_s
+{
+   unsigned int writes;                      /// number of skipped writes
+   unsigned int signals;                     /// number of skipped change notifications, always 0 (shared keys are not skipped)
+   unsigned long long bytes;                 /// number of bytes not written
+} pclWriteElisionStats_s;
+
+
+/**
+* statistics of the value cache, see ::pclUserPrefetch and ::pclKeyReadRef
+*/
+typedef struct _pclCacheStats_s
+{
+   unsigned int hits;                        /// reads of local keys served from the cache
+   unsigned int misses;                      /// reads of local keys not found in the cache
+   unsigned int prefetched;                  /// values added to the cache by ::pclUserPrefetch
+} pclCacheStats_s;
+
+
+/**
+* a key of a batch, see ::pclKeyReadDataMulti and ::pclKeyWriteDataMulti
+*/
+typedef struct _pclKeyMultiItem_s
+{
+   const char* resource_id;                  /// resource id
+   unsigned char* buffer;                    /// the buffer to read to or the data to write
+   int buffer_size;                          /// size of the buffer or number of bytes to write
+   int result;                               /// the bytes read or written or a negative error code
+} pclKeyMultiItem_s;
+
+
 
 /** \} */
 
@@ -86,6 +120,25 @@ typedef struct _pclNotification_s
 typedef int(* pclChangeNotifyCallback_t)(pclNotification_s * notifyStruct);
 
 
+/** definition of the completion callback of ::pclKeyWriteDataAsync and ::pclKeyReadDataAsync
+ *
+ * @param request_id the request ID returned by ::pclKeyWriteDataAsync or ::pclKeyReadDataAsync
+ * @param result the result of the request, see ::pclKeyWriteData and ::pclKeyReadData
+ * @param user_data the user data passed with the request
+*/
+typedef void(* pclKeyWriteDoneCallback_t)(int request_id, int result, void* user_data);
+
+
+/** definition of the callback of ::pclKeyIterate
+ *
+ * @param resource_id the resource ID of a key
+ * @param user_data the user data passed to ::pclKeyIterate
+ *
+ * @return 0 to continue the iteration, any other value to stop it
+*/
+typedef int(* pclKeyIterateCallback_t)(const char* resource_id, void* user_data);
+
+
 /** \defgroup PCL_KEYVALUE functions Key-Value access
  * \{
  */
@@ -106,6 +159,25 @@ int pclKeyDelete(unsigned int ldbid, const char* resource_id, unsigned int user_
 
 
 
+/**
+ * @brief delete all persistent data of a user, e.g. to reset a user profile.
+ *        All keys of the user in the namespace of the logical database ID are deleted in one pass,
+ *        if the seat number is 0 the keys of all seats of the user are deleted too.
+ *        For shared data one notification ::pclNotifyStatus_deleted with an empty resource ID
+ *        is sent instead of one notification per key.
+ *
+ * @param ldbid logical database ID
+ * @param user_no  the user ID; user_no=0 can not be used as user-ID because ‘0’ is defined as System/node
+ * @param seat_no  the seat number, 0 for all seats
+ *
+ * @return positive value (0 or greater): the number of deleted keys;
+ * On error a negative value will be returned with the following error codes:
+ * ::EPERS_LOCKFS ::EPERS_COMMON ::EPERS_NO_PLUGIN_FUNCT ::EPERS_DB_ERROR_INTERNAL ::EPERS_DESER_ALLOCMEM
+ */
+int pclKeyDeleteUser(unsigned int ldbid, unsigned int user_no, unsigned int seat_no);
+
+
+
 /**
  * @brief gets the size of persistent data in bytes
  *
@@ -248,6 +320,96 @@ int pclKeyReadData(unsigned int ldbid, const char* resource_id, unsigned int use
 
 
 
+/**
+ * @brief reads several keys of a logical database with one call.
+ *        Keys stored by a custom plugin providing vectored access are read with one plugin call per plugin.
+ *
+ * @param ldbid logical database ID
+ * @param user_no  the user ID; user_no=0 can not be used as user-ID because ‘0’ is defined as System/node
+ * @param seat_no  the seat number
+ * @param items the keys to read, the result of each key is stored in the item, see ::pclKeyReadData
+ * @param count the number of items
+ *
+ * @return positive value (0 or greater): the number of keys read successfully;
+ * On error a negative value will be returned with the following error codes:
+ * ::EPERS_LOCKFS ::EPERS_NOT_INITIALIZED ::EPERS_SHUTDOWN_NO_TRUSTED ::EPERS_DESER_ALLOCMEM ::EPERS_COMMON
+ */
+int pclKeyReadDataMulti(unsigned int ldbid, unsigned int user_no, unsigned int seat_no, pclKeyMultiItem_s* items, int count);
+
+
+
+/**
+ * @brief get a reference to persistent data identified by ldbid and resource_id without copying it.
+ *        The data stays valid until it has been released with ::pclKeyReleaseRef, even if the key
+ *        is written or deleted meanwhile. Values of local keys are kept in a cache,
+ *        so reading them again neither accesses the database nor copies the data.
+ *
+ * @param ldbid logical database ID
+ * @param resource_id the resource ID
+ * @param user_no  the user ID; user_no=0 can not be used as user-ID because ‘0’ is defined as System/node
+ * @param seat_no  the seat number
+ * @param data pointer to store the address of the read only data, the data is terminated with an additional '\0'
+ *
+ * @return positive value (0 or greater): the size of the data;
+ * On error a negative value will be returned with the following error codes:
+ * ::EPERS_LOCKFS ::EPERS_NOTIFY_SIG ::EPERS_DESER_ALLOCMEM, see ::pclKeyReadData
+ */
+int pclKeyReadRef(unsigned int ldbid, const char* resource_id, unsigned int user_no, unsigned int seat_no,
+                  const unsigned char** data);
+
+
+/**
+ * @brief release a reference returned by ::pclKeyReadRef
+ *
+ * @param data the data returned by ::pclKeyReadRef
+ *
+ * @return positive value (0 or greater): success;
+ * On error a negative value will be returned with the following error codes: ::EPERS_COMMON
+ */
+int pclKeyReleaseRef(const unsigned char* data);
+
+
+/**
+ * @brief reads persistent data identified by ldbid and resource_id into a buffer allocated by the library,
+ *        the size of the data does not need to be known in advance.
+ *
+ * @param ldbid logical database ID
+ * @param resource_id the resource ID
+ * @param user_no  the user ID; user_no=0 can not be used as user-ID because ‘0’ is defined as System/node
+ * @param seat_no  the seat number
+ * @param buffer pointer to store the address of the buffer, the buffer must be released with free().
+ *        The data is terminated with an additional '\0'
+ *
+ * @return positive value (0 or greater): the size of the data;
+ * On error a negative value will be returned with the error codes of ::pclKeyReadRef
+ */
+int pclKeyReadDataAlloc(unsigned int ldbid, const char* resource_id, unsigned int user_no, unsigned int seat_no,
+                        unsigned char** buffer);
+
+
+
+/**
+ * @brief iterate over the keys stored for a logical database ID, user and seat.
+ *        The resource IDs are collected first, then the callback is called for each of them,
+ *        so the callback may read, write or delete the keys (e.g. for export or migration).
+ *        Keys which only have a default value are not included. Keys of custom storages are not supported.
+ *
+ * @param ldbid logical database ID
+ * @param user_no  the user ID; user_no=0 can not be used as user-ID because ‘0’ is defined as System/node
+ * @param seat_no  the seat number
+ * @param prefix only resource IDs starting with the prefix are passed to the callback, NULL or "" for all
+ * @param callback called for each resource ID
+ * @param user_data passed to the callback
+ *
+ * @return positive value (0 or greater): the number of resource IDs passed to the callback;
+ * On error a negative value will be returned with the following error codes:
+ * ::EPERS_LOCKFS ::EPERS_NOT_INITIALIZED ::EPERS_NO_PLUGIN_FUNCT ::EPERS_DB_ERROR_INTERNAL ::EPERS_DESER_ALLOCMEM
+ */
+int pclKeyIterate(unsigned int ldbid, unsigned int user_no, unsigned int seat_no, const char* prefix,
+                  pclKeyIterateCallback_t callback, void* user_data);
+
+
+
 /**
  * @brief register for a change notification for persistent data
  *
@@ -306,6 +468,150 @@ int pclKeyUnRegisterNotifyOnChange( unsigned int  ldbid, const char *  resource_
 int pclKeyWriteData(unsigned int ldbid, const char* resource_id, unsigned int user_no, unsigned int seat_no, unsigned char* buffer, int buffer_size);
 
 
+
+/**
+ * @brief writes several keys of a logical database with one call.
+ *        Keys stored by a custom plugin providing vectored access are written with one plugin call per plugin.
+ *
+ * @param ldbid logical database ID
+ * @param user_no  the user ID; user_no=0 can not be used as user-ID because ‘0’ is defined as System/node
+ * @param seat_no  the seat number
+ * @param items the keys to write, the result of each key is stored in the item, see ::pclKeyWriteData
+ * @param count the number of items
+ *
+ * @return positive value (0 or greater): the number of keys written successfully;
+ * On error a negative value will be returned with the following error codes:
+ * ::EPERS_LOCKFS ::EPERS_NOT_INITIALIZED ::EPERS_SHUTDOWN_NO_TRUSTED ::EPERS_DESER_ALLOCMEM ::EPERS_COMMON
+ */
+int pclKeyWriteDataMulti(unsigned int ldbid, unsigned int user_no, unsigned int seat_no, pclKeyMultiItem_s* items, int count);
+
+
+
+/**
+ * @brief writes persistent data identified by ldbid and resource_id asynchronously.
+ *        The data is copied and written by an I/O worker thread of the library.
+ *        Requests are executed in the order they have been issued, so writes to
+ *        the same key are never reordered. A read of the key may return the old
+ *        data until the request has been completed.
+ *        Keys stored by a custom plugin providing non blocking access are written
+ *        by the plugin, the I/O worker thread does not wait for the plugin then.
+ *        Pending requests are executed by ::pclDeinitLibrary.
+ *
+ * @param ldbid logical database ID
+ * @param resource_id the resource ID
+ * @param user_no  the user ID; user_no=0 can not be used as user-ID because ‘0’ is defined as System/node
+ * @param seat_no  the seat number
+ * @param buffer the buffer containing the persistent data to write
+ * @param buffer_size the number of bytes to write, see ::pclKeyWriteData
+ * @param callback called by the I/O worker thread when the request has been completed,
+ *        must not call ::pclDeinitLibrary.
+ *        If NULL, the result can be retrieved with ::pclKeyAsyncGetResult
+ * @param user_data passed to the callback
+ *
+ * @return positive value (greater than 0): the request ID;
+ * On error a negative value will be returned with the following error codes:
+ * ::EPERS_NOT_INITIALIZED ::EPERS_BUFLIMIT ::EPERS_DB_KEY_SIZE ::EPERS_DESER_ALLOCMEM ::EPERS_COMMON
+ */
+int pclKeyWriteDataAsync(unsigned int ldbid, const char* resource_id, unsigned int user_no, unsigned int seat_no,
+                         unsigned char* buffer, int buffer_size, pclKeyWriteDoneCallback_t callback, void* user_data);
+
+
+/**
+ * @brief reads persistent data identified by ldbid and resource_id asynchronously.
+ *        The request is queued behind the asynchronous write requests, see ::pclKeyWriteDataAsync.
+ *        Keys stored by a custom plugin providing non blocking access are read
+ *        by the plugin, the I/O worker thread does not wait for the plugin then.
+ *
+ * @param ldbid logical database ID
+ * @param resource_id the resource ID
+ * @param user_no  the user ID; user_no=0 can not be used as user-ID because ‘0’ is defined as System/node
+ * @param seat_no  the seat number
+ * @param buffer the buffer to read the persistent data, must stay valid until the request has been completed
+ * @param buffer_size size of buffer for reading
+ * @param callback called by the I/O worker thread when the request has been completed,
+ *        must not call ::pclDeinitLibrary.
+ *        If NULL, the result can be retrieved with ::pclKeyAsyncGetResult
+ * @param user_data passed to the callback
+ *
+ * @return positive value (greater than 0): the request ID;
+ * On error a negative value will be returned with the following error codes:
+ * ::EPERS_NOT_INITIALIZED ::EPERS_DB_KEY_SIZE ::EPERS_DESER_ALLOCMEM ::EPERS_COMMON
+ */
+int pclKeyReadDataAsync(unsigned int ldbid, const char* resource_id, unsigned int user_no, unsigned int seat_no,
+                        unsigned char* buffer, int buffer_size, pclKeyWriteDoneCallback_t callback, void* user_data);
+
+
+/**
+ * @brief get a pollable file descriptor (eventfd) which becomes readable when an asynchronous
+ *        request without callback has been completed.
+ *        Read the eventfd to reset it, then call ::pclKeyAsyncGetResult until it returns 0.
+ *        Results of requests without callback are only stored after the eventfd has been requested.
+ *        The file descriptor is closed by ::pclDeinitLibrary.
+ *
+ * @return positive value (0 or greater): the file descriptor;
+ * On error a negative value will be returned with the following error codes:
+ * ::EPERS_NOT_INITIALIZED ::EPERS_COMMON
+ */
+int pclKeyAsyncGetFd(void);
+
+
+/**
+ * @brief get the result of a completed asynchronous request without callback,
+ *        the results are returned in the order the requests have been completed.
+ *
+ * @param result pointer to store the result of the request, see ::pclKeyWriteData and ::pclKeyReadData
+ *
+ * @return the request ID or 0 if there is no completed request;
+ * On error a negative value will be returned with the following error codes:
+ * ::EPERS_NOT_INITIALIZED
+ */
+int pclKeyAsyncGetResult(int* result);
+
+
+
+/**
+ * @brief get the statistics of the writes skipped since ::pclInitLibrary has been called
+ *        with ::PCL_INIT_WRITE_ELISION
+ *
+ * @param stats pointer to store the statistics
+ *
+ * @return positive value (0 or greater): success;
+ * On error a negative value will be returned with the following error codes:
+ * ::EPERS_NOT_INITIALIZED ::EPERS_COMMON
+ */
+int pclKeyGetWriteElisionStats(pclWriteElisionStats_s* stats);
+
+
+
+/**
+ * @brief hint to load the local keys of a user and seat into the value cache in the background,
+ *        e.g. before a switch of the user profile. Reads of the keys are then served from memory.
+ *        The default values are loaded too. The function returns immediately.
+ *        The keys are loaded in small batches, the application is not blocked by the prefetch.
+ *        Keys already in the value cache and keys not yet written back are skipped.
+ *
+ * @param user_no  the user ID
+ * @param seat_no  the seat number, 0 for the keys of the user without seat
+ *
+ * @return positive value (0 or greater): the prefetch has been queued;
+ * On error a negative value will be returned with the following error codes:
+ * ::EPERS_NOT_INITIALIZED ::EPERS_DESER_ALLOCMEM ::EPERS_COMMON
+ */
+int pclUserPrefetch(unsigned int user_no, unsigned int seat_no);
+
+
+/**
+ * @brief get the statistics of the value cache
+ *
+ * @param stats pointer to store the statistics
+ *
+ * @return positive value (0 or greater): success;
+ * On error a negative value will be returned with the following error codes:
+ * ::EPERS_NOT_INITIALIZED ::EPERS_COMMON
+ */
+int pclKeyGetCacheStats(pclCacheStats_s* stats);
+
+
 /** \} */
 
 #ifdef __cplusplus
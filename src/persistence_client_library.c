@@ -26,6 +26,14 @@
 #include "persistence_client_library_backup_filelist.h"
 #include "persistence_client_library_db_access.h"
 #include "persistence_client_library_dbus_cmd.h"
+#include "persistence_client_library_prct_access.h"
+#include "persistence_client_library_key_cache.h"
+#include "persistence_client_library_key_async.h"
+#include "persistence_client_library_write_elision.h"
+#include "persistence_client_library_shared_cache.h"
+#include "persistence_client_library_plugin_stats.h"
+#include "persistence_client_library_flush.h"
+#include "persistence_client_library_warm_start.h"
 
 #if USE_FILECACHE
    #include <persistence_file_cache.h>
@@ -40,6 +48,10 @@
 #include <dlt.h>
 #include <ctype.h>
 #include <semaphore.h>
+#include <time.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
 
 /// debug log and trace (DLT) setup
 DLT_DECLARE_CONTEXT(gPclDLTContext);
@@ -52,8 +64,25 @@ static int gCancelCounter = 0;
 
 static pthread_mutex_t gInitMutex = PTHREAD_MUTEX_INITIALIZER;
 
+/// thread of the background initialization, see ::PCL_INIT_ASYNC, ::PCL_INIT_PREOPEN and ::PCL_INIT_PRELOAD_PLUGINS
+static pthread_t gInitThread;
+/// flag to indicate if the background initialization thread has been started
+static int gInitThreadStarted = 0;
+/// ready flag, 0 while the background initialization is running
+static int gInitReady = 1;
+/// error of the background initialization, 0 if none
+static int gInitError = 0;
+/// eventfd signalled when the background initialization has finished, -1 if not requested
+static int gInitReadyFd = -1;
+static pthread_mutex_t gInitReadyMtx = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t gInitReadyCond = PTHREAD_COND_INITIALIZER;
+
 /// name of the backup blacklist file (contains all the files which are excluded from backup creation)
 static const char* gBackupFilename = "BackupFileList.info";
+/// name of the redo log file of the write back key cache
+static const char* gKeyCacheLogFilename = "KeyCacheRedo.log";
+/// name of the warm start snapshot file
+static const char* gWarmStartFilename = "WarmStart.snap";
 static const char* gNsmAppId = "NodeStateManager";
 
 static const char* gArtefactTemplate[]  = { "_Data_mnt_wt_%s_wt_itz-sem",
@@ -193,6 +222,141 @@ void checkLocalArtefacts(const char* thePath, const char* appName)
 
 
 
+static void setInitReady(int ready)
+{
+   pthread_mutex_lock(&gInitReadyMtx);
+   gInitReady = ready;
+   if(ready == 1 && gInitReadyFd != -1)
+   {
+      uint64_t one = 1;
+      if(write(gInitReadyFd, &one, sizeof(one)) != (ssize_t)sizeof(one))
+      {
+         DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("initLibrary - Failed to signal eventfd"));
+      }
+   }
+   pthread_cond_broadcast(&gInitReadyCond);
+   pthread_mutex_unlock(&gInitReadyMtx);
+}
+
+
+
+/* set up the dbus mainloop and register to the persistence administration service */
+static int initDbus(void)
+{
+#if USE_PASINTERFACE
+   int pasRegStatus = -1;
+#endif
+
+   if(gDbusMainloopRunning == 0) // check if dbus has been already initialized
+   {
+      if(setup_dbus_mainloop() == -1)
+      {
+        DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("initLibrary - Failed to setup main loop"));
+        set_dbus_mainloop_ready(0);
+        return EPERS_DBUS_MAINLOOP;
+      }
+      gDbusMainloopRunning = 1;
+   }
+   set_dbus_mainloop_ready(1);
+
+#if USE_PASINTERFACE
+   DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("PAS interface is enabled!!"));
+
+   pasRegStatus = register_pers_admin_service();
+
+   if(pasRegStatus == -1)
+   {
+     DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("initLibrary - Failed reg to PAS dbus interface"));
+   }
+   else if(pasRegStatus < -1)
+   {
+      DLT_LOG(gPclDLTContext, DLT_LOG_INFO,  DLT_STRING("initLibrary - registration to PAS currently not possible."));
+      return EPERS_NO_REG_TO_PAS;
+   }
+   else
+   {
+     DLT_LOG(gPclDLTContext, DLT_LOG_INFO,  DLT_STRING("initLibrary - Successfully established IPC protocol for PCL."));
+     gPasRegistered = 1;   // remember registration to PAS
+   }
+#else
+   DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("PAS interface not enabled, enable with \"./configure --enable-pasinterface\""));
+#endif
+
+   return 1;
+}
+
+
+
+/* register for lifecycle dbus messages */
+static void initLifecycle(void)
+{
+   if(gShutdownMode != PCL_SHUTDOWN_TYPE_NONE)
+   {
+     if(register_lifecycle(gShutdownMode) == -1) // register for lifecycle dbus messages
+     {
+       DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("initLibrary => Failed reg to LC dbus interface"));
+     }
+   }
+}
+
+
+
+static void* initBackground(void* flags)
+{
+   if((intptr_t)flags & PCL_INIT_ASYNC)
+   {
+      int rval = initDbus();
+
+      if(rval >= 0)
+      {
+         initLifecycle();
+      }
+
+      // always load the plugins, access to them waits until they have been loaded
+      if(load_custom_plugins(customAsyncInitClbk) < 0 && rval >= 0)
+      {
+         DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("Failed to load custom plugins"));
+         rval = EPERS_COMMON;
+      }
+
+      if(rval < 0)
+      {
+         // pclInitLibrary would have failed, don't allow any further access
+         DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("initLibrary - background init failed:"), DLT_INT(rval));
+         pers_lock_access();
+         pthread_mutex_lock(&gInitReadyMtx);
+         gInitError = rval;
+         pthread_mutex_unlock(&gInitReadyMtx);
+      }
+   }
+
+   if((intptr_t)flags & PCL_INIT_PRELOAD_PLUGINS)
+   {
+      preload_custom_plugins();     // serialized with on demand loading by the custom loader
+   }
+
+   // serialize with the key and file API, they access the same database handles
+   if(((intptr_t)flags & PCL_INIT_PREOPEN) && pthread_mutex_lock(&gKeyAPIAccessMtx) == 0)
+   {
+      if(pthread_mutex_lock(&gFileAccessMtx) == 0)
+      {
+         if(AccessNoLock != isAccessLocked())
+         {
+            database_preopen_local();
+         }
+         pthread_mutex_unlock(&gFileAccessMtx);
+      }
+      pthread_mutex_unlock(&gKeyAPIAccessMtx);
+   }
+
+   DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("initLibrary - background init finished"));
+   setInitReady(1);
+
+   return NULL;
+}
+
+
+
 int pclInitLibrary(const char* appName, int shutdownMode)
 {
    int rval = 1;
@@ -247,13 +411,15 @@ static int private_pclInitLibrary(const char* appName, int shutdownMode)
    // no need for NULL ptr check for appName, already done in calling function
 
    int rval = 1;
-#if USE_PASINTERFACE
-   int pasRegStatus = -1;
-#endif
+   int backgroundFlags = shutdownMode & (PCL_INIT_ASYNC | PCL_INIT_PREOPEN | PCL_INIT_PRELOAD_PLUGINS);
 
    char blacklistPath[PERS_ORG_MAX_LENGTH_PATH_FILENAME] = {0};
+   char keyCacheLogPath[PERS_ORG_MAX_LENGTH_PATH_FILENAME] = {0};
+   char warmStartPath[PERS_ORG_MAX_LENGTH_PATH_FILENAME] = {0};
 
-   gShutdownMode = shutdownMode;
+   gShutdownMode = shutdownMode & ~(PCL_INIT_PREOPEN | PCL_INIT_WRITE_ELISION | PCL_INIT_SHARED_CACHE | PCL_INIT_PRELOAD_PLUGINS
+                                    | PCL_INIT_ASYNC | PCL_INIT_WARM_START);    // init flags are not part of the shutdown mode
+   gInitError = 0;
 
 #if USE_FSYNC
    DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("Using fsync version"));
@@ -266,38 +432,16 @@ static int private_pclInitLibrary(const char* appName, int shutdownMode)
    pfcInitCache(appName);
 #endif
 
-   if(gDbusMainloopRunning == 0) // check if dbus has been already initialized
+   if(shutdownMode & PCL_INIT_ASYNC)
    {
-      if(setup_dbus_mainloop() == -1)
-      {
-        DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("initLibrary - Failed to setup main loop"));
-        return EPERS_DBUS_MAINLOOP;
-      }
-      gDbusMainloopRunning = 1;
+      // dbus, lifecycle and plugins are set up in the background, messages and plugin access wait for it
+      set_dbus_mainloop_pending();
+      set_custom_plugins_pending();
    }
-
-#if USE_PASINTERFACE
-   DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("PAS interface is enabled!!"));
-
-   pasRegStatus = register_pers_admin_service();
-
-   if(pasRegStatus == -1)
-   {
-     DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("initLibrary - Failed reg to PAS dbus interface"));
-   }
-   else if(pasRegStatus < -1)
-   {
-      DLT_LOG(gPclDLTContext, DLT_LOG_INFO,  DLT_STRING("initLibrary - registration to PAS currently not possible."));
-      return EPERS_NO_REG_TO_PAS;
-   }
-   else
+   else if((rval = initDbus()) < 0)
    {
-     DLT_LOG(gPclDLTContext, DLT_LOG_INFO,  DLT_STRING("initLibrary - Successfully established IPC protocol for PCL."));
-     gPasRegistered = 1;   // remember registration to PAS
+      return rval;
    }
-#else
-   DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("PAS interface not enabled, enable with \"./configure --enable-pasinterface\""));
-#endif
 
    strncpy(gAppId, appName, PERS_RCT_MAX_LENGTH_RESPONSIBLE);  // assign application name
    gAppId[PERS_RCT_MAX_LENGTH_RESPONSIBLE-1] = '\0';
@@ -322,37 +466,70 @@ static int private_pclInitLibrary(const char* appName, int shutdownMode)
       gIsNodeStateManager = 1;
    }
 
-   // Assemble backup blacklist path
-   snprintf(blacklistPath, PERS_ORG_MAX_LENGTH_PATH_FILENAME, "%s%s/%s", CACHEPREFIX, appName, gBackupFilename);
+   if((shutdownMode & PCL_INIT_ASYNC) == 0)
+   {
+      initLifecycle();
 
-   if(readBlacklistConfigFile(blacklistPath) == -1)
+      if((rval = load_custom_plugins(customAsyncInitClbk)) < 0)      // load custom plugins
+      {
+        DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("Failed to load custom plugins"));
+        return rval;
+      }
+   }
+   else if(load_default_plugin() < 0)    // the replay and the local data access need the database functions now
    {
-     DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("initLibrary - Err access blacklist:"), DLT_STRING(blacklistPath));
+      DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("Failed to load default plugin"));
    }
 
-
-   if(gShutdownMode != PCL_SHUTDOWN_TYPE_NONE)
+   // replay unwritten cached keys of the last lifecycle before any database will be opened
+   snprintf(keyCacheLogPath, PERS_ORG_MAX_LENGTH_PATH_FILENAME, "%s%s/%s", CACHEPREFIX, appName, gKeyCacheLogFilename);
+   if(key_cache_init(keyCacheLogPath) == -1)
    {
-     if(register_lifecycle(shutdownMode) == -1) // register for lifecycle dbus messages
-     {
-       DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("initLibrary => Failed reg to LC dbus interface"));
-     }
+      DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("initLibrary - write back key cache disabled"));
    }
 
-   if((rval = load_custom_plugins(customAsyncInitClbk)) < 0)      // load custom plugins
+   // the snapshot is validated after the replay, the replay changes the databases
+   snprintf(warmStartPath, PERS_ORG_MAX_LENGTH_PATH_FILENAME, "%s%s/%s", CACHEPREFIX, appName, gWarmStartFilename);
+   (void)warm_start_init(warmStartPath, (shutdownMode & PCL_INIT_WARM_START) ? 1 : 0);
+
+   // Assemble backup blacklist path
+   snprintf(blacklistPath, PERS_ORG_MAX_LENGTH_PATH_FILENAME, "%s%s/%s", CACHEPREFIX, appName, gBackupFilename);
+
+   if(warm_start_load_blacklist(blacklistPath) != 1 && readBlacklistConfigFile(blacklistPath) == -1)
    {
-     DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("Failed to load custom plugins"));
-     return rval;
+     DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("initLibrary - Err access blacklist:"), DLT_STRING(blacklistPath));
    }
 
    init_key_handle_array();
 
+   key_async_init();             // accept asynchronous write requests
+
+   write_elision_enable((shutdownMode & PCL_INIT_WRITE_ELISION) ? 1 : 0);
+
+   shared_cache_enable((shutdownMode & PCL_INIT_SHARED_CACHE) ? 1 : 0);
+
+   init_resource_cfg_index();    // map the precompiled resource configuration table index, if available
+
 #if USE_APPCHECK
    doInitAppcheck(appName);      // check if we have a trusted application
 #endif
 
    pers_unlock_access();
 
+   if(backgroundFlags != 0)
+   {
+      setInitReady(0);
+      if(pthread_create(&gInitThread, NULL, initBackground, (void*)(intptr_t)backgroundFlags) == 0)
+      {
+         gInitThreadStarted = 1;
+      }
+      else
+      {
+         DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("initLibrary - Failed to start background init thread"));
+         (void)initBackground((void*)(intptr_t)backgroundFlags);     // do it now, the waiters must be released
+      }
+   }
+
    return rval;
 }
 
@@ -402,6 +579,22 @@ static int private_pclDeinitLibrary(void)
 
    MainLoopData_u data;
 
+   if(gInitThreadStarted == 1)
+   {
+      pthread_join(gInitThread, NULL);      // the databases will be closed below
+      gInitThreadStarted = 0;
+   }
+
+   pthread_mutex_lock(&gInitReadyMtx);
+   if(gInitReadyFd != -1)
+   {
+      close(gInitReadyFd);
+      gInitReadyFd = -1;
+   }
+   pthread_mutex_unlock(&gInitReadyMtx);
+
+   key_async_deinit();           // execute pending asynchronous write requests while the library is still usable
+
    if(gShutdownMode != PCL_SHUTDOWN_TYPE_NONE)  // unregister for lifecycle dbus messages
    {
       rval = unregister_lifecycle(gShutdownMode);
@@ -420,26 +613,41 @@ static int private_pclDeinitLibrary(void)
    }
 #endif
 
-   memset(&data, 0, sizeof(MainLoopData_u));
-   data.cmd = (uint32_t)CMD_LC_PREPARE_SHUTDOWN;
-   data.params[0] = Shutdown_Full;        // shutdown full
-   data.params[1] = 0;                    // internal prepare shutdown
-   data.string[0] = '\0';                 // no string parameter, set to 0
-   deliverToMainloop_NM(&data);           // send quit command to dbus mainloop
+   if(gDbusMainloopRunning == 1)    // the asynchronous init may have failed to set up the mainloop
+   {
+      memset(&data, 0, sizeof(MainLoopData_u));
+      data.cmd = (uint32_t)CMD_LC_PREPARE_SHUTDOWN;
+      data.params[0] = Shutdown_Full;        // shutdown full
+      data.params[1] = 0;                    // internal prepare shutdown
+      data.string[0] = '\0';                 // no string parameter, set to 0
+      deliverToMainloop_NM(&data);           // send quit command to dbus mainloop
 
 
-   memset(&data, 0, sizeof(MainLoopData_u));
-   data.cmd = (uint32_t)CMD_QUIT;
-   data.string[0] = '\0';           // no string parameter, set to 0
+      memset(&data, 0, sizeof(MainLoopData_u));
+      data.cmd = (uint32_t)CMD_QUIT;
+      data.string[0] = '\0';           // no string parameter, set to 0
 
-   deliverToMainloop_NM(&data);                       // send quit command to dbus mainloop
+      deliverToMainloop_NM(&data);                       // send quit command to dbus mainloop
 
-   pthread_join(gMainLoopThread, (void**)&retval);    // wait until the dbus mainloop has ended
+      pthread_join(gMainLoopThread, (void**)&retval);    // wait until the dbus mainloop has ended
+   }
+   else
+   {
+      // there is no mainloop to execute the shutdown, flush and close the databases here
+      (void)process_prepare_shutdown(Shutdown_Full, NULL);
+   }
+   set_dbus_mainloop_ready(1);                           // the next init sets up the mainloop again
+
+   key_cache_deinit();                                // stop the write back flusher
+
+   warm_start_deinit();
 
    deleteHandleTrees();                               // delete allocated trees
    deleteBackupTree();
    deleteNotifyTree();
 
+   flush_priority_clear();
+
 #if USE_FILECACHE
    pfcDeinitCache();
 #endif
@@ -452,6 +660,123 @@ static int private_pclDeinitLibrary(void)
 
 
 
+int pclWaitInitReady(int timeout_ms)
+{
+   int rval = EPERS_NOT_INITIALIZED;
+
+   if(__sync_add_and_fetch(&gPclInitCounter, 0) > 0)
+   {
+      struct timespec deadline;
+      int ret = 0;
+
+      clock_gettime(CLOCK_REALTIME, &deadline);
+      deadline.tv_sec  += timeout_ms / 1000;
+      deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+      if(deadline.tv_nsec >= 1000000000L)
+      {
+         deadline.tv_sec++;
+         deadline.tv_nsec -= 1000000000L;
+      }
+
+      pthread_mutex_lock(&gInitReadyMtx);
+      while(gInitReady == 0 && timeout_ms != 0 && ret == 0)
+      {
+         if(timeout_ms < 0)
+         {
+            ret = pthread_cond_wait(&gInitReadyCond, &gInitReadyMtx);
+         }
+         else
+         {
+            ret = pthread_cond_timedwait(&gInitReadyCond, &gInitReadyMtx, &deadline);
+         }
+      }
+      rval = (gInitError < 0) ? gInitError : gInitReady;
+      pthread_mutex_unlock(&gInitReadyMtx);
+   }
+
+   return rval;
+}
+
+
+
+int pclGetInitReadyFd(void)
+{
+   int rval = EPERS_NOT_INITIALIZED;
+
+   if(__sync_add_and_fetch(&gPclInitCounter, 0) > 0)
+   {
+      pthread_mutex_lock(&gInitReadyMtx);
+      if(gInitReadyFd == -1)
+      {
+         gInitReadyFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+         if(gInitReadyFd == -1)
+         {
+            DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("pclGetInitReadyFd - Failed to create eventfd"));
+         }
+         else if(gInitReady == 1)      // already finished, the eventfd must be readable anyway
+         {
+            uint64_t one = 1;
+            (void)write(gInitReadyFd, &one, sizeof(one));
+         }
+      }
+      rval = (gInitReadyFd != -1) ? gInitReadyFd : EPERS_COMMON;
+      pthread_mutex_unlock(&gInitReadyMtx);
+   }
+
+   return rval;
+}
+
+
+
+int pclGetPluginStats(int plugin, pclPluginStats_s* stats)
+{
+   int rval = EPERS_NOT_INITIALIZED;
+
+   if(__sync_add_and_fetch(&gPclInitCounter, 0) > 0)
+   {
+      if(plugin >= 0 && plugin < PersCustomLib_LastEntry && stats != NULL)
+      {
+         rval = 0;
+         if(check_valid_idx(plugin) != -1)
+         {
+            stats->name = get_custom_client_lib_name(plugin);
+            plugin_stats_get(plugin, stats->op);
+            rval = 1;
+         }
+      }
+      else
+      {
+         rval = EPERS_COMMON;
+      }
+   }
+
+   return rval;
+}
+
+
+
+int pclSetFlushPriority(const char* resource_id, int priority)
+{
+   int rval = EPERS_NOT_INITIALIZED;
+
+   if(__sync_add_and_fetch(&gPclInitCounter, 0) > 0)
+   {
+      rval = EPERS_COMMON;
+      if(   resource_id != NULL && strlen(resource_id) < PERS_DB_MAX_LENGTH_KEY_NAME
+         && priority >= PCL_FLUSH_PRIO_CRITICAL && priority < PCL_FLUSH_PRIO_LAST)
+      {
+         if(flush_priority_set(resource_id, priority) == 0)
+         {
+            rval = 1;
+         }
+      }
+   }
+
+   return rval;
+}
+
+
+
 int pclLifecycleSet(int shutdown)
 {
    int rval = 0;
@@ -88,10 +88,10 @@ static void createAndStoreFileNames()
 {
    int i= 0;
    char path[128] = {0};
-   key_value_s* item;
+   key_value_s item;
 
-   // create new tree
-   gRb_tree_bl = jsw_rbnew(key_val_cmp, key_val_dup, key_val_rel);
+   // create new tree, only the key is of interest, so the items are embedded in the tree nodes
+   gRb_tree_bl = jsw_rbnew_intrusive(key_val_cmp, sizeof(key_value_s), 0);
 
    if(gRb_tree_bl != NULL)
    {
@@ -102,16 +102,11 @@ static void createAndStoreFileNames()
             memset(path, 0, sizeof(path));
             snprintf(path, 128, "%s", gpTokenArray[i]);    // storage type
 
-            item = malloc(sizeof(key_value_s));    // asign key and value to the rbtree item
-            if(item != NULL)
-            {
-               //printf("createAndStoreFileNames => path: %s\n", path);
-               item->key = pclCrc32(0, (unsigned char*)path, strlen(path));
-               // we don't need the path name here, we just need to know that this key is available in the tree
-               item->value = "";
-               (void)jsw_rbinsert(gRb_tree_bl, item);
-               free(item);
-            }
+            //printf("createAndStoreFileNames => path: %s\n", path);
+            item.key = pclCrc32(0, (unsigned char*)path, strlen(path));
+            // we don't need the path name here, we just need to know that this key is available in the tree
+            item.value = "";
+            (void)jsw_rbinsert(gRb_tree_bl, &item);
             i+=1;
          }
          else
@@ -186,29 +181,81 @@ int readBlacklistConfigFile(const char* filename)
 
 
 
-int need_backup_key(unsigned int key)
+int readBlacklistKeys(const uint32_t* keys, unsigned int count)
 {
-   int rval = CREATE_BACKUP;
-   key_value_s* item = NULL;
+   int rval = 0;
+   unsigned int i = 0;
+
+   deleteBackupTree();
+   gRb_tree_bl = jsw_rbnew_intrusive(key_val_cmp, sizeof(key_value_s), 0);
 
-   item = malloc(sizeof(key_value_s));
-   if(item != NULL && gRb_tree_bl != NULL)
+   if(gRb_tree_bl != NULL)
    {
-      key_value_s* foundItem = NULL;
-      item->key = key;
-      foundItem = (key_value_s*)jsw_rbfind(gRb_tree_bl, item);
-      if(foundItem != NULL)
+      key_value_s item;
+
+      item.value = "";
+      for(i = 0; i < count; i++)
       {
-         rval = DONT_CREATE_BACKUP;
+         item.key = keys[i];
+         (void)jsw_rbinsert(gRb_tree_bl, &item);
       }
-      free(item);
    }
    else
    {
-      if(item!=NULL)
-        free(item);
+      rval = EPERS_COMMON;
+   }
+
+   return rval;
+}
+
+
+
+int getBlacklistKeys(uint32_t** keys)
+{
+   int count = -1;
+
+   if(gRb_tree_bl != NULL)
+   {
+      jsw_rbtrav_t* trav = jsw_rbtnew();
+
+      *keys = malloc((jsw_rbsize(gRb_tree_bl) + 1) * sizeof(uint32_t));
+      if(trav != NULL && *keys != NULL)
+      {
+         const key_value_s* item = jsw_rbtfirst(trav, gRb_tree_bl);
 
-      rval = CREATE_BACKUP;
+         for(count = 0; item != NULL; item = jsw_rbtnext(trav))
+         {
+            (*keys)[count++] = item->key;
+         }
+      }
+      else
+      {
+         free(*keys);
+         *keys = NULL;
+      }
+      if(trav != NULL)
+      {
+         jsw_rbtdelete(trav);
+      }
+   }
+
+   return count;
+}
+
+
+
+int need_backup_key(unsigned int key)
+{
+   int rval = CREATE_BACKUP;
+
+   if(gRb_tree_bl != NULL)
+   {
+      key_value_s item;
+      item.key = key;
+      if(jsw_rbfind(gRb_tree_bl, &item) != NULL)
+      {
+         rval = DONT_CREATE_BACKUP;
+      }
    }
 
    return rval;
@@ -22,6 +22,8 @@
 #include "persistence_client_library_handle.h"
 #include "persistence_client_library_tree_helper.h"
 
+#include <stdint.h>
+
 
 /**
  * @brief Read the blacklist configuration file
@@ -33,6 +35,27 @@
 int readBlacklistConfigFile(const char* filename);
 
 
+/**
+ * @brief Create the blacklist from the checksums of the file names, e.g. stored by the warm start snapshot
+ *
+ * @param keys the crc32 checksums of the file names
+ * @param count the number of checksums
+ *
+ * @return 0 on success, EPERS_COMMON on error
+ */
+int readBlacklistKeys(const uint32_t* keys, unsigned int count);
+
+
+/**
+ * @brief Get the checksums of the file names in the blacklist
+ *
+ * @param keys pointer to store the array of checksums, must be released with free
+ *
+ * @return the number of checksums or -1 if there is no blacklist
+ */
+int getBlacklistKeys(uint32_t** keys);
+
+
 /**
  * @brief Create the file under the given path.
  *        If the path does not exist, the folders will be created
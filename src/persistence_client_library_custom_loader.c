@@ -17,6 +17,7 @@
  */
 
 #include "persistence_client_library_custom_loader.h"
+#include "persistence_client_library_plugin_stats.h"
 
 #include <errno.h>
 #include <sys/mman.h>
@@ -24,6 +25,7 @@
 #include <sys/stat.h>
 #include <dlfcn.h>
 #include <dlt.h>
+#include <pthread.h>
 
 DLT_IMPORT_CONTEXT(gPclDLTContext);
 
@@ -60,6 +62,21 @@ static char* gpCustomTokenArray[TOKENARRAYSIZE];
 
 int(* gPlugin_callback_async_t)(int errcode);
 
+/// serializes loading on demand plugins, they may be loaded by the background preload and on first access
+static pthread_mutex_t gCustomLoadMtx = PTHREAD_MUTEX_INITIALIZER;
+/// 1 if an on demand plugin has been loaded and its functions resolved, published after the load
+static int gCustomPluginLoaded[PersCustomLib_LastEntry] = {0};
+/// 0 while the plugins of pclInitLibrary are loaded in the background (asynchronous init)
+static int gCustomPluginsReady = 1;
+static pthread_cond_t gCustomPluginsReadyCond = PTHREAD_COND_INITIALIZER;
+/// plugins to be loaded in pclInitLibrary, the next one to be loaded and the load results
+static int gCustomLoadIdx[PersCustomLib_LastEntry];
+static int gCustomLoadResult[PersCustomLib_LastEntry];
+static int gCustomLoadCount = 0;
+static int gCustomLoadNext = 0;
+/// 1 if the default plugin has been loaded by ::load_default_plugin, it is not loaded again by ::load_custom_plugins
+static int gDefaultPluginLoaded = 0;
+
 
 static void fillCustomCharTokenArray(unsigned int customConfigFileSize, char* fileMap)
 {
@@ -381,6 +398,16 @@ int load_default_library(void* handle)
       {
          DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("load_default_library - error:"), DLT_STRING(error));
       }
+      *(void **) (&plugin_persComRctGetSizeResourcesList) = dlsym(handle, "persComRctGetSizeResourcesList");
+      if ((error = dlerror()) != NULL)
+      {
+         DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("load_default_library - error:"), DLT_STRING(error));
+      }
+      *(void **) (&plugin_persComRctGetResourcesList) = dlsym(handle, "persComRctGetResourcesList");
+      if ((error = dlerror()) != NULL)
+      {
+         DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("load_default_library - error:"), DLT_STRING(error));
+      }
 
       /// V A R I A B L E S
       // it is an error if varaibles coulr not be loaded, and will cause an error
@@ -599,6 +626,14 @@ int load_custom_library(PersistenceCustomLibs_e customLib, Pers_custom_functs_s
                  DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("load_custom_library - error:"), DLT_STRING(error));
             }
 
+            // optional vectored access, the single item functions are used if not available
+            *(void **) (&customFuncts->custom_plugin_get_data_multi) = dlsym(handle, "plugin_get_data_multi");
+            *(void **) (&customFuncts->custom_plugin_set_data_multi) = dlsym(handle, "plugin_set_data_multi");
+            // optional non blocking access, the synchronous functions are used if not available
+            *(void **) (&customFuncts->custom_plugin_get_data_async) = dlsym(handle, "plugin_get_data_async");
+            *(void **) (&customFuncts->custom_plugin_set_data_async) = dlsym(handle, "plugin_set_data_async");
+            (void)dlerror();
+
             //
             // initialize the library
             //
@@ -606,8 +641,10 @@ int load_custom_library(PersistenceCustomLibs_e customLib, Pers_custom_functs_s
             {
                if( (gPersCustomFuncs[customLib].custom_plugin_init) != NULL)
                {
+                  uint64_t start = plugin_stats_start();
+
                   DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("load_custom_library => (sync)  : "), DLT_STRING(get_custom_client_lib_name(customLib)));
-                  gPersCustomFuncs[customLib].custom_plugin_init();
+                  plugin_stats_add(customLib, PCL_PLUGIN_OP_INIT, start, gPersCustomFuncs[customLib].custom_plugin_init());
                }
                else
                {
@@ -620,10 +657,12 @@ int load_custom_library(PersistenceCustomLibs_e customLib, Pers_custom_functs_s
             {
                if( (gPersCustomFuncs[customLib].custom_plugin_init_async) != NULL)
                {
+                  uint64_t start = plugin_stats_start();
+
                   DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("load_custom_library => (async) : "),
                                           DLT_STRING(get_custom_client_lib_name(customLib)));
 
-                  gPersCustomFuncs[customLib].custom_plugin_init_async(gPlugin_callback_async_t);
+                  plugin_stats_add(customLib, PCL_PLUGIN_OP_INIT, start, gPersCustomFuncs[customLib].custom_plugin_init_async(gPlugin_callback_async_t));
                }
                else
                {
@@ -683,6 +722,29 @@ int check_valid_idx(int idx)
 }
 
 
+/* load the plugins of pclInitLibrary until all have been taken, executed by each loader thread */
+static void* custom_load_worker(void* dummy)
+{
+   int next = 0;
+
+   (void)dummy;
+
+   while((next = __sync_fetch_and_add(&gCustomLoadNext, 1)) < gCustomLoadCount)
+   {
+      int i = gCustomLoadIdx[next];
+
+      gCustomLoadResult[next] = load_custom_library((PersistenceCustomLibs_e)i, &gPersCustomFuncs[i]);
+      if(gCustomLoadResult[next] <= 0)
+      {
+         DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("load_custom_plugins => E r r o r could not load plugin: "),
+                              DLT_STRING(get_custom_client_lib_name(i)));
+      }
+   }
+   return NULL;
+}
+
+
+
 int load_custom_plugins(plugin_callback_async_t pfInitCompletedCB)
 {
    int rval = 0, i = 0;
@@ -695,26 +757,50 @@ int load_custom_plugins(plugin_callback_async_t pfInitCompletedCB)
       // initialize custom library structure
       for(i=0; i < PersCustomLib_LastEntry; i++)
       {
-         invalidate_custom_plugin(i);
+         if(i != PersCustomLib_default || gDefaultPluginLoaded == 0)
+         {
+            invalidate_custom_plugin(i);
+         }
       }
 
+      gCustomLoadCount = 0;
+      gCustomLoadNext  = 0;
       for(i=0; i < PersCustomLib_LastEntry; i++ )
       {
-         if(check_valid_idx(i) != -1)
+         if(check_valid_idx(i) != -1 && (i != PersCustomLib_default || gDefaultPluginLoaded == 0))
          {
             if(getCustomLoadingType(i) == LoadType_PclInit) // check if the plugin must be loaded on pclInitLibrary
             {
-               if((rval = load_custom_library(i, &gPersCustomFuncs[i] )) <= 0)
-               {
-                  DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("load_custom_plugins => E r r o r could not load plugin: "),
-                                       DLT_STRING(get_custom_client_lib_name(i)));
-               }
+               gCustomLoadIdx[gCustomLoadCount++] = i;
             }
          }
-         else
+      }
+
+      if(gCustomLoadCount > 0)
+      {
+         // the plugins are independent, load and initialize them in parallel,
+         // the calling thread is one of the loaders and pclInitLibrary returns when all are loaded
+         pthread_t loader[CustomLoaderThreads];
+         int numLoader = 0;
+
+         while(numLoader < CustomLoaderThreads - 1 && numLoader < gCustomLoadCount - 1)
+         {
+            if(pthread_create(&loader[numLoader], NULL, custom_load_worker, NULL) != 0)
+            {
+               DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("load_custom_plugins - Failed to start loader thread"));
+               break;
+            }
+            numLoader++;
+         }
+
+         (void)custom_load_worker(NULL);
+
+         for(i = 0; i < numLoader; i++)
          {
-            continue;
+            pthread_join(loader[i], NULL);
          }
+
+         rval = gCustomLoadResult[gCustomLoadCount-1];    // result of the last plugin, as if loaded one after another
       }
    }
    else
@@ -723,11 +809,137 @@ int load_custom_plugins(plugin_callback_async_t pfInitCompletedCB)
       rval = EPERS_COMMON;
    }
 
+   gDefaultPluginLoaded = 0;    // loaded again at the next pclInitLibrary
+
+   pthread_mutex_lock(&gCustomLoadMtx);
+   gCustomPluginsReady = 1;
+   pthread_cond_broadcast(&gCustomPluginsReadyCond);
+   pthread_mutex_unlock(&gCustomLoadMtx);
+
    return rval;
 }
 
 
+int load_default_plugin(void)
+{
+   int rval = 0;
+
+   gDefaultPluginLoaded = 0;
+   if(   get_custom_libraries() >= 0
+      && check_valid_idx(PersCustomLib_default) != -1
+      && getCustomLoadingType(PersCustomLib_default) == LoadType_PclInit)
+   {
+      invalidate_custom_plugin(PersCustomLib_default);
+      rval = load_custom_library(PersCustomLib_default, &gPersCustomFuncs[PersCustomLib_default]);
+      if(rval > 0)
+      {
+         gDefaultPluginLoaded = 1;
+      }
+   }
+   return rval;
+}
+
+
+
+void custom_client_resolve(PersistenceInfo_s* info, const char* key)
+{
+   info->customLibId = (int)custom_client_name_to_id(info->configKey.custom_name, 1);
+
+   if(info->configKey.customID[0] == '\0')   // if we have not a customID we use the key
+   {
+      snprintf(info->customKey, CUSTOM_KEY_SIZE, "0x%08X/%s/%s", info->context.ldbid, info->configKey.custom_name, key);
+   }
+   else
+   {
+      snprintf(info->customKey, CUSTOM_KEY_SIZE, "0x%08X/%s", info->context.ldbid, info->configKey.customID);
+   }
+}
+
+
+
+const Pers_custom_functs_s* custom_client_get_functs(PersistenceInfo_s* info, const char* key)
+{
+   const Pers_custom_functs_s* functs = NULL;
+
+   if(info->customKey[0] == '\0')
+   {
+      custom_client_resolve(info, key);
+   }
+
+   if(info->customLibId >= 0 && info->customLibId < PersCustomLib_LastEntry)
+   {
+      int idx = info->customLibId;
+
+      if(__sync_add_and_fetch(&gCustomPluginsReady, 0) == 0 && pthread_mutex_lock(&gCustomLoadMtx) == 0)
+      {
+         while(gCustomPluginsReady == 0)      // the plugins are still loaded by the asynchronous init
+            pthread_cond_wait(&gCustomPluginsReadyCond, &gCustomLoadMtx);
+         pthread_mutex_unlock(&gCustomLoadMtx);
+      }
+
+      // the handle is set before a preload has resolved the functions, only the flag shows a completed load
+      if(   getCustomLoadingType(idx) == LoadType_OnDemand
+         && __atomic_load_n(&gCustomPluginLoaded[idx], __ATOMIC_ACQUIRE) == 0
+         && pthread_mutex_lock(&gCustomLoadMtx) == 0)
+      {
+         if(gPersCustomFuncs[idx].handle == NULL)
+         {
+            (void)load_custom_library((PersistenceCustomLibs_e)idx, &gPersCustomFuncs[idx]);    // plugin not loaded yet
+         }
+         if(gPersCustomFuncs[idx].handle != NULL)
+         {
+            __atomic_store_n(&gCustomPluginLoaded[idx], 1, __ATOMIC_RELEASE);
+         }
+         pthread_mutex_unlock(&gCustomLoadMtx);
+      }
+      functs = &gPersCustomFuncs[idx];
+   }
+   return functs;
+}
+
+
+
+void set_custom_plugins_pending(void)
+{
+   pthread_mutex_lock(&gCustomLoadMtx);
+   gCustomPluginsReady = 0;
+   pthread_mutex_unlock(&gCustomLoadMtx);
+}
+
+
+
+void preload_custom_plugins(void)
+{
+   int i = 0;
+
+   for(i = 0; i < PersCustomLib_LastEntry; i++)
+   {
+      if(check_valid_idx(i) != -1 && getCustomLoadingType(i) == LoadType_OnDemand)
+      {
+         if(pthread_mutex_lock(&gCustomLoadMtx) == 0)
+         {
+            if(gPersCustomFuncs[i].handle == NULL)
+            {
+               if(load_custom_library((PersistenceCustomLibs_e)i, &gPersCustomFuncs[i]) <= 0)
+               {
+                  DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("preload_custom_plugins - could not load plugin:"),
+                                                        DLT_STRING(get_custom_client_lib_name(i)));
+               }
+            }
+            if(gPersCustomFuncs[i].handle != NULL)
+            {
+               __atomic_store_n(&gCustomPluginLoaded[i], 1, __ATOMIC_RELEASE);
+            }
+            pthread_mutex_unlock(&gCustomLoadMtx);
+         }
+      }
+   }
+}
+
+
+
 void invalidate_custom_plugin(int idx)
 {
+   __atomic_store_n(&gCustomPluginLoaded[idx], 0, __ATOMIC_RELEASE);
    memset(&gPersCustomFuncs[idx], 0, sizeof(Pers_custom_functs_s));
 }
@@ -139,6 +139,12 @@ signed int (*plugin_persComRctClose)(signed int handlerRCT) ;
 /// read a resourceID's configuration from RCT
 signed int (*plugin_persComRctRead)(signed int handlerRCT, char const * resourceID, PersistenceConfigurationKey_s const * psConfig_out) ;
 
+/// Find the buffer's size needed to accomodate the list of resourceIDs in RCT
+signed int (*plugin_persComRctGetSizeResourcesList)(signed int handlerRCT) ;
+
+/// Obtain the list of resourceIDs in RCT
+signed int (*plugin_persComRctGetResourcesList)(signed int handlerRCT, char* listBuffer_out, signed int listBufferSize) ;
+
 
 /**
  * @brief definition of async init callback function.
@@ -210,6 +216,18 @@ typedef struct _Pers_custom_functs_s
    /// sync all data
    int (*custom_plugin_sync)(void);
 
+   /// get the data of several resources, optional
+   int (*custom_plugin_get_data_multi)(plugin_item_s* items, int count);
+
+   /// set the data of several resources, optional
+   int (*custom_plugin_set_data_multi)(plugin_item_s* items, int count);
+
+   /// get data without blocking, optional
+   int (*custom_plugin_get_data_async)(const char* path, char* buffer, int size, plugin_callback_io_t pfDoneCB, void* user_data);
+
+   /// set data without blocking, optional
+   int (*custom_plugin_set_data_async)(const char* path, char* buffer, int size, plugin_callback_io_t pfDoneCB, void* user_data);
+
 
 }Pers_custom_functs_s;
 
@@ -279,6 +297,27 @@ int check_valid_idx(int idx);
 char* get_custom_client_lib_name(int idx);
 
 
+/**
+ * @brief resolve the custom plugin and the plugin key of a custom storage resource once,
+ *        the result is stored in the database context
+ *
+ * @param info the database context of the resource
+ * @param key the database key of the resource
+ */
+void custom_client_resolve(PersistenceInfo_s* info, const char* key);
+
+
+/**
+ * @brief get the function table of the custom plugin of a resource, the plugin will be loaded on demand
+ *
+ * @param info the database context of the resource, resolved if not yet done
+ * @param key the database key of the resource
+ *
+ * @return the function table or NULL if the plugin is not available
+ */
+const Pers_custom_functs_s* custom_client_get_functs(PersistenceInfo_s* info, const char* key);
+
+
 /**
  * @brief invalidate customer plugin function
  *
@@ -291,6 +330,8 @@ void invalidate_custom_plugin(int idx);
  * @brief load the custom plugins.
  *        The custom library configuration file will be loaded to see
  *        if there a re plugins that must be loaded in the pclInitLibrary function.
+ *        These plugins are loaded and initialized in parallel by up to ::CustomLoaderThreads threads,
+ *        the function returns when all of them have been loaded.
  *        The other plugins will be loaded on demand.
  *
  *
@@ -300,6 +341,30 @@ void invalidate_custom_plugin(int idx);
 int load_custom_plugins(plugin_callback_async_t pfInitCompletedCB);
 
 
+/**
+ * @brief load the default plugin (the database backend) if it must be loaded in the pclInitLibrary function.
+ *        Used by the asynchronous init, the local databases are accessed before the other plugins
+ *        have been loaded in the background. ::load_custom_plugins does not load it again.
+ *
+ * @return 1 if the plugin has been loaded, 0 if it is not loaded in pclInitLibrary,
+ *         a negative value if it could not be loaded
+ */
+int load_default_plugin(void);
+
+
+/**
+ * @brief the plugins will be loaded in the background by ::load_custom_plugins,
+ *        access to the plugins waits until they have been loaded
+ */
+void set_custom_plugins_pending(void);
+
+
+/**
+ * @brief load the on demand plugins which have not been loaded yet, see ::PCL_INIT_PRELOAD_PLUGINS
+ */
+void preload_custom_plugins(void);
+
+
 /**
  * @brief Get the custom loading type.
  *        The loading type is
@@ -34,6 +34,7 @@ extern "C" {
 #include <persComDataOrg.h>
 
 #include <string.h>
+#include <pthread.h>
 
 
 // define PERS_ORG_ROOT_PATH has been defined in persistence common object
@@ -43,6 +44,9 @@ extern "C" {
 /// write through path location
 #define WTPREFIX            PERS_ORG_ROOT_PATH "/mnt-wt/"
 
+/// size of the key passed to a custom storage plugin
+#define CUSTOM_KEY_SIZE     128
+
 
 /// structure used to manage database context
 typedef struct _PersistenceDbContext_s
@@ -62,6 +66,10 @@ typedef struct _PersistenceInfo_s
    PersistenceDbContext_s           context;
    /// Persistence resource configuration key
    PersistenceConfigurationKey_s    configKey;
+   /// custom plugin of a custom storage resource, see ::PersistenceCustomLibs_e
+   int                              customLibId;
+   /// key passed to the custom plugin, empty if the plugin has not been resolved
+   char                             customKey[CUSTOM_KEY_SIZE];
 
 } PersistenceInfo_s;
 
@@ -134,6 +142,8 @@ enum _PersistenceConstantDef
    Shutdown_MaxCount     = 3,
    /// lifecycle shutdown normal
    NsmShutdownNormal       = 1,
+   /// lifecycle shutdown fast
+   NsmShutdownFast         = 2,
    /// lifecycle return OK indicator
    NsmErrorStatus_OK       = 1,
    /// lifecycle return failed indicator
@@ -154,6 +164,51 @@ enum _PersistenceConstantDef
    RDRWBufferSize          = 1024,
    /// database table size
    DbTableSize             = 1024,
+   /// max size of all keys and values of the default databases held in the default value cache
+   DefaultCacheMaxSize     = 256 * 1024,
+   /// number of dirty keys in the write back cache that triggers a flush
+   KeyCacheDirtyMax        = 64,
+   /// size of the dirty data in the write back cache that triggers a flush
+   KeyCacheMaxDataSize     = 128 * 1024,
+   /// max time [ms] a dirty key stays in the write back cache
+   KeyCacheMaxAgeMs        = 2000,
+   /// size of the redo log of the write back cache that triggers closing the cached databases to truncate it
+   KeyCacheLogMaxSize      = 1024 * 1024,
+   /// max number of keys the write elision remembers the last written value of
+   WriteElisionMaxKeys     = 1024,
+   /// max number of values held in the value cache (pclKeyReadRef, pclUserPrefetch)
+   ValueRefMaxKeys         = 1024,
+   /// number of keys pclUserPrefetch loads before it releases the key API mutex
+   KeyPrefetchBatchSize    = 16,
+   /// size of a chunk of the key list of pclKeyIterate
+   KeyListChunkSize        = 4096,
+   /// number of slots of the shared cache segment of a shared database
+   SharedCacheSlots        = 512,
+   /// max size of a value stored in the shared cache
+   SharedCacheMaxDataSize  = 256,
+   /// number of attempts to lock a slot of the shared cache before the segment is invalidated
+   SharedCacheLockSpins    = 1000,
+   /// max number of notifications delivered locally, waiting for their own D-Bus signal
+   LocalNotifyMax          = 32,
+   /// max time [ms] pclDeinitLibrary waits for the completion of asynchronous plugin requests
+   CustomAsyncTimeoutMs    = 5000,
+   /// max number of threads loading the custom plugins in pclInitLibrary
+   CustomLoaderThreads     = 4,
+   /// max number of threads flushing and closing resources at shutdown
+   ShutdownFlushThreads    = 4,
+   /// time [ms] of the lifecycle timeout reserved for syncfs and the reply, not used for flushing
+   ShutdownDeadlineReserveMs = 500,
+   /// max number of resources with a flush priority (pclSetFlushPriority)
+   FlushPriorityMaxKeys    = 64,
+   /// max time [ms] the write back of the administration service waits for queued asynchronous writes,
+   /// and the shutdown waits for a running write back
+   PasWriteBackTimeoutMs   = 5000,
+   /// max number of keys read by the application stored in the warm start snapshot
+   WarmStartMaxKeys        = 128,
+   /// max size of a value stored in the warm start snapshot
+   WarmStartMaxValueSize   = 4096,
+   /// max size of the warm start snapshot
+   WarmStartMaxSize        = 256 * 1024,
    /// persistence administration service block access
    PasMsg_Block            = 0x0001,
    /// persistence administration service unblock access
@@ -304,6 +359,12 @@ extern int(* gChangeNotifyCallback)(pclNotification_s * notifyStruct);
 /// character lookup table used for parsing configuration files
 extern const char gCharLookup[] __attribute__ ((visibility ("hidden")));
 
+/// mutex to serialize the key API access
+extern pthread_mutex_t gKeyAPIAccessMtx __attribute__ ((visibility ("hidden")));
+
+/// mutex to serialize the file API access
+extern pthread_mutex_t gFileAccessMtx __attribute__ ((visibility ("hidden")));
+
 
 #ifdef __cplusplus
 }
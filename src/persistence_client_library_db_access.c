@@ -22,11 +22,20 @@
 #include "persistence_client_library_dbus_service.h"
 #include "persistence_client_library_prct_access.h"
 #include "persistence_client_library_tree_helper.h"
+#include "persistence_client_library_default_cache.h"
+#include "persistence_client_library_key_cache.h"
+#include "persistence_client_library_write_elision.h"
+#include "persistence_client_library_value_ref.h"
+#include "persistence_client_library_shared_cache.h"
+#include "persistence_client_library_plugin_stats.h"
+#include "persistence_client_library_flush.h"
+#include "persistence_client_library_warm_start.h"
 #include "crc32.h"
 
 #include <persComErrors.h>
 
 #include <errno.h>
+#include <pthread.h>
 #include <dlt.h>
 
 DLT_IMPORT_CONTEXT(gPclDLTContext);
@@ -35,19 +44,45 @@ DLT_IMPORT_CONTEXT(gPclDLTContext);
 
 /// btree array
 static int gHandlesDB[DbTableSize][PersistenceDB_LastEntry];
+/// state of the database handles: 0 not open, 1 open, 2 closing (a close still running must not be reused)
 static int gHandlesDBCreated[DbTableSize][PersistenceDB_LastEntry] = { {0} };
+/// flush priority of the databases, the highest priority of the resources written
+static int gHandlesDBPrio[DbTableSize][PersistenceDB_LastEntry];
 
 /// tree to store notification information
 static jsw_rbtree_t *gNotificationTree = NULL;
+/// mutex protecting the notification tree, registrations and writes may use different API mutexes
+static pthread_mutex_t gNotificationMtx = PTHREAD_MUTEX_INITIALIZER;
+
+/// default value cache, same index as the database handles
+static PersDefaultCache_s* gDefaultCache[DbTableSize] = {NULL};
+/// state of the default value cache: 0 not loaded, 1 loaded, -1 defaults can't be cached
+static int gDefaultCacheState[DbTableSize] = {0};
 
 
 void deleteNotifyTree(void)
 {
+   pthread_mutex_lock(&gNotificationMtx);
    if(gNotificationTree != NULL)
    {
       jsw_rbdelete(gNotificationTree);
       gNotificationTree = NULL;
    }
+   pthread_mutex_unlock(&gNotificationMtx);
+}
+
+
+
+/* hash of a notification registration, the D-Bus match rule contains the ldbid, user and seat too */
+static unsigned int notify_hash(const char* dbKey, unsigned int ldbid, unsigned int user_no, unsigned int seat_no)
+{
+   unsigned int context[3];
+
+   context[0] = ldbid;
+   context[1] = user_no;
+   context[2] = seat_no;
+
+   return pclCrc32(pclCrc32(0, (unsigned char*)context, sizeof(context)), (const unsigned char*)dbKey, strlen(dbKey));
 }
 
 
@@ -99,6 +134,7 @@ static int database_get(PersistenceInfo_s* info, const char* dbPath, int dbType)
                {
                   gHandlesDB[arrayIdx][dbType] = handleDB ;
                   gHandlesDBCreated[arrayIdx][dbType] = 1;
+                  gHandlesDBPrio[arrayIdx][dbType] = PCL_FLUSH_PRIO_NORMAL;
                }
                else
                {
@@ -116,230 +152,1000 @@ static int database_get(PersistenceInfo_s* info, const char* dbPath, int dbType)
             DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("dbGet - wrong policy! Cannot extend dbPath wit db."));
          }
       }
+      else if(gHandlesDBCreated[arrayIdx][dbType] == 2)
+      {
+         // the close started at shutdown has not finished, the handle may be invalid at any time
+         DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("dbGet - database still closing"), DLT_UINT(arrayIdx), DLT_INT(dbType));
+         handleDB = EPERS_LOCKFS;
+      }
       else
       {
-         handleDB = gHandlesDB[arrayIdx][dbType];
+         handleDB = gHandlesDB[arrayIdx][dbType];
+      }
+   }
+   else
+   {
+      DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("dbGet - inval storage type"), DLT_STRING(dbPath));
+   }
+   return handleDB;
+}
+
+
+/* local keys with the policy cached are written back by the key cache, shared keys must be written immediately */
+static int is_write_back_key(const PersistenceInfo_s* info)
+{
+   return (   (PersistenceStorage_local == info->configKey.storage)
+           && (PersistencePolicy_wc == info->configKey.policy) );
+}
+
+
+
+static void default_cache_invalidate(unsigned int arrayIdx)
+{
+   if(arrayIdx < DbTableSize)
+   {
+      default_cache_destroy(gDefaultCache[arrayIdx]);
+      gDefaultCache[arrayIdx] = NULL;
+      gDefaultCacheState[arrayIdx] = 0;
+   }
+}
+
+
+
+static const PersDefaultCache_s* default_cache_get(PersistenceInfo_s* info, const char* dbPath)
+{
+   const PersDefaultCache_s* cache = NULL;
+   unsigned int arrayIdx = info->configKey.storage + info->context.ldbid;
+
+   if(arrayIdx < DbTableSize)
+   {
+      if(gDefaultCacheState[arrayIdx] == 0)     // load both default databases at first use
+      {
+         int handleConfDefault = database_get(info, dbPath, PersistenceDB_confdefault);
+         int handleFactoryDefault = database_get(info, dbPath, PersistenceDB_default);
+
+         gDefaultCache[arrayIdx] = default_cache_create(handleConfDefault, handleFactoryDefault, DefaultCacheMaxSize);
+         if(gDefaultCache[arrayIdx] != NULL)
+         {
+            gDefaultCacheState[arrayIdx] = 1;
+         }
+         else
+         {
+            DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("getDefaults - defaults not cached:"), DLT_STRING(dbPath));
+            gDefaultCacheState[arrayIdx] = -1;
+         }
+      }
+      cache = gDefaultCache[arrayIdx];
+   }
+   return cache;
+}
+
+
+
+int pers_get_defaults(char* dbPath, char* key, PersistenceInfo_s* info, unsigned char* buffer, unsigned int buffer_size, PersGetDefault_e job)
+{
+   PersDefaultType_e i = PersDefaultType_Configurable;
+   int handleDefaultDB = -1, read_size = EPERS_NOKEY, cached = 0;
+   char dltMessage[PERS_ORG_MAX_LENGTH_PATH_FILENAME] = {0};
+   const PersDefaultCache_s* cache = default_cache_get(info, dbPath);
+
+   if(cache != NULL)
+   {
+      const char* data = NULL;
+      int size = default_cache_find(cache, key, &data);
+
+      if(size < 0 || PersGetDefault_Size == job)
+      {
+         read_size = size;       // no default value available or only the size is requested
+         cached = 1;
+      }
+      else if(PersGetDefault_Data == job && (unsigned int)size <= buffer_size)
+      {
+         memcpy(buffer, data, (size_t)size);
+         read_size = size;
+         cached = 1;
+      }
+      // otherwise the buffer is too small, the database decides what to return
+   }
+
+   for(i=(int)PersistenceDB_confdefault; i<(int)PersistenceDB_LastEntry && cached == 0; i++)
+   {
+   	handleDefaultDB = database_get(info, dbPath, i);
+      if(handleDefaultDB >= 0)
+      {
+         if (PersGetDefault_Data == job)
+         {
+            if(*plugin_persComDbReadKey != NULL)
+               read_size = plugin_persComDbReadKey(handleDefaultDB, key, (char*)buffer, (signed int)buffer_size);
+            else
+            {
+               DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("getDefaults - EPERS_NO_PLUGIN_FUNCT"));
+               read_size = EPERS_NO_PLUGIN_FUNCT;
+            }
+         }
+         else if (PersGetDefault_Size == job)
+         {
+            if(*plugin_persComDbGetKeySize != NULL)
+               read_size = plugin_persComDbGetKeySize(handleDefaultDB, key);
+            else
+            {
+               DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("getDefaults - EPERS_NO_PLUGIN_FUNCT"));
+               read_size = EPERS_NO_PLUGIN_FUNCT;
+            }
+         }
+         else
+         {
+            DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("getDefaults - unknown job"));
+            break;
+         }
+
+         if(read_size < 0) // check read_size
+         {
+            if(PERS_COM_ERR_NOT_FOUND == read_size)
+            {
+               read_size = EPERS_NOKEY;
+            }
+         }
+         else /* read_size >= 0 --> default value found */
+         {
+            if (PersDefaultType_Configurable == i)
+            {
+               snprintf(dltMessage, PERS_ORG_MAX_LENGTH_PATH_FILENAME, "%s%s", dbPath, plugin_gLocalConfigurableDefault);
+            }
+            if (PersDefaultType_Factory == i)
+            {
+                snprintf(dltMessage, PERS_ORG_MAX_LENGTH_PATH_FILENAME, "%s%s", dbPath, plugin_gLocalFactoryDefault);
+            }
+            DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("getDefaults - default data will be used for Key"), DLT_STRING(key),
+                                                  DLT_STRING("from"), DLT_STRING(dltMessage));
+            break;
+         }
+      }
+   }
+
+   if (read_size < 0 && cached == 0)
+   {
+       DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("getDefaults - default data not available for Key"), DLT_STRING(key),
+                                             DLT_STRING("Path:"), DLT_STRING(dbPath));
+   }
+
+   return read_size;
+}
+
+
+
+void database_preopen_local(void)
+{
+   PersistenceInfo_s info;
+   char dbPath[PERS_ORG_MAX_LENGTH_PATH_FILENAME] = {0};
+
+   if(open_resource_cfg_table(PCL_LDBID_LOCAL) < 0)
+   {
+      DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("dbPreopen - no local RCT for:"), DLT_STRING(gAppId));
+   }
+
+   memset(&info, 0, sizeof(PersistenceInfo_s));
+   info.context.ldbid = PCL_LDBID_LOCAL;
+   info.configKey.storage = PersistenceStorage_local;
+
+   snprintf(dbPath, PERS_ORG_MAX_LENGTH_PATH_FILENAME, getLocalWtPath(), gAppId);
+   (void)database_get(&info, dbPath, PersistencePolicy_wt);
+
+   // the cached and the default databases are located in the cache folder
+   snprintf(dbPath, PERS_ORG_MAX_LENGTH_PATH_FILENAME, getLocalCachePath(), gAppId);
+   (void)database_get(&info, dbPath, PersistencePolicy_wc);
+   (void)database_get(&info, dbPath, PersistenceDB_confdefault);
+   (void)database_get(&info, dbPath, PersistenceDB_default);
+}
+
+
+
+void database_get_local_path(int dbType, char* path)
+{
+   switch(dbType)    // same names as used by database_get
+   {
+   case PersistencePolicy_wt:
+      snprintf(path, PERS_ORG_MAX_LENGTH_PATH_FILENAME, WTPREFIX "%s%s", gAppId, plugin_gLocalWt);
+      break;
+   case PersistencePolicy_wc:
+      snprintf(path, PERS_ORG_MAX_LENGTH_PATH_FILENAME, CACHEPREFIX "%s%s", gAppId, plugin_gLocalCached);
+      break;
+   case PersistenceDB_confdefault:
+      snprintf(path, PERS_ORG_MAX_LENGTH_PATH_FILENAME, CACHEPREFIX "%s%s", gAppId, plugin_gLocalConfigurableDefault);
+      break;
+   case PersistenceDB_default:
+      snprintf(path, PERS_ORG_MAX_LENGTH_PATH_FILENAME, CACHEPREFIX "%s%s", gAppId, plugin_gLocalFactoryDefault);
+      break;
+   default:
+      path[0] = '\0';
+      break;
+   }
+}
+
+
+
+/* close the database handle of a flush job, arg is the table index * PersistenceDB_LastEntry + the db type */
+static int database_close_job(int arg)
+{
+   int i = arg / PersistenceDB_LastEntry, j = arg % PersistenceDB_LastEntry;
+   int iErrorCode = plugin_persComDbClose(gHandlesDB[i][j]);
+
+   if (iErrorCode < 0)
+   {
+      DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("dbCloseAll - Err close db"), DLT_INT(i), DLT_INT(j));
+   }
+   return iErrorCode;
+}
+
+
+
+/* close the resource configuration table of a flush job */
+static int rct_close_job(int idx)
+{
+   int rval = plugin_persComRctClose(get_resource_cfg_table_by_idx(idx));
+
+   if(rval != 0)
+   {
+      DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("prepShtdwn - Close db => index:"), DLT_INT(idx));
+   }
+
+   return rval;
+}
+
+
+
+/* update the handle state of a finished close job, the jobs don't touch the state themselves */
+static void close_job_finished(const FlushJob_s* job)
+{
+   if(job->func == database_close_job)
+   {
+      // a database which could not be closed is still open
+      gHandlesDBCreated[job->arg / PersistenceDB_LastEntry][job->arg % PersistenceDB_LastEntry] = (job->result < 0) ? 1 : 0;
+   }
+   else if(job->func == rct_close_job)
+   {
+      invalidate_resource_cfg_table(job->arg);
+   }
+}
+
+
+
+void database_close_finished(const FlushJob_s* jobs, int count)
+{
+   int i = 0;
+
+   for(i = 0; i < count; i++)
+   {
+      if(jobs[i].state == FlushJob_Done)
+      {
+         close_job_finished(&jobs[i]);
+      }
+   }
+}
+
+
+
+/* close immediately if the close can't be added to the plan */
+static int close_job_now(int (*func)(int), int arg)
+{
+   FlushJob_s job;
+
+   job.func   = func;
+   job.arg    = arg;
+   job.result = func(arg);
+   close_job_finished(&job);
+
+   return job.result;
+}
+
+
+
+int database_plan_close_all(FlushPlan_s* plan)
+{
+   int i = 0, j = 0, failed = 0;
+
+   write_elision_clear();                            // handles will be reused, databases may change while closed
+   value_ref_clear();
+   warm_start_release();
+
+   for(i=0; i< PrctDbTableSize; i++)      // close all open persistence resource configuration tables
+   {
+   	if(get_resource_cfg_table_by_idx(i) == -1)
+   	{
+   	   invalidate_resource_cfg_table(i);   // release a mapped index image, there is no RCT handle
+   	}
+   	else if(*plugin_persComRctClose == NULL)
+   	{
+   	   DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("prepShtdwn - No plugin function available"));
+   	}
+   	else if(flush_plan_add(plan, rct_close_job, i, "rct", PCL_FLUSH_PRIO_LOW) != 0)   // read only, nothing to flush
+   	{
+   	   failed += (close_job_now(rct_close_job, i) != 0) ? 1 : 0;
+   	}
+   	else
+   	{
+   	   close_resource_cfg_table_begin(i);
+   	}
+   }
+
+   for(i=0; i<DbTableSize; i++)
+   {
+      default_cache_invalidate((unsigned int)i);     // the default databases may change while closed
+
+   	for(j=0; j < PersistenceDB_LastEntry; j++)
+   	{
+			if(gHandlesDBCreated[i][j] != 1)
+			{
+			   continue;
+			}
+			if(*plugin_persComDbClose == NULL)
+			{
+			   DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("dbCloseAll - plugin function NULL"));
+			}
+			else if(flush_plan_add(plan, database_close_job, i * PersistenceDB_LastEntry + j, "db", gHandlesDBPrio[i][j]) != 0)
+			{
+			   failed += (close_job_now(database_close_job, i * PersistenceDB_LastEntry + j) < 0) ? 1 : 0;
+			}
+			else
+			{
+			   gHandlesDBCreated[i][j] = 2;
+			}
+   	}
+   }
+
+   return failed;
+}
+
+
+
+/* get the default value of a custom storage resource the plugin has no data for, returns read_size if there is none */
+static int custom_get_defaults(char* dbPath, char* key, const char* resourceID, PersistenceInfo_s* info,
+                               unsigned char* buffer, int buffer_size, int read_size)
+{
+   int ret_defaults = -1;
+
+   info->configKey.policy = PersistencePolicy_wc;			 // Set the policy
+   info->configKey.type   = PersistenceResourceType_key;  // Set the type
+
+   (void)get_db_path_and_key(info, key, NULL, dbPath);
+
+   DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("getData - Plugin data not available - get default data of key:"), DLT_STRING(key));
+   ret_defaults = pers_get_defaults(dbPath, (char*)resourceID, info, buffer, (unsigned int)buffer_size, PersGetDefault_Data);
+   if (0 < ret_defaults)
+   {
+      read_size = ret_defaults;
+   }
+   return read_size;
+}
+
+
+
+int persistence_get_data(char* dbPath, char* key, const char* resourceID, PersistenceInfo_s* info, unsigned char* buffer, int buffer_size)
+{
+   int read_size = -1;
+
+   if(   PersistenceStorage_local == info->configKey.storage
+      && warm_start_read(info->configKey.policy, key, buffer, buffer_size, &read_size) == 1)
+   {
+      warm_start_record(info, key, resourceID);       // served from the warm start snapshot, no database access
+   }
+   else if(   PersistenceStorage_shared == info->configKey.storage
+           || PersistenceStorage_local == info->configKey.storage)
+   {
+      int handleDB = database_get(info, dbPath, info->configKey.policy);
+      if(handleDB >= 0)
+      {
+         if(*plugin_persComDbReadKey != NULL)
+         {
+            read_size = EPERS_NOKEY;
+            if(is_write_back_key(info))
+            {
+               read_size = key_cache_read(handleDB, key, (char*)buffer, buffer_size);
+            }
+
+            if(read_size == EPERS_NOKEY && PersistenceStorage_local == info->configKey.storage)
+            {
+               const unsigned char* value = NULL;
+
+               read_size = value_ref_find(handleDB, key, &value);     // cached by pclKeyReadRef or pclUserPrefetch
+               if(read_size >= 0)
+               {
+                  if(read_size > buffer_size)
+                     read_size = buffer_size;
+                  memcpy(buffer, value, (size_t)read_size);
+                  (void)value_ref_release(value);
+               }
+            }
+
+            if(read_size == EPERS_NOKEY && PersistenceStorage_shared == info->configKey.storage)
+            {
+               read_size = shared_cache_read(info->context.ldbid, info->configKey.policy, key, buffer, buffer_size);
+            }
+
+            if(read_size == EPERS_NOKEY)
+            {
+               read_size = plugin_persComDbReadKey(handleDB, key, (char*)buffer, buffer_size);
+            }
+
+            if(read_size < 0)
+            {
+               read_size = pers_get_defaults(dbPath, (char*)resourceID, info, buffer, (unsigned int)buffer_size, PersGetDefault_Data); /* 0 ==> Get data */
+            }
+
+            if(PersistenceStorage_local == info->configKey.storage && (read_size >= 0 || read_size == EPERS_NOKEY))
+            {
+               warm_start_record(info, key, resourceID);
+            }
+         }
+         else
+         {
+            DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("getData - EPERS_NO_PLUGIN_FUNCT"));
+            read_size = EPERS_NO_PLUGIN_FUNCT;
+         }
+      }
+   }
+   else if(PersistenceStorage_custom == info->configKey.storage)   // custom storage implementation via custom library
+   {
+      const Pers_custom_functs_s* functs = custom_client_get_functs(info, key);
+
+      if(functs != NULL && functs->custom_plugin_get_data != NULL)
+      {
+         uint64_t start = plugin_stats_start();
+         read_size = functs->custom_plugin_get_data(info->customKey, (char*)buffer, buffer_size);
+         plugin_stats_add(info->customLibId, PCL_PLUGIN_OP_GET, start, read_size);
+      }
+      else
+      {
+         read_size = EPERS_NOPLUGINFUNCT;
+      }
+
+      if (1 > read_size) // Try to get default values
+      {
+         read_size = custom_get_defaults(dbPath, key, resourceID, info, buffer, buffer_size, read_size);
+      }
+   }
+   return read_size;
+}
+
+
+
+int persistence_get_data_ref(char* dbPath, char* key, const char* resourceID, PersistenceInfo_s* info, const unsigned char** data)
+{
+   int read_size = EPERS_NOKEY;
+   int handleDB = -1;
+
+   // shared keys can be changed by other applications, only values of local keys are cached
+   if(PersistenceStorage_local == info->configKey.storage)
+   {
+      handleDB = database_get(info, dbPath, info->configKey.policy);
+      if(handleDB >= 0)
+      {
+         read_size = value_ref_find(handleDB, key, data);
+      }
+   }
+
+   if(read_size == EPERS_NOKEY)
+   {
+      read_size = persistence_get_data_size(dbPath, key, resourceID, info);
+      if(read_size >= 0)
+      {
+         unsigned char* value = value_ref_create(read_size);
+
+         if(value != NULL)
+         {
+            read_size = persistence_get_data(dbPath, key, resourceID, info, value, read_size);
+            if(read_size >= 0)
+            {
+               value_ref_set_size(value, read_size);
+               if(handleDB >= 0)
+               {
+                  (void)value_ref_insert(handleDB, key, value);
+               }
+               *data = value;
+            }
+            else
+            {
+               (void)value_ref_release(value);
+            }
+         }
+         else
+         {
+            read_size = EPERS_DESER_ALLOCMEM;
+         }
+      }
+   }
+
+   return read_size;
+}
+
+
+
+/* get the '\0' separated key list of a database, the list must be released with free */
+static int database_get_keys(int handleDB, char** keys)
+{
+   int listSize = 0;
+
+   *keys = NULL;
+
+   if(*plugin_persComDbGetSizeKeysList == NULL || *plugin_persComDbGetKeysList == NULL)
+   {
+      listSize = EPERS_NO_PLUGIN_FUNCT;
+   }
+   else if(handleDB >= 0)
+   {
+      listSize = plugin_persComDbGetSizeKeysList(handleDB);
+      if(listSize > 0)
+      {
+         *keys = malloc((size_t)listSize + 1);
+         if(*keys == NULL)
+         {
+            listSize = EPERS_DESER_ALLOCMEM;
+         }
+         else if(plugin_persComDbGetKeysList(handleDB, *keys, listSize) < 0)
+         {
+            DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("dbGetKeys - Failed to get key list"));
+            listSize = EPERS_DB_ERROR_INTERNAL;
+         }
+         else
+         {
+            (*keys)[listSize] = '\0';
+         }
+      }
+      else if(listSize < 0 && listSize != PERS_COM_ERR_NOT_FOUND)
+      {
+         listSize = EPERS_DB_ERROR_INTERNAL;
+      }
+      else
+      {
+         listSize = 0;    // empty database
+      }
+   }
+   return listSize;
+}
+
+
+
+/* append a resource ID to a key list, returns the last chunk of the list */
+static PersKeyListChunk_s* key_list_append(PersKeyListChunk_s** list, PersKeyListChunk_s* last, const char* name)
+{
+   size_t length = strlen(name) + 1;
+
+   if(last == NULL || last->used + length > KeyListChunkSize)
+   {
+      PersKeyListChunk_s* chunk = malloc(sizeof(PersKeyListChunk_s));
+
+      if(chunk != NULL)
+      {
+         chunk->next = NULL;
+         chunk->used = 0;
+         if(last != NULL)
+            last->next = chunk;
+         else
+            *list = chunk;
+      }
+      last = chunk;
+   }
+
+   if(last != NULL)
+   {
+      memcpy(&last->names[last->used], name, length);
+      last->used += (unsigned int)length;
+   }
+   return last;
+}
+
+
+
+int persistence_get_key_list(PersistenceInfo_s* info, const char* prefix, PersKeyListChunk_s** list)
+{
+   int count = 0, i = 0;
+   PersKeyListChunk_s* last = *list;
+   static const int policies[] = { PersistencePolicy_wc, PersistencePolicy_wt };
+
+   while(last != NULL && last->next != NULL)
+      last = last->next;
+
+   for(i = 0; i < (int)(sizeof(policies) / sizeof(policies[0])) && count >= 0; i++)
+   {
+      char nsKey[PERS_DB_MAX_LENGTH_KEY_NAME] = {0};       // namespace of the keys, e.g. "/node/"
+      char dbPath[PERS_ORG_MAX_LENGTH_PATH_FILENAME] = {0};
+      char seatNs[PERS_DB_MAX_LENGTH_KEY_NAME] = {0};      // namespace of the seat keys inside of a user namespace
+      size_t nsLength = 0, prefixLength = strlen(prefix);
+      int handleDB = -1, listSize = 0;
+      char* keys = NULL;
+
+      info->configKey.policy = (PersistencePolicy_e)policies[i];
+      info->configKey.type   = PersistenceResourceType_key;
+      info->configKey.storage = (PersistenceStorage_e)get_db_path_and_key(info, "", nsKey, dbPath);
+      nsLength = strlen(nsKey);
+
+      if(info->context.seat_no == 0 && info->context.user_no != 0)
+      {
+         snprintf(seatNs, PERS_DB_MAX_LENGTH_KEY_NAME, "%s%s", nsKey, plugin_gSeat + 1);   // e.g. "/user/3/seat/"
+      }
+
+      handleDB = database_get(info, dbPath, policies[i]);
+      listSize = database_get_keys(handleDB, &keys);
+      if(listSize > 0)
+      {
+         int k = 0;
+
+         for(k = 0; k < listSize && count >= 0; k += (int)strlen(&keys[k]) + 1)
+         {
+            const char* key = &keys[k];
+
+            if(   strncmp(key, nsKey, nsLength) == 0
+               && strncmp(key + nsLength, prefix, prefixLength) == 0
+               && (seatNs[0] == '\0' || strncmp(key, seatNs, strlen(seatNs)) != 0))
+            {
+               last = key_list_append(list, last, key + nsLength);
+               count = (last != NULL) ? count + 1 : EPERS_DESER_ALLOCMEM;
+            }
+         }
+      }
+      else if(listSize < 0)
+      {
+         count = listSize;
+      }
+      free(keys);
+   }
+
+   return count;
+}
+
+
+
+int persistence_delete_user(PersistenceInfo_s* info)
+{
+   int count = 0, i = 0;
+   static const int policies[] = { PersistencePolicy_wc, PersistencePolicy_wt };
+
+   if(*plugin_persComDbDeleteKey == NULL)
+   {
+      return EPERS_NO_PLUGIN_FUNCT;
+   }
+
+   warm_start_invalidate_all();     // the snapshot may hold values of the user
+
+   for(i = 0; i < (int)(sizeof(policies) / sizeof(policies[0])) && count >= 0; i++)
+   {
+      char nsKey[PERS_DB_MAX_LENGTH_KEY_NAME] = {0};       // namespace of the user, e.g. "/user/3/"
+      char dbPath[PERS_ORG_MAX_LENGTH_PATH_FILENAME] = {0};
+      char cachePath[PERS_ORG_MAX_LENGTH_PATH_FILENAME] = {0};
+      char* keys = NULL;
+      int handleDB = -1, listSize = 0;
+      size_t nsLength = 0;
+
+      info->configKey.policy = (PersistencePolicy_e)policies[i];
+      info->configKey.type   = PersistenceResourceType_key;
+      info->configKey.storage = (PersistenceStorage_e)get_db_path_and_key(info, "", nsKey, dbPath);
+      nsLength = strlen(nsKey);
+
+      if(is_write_back_key(info))
+      {
+         snprintf(cachePath, PERS_ORG_MAX_LENGTH_PATH_FILENAME, "%s%s", dbPath, plugin_gLocalCached);
+      }
+
+      handleDB = database_get(info, dbPath, policies[i]);
+      listSize = database_get_keys(handleDB, &keys);
+      if(listSize > 0)
+      {
+         int k = 0;
+
+         // the seat keys of the user are in the user namespace too
+         for(k = 0; k < listSize && count >= 0; k += (int)strlen(&keys[k]) + 1)
+         {
+            const char* key = &keys[k];
+
+            if(strncmp(key, nsKey, nsLength) == 0)
+            {
+               if(cachePath[0] != '\0')
+               {
+                  // logged, otherwise a write of the user would be replayed after a crash
+                  (void)key_cache_delete(cachePath, handleDB, key);
+               }
+               write_elision_remove(handleDB, key);
+               value_ref_invalidate(handleDB, key);
+
+               if(plugin_persComDbDeleteKey(handleDB, key) >= 0)
+               {
+                  count++;
+               }
+               else
+               {
+                  DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("deleteUser - failed: "), DLT_STRING(key));
+                  count = EPERS_DB_ERROR_INTERNAL;
+               }
+            }
+         }
+      }
+      else if(listSize < 0)
+      {
+         count = listSize;
+      }
+      free(keys);
+   }
+
+   if(count > 0 && PersistenceStorage_shared == info->configKey.storage)
+   {
+      shared_cache_invalidate(info->context.ldbid);
+
+      // one notification for all deleted keys, the resource ID is empty
+      (void)pers_send_Notification_Signal("", NULL, &info->context, pclNotifyStatus_deleted);
+   }
+
+   return count;
+}
+
+
+
+int persistence_prefetch_keys(PersistenceInfo_s* info, int policy, PersKeyListChunk_s** list)
+{
+   int count = 0, listSize = 0, handleDB = -1;
+   char nsKey[PERS_DB_MAX_LENGTH_KEY_NAME] = {0};       // namespace of the user, e.g. "/user/3/seat/2/"
+   char dbPath[PERS_ORG_MAX_LENGTH_PATH_FILENAME] = {0};
+   char seatNs[PERS_DB_MAX_LENGTH_KEY_NAME] = {0};
+   char* keys = NULL;
+   size_t nsLength = 0;
+   PersKeyListChunk_s* last = *list;
+
+   if(*plugin_persComDbGetKeySize == NULL || *plugin_persComDbReadKey == NULL)
+   {
+      return EPERS_NO_PLUGIN_FUNCT;
+   }
+
+   while(last != NULL && last->next != NULL)
+      last = last->next;
+
+   info->configKey.policy = (PersistencePolicy_e)policy;
+   info->configKey.type   = PersistenceResourceType_key;
+   info->configKey.storage = (PersistenceStorage_e)get_db_path_and_key(info, "", nsKey, dbPath);
+   nsLength = strlen(nsKey);
+
+   if(info->context.seat_no == 0 && info->context.user_no != 0)
+   {
+      snprintf(seatNs, PERS_DB_MAX_LENGTH_KEY_NAME, "%s%s", nsKey, plugin_gSeat + 1);   // e.g. "/user/3/seat/"
+   }
+
+   if(PersistencePolicy_wc == policy)
+   {
+      (void)default_cache_get(info, dbPath);   // load the default values too
+   }
+
+   handleDB = database_get(info, dbPath, policy);
+   listSize = database_get_keys(handleDB, &keys);
+   if(listSize > 0)
+   {
+      int k = 0;
+
+      for(k = 0; k < listSize && count >= 0; k += (int)strlen(&keys[k]) + 1)
+      {
+         const char* key = &keys[k];
+
+         if(   strncmp(key, nsKey, nsLength) == 0
+            && (seatNs[0] == '\0' || strncmp(key, seatNs, strlen(seatNs)) != 0))
+         {
+            last = key_list_append(list, last, key);
+            count = (last != NULL) ? count + 1 : EPERS_DESER_ALLOCMEM;
+         }
+      }
+   }
+   else if(listSize < 0)
+   {
+      count = listSize;
+   }
+   free(keys);
+
+   return count;
+}
+
+
+
+int persistence_prefetch_key(PersistenceInfo_s* info, int policy, const char* key)
+{
+   int rval = 0, handleDB = -1;
+   char nsKey[PERS_DB_MAX_LENGTH_KEY_NAME] = {0};
+   char dbPath[PERS_ORG_MAX_LENGTH_PATH_FILENAME] = {0};
+
+   info->configKey.policy = (PersistencePolicy_e)policy;
+   info->configKey.type   = PersistenceResourceType_key;
+   info->configKey.storage = (PersistenceStorage_e)get_db_path_and_key(info, "", nsKey, dbPath);
+
+   // the handle may have changed since the key list has been taken, the databases are closed at shutdown
+   handleDB = database_get(info, dbPath, policy);
+   if(handleDB < 0)
+   {
+      rval = handleDB;
+   }
+   else if(value_ref_contains(handleDB, key) == 0
+        && (is_write_back_key(info) == 0 || key_cache_get_size(handleDB, key) == EPERS_NOKEY))   // the database has an old value
+   {
+      int size = plugin_persComDbGetKeySize(handleDB, key);
+      unsigned char* value = (size >= 0) ? value_ref_create(size) : NULL;
+
+      if(value != NULL)
+      {
+         if(plugin_persComDbReadKey(handleDB, key, (char*)value, size) == size)
+         {
+            rval = value_ref_insert(handleDB, key, value);
+         }
+         (void)value_ref_release(value);
+      }
+   }
+
+   return rval;
+}
+
+
+
+void persistence_free_key_list(PersKeyListChunk_s* list)
+{
+   while(list != NULL)
+   {
+      PersKeyListChunk_s* next = list->next;
+
+      free(list);
+      list = next;
+   }
+}
+
+
+
+void persistence_custom_item_done(PersCustomItem_s* item, int write)
+{
+   if(write == 0 && 1 > item->result)
+   {
+      item->result = custom_get_defaults(item->dbPath, item->dbKey, item->resource_id, &item->info,
+                                         item->buffer, item->size, item->result);
+   }
+   else if(write == 1 && 0 < item->result && item->result == item->size)
+   {
+      int rval = pers_send_Notification_Signal(item->resource_id, item->dbKey, &item->info.context, pclNotifyStatus_changed);
+      if(rval <= 0)
+      {
+         DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("customItemDone - Err send noty sig"));
+         item->result = rval;
       }
    }
-   else
+}
+
+
+
+int persistence_custom_start_async(PersCustomItem_s* item, int write, plugin_callback_io_t callback, void* user_data)
+{
+   int rval = EPERS_NOPLUGINFUNCT;
+   const Pers_custom_functs_s* functs = custom_client_get_functs(&item->info, item->dbKey);
+
+   if(functs != NULL)
    {
-      DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("dbGet - inval storage type"), DLT_STRING(dbPath));
+      if(write == 1 && functs->custom_plugin_set_data_async != NULL)
+      {
+         rval = functs->custom_plugin_set_data_async(item->info.customKey, (char*)item->buffer, item->size, callback, user_data);
+      }
+      else if(write == 0 && functs->custom_plugin_get_data_async != NULL)
+      {
+         rval = functs->custom_plugin_get_data_async(item->info.customKey, (char*)item->buffer, item->size, callback, user_data);
+      }
    }
-   return handleDB;
+   return rval;
 }
 
 
-int pers_get_defaults(char* dbPath, char* key, PersistenceInfo_s* info, unsigned char* buffer, unsigned int buffer_size, PersGetDefault_e job)
+
+/* access custom storage items, the items of a plugin supporting vectored access are passed with one call */
+static void custom_access_multi(PersCustomItem_s* items, int count, int write)
 {
-   PersDefaultType_e i = PersDefaultType_Configurable;
-   int handleDefaultDB = -1, read_size = EPERS_NOKEY;
-   char dltMessage[PERS_ORG_MAX_LENGTH_PATH_FILENAME] = {0};
+   int i = 0, lib = 0;
+   char* done = calloc((size_t)count, 1);
+   plugin_item_s* pluginItems = malloc((size_t)count * sizeof(plugin_item_s));
+   int* itemIdx = malloc((size_t)count * sizeof(int));
 
-   for(i=(int)PersistenceDB_confdefault; i<(int)PersistenceDB_LastEntry; i++)
+   for(lib = 0; lib < PersCustomLib_LastEntry && done != NULL && pluginItems != NULL && itemIdx != NULL; lib++)
    {
-   	handleDefaultDB = database_get(info, dbPath, i);
-      if(handleDefaultDB >= 0)
+      int (*multi)(plugin_item_s* items, int count) = NULL;
+      int n = 0;
+
+      for(i = 0; i < count; i++)
       {
-         if (PersGetDefault_Data == job)
-         {
-            if(*plugin_persComDbReadKey != NULL)
-               read_size = plugin_persComDbReadKey(handleDefaultDB, key, (char*)buffer, (signed int)buffer_size);
-            else
-            {
-               DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("getDefaults - EPERS_NO_PLUGIN_FUNCT"));
-               read_size = EPERS_NO_PLUGIN_FUNCT;
-            }
-         }
-         else if (PersGetDefault_Size == job)
-         {
-            if(*plugin_persComDbGetKeySize != NULL)
-               read_size = plugin_persComDbGetKeySize(handleDefaultDB, key);
-            else
-            {
-               DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("getDefaults - EPERS_NO_PLUGIN_FUNCT"));
-               read_size = EPERS_NO_PLUGIN_FUNCT;
-            }
-         }
-         else
+         const Pers_custom_functs_s* functs = custom_client_get_functs(&items[i].info, items[i].dbKey);
+
+         if(functs != NULL && items[i].info.customLibId == lib)
          {
-            DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("getDefaults - unknown job"));
-            break;
+            multi = (write == 1) ? functs->custom_plugin_set_data_multi : functs->custom_plugin_get_data_multi;
+
+            pluginItems[n].path   = items[i].info.customKey;
+            pluginItems[n].buffer = (char*)items[i].buffer;
+            pluginItems[n].size   = items[i].size;
+            pluginItems[n].result = EPERS_COMMON;
+            itemIdx[n++] = i;
          }
+      }
 
-         if(read_size < 0) // check read_size
+      if(n > 0 && multi != NULL)
+      {
+         uint64_t start = plugin_stats_start();
+         int ret = multi(pluginItems, n);
+
+         plugin_stats_add(lib, (write == 1) ? PCL_PLUGIN_OP_SET : PCL_PLUGIN_OP_GET, start, ret);
+         if(ret >= 0)
          {
-            if(PERS_COM_ERR_NOT_FOUND == read_size)
+            for(i = 0; i < n; i++)
             {
-               read_size = EPERS_NOKEY;
+               PersCustomItem_s* item = &items[itemIdx[i]];
+
+               item->result = pluginItems[i].result;
+               persistence_custom_item_done(item, write);
+               done[itemIdx[i]] = 1;
             }
          }
-         else /* read_size >= 0 --> default value found */
+         else
          {
-            if (PersDefaultType_Configurable == i)
-            {
-               snprintf(dltMessage, PERS_ORG_MAX_LENGTH_PATH_FILENAME, "%s%s", dbPath, plugin_gLocalConfigurableDefault);
-            }
-            if (PersDefaultType_Factory == i)
-            {
-                snprintf(dltMessage, PERS_ORG_MAX_LENGTH_PATH_FILENAME, "%s%s", dbPath, plugin_gLocalFactoryDefault);
-            }
-            DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("getDefaults - default data will be used for Key"), DLT_STRING(key),
-                                                  DLT_STRING("from"), DLT_STRING(dltMessage));
-            break;
+            DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("customMulti - plugin failed, access items one by one:"), DLT_INT(lib));
          }
       }
    }
 
-   if (read_size < 0)
+   for(i = 0; i < count; i++)    // plugins without vectored access
    {
-       DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("getDefaults - default data not available for Key"), DLT_STRING(key),
-                                             DLT_STRING("Path:"), DLT_STRING(dbPath));
+      if(done == NULL || done[i] == 0)
+      {
+         PersCustomItem_s* item = &items[i];
+
+         if(write == 1)
+            item->result = persistence_set_data(item->dbPath, item->dbKey, item->resource_id, &item->info, item->buffer, item->size);
+         else
+            item->result = persistence_get_data(item->dbPath, item->dbKey, item->resource_id, &item->info, item->buffer, item->size);
+      }
    }
 
-   return read_size;
+   free(itemIdx);
+   free(pluginItems);
+   free(done);
 }
 
 
 
-void database_close_all()
+void persistence_custom_get_data_multi(PersCustomItem_s* items, int count)
 {
-   int i = 0, j = 0;
+   custom_access_multi(items, count, 0);
+}
 
-   for(i=0; i<DbTableSize; i++)
-   {
-   	for(j=0; j < PersistenceDB_LastEntry; j++)
-   	{
-			if(gHandlesDBCreated[i][j] == 1)
-			{
-			   if(*plugin_persComDbClose != NULL)
-			   {
-               int iErrorCode = plugin_persComDbClose(gHandlesDB[i][j]);
-               if (iErrorCode < 0)
-               {
-                  DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("dbCloseAll - Err close db"));
-               }
-               else
-               {
-                   gHandlesDBCreated[i][j] = 0;
-               }
-			   }
-			   else
-			   {
-			      DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("dbCloseAll - plugin function NULL"));
-			   }
-			}
-   	}
-   }
+
+
+void persistence_custom_set_data_multi(PersCustomItem_s* items, int count)
+{
+   custom_access_multi(items, count, 1);
 }
 
 
 
-int persistence_get_data(char* dbPath, char* key, const char* resourceID, PersistenceInfo_s* info, unsigned char* buffer, int buffer_size)
+/* flush the write back cache and close the cached databases, the redo log can be truncated then */
+static void database_close_write_back(void)
 {
-   int read_size = -1, ret_defaults = -1;
+   int i = 0, failed = key_cache_flush();
 
-   if(   PersistenceStorage_shared == info->configKey.storage
-      || PersistenceStorage_local == info->configKey.storage)
+   if(failed == 0)
    {
-      int handleDB = database_get(info, dbPath, info->configKey.policy);
-      if(handleDB >= 0)
+      write_elision_clear();                         // handles will be reused
+      value_ref_clear();
+
+      for(i=0; i<DbTableSize; i++)
       {
-         if(*plugin_persComDbReadKey != NULL)
-         {
-            read_size = plugin_persComDbReadKey(handleDB, key, (char*)buffer, buffer_size);
-            if(read_size < 0)
-            {
-               read_size = pers_get_defaults(dbPath, (char*)resourceID, info, buffer, (unsigned int)buffer_size, PersGetDefault_Data); /* 0 ==> Get data */
-            }
-         }
-         else
+         if(gHandlesDBCreated[i][PersistencePolicy_wc] == 1 && *plugin_persComDbClose != NULL)
          {
-            DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("getData - EPERS_NO_PLUGIN_FUNCT"));
-            read_size = EPERS_NO_PLUGIN_FUNCT;
+            failed += (close_job_now(database_close_job, i * PersistenceDB_LastEntry + PersistencePolicy_wc) < 0) ? 1 : 0;
          }
       }
    }
-   else if(PersistenceStorage_custom == info->configKey.storage)   // custom storage implementation via custom library
-   {
-      int idx =  custom_client_name_to_id(dbPath, 1);
-      char workaroundPath[128];  								         // workaround, because /sys/ can not be accessed on host!!!!
-      snprintf(workaroundPath, 128, "%s%s", "/Data", dbPath  );
-
-      if(idx < PersCustomLib_LastEntry)
-      {
-      	int available = 0;
-      	if(gPersCustomFuncs[idx].custom_plugin_get_size == NULL )
-			{
-				if(getCustomLoadingType(idx) == LoadType_OnDemand)
-				{
-					// plugin not loaded, try to load the requested plugin
-					if(load_custom_library(idx, &gPersCustomFuncs[idx]) == 1)
-					{
-						// check again if the plugin function is now available
-						if(gPersCustomFuncs[idx].custom_plugin_get_data != NULL)
-						{
-							available = 1;
-						}
-					}
-				}
-				else if(getCustomLoadingType(idx) == LoadType_PclInit)
-				{
-					if(gPersCustomFuncs[idx].custom_plugin_get_data != NULL)
-					{
-						available = 1;
-					}
-				}
-				else
-				{
-					 DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("getData - Plugin not avail, unknown loading type: "),
-					                                       DLT_INT(getCustomLoadingType(idx)));
-					 read_size = EPERS_COMMON;
-				}
-			}
-      	else
-      	{
-      		available = 1;	// already loaded
-      	}
-
-      	if(available == 1)
-      	{
-				char pathKeyString[128] = {0};
-				if(info->configKey.customID[0] == '\0')   // if we have not a customID we use the key
-				{
-					snprintf(pathKeyString, 128, "0x%08X/%s/%s", info->context.ldbid, info->configKey.custom_name, key);
-				}
-				else
-				{
-					snprintf(pathKeyString, 128, "0x%08X/%s", info->context.ldbid, info->configKey.customID);
-				}
-				read_size = gPersCustomFuncs[idx].custom_plugin_get_data(pathKeyString, (char*)buffer, buffer_size);
-      	}
-      	else
-      	{
-      		read_size = EPERS_NOPLUGINFUNCT;
-      	}
-      }
-      else
-      {
-         read_size = EPERS_NOPLUGINFUNCT;
-      }
 
-      if (1 > read_size) // Try to get default values
-      {
-         info->configKey.policy = PersistencePolicy_wc;			 // Set the policy
-         info->configKey.type   = PersistenceResourceType_key;  // Set the type
-
-         (void)get_db_path_and_key(info, key, NULL, dbPath);
-
-         DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("getData - Plugin data not available - get default data of key:"), DLT_STRING(key));
-         ret_defaults = pers_get_defaults(dbPath, (char*)resourceID, info, buffer, (unsigned int)buffer_size, PersGetDefault_Data);
-         if (0 < ret_defaults)
-         {
-        	   read_size = ret_defaults;
-         }
-      }
+   if(failed == 0)
+   {
+      key_cache_databases_closed(1);
+   }
+   else
+   {
+      DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("setData - redo log full, keep it:"), DLT_INT(failed));
    }
-   return read_size;
 }
 
 
@@ -365,18 +1171,81 @@ int persistence_set_data(char* dbPath, char* key, const char* resource_id, Persi
 
       if(handleDB >= 0)
       {
-         if(*plugin_persComDbWriteKey != NULL)
+         uint32_t crc = 0;
+         // other processes write shared keys too, the last value written by this process is not the stored one
+         int elision = (PersistenceStorage_shared != info->configKey.storage) ? 1 : 0;
+         int priority = flush_priority_get(resource_id);
+         unsigned int arrayIdx = info->configKey.storage + info->context.ldbid;
+
+         if(priority < gHandlesDBPrio[arrayIdx][dbType])
+         {
+            gHandlesDBPrio[arrayIdx][dbType] = priority;    // the database is flushed with the highest priority of its resources
+         }
+
+         if(elision == 1 && write_elision_check(handleDB, dbInput, buffer, buffer_size, &crc) == 1)
+         {
+            write_size = buffer_size;     // same value as written before, skip the database
+         }
+         else if(*plugin_persComDbWriteKey != NULL)
          {
-            write_size = plugin_persComDbWriteKey(handleDB, dbInput, (char*)buffer, buffer_size) ;
+            SharedCacheWrite_s sharedWrite;
+            int shared = (PersistenceStorage_shared == info->configKey.storage && PersistenceDB_confdefault != dbType) ? 1 : 0;
+
+            if(shared == 1)
+            {
+               // readers of other processes must not see the old value after the database has been written
+               shared_cache_begin_write(info->context.ldbid, dbType, dbInput, &sharedWrite);
+            }
+
+            write_size = EPERS_COMMON;
+            if(is_write_back_key(info) && PersistencePolicy_wc == dbType)
+            {
+               char path[PERS_ORG_MAX_LENGTH_PATH_FILENAME] = {0};
+
+               snprintf(path, PERS_ORG_MAX_LENGTH_PATH_FILENAME, "%s%s", dbPath, plugin_gLocalCached);
+               write_size = key_cache_write(path, handleDB, dbInput, (char*)buffer, buffer_size, priority);
+            }
+
+            if(write_size < 0)      // not cached, write directly
+            {
+               write_size = plugin_persComDbWriteKey(handleDB, dbInput, (char*)buffer, buffer_size) ;
+            }
+
+            if(shared == 1)
+            {
+               shared_cache_end_write(&sharedWrite, dbInput, (write_size < 0) ? NULL : buffer, buffer_size);
+            }
             if(write_size < 0)
             {
                DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("setData - persComDbWriteKey() failure"));
             }
             else
             {
+               if(elision == 1)
+               {
+                  write_elision_update(handleDB, dbInput, crc, buffer_size);
+               }
+
+               if(PersistenceDB_confdefault == dbType)
+               {
+                  default_cache_invalidate(info->configKey.storage + info->context.ldbid);
+                  value_ref_clear();      // cached values may be default values
+                  warm_start_invalidate_all();
+               }
+               else
+               {
+                  value_ref_invalidate(handleDB, dbInput);
+                  warm_start_invalidate(dbType, dbInput);
+               }
+
+               if(is_write_back_key(info) && PersistencePolicy_wc == dbType && key_cache_log_full() == 1)
+               {
+                  database_close_write_back();     // the cached databases are opened again by the next access
+               }
+
                if(PersistenceStorage_shared == info->configKey.storage)
                {
-                  int rval = pers_send_Notification_Signal(resource_id, &info->context, pclNotifyStatus_changed);
+                  int rval = pers_send_Notification_Signal(resource_id, key, &info->context, pclNotifyStatus_changed);
                   if(rval <= 0)
                   {
                      DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("setData - Err to send noty sig"));
@@ -399,70 +1268,23 @@ int persistence_set_data(char* dbPath, char* key, const char* resource_id, Persi
    }
    else if(PersistenceStorage_custom == info->configKey.storage)   // custom storage implementation via custom library
    {
-   	int available = 0, idx = custom_client_name_to_id(dbPath, 1);
-
-      if(idx < PersCustomLib_LastEntry )
-      {
-      	if(gPersCustomFuncs[idx].custom_plugin_set_data == NULL)
-      	{
-				if (getCustomLoadingType(idx) == LoadType_OnDemand)
-				{
-					// plugin not loaded, try to load the requested plugin
-					if(load_custom_library(idx, &gPersCustomFuncs[idx]) == 1)
-					{
-						// check again if the plugin function is now available
-						if(gPersCustomFuncs[idx].custom_plugin_set_data != NULL)
-						{
-							available = 1;
-						}
-					}
-				}
-				else if(getCustomLoadingType(idx) == LoadType_PclInit)
-				{
-					if(gPersCustomFuncs[idx].custom_plugin_set_data != NULL)
-					{
-						available = 1;
-					}
-				}
-				else
-				{
-					 DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("setData - Plugin not avail, unknown loading type: "),
-					                                       DLT_INT(getCustomLoadingType(idx)));
-					 write_size = EPERS_COMMON;
-				}
-			}
-      	else
-      	{
-      		available = 1;	// already loaded
-      	}
-
-      	if(available == 1)
-      	{
-				char pathKeyString[128] = {0};
-				if(info->configKey.customID[0] == '\0')   // if we have not a customID we use the key
-				{
-					snprintf(pathKeyString, 128, "0x%08X/%s/%s", info->context.ldbid, info->configKey.custom_name, key);
-				}
-				else
-				{
-					snprintf(pathKeyString, 128, "0x%08X/%s", info->context.ldbid, info->configKey.customID);
-				}
-				write_size = gPersCustomFuncs[idx].custom_plugin_set_data(pathKeyString, (char*)buffer, buffer_size);
-
-				if ((0 < write_size) && ((unsigned int)write_size == buffer_size)) /* Check return value and send notification if OK */
-				{
-					int rval = pers_send_Notification_Signal(resource_id, &info->context, pclNotifyStatus_changed);
-					if(rval <= 0)
-					{
-						DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("setData - Err send noty sig"));
-						write_size = rval;
-					}
-				}
-      	}
-      	else
-      	{
-      		write_size = EPERS_NOPLUGINFUNCT;
-      	}
+      const Pers_custom_functs_s* functs = custom_client_get_functs(info, key);
+
+      if(functs != NULL && functs->custom_plugin_set_data != NULL)
+      {
+         uint64_t start = plugin_stats_start();
+         write_size = functs->custom_plugin_set_data(info->customKey, (char*)buffer, buffer_size);
+         plugin_stats_add(info->customLibId, PCL_PLUGIN_OP_SET, start, write_size);
+
+         if ((0 < write_size) && ((unsigned int)write_size == buffer_size)) /* Check return value and send notification if OK */
+         {
+            int rval = pers_send_Notification_Signal(resource_id, key, &info->context, pclNotifyStatus_changed);
+            if(rval <= 0)
+            {
+               DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("setData - Err send noty sig"));
+               write_size = rval;
+            }
+         }
       }
       else
       {
@@ -478,15 +1300,46 @@ int persistence_get_data_size(char* dbPath, char* key, const char* resourceID, P
 {
    int read_size = -1, ret_defaults = -1;
 
-   if(   PersistenceStorage_shared == info->configKey.storage
-      || PersistenceStorage_local == info->configKey.storage)
+   if(   PersistenceStorage_local == info->configKey.storage
+      && warm_start_get_size(info->configKey.policy, key, &read_size) == 1)
+   {
+      // served from the warm start snapshot, no database access
+   }
+   else if(   PersistenceStorage_shared == info->configKey.storage
+           || PersistenceStorage_local == info->configKey.storage)
    {
       int handleDB = database_get(info, dbPath, info->configKey.policy);
       if(handleDB >= 0)
       {
          if(*plugin_persComDbGetKeySize != NULL)
          {
-            read_size = plugin_persComDbGetKeySize(handleDB, key);
+            read_size = EPERS_NOKEY;
+            if(is_write_back_key(info))
+            {
+               read_size = key_cache_get_size(handleDB, key);
+            }
+
+            if(read_size == EPERS_NOKEY && PersistenceStorage_local == info->configKey.storage)
+            {
+               const unsigned char* value = NULL;
+
+               read_size = value_ref_find(handleDB, key, &value);
+               if(read_size >= 0)
+               {
+                  (void)value_ref_release(value);
+               }
+            }
+
+            if(read_size == EPERS_NOKEY && PersistenceStorage_shared == info->configKey.storage)
+            {
+               read_size = shared_cache_read(info->context.ldbid, info->configKey.policy, key, NULL, 0);
+            }
+
+            if(read_size == EPERS_NOKEY)
+            {
+               read_size = plugin_persComDbGetKeySize(handleDB, key);
+            }
+
             if(read_size < 0)
             {
                read_size = pers_get_defaults( dbPath, (char*)resourceID, info, NULL, 0, PersGetDefault_Size);
@@ -501,60 +1354,13 @@ int persistence_get_data_size(char* dbPath, char* key, const char* resourceID, P
    }
    else if(PersistenceStorage_custom == info->configKey.storage)   // custom storage implementation via custom library
    {
-   	int available = 0, idx = custom_client_name_to_id(dbPath, 1);
-
-      if(idx < PersCustomLib_LastEntry )
-      {
-      	if(gPersCustomFuncs[idx].custom_plugin_get_size == NULL )
-      	{
-      		if (getCustomLoadingType(idx) == LoadType_OnDemand)
-      		{
-					// plugin not loaded, try to load the requested plugin
-					if(load_custom_library(idx, &gPersCustomFuncs[idx]) == 1)
-					{
-						// check again if the plugin function is now available
-						if(gPersCustomFuncs[idx].custom_plugin_get_size != NULL)
-						{
-							available = 1;
-						}
-					}
-      		}
-      		else if(getCustomLoadingType(idx) == LoadType_PclInit)
-      		{
-   				if(gPersCustomFuncs[idx].custom_plugin_get_size != NULL)
-					{
-   					available = 1;
-					}
-      		}
-				else
-				{
-					 DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("getDataSize - Plugin not avail, unknown loading type: "),
-					                                       DLT_INT(getCustomLoadingType(idx)));
-					 read_size = EPERS_COMMON;
-				}
-      	}
-      	else
-      	{
-      		available = 1;	// already loaded
-      	}
-
-      	if(available == 1)
-      	{
-      		char pathKeyString[128] = {0};
-				if(info->configKey.customID[0] == '\0')   // if we have not a customID we use the key
-				{
-					snprintf(pathKeyString, 128, "0x%08X/%s/%s", info->context.ldbid, info->configKey.custom_name, key);
-				}
-				else
-				{
-					snprintf(pathKeyString, 128, "0x%08X/%s", info->context.ldbid, info->configKey.customID);
-				}
-				read_size = gPersCustomFuncs[idx].custom_plugin_get_size(pathKeyString);
-      	}
-      	else
-      	{
-      		read_size = EPERS_NOPLUGINFUNCT;
-      	}
+      const Pers_custom_functs_s* functs = custom_client_get_functs(info, key);
+
+      if(functs != NULL && functs->custom_plugin_get_size != NULL)
+      {
+         uint64_t start = plugin_stats_start();
+         read_size = functs->custom_plugin_get_size(info->customKey);
+         plugin_stats_add(info->customLibId, PCL_PLUGIN_OP_GET_SIZE, start, read_size);
       }
       else
       {
@@ -590,7 +1396,36 @@ int persistence_delete_data(char* dbPath, char* key, const char* resource_id, Pe
       {
          if(*plugin_persComDbDeleteKey != NULL)
          {
+            int cached = 0;
+            SharedCacheWrite_s sharedWrite;
+
+            if(is_write_back_key(info))
+            {
+               char path[PERS_ORG_MAX_LENGTH_PATH_FILENAME] = {0};
+
+               snprintf(path, PERS_ORG_MAX_LENGTH_PATH_FILENAME, "%s%s", dbPath, plugin_gLocalCached);
+               cached = key_cache_delete(path, handleDB, key);    // discard data not yet written back
+            }
+            write_elision_remove(handleDB, key);
+            value_ref_invalidate(handleDB, key);
+            warm_start_invalidate(info->configKey.policy, key);
+
+            if(PersistenceStorage_shared == info->configKey.storage)
+            {
+               shared_cache_begin_write(info->context.ldbid, info->configKey.policy, key, &sharedWrite);
+            }
+
             ret = plugin_persComDbDeleteKey(handleDB, key) ;
+
+            if(PersistenceStorage_shared == info->configKey.storage)
+            {
+               shared_cache_end_write(&sharedWrite, key, NULL, -1);
+            }
+            if(ret < 0 && cached == 1 && PERS_COM_ERR_NOT_FOUND == ret)
+            {
+               ret = 0;    // the key only existed in the cache
+            }
+
             if(ret < 0)
             {
                DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("deleteData - failed: "), DLT_STRING(key));
@@ -606,7 +1441,7 @@ int persistence_delete_data(char* dbPath, char* key, const char* resource_id, Pe
 
             if(PersistenceStorage_shared == info->configKey.storage)
             {
-               pers_send_Notification_Signal(resource_id, &info->context, pclNotifyStatus_deleted);
+               pers_send_Notification_Signal(resource_id, key, &info->context, pclNotifyStatus_deleted);
             }
          }
          else
@@ -623,65 +1458,18 @@ int persistence_delete_data(char* dbPath, char* key, const char* resource_id, Pe
    }
    else   // custom storage implementation via custom library
    {
-   	int available = 0, idx = custom_client_name_to_id(dbPath, 1);
+      const Pers_custom_functs_s* functs = custom_client_get_functs(info, key);
 
-      if(idx < PersCustomLib_LastEntry)
+      if(functs != NULL && functs->custom_plugin_delete_data != NULL)
       {
-      	if(gPersCustomFuncs[idx].custom_plugin_delete_data == NULL )
-			{
-				if (getCustomLoadingType(idx) == LoadType_OnDemand)
-				{
-					// plugin not loaded, try to load the requested plugin
-					if(load_custom_library(idx, &gPersCustomFuncs[idx]) == 1)
-					{
-						// check again if the plugin function is now available
-						if(gPersCustomFuncs[idx].custom_plugin_delete_data != NULL)
-						{
-							available = 1;
-						}
-					}
-				}
-				else if(getCustomLoadingType(idx) == LoadType_PclInit)
-				{
-					if(gPersCustomFuncs[idx].custom_plugin_delete_data != NULL)
-					{
-						available = 1;
-					}
-				}
-				else
-				{
-					 DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("deleteData - Plugin not available, unknown loading type: "),
-					                                       DLT_INT(getCustomLoadingType(idx)));
-					 ret = EPERS_COMMON;
-				}
-			}
-      	else
-      	{
-      		available = 1;	// already loaded
-      	}
-
-      	if(available == 1)
-      	{
-				char pathKeyString[128] = {0};
-				if(info->configKey.customID[0] == '\0')   // if we have not a customID we use the key
-				{
-					snprintf(pathKeyString, 128, "0x%08X/%s/%s", info->context.ldbid, info->configKey.custom_name, key);
-				}
-				else
-				{
-					snprintf(pathKeyString, 128, "0x%08X/%s", info->context.ldbid, info->configKey.customID);
-				}
-				ret = gPersCustomFuncs[idx].custom_plugin_delete_data(pathKeyString);
-
-				if(0 <= ret) /* Check return value and send notification if OK */
-				{
-					pers_send_Notification_Signal(resource_id, &info->context, pclNotifyStatus_deleted);
-				}
-      	}
-      	else
-      	{
-      		ret = EPERS_NOPLUGINFUNCT;
-      	}
+         uint64_t start = plugin_stats_start();
+         ret = functs->custom_plugin_delete_data(info->customKey);
+         plugin_stats_add(info->customLibId, PCL_PLUGIN_OP_DELETE, start, ret);
+
+         if(0 <= ret) /* Check return value and send notification if OK */
+         {
+            pers_send_Notification_Signal(resource_id, key, &info->context, pclNotifyStatus_deleted);
+         }
       }
       else
       {
@@ -702,8 +1490,8 @@ int persistence_notify_on_change(const char* resource_id, const char* dbKey, uns
    {
    	MainLoopData_u data;
       key_value_s* foundItem = NULL;
-      key_value_s* searchItem = NULL;
-      unsigned int hashKey = pclCrc32(0, (unsigned char*)dbKey, strlen(dbKey));
+      key_value_s searchItem;
+      unsigned int hashKey = notify_hash(dbKey, ldbid, user_no, seat_no);
 
       memset(&data, 0, sizeof(MainLoopData_u));
    	data.cmd = (uint32_t)CMD_REG_NOTIFY_SIGNAL;
@@ -714,70 +1502,53 @@ int persistence_notify_on_change(const char* resource_id, const char* dbKey, uns
 
    	snprintf(data.string, PERS_DB_MAX_LENGTH_KEY_NAME, "%s", resource_id);
 
+      pthread_mutex_lock(&gNotificationMtx);
+
       // check if the tree has already been created
    	if(gNotificationTree == NULL)
    	{
-   	   gNotificationTree = jsw_rbnew(key_val_cmp, key_val_dup, key_val_rel);
+   	   // only the key is of interest, so the items are embedded in the tree nodes
+   	   gNotificationTree = jsw_rbnew_intrusive(key_val_cmp, sizeof(key_value_s), 0);
    	}
 
    	// search if item is already stored in the tree
-   	searchItem = malloc(sizeof(key_value_s));
-   	if(searchItem != NULL)
-   	{
-         searchItem->key = hashKey;
-         foundItem = (key_value_s*)jsw_rbfind(gNotificationTree, searchItem);
+      searchItem.key = hashKey;
+      // we don't need the path name here, we just need to know that this key is available in the tree
+      searchItem.value = "";
+      foundItem = (key_value_s*)jsw_rbfind(gNotificationTree, &searchItem);
 
-         if(regPolicy == Notify_register)
+      if(regPolicy == Notify_register)
+      {
+         if(foundItem == NULL)   // item not found add it, else already added so nothing to do
          {
-            if(foundItem == NULL)   // item not found add it, else already added so nothing to do
+            if(jsw_rbinsert(gNotificationTree, &searchItem) == 1)
             {
-               key_value_s* item = malloc(sizeof(key_value_s));    // assign key and value to the rbtree item
-               if(item != NULL)
-               {
-                  item->key = hashKey;
-                  // we don't need the path name here, we just need to know that this key is available in the tree
-                  item->value = "";
-                  (void)jsw_rbinsert(gNotificationTree, item);
-                  free(item);
-
-                  gChangeNotifyCallback = callback;      // assign callback
-               }
-               else
-               {
-                  rval = -1;
-               }
+               gChangeNotifyCallback = callback;      // assign callback
+            }
+            else
+            {
+               rval = -1;
             }
-            free(foundItem);
          }
-         else if(regPolicy == Notify_unregister)
+      }
+      else if(regPolicy == Notify_unregister)
+      {
+         if(foundItem != NULL)   // item already in the tree remove it, if not found nothing to do
          {
-            if(foundItem != NULL)   // item already in the tree remove it, if not found nothing to do
-            {
-               // we don't need the path name here, we just need to know that this key is available in the tree
-               jsw_rberase(gNotificationTree, foundItem);
+            jsw_rberase(gNotificationTree, foundItem);
 
-               if(jsw_rbsize(gNotificationTree) == 0)  // if no other notification is stored in the tree, remove callback
-               {
-                  gChangeNotifyCallback = NULL;          // remove callback
-               }
-            }
-            else
+            if(jsw_rbsize(gNotificationTree) == 0)  // if no other notification is stored in the tree, remove callback
             {
-               free(foundItem);
+               gChangeNotifyCallback = NULL;          // remove callback
             }
          }
+      }
 
-         if(-1 == deliverToMainloop(&data))
-         {
-            DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("notifyOnChange - Write to pipe"), DLT_INT(errno));
-            rval = -1;
-         }
+      pthread_mutex_unlock(&gNotificationMtx);
 
-         free(searchItem);
-      }
-      else
+      if(-1 == deliverToMainloop(&data))
       {
-         DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("notifyOnChange - failed to alloc memory"));
+         DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("notifyOnChange - Write to pipe"), DLT_INT(errno));
          rval = -1;
       }
    }
@@ -791,7 +1562,7 @@ int persistence_notify_on_change(const char* resource_id, const char* dbKey, uns
 
 
 
-int pers_send_Notification_Signal(const char* key, PersistenceDbContext_s* context, pclNotifyStatus_e reason)
+int pers_send_Notification_Signal(const char* key, const char* dbKey, PersistenceDbContext_s* context, pclNotifyStatus_e reason)
 {
    int rval = 1;
    if(reason < pclNotifyStatus_lastEntry)
@@ -800,6 +1571,22 @@ int pers_send_Notification_Signal(const char* key, PersistenceDbContext_s* conte
 
    	memset(&data, 0, sizeof(MainLoopData_u));
    	data.cmd = (uint32_t)CMD_SEND_NOTIFY_SIGNAL;
+
+      if(dbKey != NULL)
+      {
+         key_value_s searchItem;
+
+         searchItem.key = notify_hash(dbKey, context->ldbid, context->user_no, context->seat_no);
+         searchItem.value = "";
+
+         // the own D-Bus signal is ignored, the mainloop calls the callback of this process directly
+         pthread_mutex_lock(&gNotificationMtx);
+         if(gNotificationTree != NULL && gChangeNotifyCallback != NULL && jsw_rbfind(gNotificationTree, &searchItem) != NULL)
+         {
+            data.cmd = (uint32_t)CMD_SEND_NOTIFY_LOCAL;
+         }
+         pthread_mutex_unlock(&gNotificationMtx);
+      }
    	data.params[0] = context->ldbid;
    	data.params[1] = context->user_no;
    	data.params[2] = context->seat_no;
@@ -821,28 +1608,3 @@ int pers_send_Notification_Signal(const char* key, PersistenceDbContext_s* conte
    return rval;
 }
 
-
-void pers_rct_close_all()
-{
-   int i = 0;
-
-   for(i=0; i< PrctDbTableSize; i++)      // close all open persistence resource configuration tables
-   {
-   	if(get_resource_cfg_table_by_idx(i) != -1)
-   	{
-   	   if(*plugin_persComRctClose != NULL)
-   	   {
-            if(plugin_persComRctClose(get_resource_cfg_table_by_idx(i)) != 0)
-            {
-               DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("prepShtdwn - Close db => index:"), DLT_INT(i));
-            }
-            invalidate_resource_cfg_table(i);
-   	   }
-   	   else
-   	   {
-   	      DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("prepShtdwn - No plugin function available"));
-   	   }
-   	}
-   }
-}
-
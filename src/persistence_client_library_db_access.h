@@ -29,6 +29,9 @@ extern "C" {
 
 #include "persistence_client_library_data_organization.h"
 #include "../include/persistence_client_library_key.h"
+#include "../include/persistence_client_custom.h"
+
+#include "persistence_client_library_flush.h"
 
 #include <persComRct.h>
 
@@ -47,6 +50,38 @@ typedef enum PersistenceDB_e_
 } PersistenceDefaultDB_e;
 
 
+/// access to a custom storage resource, part of a batch
+typedef struct _PersCustomItem_s
+{
+   /// persistence information, see ::get_db_context
+   PersistenceInfo_s info;
+   /// the database key
+   char dbKey[PERS_DB_MAX_LENGTH_KEY_NAME];
+   /// the database path, the custom name of the resource
+   char dbPath[PERS_ORG_MAX_LENGTH_PATH_FILENAME];
+   /// the resource ID
+   const char* resource_id;
+   /// the buffer to read to or the data to write
+   unsigned char* buffer;
+   /// the size of the buffer or of the data
+   int size;
+   /// the result, see ::persistence_get_data and ::persistence_set_data
+   int result;
+} PersCustomItem_s;
+
+
+/// chunk of a key list, holds '\0' terminated resource IDs
+typedef struct _PersKeyListChunk_s
+{
+   /// next chunk of the list
+   struct _PersKeyListChunk_s* next;
+   /// used size of the chunk
+   unsigned int used;
+   /// the resource IDs
+   char names[KeyListChunkSize];
+} PersKeyListChunk_s;
+
+
 /**
  * @brief get the raw key without prefixed '/node/', '/user/3/' etc
  *
@@ -110,6 +145,131 @@ int persistence_get_data(char* dbPath, char* key, const char* resourceID, Persis
 
 
 
+/**
+ * @brief get a reference to the data of a key, values of local keys are cached
+ *
+ * @param dbPath the path to the database where the key is in
+ * @param key the database key
+ * @param resourceID the resource id
+ * @param info persistence information
+ * @param data pointer to store the data, must be released with value_ref_release
+ *
+ * @return the number of bytes of the data or a negative value if an error occured, see ::persistence_get_data
+ */
+int persistence_get_data_ref(char* dbPath, char* key, const char* resourceID, PersistenceInfo_s* info, const unsigned char** data);
+
+
+
+/**
+ * @brief get the data of several custom storage resources.
+ *        Resources of a plugin providing plugin_get_data_multi are read with one call,
+ *        the other resources with ::persistence_get_data.
+ *
+ * @param items the resources, the result is stored in the items
+ * @param count the number of items
+ */
+void persistence_custom_get_data_multi(PersCustomItem_s* items, int count);
+
+
+/**
+ * @brief set the data of several custom storage resources.
+ *        Resources of a plugin providing plugin_set_data_multi are written with one call,
+ *        the other resources with ::persistence_set_data.
+ *
+ * @param items the resources, the result is stored in the items
+ * @param count the number of items
+ */
+void persistence_custom_set_data_multi(PersCustomItem_s* items, int count);
+
+
+
+/**
+ * @brief complete the access to a custom storage resource after the plugin has returned the result:
+ *        get the default value if no data has been read or send the change notification of a write
+ *
+ * @param item the resource, item->result must contain the result of the plugin
+ * @param write 1 if the resource has been written, 0 if it has been read
+ */
+void persistence_custom_item_done(PersCustomItem_s* item, int write);
+
+
+/**
+ * @brief start a non blocking access to a custom storage resource,
+ *        ::persistence_custom_item_done must be called after the callback has been called
+ *
+ * @param item the resource, the buffer must stay valid until the callback has been called
+ * @param write 1 to write the resource, 0 to read it
+ * @param callback called by the plugin when the request is complete
+ * @param user_data passed to the callback
+ *
+ * @return 0 if the request has been started, EPERS_NOPLUGINFUNCT if the plugin has no
+ *         non blocking access function or the error of the plugin
+ */
+int persistence_custom_start_async(PersCustomItem_s* item, int write, plugin_callback_io_t callback, void* user_data);
+
+
+
+/**
+ * @brief get the resource IDs of all keys stored in the local or shared databases of a
+ *        logical database ID, user and seat. Keys only held in the write back cache are not included.
+ *
+ * @param info persistence information, the ldbid, user and seat must be set
+ * @param prefix only resource IDs starting with the prefix are returned
+ * @param list pointer to the list the chunks will be appended to, must be released with ::persistence_free_key_list
+ *
+ * @return the number of resource IDs or a negative value if an error occured
+ */
+int persistence_get_key_list(PersistenceInfo_s* info, const char* prefix, PersKeyListChunk_s** list);
+
+
+/**
+ * @brief delete all keys of a user (and all seats of the user if the seat is 0) from the
+ *        write cached and the write through database of a logical database ID.
+ *        For shared databases one notification with an empty resource ID is sent.
+ *        The write back cache must have been flushed before.
+ *
+ * @param info persistence information, the ldbid, user and seat must be set
+ *
+ * @return the number of deleted keys or a negative value if an error occured
+ */
+int persistence_delete_user(PersistenceInfo_s* info);
+
+
+/**
+ * @brief get the database keys of a user and seat of a logical database ID to be loaded
+ *        by ::persistence_prefetch_key and load the default values into the default value cache
+ *
+ * @param info persistence information, the ldbid, user and seat must be set
+ * @param policy the database policy, ::PersistencePolicy_wc or ::PersistencePolicy_wt
+ * @param list pointer to the list the database keys will be appended to, must be released with ::persistence_free_key_list
+ *
+ * @return the number of database keys or a negative value if an error occured
+ */
+int persistence_prefetch_keys(PersistenceInfo_s* info, int policy, PersKeyListChunk_s** list);
+
+
+/**
+ * @brief load a key returned by ::persistence_prefetch_keys into the value cache.
+ *        Keys which are cached already or are dirty in the write back cache are skipped.
+ *
+ * @param info persistence information, the ldbid, user and seat must be set
+ * @param policy the database policy passed to ::persistence_prefetch_keys
+ * @param key the database key
+ *
+ * @return 1 if the value has been added to the value cache, 0 if not or a negative value if an error occured
+ */
+int persistence_prefetch_key(PersistenceInfo_s* info, int policy, const char* key);
+
+
+/**
+ * @brief release a key list
+ *
+ * @param list the list returned by ::persistence_get_key_list
+ */
+void persistence_free_key_list(PersKeyListChunk_s* list);
+
+
+
 /**
  * @brief get the size of the data from a given key
  *
@@ -141,9 +301,45 @@ int persistence_delete_data(char* dbPath, char* key, const char* resource_id, Pe
 
 
 /**
- * @brief close all databases
+ * @brief add the closes of all resource configuration tables and databases to a flush plan,
+ *        the databases with the flush priority of their resources.
+ *        The tables and databases are marked as closing until ::database_close_finished has been called.
+ *
+ * @param plan the flush plan
+ *
+ * @return the number of tables and databases which could not be closed immediately because
+ *         the plan could not be extended
+ */
+int database_plan_close_all(FlushPlan_s* plan);
+
+
+/**
+ * @brief update the state of the tables and databases closed by a flush plan, must be called
+ *        after ::flush_run_jobs has returned.
+ *        The tables and databases of closes not finished stay marked as closing and will not be used anymore.
+ *
+ * @param jobs the jobs of the flush plan
+ * @param count the number of jobs
+ */
+void database_close_finished(const FlushJob_s* jobs, int count);
+
+
+
+/**
+ * @brief open the resource configuration table and the databases of the local application data
+ *        in advance, so the first access does not need to open them
  */
-void database_close_all();
+void database_preopen_local(void);
+
+
+
+/**
+ * @brief get the file name of a database of the local application data
+ *
+ * @param dbType the database type, see ::PersistenceDB_e
+ * @param path the buffer of size PERS_ORG_MAX_LENGTH_PATH_FILENAME to store the file name
+ */
+void database_get_local_path(int dbType, char* path);
 
 
 
@@ -168,18 +364,15 @@ int persistence_notify_on_change(const char* resource_id, const char* dbKey, uns
  * @brief send a notification signal
  *
  * @param key the database key to register on
+ * @param dbKey the database key with the user and seat namespace, used to find a registration
+ *              of this process, or NULL if there is none
  * @param context the database context
  * @param reason the reason of the signal, values see pclNotifyStatus_e.
  *
  * @return 0 of registration was successful; -1 if registration failes
  */
-int pers_send_Notification_Signal(const char* key, PersistenceDbContext_s* context, pclNotifyStatus_e reason);
-
+int pers_send_Notification_Signal(const char* key, const char* dbKey, PersistenceDbContext_s* context, pclNotifyStatus_e reason);
 
-/**
- * @brief close all open persistence resource configuration tables
- */
-void pers_rct_close_all();
 
 
 /**
@@ -22,7 +22,12 @@
 #include "persistence_client_library_custom_loader.h"
 #include "persistence_client_library_pas_interface.h"
 #include "persistence_client_library_db_access.h"
+#include "persistence_client_library_key_cache.h"
+#include "persistence_client_library_plugin_stats.h"
 #include "persistence_client_library_file.h"
+#include "persistence_client_library_flush.h"
+#include "persistence_client_library_key_async.h"
+#include "persistence_client_library_warm_start.h"
 
 
 #if USE_FILECACHE
@@ -54,6 +59,9 @@ static const char* gCreateSignal = "PersistenceResCreate";
 /// dbus timeout
 static int gTimeoutMs = 5000;
 
+/// held while data is written back on request of the administration service or at shutdown
+static pthread_mutex_t gWriteBackMtx = PTHREAD_MUTEX_INITIALIZER;
+
 // function prototype
 static void msg_pending_func(DBusPendingCall *call, void *data);
 
@@ -183,27 +191,211 @@ void process_send_notification_signal(DBusConnection* conn, unsigned int notifyL
 
 
 
-void process_block_and_write_data_back(unsigned int requestID, unsigned int status)
+/* add the sync of the open files to the flush plan */
+static int plan_sync_open_files(FlushPlan_s* plan, int (*syncFunc)(int fd))
 {
-   (void)requestID;
-   (void)status;
+   int failed = 0;
+   PersList_item_s* item = NULL;
+
+   pthread_mutex_lock(&gFileAccessMtx);
+   for(item = gOpenFdList; item != NULL; item = item->next)
+   {
+      if(flush_plan_add(plan, syncFunc, item->fd, "file", item->priority) != 0)
+      {
+         failed += (syncFunc(item->fd) != 0) ? 1 : 0;    // no memory, sync it now
+      }
+   }
+   pthread_mutex_unlock(&gFileAccessMtx);
+
+   return failed;
+}
+
+
+
+/* close the open files, except files still being synced by a flush job */
+static void close_open_files(const FlushPlan_s* plan)
+{
+   PersList_item_s* item = gOpenFdList;
+
+   while(item != NULL)
+   {
+      int fd = item->fd, i = 0;
+
+      item = item->next;      // pclFileClose removes the item
+
+      for(i = 0; i < plan->count; i++)
+      {
+         if(plan->jobs[i].func == fsync && plan->jobs[i].arg == fd)
+            break;
+      }
+
+      if(i == plan->count || plan->jobs[i].state == FlushJob_Done)
+      {
+         (void)pclFileClose(fd);
+      }
+   }
+}
+
+
+
+static void* write_back_worker(void* data)
+{
+   unsigned int requestID = (unsigned int)(uintptr_t)data;
+   int failed = 0;
+   uint64_t start = flush_time_us(), drained = 0, cached = 0, synced = 0;
+   FlushPlan_s plan = {NULL, 0, 0};
+   MainLoopData_u msg;
+
+   pthread_mutex_lock(&gWriteBackMtx);      // one write back at a time, not during shutdown
+
+   // the asynchronous writes accepted before the request must not be rejected
+   if(key_async_drain(PasWriteBackTimeoutMs) < 0)
+   {
+      failed++;
+   }
+
    // lock persistence data access
    pers_lock_access();
+
+   // wait until the writes still in progress have finished, they hold the API mutexes
+   pthread_mutex_lock(&gKeyAPIAccessMtx);
+   pthread_mutex_unlock(&gKeyAPIAccessMtx);
+   pthread_mutex_lock(&gFileAccessMtx);
+   pthread_mutex_unlock(&gFileAccessMtx);
+   drained = flush_time_us();
+
    // sync data back to memory device
+   failed += key_cache_flush();
+   cached = flush_time_us();
+
+   // the databases are closed to write them, they will be opened again after the unblock
+   failed += plan_sync_open_files(&plan, fdatasync);
+   failed += database_plan_close_all(&plan);
+   failed += flush_run_jobs(plan.jobs, plan.count, 0);
+   database_close_finished(plan.jobs, plan.count);
+   key_cache_databases_closed((failed == 0) ? 1 : 0);     // the redo log is not needed anymore
+   flush_plan_free(&plan);
+
+   if(gIsNodeStateManager == 0)
+      syncfs(gSyncFd);
+   synced = flush_time_us();
+
+   pthread_mutex_unlock(&gWriteBackMtx);
+
+   DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("writeBack - finished, failed:"), DLT_INT(failed),
+                                         DLT_STRING("drain [us]:"), DLT_UINT64(drained - start),
+                                         DLT_STRING("key cache [us]:"), DLT_UINT64(cached - drained),
+                                         DLT_STRING("sync [us]:"), DLT_UINT64(synced - cached));
+
+   // the response is sent by the mainloop
+   memset(&msg, 0, sizeof(MainLoopData_u));
+   msg.cmd = (uint32_t)CMD_PAS_WRITE_BACK_DONE;
+   msg.params[0] = (failed == 0) ? PasErrorStatus_OK : PasErrorStatus_FAIL;
+   msg.params[1] = requestID;
+   if(deliverToMainloop_NM(&msg) == -1)
+   {
+      DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("writeBack - failed to send response"), DLT_UINT(requestID));
+   }
+
+   return NULL;
 }
 
 
 
-void process_prepare_shutdown(unsigned int complete)
+/* wait until a running write back has finished, bounded by the deadline or ::PasWriteBackTimeoutMs.
+   Returns 1 if the write back lock has been taken */
+static int write_back_lock(uint64_t deadline)
 {
-   int i = 0;
+   struct timespec timeout;
+   uint64_t now = flush_time_us();
+   uint64_t wait = (uint64_t)PasWriteBackTimeoutMs * 1000ULL;
 
-   DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("prepShtdwn - writing all changed data / closing all handles"));
+   if(deadline != 0)
+   {
+      wait = (deadline > now) ? deadline - now : 0;
+   }
+
+   clock_gettime(CLOCK_REALTIME, &timeout);     // pthread_mutex_timedlock uses the realtime clock
+   timeout.tv_sec  += (time_t)(wait / 1000000ULL);
+   timeout.tv_nsec += (long)(wait % 1000000ULL) * 1000L;
+   if(timeout.tv_nsec >= 1000000000L)
+   {
+      timeout.tv_sec++;
+      timeout.tv_nsec -= 1000000000L;
+   }
+
+   return (pthread_mutex_timedlock(&gWriteBackMtx, &timeout) == 0) ? 1 : 0;
+}
+
+
+
+void process_block_and_write_data_back(unsigned int requestID, unsigned int status)
+{
+   pthread_t worker;
+
+   (void)status;
+
+   // the data is written back by a worker thread, the mainloop must not be blocked
+   if(pthread_create(&worker, NULL, write_back_worker, (void*)(uintptr_t)requestID) == 0)
+   {
+      pthread_detach(worker);
+   }
+   else
+   {
+      DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("writeBack - Failed to start worker thread"));
+      (void)write_back_worker((void*)(uintptr_t)requestID);
+   }
+}
+
+
+
+/* deinitialize a custom plugin, executed as flush job */
+static int custom_plugin_deinit_job(int i)
+{
+   uint64_t start = plugin_stats_start();
+   int rval = gPersCustomFuncs[i].custom_plugin_deinit();     // deinitialize plugin
+
+   plugin_stats_add(i, PCL_PLUGIN_OP_DEINIT, start, rval);
+
+   return rval;
+}
+
+
+
+int process_prepare_shutdown(unsigned int complete, const struct timespec* requestTime)
+{
+   int i = 0, failed = 0, locked = 0;
+   uint64_t start = flush_time_us(), deadline = 0;
+   FlushPlan_s plan = {NULL, 0, 0};
+
+   if(requestTime != NULL)    // lifecycle request, the lifecycle timeout has started when the request was received
+   {
+      deadline = (uint64_t)requestTime->tv_sec * 1000000ULL + (uint64_t)requestTime->tv_nsec / 1000ULL;
+      deadline += (uint64_t)(unsigned int)(gTimeoutMs - ShutdownDeadlineReserveMs) * 1000ULL;
+   }
+
+   DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("prepShtdwn - writing all changed data / closing all handles"),
+                                         DLT_STRING("deadline [ms]:"), DLT_INT(deadline != 0 ? (int)((int64_t)(deadline - start) / 1000) : -1));
 
    // block write
    pers_lock_access();
 
-   // flush open files to disk
+   locked = write_back_lock(deadline);
+   if(locked == 0)
+   {
+      // the write back closes the same database handles, nothing must be flushed or closed while it is running
+      DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("prepShtdwn - write back of the administration service still running, nothing closed"));
+      return NsmErrorStatus_Fail;
+   }
+
+   failed += key_cache_flush();         // write back cached keys before the databases will be closed
+
+   if(complete == Shutdown_Full)
+   {
+      warm_start_collect();   // read the values of the snapshot before the databases will be closed
+   }
+
+   // flush open files to disk and close the databases, in the order of their flush priority
 
 #if USE_FILECACHE
    if(complete == Shutdown_Full)
@@ -215,39 +407,71 @@ void process_prepare_shutdown(unsigned int complete)
       pfcWriteBackAndSync(i);
    }
 #else
+   failed += plan_sync_open_files(&plan, fsync);
+#endif
+
+   failed += database_plan_close_all(&plan);      // close opened resource configuration tables and databases
+
+   failed += flush_run_jobs(plan.jobs, plan.count, deadline);
+   database_close_finished(plan.jobs, plan.count);      // closes still running stay marked as closing
+   key_cache_databases_closed((failed == 0) ? 1 : 0);   // keep the redo log if a database may not be written
+
+#if !USE_FILECACHE
    if(complete == Shutdown_Full)
    {
-      list_iterate(&gOpenFdList, &pclFileClose);
-   }
-   else if(complete == Shutdown_Partial)
-   {
-      list_iterate(&gOpenFdList, &fsync);
+      close_open_files(&plan);
    }
 #endif
+   flush_plan_free(&plan);
 
-   pers_rct_close_all();      // close all opened resource configuration table
-
-   database_close_all();      // close opened database
+   // the databases are stamped when the snapshot is written, all of them must have been closed
+   (void)warm_start_write((failed == 0 && (deadline == 0 || flush_time_us() < deadline)) ? 1 : 0);
 
    if(complete > 0)
    {
+      FlushJob_s jobs[PersCustomLib_LastEntry];
+      int numJobs = 0;
+
       close_all_persistence_handle();
 
 		for(i=0; i<PersCustomLib_LastEntry; i++)  // unload custom client libraries
 		{
 			if(gPersCustomFuncs[i].custom_plugin_deinit != NULL)
 			{
-				gPersCustomFuncs[i].custom_plugin_deinit();     // deinitialize plugin
+			   jobs[numJobs].func = custom_plugin_deinit_job;
+			   jobs[numJobs].arg  = i;
+			   jobs[numJobs].type = "plugin";
+			   jobs[numJobs].priority = PCL_FLUSH_PRIO_NORMAL;
+			   numJobs++;
+			}
+		}
 
-				dlclose(gPersCustomFuncs[i].handle);            // close library handle
+		failed += flush_run_jobs(jobs, numJobs, deadline);
 
-				invalidate_custom_plugin(i);
+		for(i=0; i<numJobs; i++)
+		{
+			if(jobs[i].state == FlushJob_Done)       // a plugin still in plugin_deinit must not be unloaded
+			{
+				dlclose(gPersCustomFuncs[jobs[i].arg].handle);            // close library handle
+
+				invalidate_custom_plugin(jobs[i].arg);
 			}
 		}
    }
 
    if(gIsNodeStateManager == 0)
       syncfs(gSyncFd);  // finally make sure to commit buffer cache to disk
+
+   pthread_mutex_unlock(&gWriteBackMtx);
+
+   DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("prepShtdwn - finished, failed or unfinished:"), DLT_INT(failed),
+                                         DLT_STRING("duration [ms]:"), DLT_UINT((unsigned int)((flush_time_us() - start) / 1000)));
+   if(deadline != 0 && flush_time_us() > deadline)
+   {
+      DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("prepShtdwn - deadline missed"));
+   }
+
+   return (failed == 0) ? NsmErrorStatus_OK : NsmErrorStatus_Fail;
 }
 
 
@@ -20,15 +20,23 @@
  */
 
 #include <dbus/dbus.h>
+#include <time.h>
 
 #include "persistence_client_library_dbus_service.h"
 
 /**
  * @brief process a shutdown message (close all open files, open databases, ...
+ *        Files, databases and plugins are flushed and closed in parallel.
  *
  * @param complete The mode: Shutdown_Partial=0; Shutdown_Full=1
+ * @param requestTime time (CLOCK_MONOTONIC) the lifecycle request has been received,
+ *        the flush is bounded by the lifecycle timeout; NULL for an internal shutdown without deadline
+ *
+ * @return NsmErrorStatus_OK if everything has been flushed and closed, NsmErrorStatus_Fail otherwise.
+ *         If a write back of the administration service is still running at the deadline,
+ *         nothing is flushed or closed and NsmErrorStatus_Fail is returned.
  */
-void process_prepare_shutdown(unsigned int complete);
+int process_prepare_shutdown(unsigned int complete, const struct timespec* requestTime);
 
 
 /**
@@ -80,7 +88,9 @@ void process_send_lifecycle_register(DBusConnection* conn, int regType, int shut
 
 
 /**
- * @brief block persistence access and write data back to device
+ * @brief block persistence access and write data back to device.
+ *        The data is written back by a worker thread, which sends ::CMD_PAS_WRITE_BACK_DONE
+ *        to the mainloop when the data is durable.
  *
  * @param requestID the requestID
  * @param status the status
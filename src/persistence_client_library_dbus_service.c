@@ -58,6 +58,31 @@ const char* gDbusPersAdminConsMsg       = "PersistenceAdminRequest";
 /// communication channel into the dbus mainloop
 static int gPipeFd[2] = {-1};
 
+/// state of the dbus mainloop: 1 usable, 0 setup pending (asynchronous init), -1 setup failed
+static int gMainLoopState = 1;
+static pthread_mutex_t gMainLoopStateMtx = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  gMainLoopStateCond = PTHREAD_COND_INITIALIZER;
+
+
+/// notification already delivered by ::process_local_notification, waiting for its own D-Bus signal
+typedef struct _LocalNotify_s
+{
+   /// the notification status
+   unsigned int status;
+   /// logical database ID
+   unsigned int ldbid;
+   /// the user ID
+   unsigned int user_no;
+   /// the seat number
+   unsigned int seat_no;
+   /// the resource ID
+   char resource_id[PERS_DB_MAX_LENGTH_KEY_NAME];
+} LocalNotify_s;
+
+/// local notifications in the order they have been sent, only accessed by the mainloop thread
+static LocalNotify_s gLocalNotify[LocalNotifyMax];
+static int gLocalNotifyCount = 0;
+
 
 typedef enum EDBusObjectType
 {
@@ -146,6 +171,29 @@ void* registerToPas(void* data)
 
 
 
+/* remove the local notification of an own D-Bus signal, returns 1 if the signal has been sent as a local notification */
+static int local_notify_remove(const pclNotification_s* notifyStruct)
+{
+   int i = 0;
+
+   for(i = 0; i < gLocalNotifyCount; i++)
+   {
+      if(   gLocalNotify[i].status  == (unsigned int)notifyStruct->pclKeyNotify_Status
+         && gLocalNotify[i].ldbid   == notifyStruct->ldbid
+         && gLocalNotify[i].user_no == notifyStruct->user_no
+         && gLocalNotify[i].seat_no == notifyStruct->seat_no
+         && strcmp(gLocalNotify[i].resource_id, notifyStruct->resource_id) == 0)
+      {
+         gLocalNotifyCount--;
+         memmove(&gLocalNotify[i], &gLocalNotify[i+1], (size_t)(gLocalNotifyCount - i) * sizeof(LocalNotify_s));
+         return 1;
+      }
+   }
+   return 0;
+}
+
+
+
 /* catches messages not directed to any registered object path ("garbage collector") */
 static DBusHandlerResult handleObjectPathMessageFallback(DBusConnection * connection, DBusMessage * message, void * user_data)
 {
@@ -209,7 +257,14 @@ static DBusHandlerResult handleObjectPathMessageFallback(DBusConnection * connec
                notifyStruct.user_no     = (unsigned int)atoi(user_no);
                notifyStruct.seat_no     = (unsigned int)atoi(seat_no);
 
-               if(gChangeNotifyCallback != NULL )  // call the registered callback function
+               // own signals sent as local notification have already been delivered by process_local_notification
+               if(   dbus_message_get_sender(message) != NULL && dbus_bus_get_unique_name(connection) != NULL
+                  && 0 == strcmp(dbus_message_get_sender(message), dbus_bus_get_unique_name(connection))
+                  && local_notify_remove(&notifyStruct) == 1)
+               {
+                  DLT_LOG(gPclDLTContext, DLT_LOG_VERBOSE, DLT_STRING("handleObjPathMsgFback - own signal delivered locally"));
+               }
+               else if(gChangeNotifyCallback != NULL )  // call the registered callback function
                {
                   gChangeNotifyCallback(&notifyStruct);
                }
@@ -618,6 +673,38 @@ int setup_dbus_mainloop(void)
 
 
 
+/* call the change callback for a key written by this process, the own D-Bus signal of the key is ignored */
+static void process_local_notification(MainLoopData_u* readData)
+{
+   pclNotification_s notifyStruct;
+
+   notifyStruct.pclKeyNotify_Status = (pclNotifyStatus_e)readData->params[3];
+   notifyStruct.ldbid               = readData->params[0];
+   notifyStruct.user_no             = readData->params[1];
+   notifyStruct.seat_no             = readData->params[2];
+   notifyStruct.resource_id         = readData->string;
+
+   if(gLocalNotifyCount == LocalNotifyMax)
+   {
+      // the oldest signal has not been received, e.g. the notification has been unregistered meanwhile
+      gLocalNotifyCount--;
+      memmove(&gLocalNotify[0], &gLocalNotify[1], (size_t)gLocalNotifyCount * sizeof(LocalNotify_s));
+   }
+   gLocalNotify[gLocalNotifyCount].status  = (unsigned int)readData->params[3];
+   gLocalNotify[gLocalNotifyCount].ldbid   = (unsigned int)readData->params[0];
+   gLocalNotify[gLocalNotifyCount].user_no = (unsigned int)readData->params[1];
+   gLocalNotify[gLocalNotifyCount].seat_no = (unsigned int)readData->params[2];
+   snprintf(gLocalNotify[gLocalNotifyCount].resource_id, PERS_DB_MAX_LENGTH_KEY_NAME, "%s", readData->string);
+   gLocalNotifyCount++;
+
+   if(gChangeNotifyCallback != NULL)
+   {
+      gChangeNotifyCallback(&notifyStruct);
+   }
+}
+
+
+
 int dispatchInternalCommand(DBusConnection* conn, MainLoopData_u* readData, int* quit)
 {
    int rval = 1;
@@ -625,8 +712,10 @@ int dispatchInternalCommand(DBusConnection* conn, MainLoopData_u* readData, int*
    DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("mainLoop - receive cmd:"), DLT_UINT(readData->cmd));
    switch (readData->cmd)
    {
-      case CMD_PAS_BLOCK_AND_WRITE_BACK:
+      case CMD_PAS_BLOCK_AND_WRITE_BACK:     // the response is sent with CMD_PAS_WRITE_BACK_DONE when the data is durable
          process_block_and_write_data_back((unsigned int)readData->params[1] /*requestID*/, (unsigned int)readData->params[0] /*status*/);
+         break;
+      case CMD_PAS_WRITE_BACK_DONE:
          process_send_pas_request(conn,    (unsigned int)readData->params[1] /*request*/,   (int)readData->params[0] /*status*/);
          break;
       case CMD_LC_PREPARE_SHUTDOWN:
@@ -635,17 +724,24 @@ int dispatchInternalCommand(DBusConnection* conn, MainLoopData_u* readData, int*
          if(readData->params[1] == 0)  // if params[1] == 0, internal shutdown; no need to send lifecycle notification
          {
             DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("mainLoop  internal shutdown"), DLT_UINT(readData->cmd));
-            process_prepare_shutdown(readData->params[0]);
+            (void)process_prepare_shutdown(readData->params[0], NULL);
          }
          else
          {
+            struct timespec requestTime;
+            int status = 0;
+
+            requestTime.tv_sec  = (time_t)readData->params[2];    // time the lifecycle request has been received
+            requestTime.tv_nsec = (long)readData->params[3];
+
             DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("mainLoop  external shutdown"), DLT_UINT(readData->cmd));
-            process_prepare_shutdown(Shutdown_Full);
-            process_send_lifecycle_request(conn, (unsigned int)readData->params[1] /*requestID*/, (unsigned int)readData->params[0] /*status*/);
+            status = process_prepare_shutdown(Shutdown_Full, &requestTime);
+            process_send_lifecycle_request(conn, (unsigned int)readData->params[1] /*requestID*/, (unsigned int)status);
          }
          break;
       }
       case CMD_SEND_NOTIFY_SIGNAL:
+      case CMD_SEND_NOTIFY_LOCAL:      // the callback will be called after the sender has been released
          process_send_notification_signal(conn, (unsigned int)readData->params[0] /*ldbid*/, (unsigned int)readData->params[1], /*user*/
                                                 (unsigned int)readData->params[2] /*seat*/,  (unsigned int)readData->params[3], /*reason*/
                                                 readData->string);
@@ -740,6 +836,11 @@ void* mainLoop(void* userData)
                         gMainLoopCondValue = 1;
                         pthread_cond_signal(&gMainLoopCond);
                         pthread_mutex_unlock(&gMainCondMtx);
+
+                        if(readData.cmd == CMD_SEND_NOTIFY_LOCAL)
+                        {
+                           process_local_notification(&readData);
+                        }
                      }
                   }
                }
@@ -791,6 +892,25 @@ void* mainLoop(void* userData)
 
 
 
+void set_dbus_mainloop_pending(void)
+{
+   pthread_mutex_lock(&gMainLoopStateMtx);
+   gMainLoopState = 0;
+   pthread_mutex_unlock(&gMainLoopStateMtx);
+}
+
+
+
+void set_dbus_mainloop_ready(int ok)
+{
+   pthread_mutex_lock(&gMainLoopStateMtx);
+   gMainLoopState = (ok == 1) ? 1 : -1;
+   pthread_cond_broadcast(&gMainLoopStateCond);
+   pthread_mutex_unlock(&gMainLoopStateMtx);
+}
+
+
+
 int deliverToMainloop(MainLoopData_u* payload)
 {
    int rval = 0;
@@ -798,12 +918,15 @@ int deliverToMainloop(MainLoopData_u* payload)
    pthread_mutex_lock(&gDeliverpMtx);     // make sure  deliverToMainloop will be used exclusively
    rval = deliverToMainloop_NM(payload);
 
-   pthread_mutex_lock(&gMainCondMtx);     // mutex needed for pthread condition used to wait on other thread (mainloop)
-   while(0 == gMainLoopCondValue)
-      pthread_cond_wait(&gMainLoopCond, &gMainCondMtx);
-   pthread_mutex_unlock(&gMainCondMtx);
+   if(rval == 0)     // don't wait for a message that has not been delivered
+   {
+      pthread_mutex_lock(&gMainCondMtx);     // mutex needed for pthread condition used to wait on other thread (mainloop)
+      while(0 == gMainLoopCondValue)
+         pthread_cond_wait(&gMainLoopCond, &gMainCondMtx);
+      pthread_mutex_unlock(&gMainCondMtx);
 
-   gMainLoopCondValue = 0;
+      gMainLoopCondValue = 0;
+   }
    pthread_mutex_unlock(&gDeliverpMtx);
 
    return rval;
@@ -813,9 +936,20 @@ int deliverToMainloop(MainLoopData_u* payload)
 
 int deliverToMainloop_NM(MainLoopData_u* payload)
 {
-   int rval = 0;
+   int rval = 0, state = 0;
+
+   pthread_mutex_lock(&gMainLoopStateMtx);      // wait until the mainloop has been set up by the asynchronous init
+   while(gMainLoopState == 0)
+      pthread_cond_wait(&gMainLoopStateCond, &gMainLoopStateMtx);
+   state = gMainLoopState;
+   pthread_mutex_unlock(&gMainLoopStateMtx);
 
-   if(-1 == write(gPipeFd[1], payload, sizeof(MainLoopData_u)))
+   if(state != 1)
+   {
+     DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("toMainloop => no mainloop"));
+     rval = -1;
+   }
+   else if(-1 == write(gPipeFd[1], payload, sizeof(MainLoopData_u)))
    {
      DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("toMainloop => failed write pipe"), DLT_INT(errno));
      rval = -1;
@@ -39,12 +39,16 @@ typedef enum ECmd
    CMD_LC_PREPARE_SHUTDOWN,
    /// command send changed notification signal
    CMD_SEND_NOTIFY_SIGNAL,
+   /// command send changed notification signal and call the change callback of this process
+   CMD_SEND_NOTIFY_LOCAL,
    /// command send register/unregister command
    CMD_REG_NOTIFY_SIGNAL,
    /// command send admin register/unregister
    CMD_SEND_PAS_REGISTER,
    /// command send lifecycle register/unregister
    CMD_SEND_LC_REGISTER,
+   /// command send the response of a block and write back request, the data has been written back
+   CMD_PAS_WRITE_BACK_DONE,
    /// quit command
    CMD_QUIT
 } tCmd;
@@ -119,6 +123,21 @@ void* mainLoop(void* userData);
 int setup_dbus_mainloop(void);
 
 
+/**
+ * @brief the mainloop will be set up in the background,
+ *        messages to the mainloop wait until ::set_dbus_mainloop_ready has been called
+ */
+void set_dbus_mainloop_pending(void);
+
+
+/**
+ * @brief the background setup of the mainloop has finished
+ *
+ * @param ok 1 if the mainloop has been set up, messages fail otherwise
+ */
+void set_dbus_mainloop_ready(int ok);
+
+
 /**
  * @brief deliver message to mainloop (blocking)
  *        The function blocks until the message has
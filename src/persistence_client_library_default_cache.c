@@ -0,0 +1,241 @@
+/******************************************************************************
+ * Project         Persistency
+ * (c) copyright   2012
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+******************************************************************************/
+ /**
+ * @file           persistence_client_library_default_cache.c
+ * @ingroup        Persistence client library
+ * @author         Ingo Huerner
+ * @brief          Implementation of the default value cache.
+ *                 Open addressing hash table with linear probing, keys and
+ *                 values are stored in one string pool.
+ * @see
+ */
+
+#include "persistence_client_library_default_cache.h"
+#include "persistence_client_library_custom_loader.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/// entry of the default value cache
+typedef struct _PersDefaultEntry_s
+{
+   /// hash of the key
+   uint32_t hash;
+   /// offset of the key in the pool
+   uint32_t keyOffset;
+   /// offset of the value in the pool
+   uint32_t dataOffset;
+   /// size of the value
+   uint32_t dataSize;
+} PersDefaultEntry_s;
+
+
+struct _PersDefaultCache_s
+{
+   /// number of entries
+   uint32_t count;
+   /// number of slots - 1 (the number of slots is a power of 2)
+   uint32_t mask;
+   /// slots, entry index + 1 or 0 for an empty slot
+   uint32_t* slots;
+   /// entries
+   PersDefaultEntry_s* entries;
+   /// pool for keys and values
+   char* pool;
+   /// used size of the pool
+   uint32_t poolSize;
+};
+
+
+static uint32_t default_cache_hash(const char* key)
+{
+   uint32_t h = 2166136261U;     // FNV-1a
+
+   while(*key != '\0')
+   {
+      h ^= (uint8_t)*key++;
+      h *= 16777619U;
+   }
+   return h;
+}
+
+
+/* find the slot of a key, the slot is empty if the key is not in the cache */
+static uint32_t default_cache_slot(const PersDefaultCache_s* cache, const char* key, uint32_t hash)
+{
+   uint32_t slot = hash & cache->mask;
+
+   while(cache->slots[slot] != 0)
+   {
+      const PersDefaultEntry_s* entry = &cache->entries[cache->slots[slot] - 1];
+
+      if(entry->hash == hash && strcmp(cache->pool + entry->keyOffset, key) == 0)
+         break;
+
+      slot = (slot + 1) & cache->mask;
+   }
+   return slot;
+}
+
+
+/* get the key list of a database, the list must be released with free */
+static int default_cache_get_keys(int handle, char** list)
+{
+   int listSize = -1;
+
+   *list = NULL;
+
+   if(handle >= 0 && *plugin_persComDbGetSizeKeysList != NULL && *plugin_persComDbGetKeysList != NULL)
+   {
+      listSize = plugin_persComDbGetSizeKeysList(handle);
+      if(listSize > 0)
+      {
+         *list = calloc((size_t)listSize + 1, 1);
+         if(*list == NULL || plugin_persComDbGetKeysList(handle, *list, listSize) < 0)
+         {
+            listSize = -1;
+         }
+      }
+   }
+   return listSize;
+}
+
+
+/* add all keys of a database which are not already in the cache */
+static int default_cache_add(PersDefaultCache_s* cache, int handle, const char* list, int listSize, unsigned int maxSize)
+{
+   int rval = 0, i = 0;
+
+   for(i = 0; i < listSize && rval == 0; i += (int)strlen(&list[i]) + 1)
+   {
+      const char* key = &list[i];
+      uint32_t hash = default_cache_hash(key);
+      uint32_t slot = 0;
+
+      if(key[0] == '\0')
+         continue;
+
+      slot = default_cache_slot(cache, key, hash);
+      if(cache->slots[slot] == 0)
+      {
+         int dataSize = plugin_persComDbGetKeySize(handle, key);
+         size_t keySize = strlen(key) + 1;
+
+         if(dataSize >= 0 && (size_t)cache->poolSize + keySize + (size_t)dataSize <= maxSize)
+         {
+            char* pool = realloc(cache->pool, (size_t)cache->poolSize + keySize + (size_t)dataSize + 1);
+
+            if(pool != NULL)
+            {
+               PersDefaultEntry_s* entry = &cache->entries[cache->count];
+
+               cache->pool = pool;
+               entry->hash       = hash;
+               entry->keyOffset  = cache->poolSize;
+               entry->dataOffset = cache->poolSize + (uint32_t)keySize;
+               entry->dataSize   = (uint32_t)dataSize;
+               memcpy(pool + entry->keyOffset, key, keySize);
+
+               if(plugin_persComDbReadKey(handle, key, pool + entry->dataOffset, dataSize) == dataSize)
+               {
+                  cache->poolSize += (uint32_t)keySize + (uint32_t)dataSize;
+                  cache->slots[slot] = ++cache->count;
+               }
+               else
+               {
+                  rval = -1;
+               }
+            }
+            else
+            {
+               rval = -1;
+            }
+         }
+         else
+         {
+            rval = -1;     // too big for the cache
+         }
+      }
+   }
+   return rval;
+}
+
+
+PersDefaultCache_s* default_cache_create(int handleConfDefault, int handleFactoryDefault, unsigned int maxSize)
+{
+   PersDefaultCache_s* cache = NULL;
+   char* confList = NULL;
+   char* factoryList = NULL;
+   int confSize = default_cache_get_keys(handleConfDefault, &confList);
+   int factorySize = default_cache_get_keys(handleFactoryDefault, &factoryList);
+
+   if(   confSize >= 0 && factorySize >= 0
+      && *plugin_persComDbGetKeySize != NULL && *plugin_persComDbReadKey != NULL)
+   {
+      // every key needs at least two bytes in the key list, that's the upper limit of entries
+      uint32_t maxEntries = (uint32_t)(confSize + factorySize) / 2U + 1U;
+      uint32_t numSlots = 2;
+
+      while(numSlots < maxEntries * 2U)
+         numSlots <<= 1;
+
+      cache = calloc(1, sizeof(PersDefaultCache_s));
+      if(cache != NULL)
+      {
+         cache->mask    = numSlots - 1;
+         cache->slots   = calloc(numSlots, sizeof(uint32_t));
+         cache->entries = calloc(maxEntries, sizeof(PersDefaultEntry_s));
+
+         if(   cache->slots == NULL || cache->entries == NULL
+            || default_cache_add(cache, handleConfDefault, confList, confSize, maxSize) != 0
+            || default_cache_add(cache, handleFactoryDefault, factoryList, factorySize, maxSize) != 0)
+         {
+            default_cache_destroy(cache);
+            cache = NULL;
+         }
+      }
+   }
+
+   free(confList);
+   free(factoryList);
+
+   return cache;
+}
+
+
+int default_cache_find(const PersDefaultCache_s* cache, const char* key, const char** data)
+{
+   int size = EPERS_NOKEY;
+   uint32_t slot = default_cache_slot(cache, key, default_cache_hash(key));
+
+   if(cache->slots[slot] != 0)
+   {
+      const PersDefaultEntry_s* entry = &cache->entries[cache->slots[slot] - 1];
+
+      *data = cache->pool + entry->dataOffset;
+      size = (int)entry->dataSize;
+   }
+   return size;
+}
+
+
+void default_cache_destroy(PersDefaultCache_s* cache)
+{
+   if(cache != NULL)
+   {
+      free(cache->slots);
+      free(cache->entries);
+      free(cache->pool);
+      free(cache);
+   }
+}
@@ -0,0 +1,73 @@
+#ifndef PERSISTENCE_CLIENT_LIBRARY_DEFAULT_CACHE_H
+#define PERSISTENCE_CLIENT_LIBRARY_DEFAULT_CACHE_H
+
+/******************************************************************************
+ * Project         Persistency
+ * (c) copyright   2012
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+******************************************************************************/
+ /**
+ * @file           persistence_client_library_default_cache.h
+ * @ingroup        Persistence client library
+ * @author         Ingo Huerner
+ * @brief          Header of the default value cache.
+ *                 The cache holds the complete content of the configurable and
+ *                 the factory default database in an immutable hash table.
+ *                 As the content is complete, a key not found in the cache
+ *                 does not have a default value (negative lookup).
+ * @see
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/// opaque default value cache type
+typedef struct _PersDefaultCache_s PersDefaultCache_s;
+
+
+/**
+ * @brief create a default value cache from the default databases.
+ *        Values of the configurable default database take precedence.
+ *
+ * @param handleConfDefault handle of the configurable default database
+ * @param handleFactoryDefault handle of the factory default database
+ * @param maxSize the max size of all keys and values,
+ *        if the databases are bigger the cache will not be created
+ *
+ * @return the cache or NULL if the cache could not be created
+ */
+PersDefaultCache_s* default_cache_create(int handleConfDefault, int handleFactoryDefault, unsigned int maxSize);
+
+
+/**
+ * @brief find the default value of a key
+ *
+ * @param cache the default value cache
+ * @param key the database key
+ * @param data pointer to store the address of the value inside the cache
+ *
+ * @return the size of the value or EPERS_NOKEY if the key has no default value
+ */
+int default_cache_find(const PersDefaultCache_s* cache, const char* key, const char** data);
+
+
+/**
+ * @brief destroy a default value cache
+ *
+ * @param cache the default value cache, can be NULL
+ */
+void default_cache_destroy(PersDefaultCache_s* cache);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PERSISTENCE_CLIENT_LIBRARY_DEFAULT_CACHE_H */
@@ -22,6 +22,7 @@
 #include "persistence_client_library_pas_interface.h"
 #include "persistence_client_library_handle.h"
 #include "persistence_client_library_prct_access.h"
+#include "persistence_client_library_flush.h"
 #include "crc32.h"
 
 
@@ -392,6 +393,7 @@ int pclFileOpenRegular(PersistenceInfo_s* dbContext, const char* resource_id, ch
             {
                set_file_backup_status(handle, wantBackup);
                list_item_insert(&gOpenFdList, handle);
+               list_item_set_priority(&gOpenFdList, handle, flush_priority_get(resource_id));
             }
             else
             {
@@ -430,6 +432,7 @@ int pclFileOpenRegular(PersistenceInfo_s* dbContext, const char* resource_id, ch
             {
                set_file_backup_status(handle, 1);
                list_item_insert(&gOpenFdList, handle);
+               list_item_set_priority(&gOpenFdList, handle, flush_priority_get(resource_id));
             }
             else
             {
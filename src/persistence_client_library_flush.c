@@ -0,0 +1,371 @@
+/******************************************************************************
+ * Project         Persistency
+ * (c) copyright   2012
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+******************************************************************************/
+ /**
+ * @file           persistence_client_library_flush.c
+ * @ingroup        Persistence client library
+ * @author         Ingo Huerner
+ * @brief          Implementation of the worker pool flushing and closing resources at shutdown.
+ *                 The workers are detached, the run is freed by the last of the caller
+ *                 and the workers, so a worker blocked in a job can't block the caller.
+ * @see
+ */
+
+#include "persistence_client_library_flush.h"
+#include "persistence_client_library_data_organization.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <dlt.h>
+
+DLT_IMPORT_CONTEXT(gPclDLTContext);
+
+
+/// a run of flush jobs, shared by the caller and the workers
+typedef struct _FlushRun_s
+{
+   pthread_mutex_t mtx;
+   /// signalled when a job has finished or no more jobs will be started
+   pthread_cond_t cond;
+   /// copy of the jobs of the caller
+   FlushJob_s* jobs;
+   int count;
+   /// the next job to start
+   int next;
+   /// the number of finished jobs
+   int finished;
+   /// set if no more jobs must be started
+   int stop;
+   /// the caller and the workers still using the run
+   int refs;
+   uint64_t deadline;
+} FlushRun_s;
+
+
+/// resource with a flush priority
+typedef struct _FlushPriority_s
+{
+   /// the resource ID
+   char resource_id[PERS_DB_MAX_LENGTH_KEY_NAME];
+   /// the priority
+   int priority;
+} FlushPriority_s;
+
+
+/// resources with a flush priority other than ::PCL_FLUSH_PRIO_NORMAL
+static FlushPriority_s gFlushPriority[FlushPriorityMaxKeys];
+/// number of resources with a flush priority
+static int gFlushPriorityCount = 0;
+/// mutex protecting the flush priorities
+static pthread_mutex_t gFlushPriorityMtx = PTHREAD_MUTEX_INITIALIZER;
+
+
+
+uint64_t flush_time_us(void)
+{
+   struct timespec now;
+
+   clock_gettime(CLOCK_MONOTONIC, &now);
+
+   return (uint64_t)now.tv_sec * 1000000ULL + (uint64_t)now.tv_nsec / 1000ULL;
+}
+
+
+
+/* release a reference to the run, must be called with the run locked */
+static void flush_run_release(FlushRun_s* run)
+{
+   int last = (--run->refs == 0);
+
+   pthread_mutex_unlock(&run->mtx);
+
+   if(last)
+   {
+      pthread_cond_destroy(&run->cond);
+      pthread_mutex_destroy(&run->mtx);
+      free(run->jobs);
+      free(run);
+   }
+}
+
+
+
+static void* flush_worker(void* data)
+{
+   FlushRun_s* run = (FlushRun_s*)data;
+
+   pthread_mutex_lock(&run->mtx);
+   while(run->stop == 0 && run->next < run->count)
+   {
+      FlushJob_s* job = &run->jobs[run->next];
+      int result = 0;
+
+      if(run->deadline != 0 && flush_time_us() >= run->deadline)
+      {
+         run->stop = 1;                      // deadline expired, leave the remaining jobs
+         pthread_cond_broadcast(&run->cond);
+         break;
+      }
+
+      run->next++;
+      job->state = FlushJob_Running;
+      pthread_mutex_unlock(&run->mtx);
+
+      result = job->func(job->arg);
+
+      pthread_mutex_lock(&run->mtx);
+      job->result = result;
+      job->state  = FlushJob_Done;
+      run->finished++;
+      pthread_cond_broadcast(&run->cond);
+   }
+   flush_run_release(run);
+
+   return NULL;
+}
+
+
+
+int flush_run_jobs(FlushJob_s* jobs, int count, uint64_t deadline)
+{
+   int i = 0, numWorker = 0, failed = 0;
+   FlushRun_s* run = NULL;
+   pthread_condattr_t attr;
+
+   if(count <= 0)
+      return 0;
+
+   for(i = 0; i < count; i++)    // stable insertion sort by priority, most of the jobs have the same priority
+   {
+      FlushJob_s job = jobs[i];
+      int j = i;
+
+      while(j > 0 && jobs[j-1].priority > job.priority)
+      {
+         jobs[j] = jobs[j-1];
+         j--;
+      }
+      jobs[j] = job;
+      jobs[j].state  = FlushJob_NotStarted;
+      jobs[j].result = 0;
+   }
+
+   run = (FlushRun_s*)malloc(sizeof(FlushRun_s));
+   if(run != NULL)
+   {
+      run->jobs = (FlushJob_s*)malloc((size_t)count * sizeof(FlushJob_s));
+      if(run->jobs == NULL)
+      {
+         free(run);
+         run = NULL;
+      }
+   }
+
+   if(run == NULL)
+   {
+      DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("flush - no memory, flush sequentially"));
+      for(i = 0; i < count && (deadline == 0 || flush_time_us() < deadline); i++)
+      {
+         jobs[i].result = jobs[i].func(jobs[i].arg);
+         jobs[i].state  = FlushJob_Done;
+      }
+   }
+   else
+   {
+      memcpy(run->jobs, jobs, (size_t)count * sizeof(FlushJob_s));
+      run->count    = count;
+      run->next     = 0;
+      run->finished = 0;
+      run->stop     = 0;
+      run->refs     = 1;
+      run->deadline = deadline;
+      pthread_mutex_init(&run->mtx, NULL);
+      pthread_condattr_init(&attr);
+      pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+      pthread_cond_init(&run->cond, &attr);
+      pthread_condattr_destroy(&attr);
+
+      pthread_mutex_lock(&run->mtx);
+      while(numWorker < ShutdownFlushThreads && numWorker < count)
+      {
+         pthread_t worker;
+
+         run->refs++;
+         if(pthread_create(&worker, NULL, flush_worker, run) != 0)
+         {
+            run->refs--;
+            DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("flush - Failed to start worker thread"));
+            break;
+         }
+         pthread_detach(worker);
+         numWorker++;
+      }
+
+      if(numWorker == 0)
+      {
+         run->refs++;
+         pthread_mutex_unlock(&run->mtx);
+         (void)flush_worker(run);               // no worker, the caller executes the jobs
+         pthread_mutex_lock(&run->mtx);
+      }
+
+      // wait until all started jobs have finished and no more will be started
+      while(run->finished < run->next || (run->stop == 0 && run->next < run->count))
+      {
+         if(deadline != 0)
+         {
+            struct timespec ts;
+
+            ts.tv_sec  = (time_t)(deadline / 1000000ULL);
+            ts.tv_nsec = (long)(deadline % 1000000ULL) * 1000L;
+            if(pthread_cond_timedwait(&run->cond, &run->mtx, &ts) == ETIMEDOUT)
+            {
+               break;
+            }
+         }
+         else
+         {
+            pthread_cond_wait(&run->cond, &run->mtx);
+         }
+      }
+      run->stop = 1;
+
+      memcpy(jobs, run->jobs, (size_t)count * sizeof(FlushJob_s));
+      flush_run_release(run);
+   }
+
+   for(i = 0; i < count; i++)
+   {
+      if(jobs[i].state != FlushJob_Done || jobs[i].result < 0)
+      {
+         DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("flush -"), DLT_STRING(jobs[i].type), DLT_INT(jobs[i].arg),
+                 DLT_STRING(jobs[i].state == FlushJob_Done ? "failed:" : (jobs[i].state == FlushJob_Running ? "still running" : "not started")),
+                 DLT_INT(jobs[i].result));
+         failed++;
+      }
+   }
+
+   return failed;
+}
+
+
+
+int flush_plan_add(FlushPlan_s* plan, int (*func)(int arg), int arg, const char* type, int priority)
+{
+   if(plan->count == plan->size)
+   {
+      int size = (plan->size == 0) ? 64 : 2 * plan->size;
+      FlushJob_s* jobs = (FlushJob_s*)realloc(plan->jobs, (size_t)size * sizeof(FlushJob_s));
+
+      if(jobs == NULL)
+      {
+         return -1;
+      }
+      plan->jobs = jobs;
+      plan->size = size;
+   }
+
+   plan->jobs[plan->count].func     = func;
+   plan->jobs[plan->count].arg      = arg;
+   plan->jobs[plan->count].type     = type;
+   plan->jobs[plan->count].priority = priority;
+   plan->count++;
+
+   return 0;
+}
+
+
+
+void flush_plan_free(FlushPlan_s* plan)
+{
+   free(plan->jobs);
+   plan->jobs  = NULL;
+   plan->count = 0;
+   plan->size  = 0;
+}
+
+
+
+int flush_priority_set(const char* resource_id, int priority)
+{
+   int rval = 0, i = 0;
+
+   pthread_mutex_lock(&gFlushPriorityMtx);
+   for(i = 0; i < gFlushPriorityCount; i++)
+   {
+      if(strcmp(gFlushPriority[i].resource_id, resource_id) == 0)
+         break;
+   }
+
+   if(priority == PCL_FLUSH_PRIO_NORMAL)
+   {
+      if(i < gFlushPriorityCount)      // the default priority is not stored
+      {
+         gFlushPriority[i] = gFlushPriority[gFlushPriorityCount-1];
+         __sync_sub_and_fetch(&gFlushPriorityCount, 1);
+      }
+   }
+   else if(i < gFlushPriorityCount)
+   {
+      gFlushPriority[i].priority = priority;
+   }
+   else if(i < FlushPriorityMaxKeys)
+   {
+      strncpy(gFlushPriority[i].resource_id, resource_id, PERS_DB_MAX_LENGTH_KEY_NAME);
+      gFlushPriority[i].resource_id[PERS_DB_MAX_LENGTH_KEY_NAME-1] = '\0';
+      gFlushPriority[i].priority = priority;
+      __sync_add_and_fetch(&gFlushPriorityCount, 1);
+   }
+   else
+   {
+      DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("flush - too many priorities, ignored:"), DLT_STRING(resource_id));
+      rval = -1;
+   }
+   pthread_mutex_unlock(&gFlushPriorityMtx);
+
+   return rval;
+}
+
+
+
+int flush_priority_get(const char* resource_id)
+{
+   int priority = PCL_FLUSH_PRIO_NORMAL;
+
+   if(resource_id != NULL && __sync_add_and_fetch(&gFlushPriorityCount, 0) > 0)  // no lock if no priority has been set
+   {
+      int i = 0;
+
+      pthread_mutex_lock(&gFlushPriorityMtx);
+      for(i = 0; i < gFlushPriorityCount; i++)
+      {
+         if(strcmp(gFlushPriority[i].resource_id, resource_id) == 0)
+         {
+            priority = gFlushPriority[i].priority;
+            break;
+         }
+      }
+      pthread_mutex_unlock(&gFlushPriorityMtx);
+   }
+
+   return priority;
+}
+
+
+
+void flush_priority_clear(void)
+{
+   pthread_mutex_lock(&gFlushPriorityMtx);
+   gFlushPriorityCount = 0;
+   pthread_mutex_unlock(&gFlushPriorityMtx);
+}
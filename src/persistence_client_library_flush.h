@@ -0,0 +1,151 @@
+#ifndef PERSISTENCE_CLIENT_LIBRARY_FLUSH_H
+#define PERSISTENCE_CLIENT_LIBRARY_FLUSH_H
+
+/******************************************************************************
+ * Project         Persistency
+ * (c) copyright   2012
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+******************************************************************************/
+ /**
+ * @file           persistence_client_library_flush.h
+ * @ingroup        Persistence client library
+ * @author         Ingo Huerner
+ * @brief          Header of the worker pool flushing and closing resources at shutdown.
+ *                 The jobs of a run are executed in parallel until a deadline, in the
+ *                 order of their flush priority (see ::pclSetFlushPriority).
+ *                 Jobs still running at the deadline are left to their worker thread.
+ * @see
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "../include/persistence_client_library.h"
+
+#include <stdint.h>
+
+
+/// state of a flush job
+typedef enum _FlushJobState_e
+{
+   /// the job has not been started before the deadline
+   FlushJob_NotStarted = 0,
+   /// the job was still running at the deadline
+   FlushJob_Running,
+   /// the job has finished, see the result
+   FlushJob_Done
+} FlushJobState_e;
+
+
+/// a job of a flush run
+typedef struct _FlushJob_s
+{
+   /// the job function, returns a negative value on error
+   int (*func)(int arg);
+   /// the argument of the job function
+   int arg;
+   /// the type of the resource, used for logging
+   const char* type;
+   /// the flush priority, see ::PCL_FLUSH_PRIO_CRITICAL
+   int priority;
+   /// the result of the job function
+   int result;
+   /// the state of the job
+   FlushJobState_e state;
+} FlushJob_s;
+
+
+/// jobs to be executed in one run
+typedef struct _FlushPlan_s
+{
+   /// the jobs
+   FlushJob_s* jobs;
+   /// the number of jobs
+   int count;
+   /// the number of allocated jobs
+   int size;
+} FlushPlan_s;
+
+
+/**
+ * @brief get the current time of the monotonic clock
+ *
+ * @return the time in microseconds
+ */
+uint64_t flush_time_us(void);
+
+
+/**
+ * @brief execute jobs in parallel, no job will be started after the deadline.
+ *        The jobs are sorted and started by priority, jobs of the same priority in the given order.
+ *        The outcome of every job which failed or has not finished is logged.
+ *
+ * @param jobs the jobs, the jobs will be sorted and the state and result will be set
+ * @param count the number of jobs
+ * @param deadline the deadline (see ::flush_time_us) or 0 to wait until all jobs have finished
+ *
+ * @return the number of jobs which failed or have not finished
+ */
+int flush_run_jobs(FlushJob_s* jobs, int count, uint64_t deadline);
+
+
+/**
+ * @brief add a job to a plan, the plan must be initialized with zeros
+ *
+ * @param plan the plan
+ * @param func the job function
+ * @param arg the argument of the job function
+ * @param type the type of the resource, used for logging
+ * @param priority the flush priority
+ *
+ * @return 0 on success, -1 if there is no memory (the job has not been added)
+ */
+int flush_plan_add(FlushPlan_s* plan, int (*func)(int arg), int arg, const char* type, int priority);
+
+
+/**
+ * @brief free the jobs of a plan
+ *
+ * @param plan the plan
+ */
+void flush_plan_free(FlushPlan_s* plan);
+
+
+/**
+ * @brief set the flush priority of a resource
+ *
+ * @param resource_id the resource ID
+ * @param priority the priority, ::PCL_FLUSH_PRIO_NORMAL removes the resource
+ *
+ * @return 0 on success, -1 if too many priorities have been set
+ */
+int flush_priority_set(const char* resource_id, int priority);
+
+
+/**
+ * @brief get the flush priority of a resource
+ *
+ * @param resource_id the resource ID
+ *
+ * @return the priority, ::PCL_FLUSH_PRIO_NORMAL if none has been set
+ */
+int flush_priority_get(const char* resource_id);
+
+
+/**
+ * @brief remove all flush priorities
+ */
+void flush_priority_clear(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PERSISTENCE_CLIENT_LIBRARY_FLUSH_H */
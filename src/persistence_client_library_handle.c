@@ -71,6 +71,7 @@ int list_item_insert(PersList_item_s** list, int fd)
          if(tmp->next != NULL)
          {
             tmp->next->fd = fd;
+            tmp->next->priority = PCL_FLUSH_PRIO_NORMAL;
             tmp->next->next = NULL;
          }
          else
@@ -84,6 +85,7 @@ int list_item_insert(PersList_item_s** list, int fd)
          if(list != NULL)
          {
             (*list)->fd = fd;
+            (*list)->priority = PCL_FLUSH_PRIO_NORMAL;
             (*list)->next = NULL;
          }
          else
@@ -164,6 +166,22 @@ int  list_item_remove(PersList_item_s** list, int fd)
 }
 
 
+void list_item_set_priority(PersList_item_s** list, int fd, int priority)
+{
+   PersList_item_s *tmp = *list;
+
+   while(tmp != NULL)
+   {
+      if(tmp->fd == fd)
+      {
+         tmp->priority = priority;
+         break;
+      }
+      tmp = tmp->next;
+   }
+}
+
+
 void list_iterate(PersList_item_s** list, int(*callback)(int a))
 {
    PersList_item_s *tmp = *list;
@@ -286,37 +304,77 @@ void close_all_persistence_handle()
 }
 
 
+/**
+ * @brief create the intrusive file handle tree if not done yet
+ *
+ * @param tree the tree to create
+ */
+static void create_file_handle_tree(jsw_rbtree_t** tree)
+{
+   if(*tree == NULL)
+   {
+      *tree = jsw_rbnew_intrusive(fh_key_val_cmp, sizeof(FileHandleTreeItem_s), 0);
+   }
+}
+
+
+/**
+ * @brief find a file handle item
+ *
+ * @param tree the file handle tree to search in
+ * @param idx the handle index
+ *
+ * @return the item stored in the tree or NULL if not available
+ */
+static FileHandleTreeItem_s* find_file_handle_item(jsw_rbtree_t* tree, int idx)
+{
+   FileHandleTreeItem_s* foundItem = NULL;
+
+   if(tree != NULL)
+   {
+      FileHandleTreeItem_s searchItem;
+      searchItem.key = idx;
+      foundItem = (FileHandleTreeItem_s*)jsw_rbfind(tree, &searchItem);
+   }
+
+   return foundItem;
+}
+
+
 int set_key_handle_data(int idx, const char* id, unsigned int ldbid,  unsigned int user_no, unsigned int seat_no)
 {
 	int handle = -1;
 
 	if(pthread_mutex_lock(&gKeyHandleAccessMtx) == 0)
 	{
-	   KeyHandleTreeItem_s* item = NULL;
+	   KeyHandleTreeItem_s item;
+	   KeyHandleTreeItem_s* foundItem = NULL;
 
 	   if(gKeyHandleTree == NULL)
 	   {
-	      gKeyHandleTree = jsw_rbnew(kh_key_val_cmp, kh_key_val_dup, kh_key_val_rel);
+	      gKeyHandleTree = jsw_rbnew_intrusive(kh_key_val_cmp, sizeof(KeyHandleTreeItem_s), 0);
 	   }
 
-	   item = malloc(sizeof(KeyHandleTreeItem_s));    // assign key and value to the rbtree item
-      if(item != NULL)
-      {
-         item->key = idx;
-
-         item->value.keyHandle.ldbid   = ldbid;
-         item->value.keyHandle.user_no = user_no;
-         item->value.keyHandle.seat_no = seat_no;
-         strncpy(item->value.keyHandle.resource_id, id, PERS_DB_MAX_LENGTH_KEY_NAME);
-         item->value.keyHandle.resource_id[PERS_DB_MAX_LENGTH_KEY_NAME-1] = '\0'; // Ensures 0-Termination
-
-         jsw_rbinsert(gKeyHandleTree, item);
+	   item.key = idx;
+	   foundItem = (KeyHandleTreeItem_s*)jsw_rbfind(gKeyHandleTree, &item);
+	   if(foundItem == NULL)
+	   {
+	      foundItem = &item;      // assign key and value to the rbtree item, copied into the tree on insert
+	   }
 
-         free(item);
+      foundItem->value.keyHandle.ldbid   = ldbid;
+      foundItem->value.keyHandle.user_no = user_no;
+      foundItem->value.keyHandle.seat_no = seat_no;
+      strncpy(foundItem->value.keyHandle.resource_id, id, PERS_DB_MAX_LENGTH_KEY_NAME);
+      foundItem->value.keyHandle.resource_id[PERS_DB_MAX_LENGTH_KEY_NAME-1] = '\0'; // Ensures 0-Termination
 
-         handle = idx;
+      if(foundItem == &item)
+      {
+         jsw_rbinsert(gKeyHandleTree, &item);
       }
 
+      handle = idx;
+
 		pthread_mutex_unlock(&gKeyHandleAccessMtx);
    }
 
@@ -332,22 +390,19 @@ int get_key_handle_data(int idx, PersistenceKeyHandle_s* handleStruct)
 	{
       if(gKeyHandleTree != NULL)
       {
-         KeyHandleTreeItem_s* item = malloc(sizeof(KeyHandleTreeItem_s));
-         if(item != NULL)
+         KeyHandleTreeItem_s item;
+         KeyHandleTreeItem_s* foundItem = NULL;
+
+         item.key = idx;
+         foundItem = (KeyHandleTreeItem_s*)jsw_rbfind(gKeyHandleTree, &item);
+         if(foundItem != NULL)
          {
-            KeyHandleTreeItem_s* foundItem = NULL;
-            item->key = idx;
-            foundItem = (KeyHandleTreeItem_s*)jsw_rbfind(gKeyHandleTree, item);
-            if(foundItem != NULL)
-            {
-               handleStruct->ldbid   = foundItem->value.keyHandle.ldbid;
-               handleStruct->user_no = foundItem->value.keyHandle.user_no;
-               handleStruct->seat_no = foundItem->value.keyHandle.seat_no;
-               strncpy(handleStruct->resource_id, foundItem->value.keyHandle.resource_id, PERS_DB_MAX_LENGTH_KEY_NAME);
-               handleStruct->resource_id[PERS_DB_MAX_LENGTH_KEY_NAME-1] = '\0'; // Ensures 0-Termination
-               rval = 0;
-            }
-            free(item);
+            handleStruct->ldbid   = foundItem->value.keyHandle.ldbid;
+            handleStruct->user_no = foundItem->value.keyHandle.user_no;
+            handleStruct->seat_no = foundItem->value.keyHandle.seat_no;
+            strncpy(handleStruct->resource_id, foundItem->value.keyHandle.resource_id, PERS_DB_MAX_LENGTH_KEY_NAME);
+            handleStruct->resource_id[PERS_DB_MAX_LENGTH_KEY_NAME-1] = '\0'; // Ensures 0-Termination
+            rval = 0;
          }
       }
 
@@ -367,7 +422,7 @@ void init_key_handle_array()
          jsw_rbdelete (gKeyHandleTree);
       }
 
-      gKeyHandleTree = jsw_rbnew(kh_key_val_cmp, kh_key_val_dup, kh_key_val_rel);
+      gKeyHandleTree = jsw_rbnew_intrusive(kh_key_val_cmp, sizeof(KeyHandleTreeItem_s), 0);
 
 		pthread_mutex_unlock(&gKeyHandleAccessMtx);
 	}
@@ -380,16 +435,12 @@ void clear_key_handle_array(int idx)
    {
       if(gKeyHandleTree != NULL)
       {
-         KeyHandleTreeItem_s* item = malloc(sizeof(KeyHandleTreeItem_s));
-         if(item != NULL)
-         {
-            item->key = idx;
+         KeyHandleTreeItem_s item;
+         item.key = idx;
 
-            if(jsw_rberase(gKeyHandleTree, item) == 0)
-            {
-               DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("clear_key_handle_array - failed remove idx: "), DLT_INT(idx));
-            }
-            free(item);
+         if(jsw_rberase(gKeyHandleTree, &item) == 0)
+         {
+            DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("clear_key_handle_array - failed remove idx: "), DLT_INT(idx));
          }
       }
 
@@ -406,13 +457,9 @@ int remove_file_handle_data(int idx)
    {
       if(gFileHandleTree != NULL)
       {
-         FileHandleTreeItem_s* item = malloc(sizeof(FileHandleTreeItem_s));    // assign key and value to the rbtree item
-         if(item != NULL)
-         {
-            item->key = idx;
-            rval = jsw_rberase(gFileHandleTree, item);
-            free(item);
-         }
+         FileHandleTreeItem_s item;
+         item.key = idx;
+         rval = jsw_rberase(gFileHandleTree, &item);
       }
 
       pthread_mutex_unlock(&gFileHandleAccessMtx);
@@ -427,68 +474,37 @@ int set_file_handle_data(int idx, PersistencePermission_e permission, const char
 
 	if(pthread_mutex_lock(&gFileHandleAccessMtx) == 0)
 	{
-		FileHandleTreeItem_s* item = NULL;
+	   FileHandleTreeItem_s item;
+	   FileHandleTreeItem_s* foundItem = NULL;
 
-      if(gFileHandleTree == NULL)
-      {
-         gFileHandleTree = jsw_rbnew(fh_key_val_cmp, fh_key_val_dup, fh_key_val_rel);
-      }
+      create_file_handle_tree(&gFileHandleTree);
 
-      item = malloc(sizeof(FileHandleTreeItem_s));    // assign key and value to the rbtree item
-      if(item != NULL)
+      foundItem = find_file_handle_item(gFileHandleTree, idx);
+      if(foundItem == NULL)
       {
-         FileHandleTreeItem_s* foundItem = NULL;
-         item->key = idx;
-         foundItem = (FileHandleTreeItem_s*)jsw_rbfind(gFileHandleTree, item);
-         if(foundItem == NULL)
-         {
-            item->key = idx;
-
-            item->value.fileHandle.permission    = permission;
-            item->value.fileHandle.backupCreated = 0;             // set to 0 by default
-            item->value.fileHandle.cacheStatus   = -1;            // set to -1 by default
-            item->value.fileHandle.userId        = 0;             // default value
-            item->value.fileHandle.filePath      = filePath;
-
-            strncpy(item->value.fileHandle.backupPath, backup, PERS_ORG_MAX_LENGTH_PATH_FILENAME);
-            item->value.fileHandle.backupPath[PERS_ORG_MAX_LENGTH_PATH_FILENAME-1] = '\0'; // Ensures 0-Termination
-
-            strncpy(item->value.fileHandle.csumPath, csumPath, PERS_ORG_MAX_LENGTH_PATH_FILENAME);
-            item->value.fileHandle.csumPath[PERS_ORG_MAX_LENGTH_PATH_FILENAME-1] = '\0'; // Ensures 0-Termination
-
-            //debugFileItem("set_file_handle_data => insert", item);
-            jsw_rbinsert(gFileHandleTree, item);
-         }
-         else
-         {
-            FileHandleTreeItem_s* newItem = malloc(sizeof(FileHandleTreeItem_s));
-            if(newItem != NULL)
-            {
-               memcpy(newItem->value.payload , foundItem->value.payload, sizeof(FileHandleData_u) ); // duplicate value
-
-               newItem->key = idx;
+         foundItem = &item;
 
-               newItem->value.fileHandle.permission    = permission;
-               newItem->value.fileHandle.filePath      = filePath;
-
-               strncpy(newItem->value.fileHandle.backupPath, backup, PERS_ORG_MAX_LENGTH_PATH_FILENAME);
-               newItem->value.fileHandle.backupPath[PERS_ORG_MAX_LENGTH_PATH_FILENAME-1] = '\0'; // Ensures 0-Termination
+         item.key = idx;
+         item.value.fileHandle.backupCreated = 0;             // set to 0 by default
+         item.value.fileHandle.cacheStatus   = -1;            // set to -1 by default
+         item.value.fileHandle.userId        = 0;             // default value
+      }
 
-               strncpy(newItem->value.fileHandle.csumPath, csumPath, PERS_ORG_MAX_LENGTH_PATH_FILENAME);
-               newItem->value.fileHandle.csumPath[PERS_ORG_MAX_LENGTH_PATH_FILENAME-1] = '\0'; // Ensures 0-Termination
+      foundItem->value.fileHandle.permission    = permission;
+      foundItem->value.fileHandle.filePath      = filePath;
 
-               //debugFileItem("set_file_backup_status => erase => foundItem", foundItem);
-               jsw_rberase(gFileHandleTree, foundItem);
+      strncpy(foundItem->value.fileHandle.backupPath, backup, PERS_ORG_MAX_LENGTH_PATH_FILENAME);
+      foundItem->value.fileHandle.backupPath[PERS_ORG_MAX_LENGTH_PATH_FILENAME-1] = '\0'; // Ensures 0-Termination
 
-               //debugFileItem("set_file_backup_status => insert => newItem", newItem);
-               jsw_rbinsert(gFileHandleTree, newItem);
+      strncpy(foundItem->value.fileHandle.csumPath, csumPath, PERS_ORG_MAX_LENGTH_PATH_FILENAME);
+      foundItem->value.fileHandle.csumPath[PERS_ORG_MAX_LENGTH_PATH_FILENAME-1] = '\0'; // Ensures 0-Termination
 
-               free(newItem);
-            }
-         }
-         free(item);
-         rval = 0;
+      if(foundItem == &item)
+      {
+         //debugFileItem("set_file_handle_data => insert", &item);
+         jsw_rbinsert(gFileHandleTree, &item);
       }
+      rval = 0;
 
 		pthread_mutex_unlock(&gFileHandleAccessMtx);
 	}
@@ -505,21 +521,14 @@ int get_file_permission(int idx)
 	{
       if(gFileHandleTree != NULL)
       {
-         FileHandleTreeItem_s* item = malloc(sizeof(FileHandleTreeItem_s));
-         if(item != NULL)
+         FileHandleTreeItem_s* foundItem = find_file_handle_item(gFileHandleTree, idx);
+         if(foundItem != NULL)
          {
-            FileHandleTreeItem_s* foundItem = NULL;
-            item->key = idx;
-            foundItem = (FileHandleTreeItem_s*)jsw_rbfind(gFileHandleTree, item);
-            if(foundItem != NULL)
-            {
-               permission = foundItem->value.fileHandle.permission;
-            }
-            else
-            {
-               permission = -1;
-            }
-            free(item);
+            permission = foundItem->value.fileHandle.permission;
+         }
+         else
+         {
+            permission = -1;
          }
       }
 		pthread_mutex_unlock(&gFileHandleAccessMtx);
@@ -533,21 +542,11 @@ char* get_file_backup_path(int idx)
    char* charPtr = NULL;
    if(pthread_mutex_lock(&gFileHandleAccessMtx) == 0)
    {
-      if(gFileHandleTree != NULL)
+      FileHandleTreeItem_s* foundItem = find_file_handle_item(gFileHandleTree, idx);
+      if(foundItem != NULL)
       {
-         FileHandleTreeItem_s* item = malloc(sizeof(FileHandleTreeItem_s));
-         if(item != NULL)
-         {
-            FileHandleTreeItem_s* foundItem = NULL;
-            item->key = idx;
-            foundItem = (FileHandleTreeItem_s*)jsw_rbfind(gFileHandleTree, item);
-            if(foundItem != NULL)
-            {
-               charPtr = foundItem->value.fileHandle.backupPath;
-               //debugFileItem("get_file_backup_path => foundItem", foundItem);
-            }
-            free(item);
-         }
+         charPtr = foundItem->value.fileHandle.backupPath;
+         //debugFileItem("get_file_backup_path => foundItem", foundItem);
       }
 
       pthread_mutex_unlock(&gFileHandleAccessMtx);
@@ -560,21 +559,11 @@ char* get_file_checksum_path(int idx)
    char* charPtr = NULL;
    if(pthread_mutex_lock(&gFileHandleAccessMtx) == 0)
    {
-      if(gFileHandleTree != NULL)
+      FileHandleTreeItem_s* foundItem = find_file_handle_item(gFileHandleTree, idx);
+      if(foundItem != NULL)
       {
-         FileHandleTreeItem_s* item = malloc(sizeof(FileHandleTreeItem_s));
-         if(item != NULL)
-         {
-            FileHandleTreeItem_s* foundItem = NULL;
-            item->key = idx;
-            foundItem = (FileHandleTreeItem_s*)jsw_rbfind(gFileHandleTree, item);
-            if(foundItem != NULL)
-            {
-               charPtr = foundItem->value.fileHandle.csumPath;
-               //debugFileItem("get_file_checksum_path => foundItem", foundItem);
-            }
-            free(item);
-         }
+         charPtr = foundItem->value.fileHandle.csumPath;
+         //debugFileItem("get_file_checksum_path => foundItem", foundItem);
       }
       pthread_mutex_unlock(&gFileHandleAccessMtx);
    }
@@ -586,50 +575,28 @@ void set_file_backup_status(int idx, int status)
 {
 	if(pthread_mutex_lock(&gFileHandleAccessMtx) == 0)
 	{
-	   FileHandleTreeItem_s* item = malloc(sizeof(FileHandleTreeItem_s));
+	   FileHandleTreeItem_s* foundItem = NULL;
 
-      if(gFileHandleTree == NULL)
-      {
-         gFileHandleTree = jsw_rbnew(fh_key_val_cmp, fh_key_val_dup, fh_key_val_rel);
-      }
+      create_file_handle_tree(&gFileHandleTree);
 
-      if(item != NULL)
+      foundItem = find_file_handle_item(gFileHandleTree, idx);
+      if(foundItem == NULL)
       {
-         FileHandleTreeItem_s* foundItem = NULL;
-         item->key = idx;
-         foundItem = (FileHandleTreeItem_s*)jsw_rbfind(gFileHandleTree, item);
-         if(foundItem == NULL)
-         {
-            item->value.fileHandle.backupCreated = status;
-
-            item->value.fileHandle.permission    = PersistencePermission_LastEntry;
-            item->value.fileHandle.cacheStatus   = -1;            // set to -1 by default
-            item->value.fileHandle.userId        = 0;             // default value
-            item->value.fileHandle.filePath      = NULL;
-
-            //debugFileItem("set_file_backup_status => insert => item", item);
-            jsw_rbinsert(gFileHandleTree, item);
-         }
-         else
-         {
-            FileHandleTreeItem_s* newItem = malloc(sizeof(FileHandleTreeItem_s));
-            if(newItem != NULL)
-            {
-               memcpy(newItem->value.payload , foundItem->value.payload, sizeof(FileHandleData_u) ); // duplicate value
+         FileHandleTreeItem_s item;
+         item.key = idx;
+         item.value.fileHandle.backupCreated = status;
 
-               newItem->key = idx;
-               newItem->value.fileHandle.backupCreated = status;
+         item.value.fileHandle.permission    = PersistencePermission_LastEntry;
+         item.value.fileHandle.cacheStatus   = -1;            // set to -1 by default
+         item.value.fileHandle.userId        = 0;             // default value
+         item.value.fileHandle.filePath      = NULL;
 
-               //debugFileItem("set_file_backup_status => erase => foundItem", foundItem);
-               jsw_rberase(gFileHandleTree, foundItem);
-
-               //debugFileItem("set_file_backup_status => insert => newItem", newItem);
-               jsw_rbinsert(gFileHandleTree, newItem);
-
-               free(newItem);
-            }
-         }
-         free(item);
+         //debugFileItem("set_file_backup_status => insert => item", &item);
+         jsw_rbinsert(gFileHandleTree, &item);
+      }
+      else
+      {
+         foundItem->value.fileHandle.backupCreated = status;    // update in place, the item is owned by the tree
       }
 		pthread_mutex_unlock(&gFileHandleAccessMtx);
 	}
@@ -640,21 +607,11 @@ int get_file_backup_status(int idx)
    int backup = -1;
    if(pthread_mutex_lock(&gFileHandleAccessMtx) == 0)
    {
-      if(gFileHandleTree != NULL)
+      FileHandleTreeItem_s* foundItem = find_file_handle_item(gFileHandleTree, idx);
+      if(foundItem != NULL)
       {
-         FileHandleTreeItem_s* item = malloc(sizeof(FileHandleTreeItem_s));
-         if(item != NULL)
-         {
-            FileHandleTreeItem_s* foundItem = NULL;
-            item->key = idx;
-            foundItem = (FileHandleTreeItem_s*)jsw_rbfind(gFileHandleTree, item);
-            if(foundItem != NULL)
-            {
-               backup = foundItem->value.fileHandle.backupCreated;
-               //debugFileItem("get_file_backup_status => foundItem", foundItem);
-            }
-            free(item);
-         }
+         backup = foundItem->value.fileHandle.backupCreated;
+         //debugFileItem("get_file_backup_status => foundItem", foundItem);
       }
       pthread_mutex_unlock(&gFileHandleAccessMtx);
    }
@@ -665,53 +622,31 @@ void set_file_cache_status(int idx, int status)
 {
 	if(pthread_mutex_lock(&gFileHandleAccessMtx) == 0)
 	{
-	   FileHandleTreeItem_s* item = malloc(sizeof(FileHandleTreeItem_s));
+	   FileHandleTreeItem_s* foundItem = NULL;
 
-	   if(gFileHandleTree == NULL)
-      {
-	      gFileHandleTree = jsw_rbnew(fh_key_val_cmp, fh_key_val_dup, fh_key_val_rel);
-      }
+	   create_file_handle_tree(&gFileHandleTree);
 
-      if(item != NULL)
+      foundItem = find_file_handle_item(gFileHandleTree, idx);
+      if(foundItem == NULL)
       {
-         FileHandleTreeItem_s* foundItem = NULL;
-         item->key = idx;
-         foundItem = (FileHandleTreeItem_s*)jsw_rbfind(gFileHandleTree, item);
-         if(foundItem == NULL)
-         {
-            item->value.fileHandle.cacheStatus   = status;
-
-            item->value.fileHandle.backupCreated = 0;            // set to 0 by default
-            item->value.fileHandle.permission    = PersistencePermission_LastEntry;
-            item->value.fileHandle.userId        = 0;             // default value
-            item->value.fileHandle.filePath      = NULL;
-
-            memset(item->value.fileHandle.csumPath  , 0, PERS_ORG_MAX_LENGTH_PATH_FILENAME);
-            item->value.fileHandle.csumPath[PERS_ORG_MAX_LENGTH_PATH_FILENAME-1] = '\0'; // Ensures 0-Termination
-            memset(item->value.fileHandle.backupPath, 0, PERS_ORG_MAX_LENGTH_PATH_FILENAME);
-            item->value.fileHandle.backupPath[PERS_ORG_MAX_LENGTH_PATH_FILENAME-1] = '\0'; // Ensures 0-Termination
+         FileHandleTreeItem_s item;
+         item.key = idx;
+         item.value.fileHandle.cacheStatus   = status;
 
-            //debugFileItem("set_file_cache_status => insert => item", item);
-            jsw_rbinsert(gFileHandleTree, item);
-         }
-         else
-         {
-            FileHandleTreeItem_s* newItem = malloc(sizeof(FileHandleTreeItem_s));
-            if(newItem != NULL)
-            {
-               memcpy(newItem->value.payload , foundItem->value.payload, sizeof(FileHandleData_u) ); // duplicate value
+         item.value.fileHandle.backupCreated = 0;            // set to 0 by default
+         item.value.fileHandle.permission    = PersistencePermission_LastEntry;
+         item.value.fileHandle.userId        = 0;             // default value
+         item.value.fileHandle.filePath      = NULL;
 
-               //debugFileItem("set_file_cache_status => erase => foundItem", foundItem);
-               jsw_rberase(gFileHandleTree, foundItem);
+         memset(item.value.fileHandle.csumPath  , 0, PERS_ORG_MAX_LENGTH_PATH_FILENAME);
+         memset(item.value.fileHandle.backupPath, 0, PERS_ORG_MAX_LENGTH_PATH_FILENAME);
 
-               newItem->key = idx;
-               newItem->value.fileHandle.cacheStatus = status;
-               //debugFileItem("set_file_cache_status => insert => newItem", newItem);
-               jsw_rbinsert(gFileHandleTree, newItem);
-               free(newItem);
-            }
-         }
-         free(item);
+         //debugFileItem("set_file_cache_status => insert => item", &item);
+         jsw_rbinsert(gFileHandleTree, &item);
+      }
+      else
+      {
+         foundItem->value.fileHandle.cacheStatus = status;
       }
 		pthread_mutex_unlock(&gFileHandleAccessMtx);
 	}
@@ -722,20 +657,10 @@ int get_file_cache_status(int idx)
 	int status = -1;
 	if(pthread_mutex_lock(&gFileHandleAccessMtx) == 0)
 	{
-      if(gFileHandleTree != NULL)
+      FileHandleTreeItem_s* foundItem = find_file_handle_item(gFileHandleTree, idx);
+      if(foundItem != NULL)
       {
-         FileHandleTreeItem_s* item = malloc(sizeof(FileHandleTreeItem_s));
-         if(item != NULL)
-         {
-            FileHandleTreeItem_s* foundItem = NULL;
-            item->key = idx;
-            foundItem = (FileHandleTreeItem_s*)jsw_rbfind(gFileHandleTree, item);
-            if(foundItem != NULL)
-            {
-               status = foundItem->value.fileHandle.cacheStatus;
-            }
-            free(item);
-         }
+         status = foundItem->value.fileHandle.cacheStatus;
       }
 		pthread_mutex_unlock(&gFileHandleAccessMtx);
 	}
@@ -747,54 +672,31 @@ void set_file_user_id(int idx, int userID)
 {
    if(pthread_mutex_lock(&gFileHandleAccessMtx) == 0)
    {
-      FileHandleTreeItem_s* item = malloc(sizeof(FileHandleTreeItem_s));
-      if(gFileHandleTree == NULL)
-      {
-         gFileHandleTree = jsw_rbnew(fh_key_val_cmp, fh_key_val_dup, fh_key_val_rel);
-      }
-
-      if(item != NULL)
-      {
-         FileHandleTreeItem_s* foundItem = NULL;
-         item->key = idx;
-         foundItem = (FileHandleTreeItem_s*)jsw_rbfind(gFileHandleTree, item);
-         if(foundItem == NULL)
-         {
-            item->value.fileHandle.userId        = userID;              // default value
+      FileHandleTreeItem_s* foundItem = NULL;
 
-            item->value.fileHandle.backupCreated = 0;                   // set to 0 by default
-            item->value.fileHandle.permission    = -1;
-            item->value.fileHandle.cacheStatus   = -1;                  // set to -1 by default
-            item->value.fileHandle.filePath      = NULL;
+      create_file_handle_tree(&gFileHandleTree);
 
-            memset(item->value.fileHandle.csumPath  , 0, PERS_ORG_MAX_LENGTH_PATH_FILENAME);
-            item->value.fileHandle.csumPath[PERS_ORG_MAX_LENGTH_PATH_FILENAME-1] = '\0'; // Ensures 0-Termination
-            memset(item->value.fileHandle.backupPath, 0, PERS_ORG_MAX_LENGTH_PATH_FILENAME);
-            item->value.fileHandle.backupPath[PERS_ORG_MAX_LENGTH_PATH_FILENAME-1] = '\0'; // Ensures 0-Termination
-
-            //debugFileItem("set_file_user_id => insert", item);
-            jsw_rbinsert(gFileHandleTree, item);
-         }
-         else
-         {
-            FileHandleTreeItem_s* newItem = malloc(sizeof(FileHandleTreeItem_s));
-            if(newItem != NULL)
-            {
-               memcpy(newItem->value.payload , foundItem->value.payload, sizeof(FileHandleData_u) ); // duplicate value
+      foundItem = find_file_handle_item(gFileHandleTree, idx);
+      if(foundItem == NULL)
+      {
+         FileHandleTreeItem_s item;
+         item.key = idx;
+         item.value.fileHandle.userId        = userID;              // default value
 
-               //debugFileItem("set_file_user_id => erase", foundItem);
-               jsw_rberase(gFileHandleTree, foundItem);
+         item.value.fileHandle.backupCreated = 0;                   // set to 0 by default
+         item.value.fileHandle.permission    = -1;
+         item.value.fileHandle.cacheStatus   = -1;                  // set to -1 by default
+         item.value.fileHandle.filePath      = NULL;
 
-               newItem->key = idx;
-               newItem->value.fileHandle.userId = userID;
-               //debugFileItem("set_file_user_id => insert", newItem);
-               jsw_rbinsert(gFileHandleTree, newItem);
+         memset(item.value.fileHandle.csumPath  , 0, PERS_ORG_MAX_LENGTH_PATH_FILENAME);
+         memset(item.value.fileHandle.backupPath, 0, PERS_ORG_MAX_LENGTH_PATH_FILENAME);
 
-               free(newItem);
-            }
-         }
-         free(item);
-         free(foundItem);
+         //debugFileItem("set_file_user_id => insert", &item);
+         jsw_rbinsert(gFileHandleTree, &item);
+      }
+      else
+      {
+         foundItem->value.fileHandle.userId = userID;
       }
 
       pthread_mutex_unlock(&gFileHandleAccessMtx);
@@ -806,20 +708,10 @@ int get_file_user_id(int idx)
    int id = -1;
    if(pthread_mutex_lock(&gFileHandleAccessMtx) == 0)
    {
-      if(gFileHandleTree != NULL)
+      FileHandleTreeItem_s* foundItem = find_file_handle_item(gFileHandleTree, idx);
+      if(foundItem != NULL)
       {
-         FileHandleTreeItem_s* item = malloc(sizeof(FileHandleTreeItem_s));
-         if(item != NULL)
-         {
-            FileHandleTreeItem_s* foundItem = NULL;
-            item->key = idx;
-            foundItem = (FileHandleTreeItem_s*)jsw_rbfind(gFileHandleTree, item);
-            if(foundItem != NULL)
-            {
-               id = foundItem->value.fileHandle.userId;
-            }
-            free(item);
-         }
+         id = foundItem->value.fileHandle.userId;
       }
       pthread_mutex_unlock(&gFileHandleAccessMtx);
    }
@@ -836,73 +728,35 @@ int set_ossfile_handle_data(int idx, PersistencePermission_e permission, int bac
 
 	if(pthread_mutex_lock(&gOssFileHandleAccessMtx) == 0)
 	{
-	   FileHandleTreeItem_s* item = NULL;
+	   FileHandleTreeItem_s item;
+	   FileHandleTreeItem_s* foundItem = NULL;
 
-      if(gOssFileHandleTree == NULL)
-      {
-         gOssFileHandleTree = jsw_rbnew(fh_key_val_cmp, fh_key_val_dup, fh_key_val_rel);
-      }
+	   create_file_handle_tree(&gOssFileHandleTree);
 
-      item = malloc(sizeof(FileHandleTreeItem_s));    // assign key and value to the rbtree item
-      if(item != NULL)
+      foundItem = find_file_handle_item(gOssFileHandleTree, idx);
+      if(foundItem == NULL)
       {
-         FileHandleTreeItem_s* foundItem = NULL;
-         item->key = idx;
-         foundItem = (FileHandleTreeItem_s*)jsw_rbfind(gOssFileHandleTree, item);
-         if(foundItem == NULL)
-         {
-
-            item->key = idx;
-
-            item->value.fileHandle.permission    = permission;
-            item->value.fileHandle.backupCreated = backupCreated;
-            item->value.fileHandle.cacheStatus   = -1;            // set to -1 by default
-            item->value.fileHandle.userId        = 0;             // default value
-            item->value.fileHandle.filePath      = filePath;
-
-            strncpy(item->value.fileHandle.backupPath, backup, PERS_ORG_MAX_LENGTH_PATH_FILENAME);
-            item->value.fileHandle.backupPath[PERS_ORG_MAX_LENGTH_PATH_FILENAME-1] = '\0'; // Ensures 0-Termination
-            strncpy(item->value.fileHandle.csumPath, csumPath, PERS_ORG_MAX_LENGTH_PATH_FILENAME);
-            item->value.fileHandle.csumPath[PERS_ORG_MAX_LENGTH_PATH_FILENAME-1] = '\0'; // Ensures 0-Termination
-
-            jsw_rbinsert(gOssFileHandleTree, item);
-
-            free(item);
-            rval = 0;
-         }
-         else
-         {
-            FileHandleTreeItem_s* newItem = malloc(sizeof(FileHandleTreeItem_s));
-            if(newItem != NULL)
-            {
-               memcpy(newItem->value.payload , foundItem->value.payload, sizeof(FileHandleData_u) ); // duplicate value
-
-               newItem->key = idx;
-
-               newItem->value.fileHandle.permission    = permission;
-               newItem->value.fileHandle.filePath      = filePath;
+         foundItem = &item;
 
-               strncpy(newItem->value.fileHandle.backupPath, backup, PERS_ORG_MAX_LENGTH_PATH_FILENAME);
-               newItem->value.fileHandle.backupPath[PERS_ORG_MAX_LENGTH_PATH_FILENAME-1] = '\0'; // Ensures 0-Termination
-
-               strncpy(newItem->value.fileHandle.csumPath, csumPath, PERS_ORG_MAX_LENGTH_PATH_FILENAME);
-               newItem->value.fileHandle.csumPath[PERS_ORG_MAX_LENGTH_PATH_FILENAME-1] = '\0'; // Ensures 0-Termination
-
-               //debugFileItem("set_file_backup_status => erase => foundItem", foundItem);
-               jsw_rberase(gOssFileHandleTree, foundItem);
+         item.key = idx;
+         item.value.fileHandle.backupCreated = backupCreated;
+         item.value.fileHandle.cacheStatus   = -1;            // set to -1 by default
+         item.value.fileHandle.userId        = 0;             // default value
+      }
 
-               //debugFileItem("set_file_backup_status => insert => newItem", newItem);
-               jsw_rbinsert(gOssFileHandleTree, newItem);
+      foundItem->value.fileHandle.permission    = permission;
+      foundItem->value.fileHandle.filePath      = filePath;
 
-               free(newItem);
-            }
+      strncpy(foundItem->value.fileHandle.backupPath, backup, PERS_ORG_MAX_LENGTH_PATH_FILENAME);
+      foundItem->value.fileHandle.backupPath[PERS_ORG_MAX_LENGTH_PATH_FILENAME-1] = '\0'; // Ensures 0-Termination
+      strncpy(foundItem->value.fileHandle.csumPath, csumPath, PERS_ORG_MAX_LENGTH_PATH_FILENAME);
+      foundItem->value.fileHandle.csumPath[PERS_ORG_MAX_LENGTH_PATH_FILENAME-1] = '\0'; // Ensures 0-Termination
 
-         }
-      }
-      else
+      if(foundItem == &item)
       {
-
+         jsw_rbinsert(gOssFileHandleTree, &item);
       }
+
 		pthread_mutex_unlock(&gOssFileHandleAccessMtx);
 	}
 
@@ -918,21 +772,14 @@ int get_ossfile_permission(int idx)
 	{
 	   if(gOssFileHandleTree != NULL)
       {
-         FileHandleTreeItem_s* item = malloc(sizeof(FileHandleTreeItem_s));
-         if(item != NULL)
+         FileHandleTreeItem_s* foundItem = find_file_handle_item(gOssFileHandleTree, idx);
+         if(foundItem != NULL)
          {
-            FileHandleTreeItem_s* foundItem = NULL;
-            item->key = idx;
-            foundItem = (FileHandleTreeItem_s*)jsw_rbfind(gOssFileHandleTree, item);
-            if(foundItem != NULL)
-            {
-               permission = foundItem->value.fileHandle.permission;
-            }
-            else
-            {
-               permission = -1;
-            }
-            free(item);
+            permission = foundItem->value.fileHandle.permission;
+         }
+         else
+         {
+            permission = -1;
          }
       }
 		pthread_mutex_unlock(&gOssFileHandleAccessMtx);
@@ -947,20 +794,10 @@ char* get_ossfile_backup_path(int idx)
    char* charPtr = NULL;
    if(pthread_mutex_lock(&gOssFileHandleAccessMtx) == 0)
    {
-      if(gOssFileHandleTree != NULL)
+      FileHandleTreeItem_s* foundItem = find_file_handle_item(gOssFileHandleTree, idx);
+      if(foundItem != NULL)
       {
-         FileHandleTreeItem_s* item = malloc(sizeof(FileHandleTreeItem_s));
-         if(item != NULL)
-         {
-            FileHandleTreeItem_s* foundItem = NULL;
-            item->key = idx;
-            foundItem = (FileHandleTreeItem_s*)jsw_rbfind(gOssFileHandleTree, item);
-            if(foundItem != NULL)
-            {
-               charPtr = foundItem->value.fileHandle.backupPath;
-            }
-            free(item);
-         }
+         charPtr = foundItem->value.fileHandle.backupPath;
       }
       pthread_mutex_unlock(&gOssFileHandleAccessMtx);
    }
@@ -973,20 +810,10 @@ char* get_ossfile_file_path(int idx)
    char* charPtr = NULL;
    if(pthread_mutex_lock(&gOssFileHandleAccessMtx) == 0)
    {
-      if(gOssFileHandleTree != NULL)
+      FileHandleTreeItem_s* foundItem = find_file_handle_item(gOssFileHandleTree, idx);
+      if(foundItem != NULL)
       {
-         FileHandleTreeItem_s* item = malloc(sizeof(FileHandleTreeItem_s));
-         if(item != NULL)
-         {
-            FileHandleTreeItem_s* foundItem = NULL;
-            item->key = idx;
-            foundItem = (FileHandleTreeItem_s*)jsw_rbfind(gOssFileHandleTree, item);
-            if(foundItem != NULL)
-            {
-               charPtr = foundItem->value.fileHandle.filePath;
-            }
-            free(item);
-         }
+         charPtr = foundItem->value.fileHandle.filePath;
       }
       pthread_mutex_unlock(&gOssFileHandleAccessMtx);
    }
@@ -997,51 +824,29 @@ void set_ossfile_file_path(int idx, char* file)
 {
 	if(pthread_mutex_lock(&gOssFileHandleAccessMtx) == 0)
 	{
-	   FileHandleTreeItem_s* item = malloc(sizeof(FileHandleTreeItem_s));
+	   FileHandleTreeItem_s* foundItem = NULL;
 
-      if(gOssFileHandleTree == NULL)
-      {
-         gOssFileHandleTree = jsw_rbnew(fh_key_val_cmp, fh_key_val_dup, fh_key_val_rel);
-      }
+	   create_file_handle_tree(&gOssFileHandleTree);
 
-      if(item != NULL)
+      foundItem = find_file_handle_item(gOssFileHandleTree, idx);
+      if(foundItem == NULL)
       {
-         FileHandleTreeItem_s* foundItem = NULL;
-         item->key = idx;
-         foundItem = (FileHandleTreeItem_s*)jsw_rbfind(gOssFileHandleTree, item);
-         if(foundItem == NULL)
-         {
-            item->value.fileHandle.filePath      = file;
-
-            item->value.fileHandle.backupCreated = 0;             // set to 0 by default
-            item->value.fileHandle.permission    = -1;
-            item->value.fileHandle.cacheStatus   = -1;            // set to -1 by default
-            item->value.fileHandle.userId        = 0;             // default value
-            memset(item->value.fileHandle.csumPath  , 0, PERS_ORG_MAX_LENGTH_PATH_FILENAME);
-            item->value.fileHandle.csumPath[PERS_ORG_MAX_LENGTH_PATH_FILENAME-1] = '\0'; // Ensures 0-Termination
-
-            memset(item->value.fileHandle.backupPath, 0, PERS_ORG_MAX_LENGTH_PATH_FILENAME);
-            item->value.fileHandle.backupPath[PERS_ORG_MAX_LENGTH_PATH_FILENAME-1] = '\0'; // Ensures 0-Termination
-
-            jsw_rbinsert(gOssFileHandleTree, item);
-         }
-         else
-         {
-            FileHandleTreeItem_s* newItem = malloc(sizeof(FileHandleTreeItem_s));
-            if(newItem != NULL)
-            {
-               memcpy(newItem->value.payload , foundItem->value.payload, sizeof(FileHandleData_u) ); // duplicate value
+         FileHandleTreeItem_s item;
+         item.key = idx;
+         item.value.fileHandle.filePath      = file;
 
-               jsw_rberase(gOssFileHandleTree, foundItem);
+         item.value.fileHandle.backupCreated = 0;             // set to 0 by default
+         item.value.fileHandle.permission    = -1;
+         item.value.fileHandle.cacheStatus   = -1;            // set to -1 by default
+         item.value.fileHandle.userId        = 0;             // default value
+         memset(item.value.fileHandle.csumPath  , 0, PERS_ORG_MAX_LENGTH_PATH_FILENAME);
+         memset(item.value.fileHandle.backupPath, 0, PERS_ORG_MAX_LENGTH_PATH_FILENAME);
 
-               newItem->key = idx;
-               newItem->value.fileHandle.filePath = file;
-               jsw_rbinsert(gOssFileHandleTree, newItem);
-
-               free(newItem);
-            }
-         }
-         free(item);
+         jsw_rbinsert(gOssFileHandleTree, &item);
+      }
+      else
+      {
+         foundItem->value.fileHandle.filePath = file;
       }
 		pthread_mutex_unlock(&gOssFileHandleAccessMtx);
 	}
@@ -1053,20 +858,10 @@ char* get_ossfile_checksum_path(int idx)
    char* charPtr = NULL;
    if(pthread_mutex_lock(&gOssFileHandleAccessMtx) == 0)
    {
-      if(gOssFileHandleTree != NULL)
+      FileHandleTreeItem_s* foundItem = find_file_handle_item(gOssFileHandleTree, idx);
+      if(foundItem != NULL)
       {
-         FileHandleTreeItem_s* item = malloc(sizeof(FileHandleTreeItem_s));
-         if(item != NULL)
-         {
-            FileHandleTreeItem_s* foundItem = NULL;
-            item->key = idx;
-            foundItem = (FileHandleTreeItem_s*)jsw_rbfind(gOssFileHandleTree, item);
-            if(foundItem != NULL)
-            {
-               charPtr = foundItem->value.fileHandle.csumPath;
-            }
-            free(item);
-         }
+         charPtr = foundItem->value.fileHandle.csumPath;
       }
       pthread_mutex_unlock(&gOssFileHandleAccessMtx);
    }
@@ -1078,46 +873,27 @@ void set_ossfile_backup_status(int idx, int status)
 {
 	if(pthread_mutex_lock(&gOssFileHandleAccessMtx) == 0)
 	{
-	   FileHandleTreeItem_s* item = malloc(sizeof(FileHandleTreeItem_s));
+	   FileHandleTreeItem_s* foundItem = NULL;
 
-      if(gOssFileHandleTree == NULL)
-      {
-         gOssFileHandleTree = jsw_rbnew(fh_key_val_cmp, fh_key_val_dup, fh_key_val_rel);
-      }
+	   create_file_handle_tree(&gOssFileHandleTree);
 
-      if(item != NULL)
+      foundItem = find_file_handle_item(gOssFileHandleTree, idx);
+      if(foundItem == NULL)
       {
-         FileHandleTreeItem_s* foundItem = NULL;
-         item->key = idx;
-         foundItem = (FileHandleTreeItem_s*)jsw_rbfind(gOssFileHandleTree, item);
-         if(foundItem == NULL)
-         {
-            item->value.fileHandle.backupCreated = status;
-
-            item->value.fileHandle.permission    = PersistencePermission_LastEntry;
-            item->value.fileHandle.cacheStatus   = -1;            // set to -1 by default
-            item->value.fileHandle.userId        = 0;             // default value
-            item->value.fileHandle.filePath      = NULL;
-
-            jsw_rbinsert(gOssFileHandleTree, item);
-         }
-         else
-         {
-            FileHandleTreeItem_s* newItem = malloc(sizeof(FileHandleTreeItem_s));
-            if(newItem != NULL)
-            {
-               memcpy(newItem->value.payload , foundItem->value.payload, sizeof(FileHandleData_u) ); // duplicate value
-
-               newItem->key = idx;
-               newItem->value.fileHandle.backupCreated = status;
+         FileHandleTreeItem_s item;
+         item.key = idx;
+         item.value.fileHandle.backupCreated = status;
 
-               jsw_rberase(gOssFileHandleTree, foundItem);
+         item.value.fileHandle.permission    = PersistencePermission_LastEntry;
+         item.value.fileHandle.cacheStatus   = -1;            // set to -1 by default
+         item.value.fileHandle.userId        = 0;             // default value
+         item.value.fileHandle.filePath      = NULL;
 
-               jsw_rbinsert(gOssFileHandleTree, newItem);
-               free(newItem);
-            }
-         }
-         free(item);
+         jsw_rbinsert(gOssFileHandleTree, &item);
+      }
+      else
+      {
+         foundItem->value.fileHandle.backupCreated = status;
       }
 		pthread_mutex_unlock(&gOssFileHandleAccessMtx);
 	}
@@ -1129,20 +905,10 @@ int get_ossfile_backup_status(int idx)
 
    if(pthread_mutex_lock(&gOssFileHandleAccessMtx) == 0)
    {
-      if(gOssFileHandleTree != NULL)
+      FileHandleTreeItem_s* foundItem = find_file_handle_item(gOssFileHandleTree, idx);
+      if(foundItem != NULL)
       {
-         FileHandleTreeItem_s* item = malloc(sizeof(FileHandleTreeItem_s));
-         if(item != NULL)
-         {
-            FileHandleTreeItem_s* foundItem = NULL;
-            item->key = idx;
-            foundItem = (FileHandleTreeItem_s*)jsw_rbfind(gOssFileHandleTree, item);
-            if(foundItem != NULL)
-            {
-               rval = foundItem->value.fileHandle.backupCreated;
-            }
-            free(item);
-         }
+         rval = foundItem->value.fileHandle.backupCreated;
       }
       pthread_mutex_unlock(&gOssFileHandleAccessMtx);
    }
@@ -1158,13 +924,9 @@ int remove_ossfile_handle_data(int idx)
    {
       if(gOssFileHandleTree != NULL)
       {
-         FileHandleTreeItem_s* item = malloc(sizeof(FileHandleTreeItem_s));    // assign key and value to the rbtree item
-         if(item != NULL)
-         {
-            item->key = idx;
-            rval = jsw_rberase(gOssFileHandleTree, item);
-            free(item);
-         }
+         FileHandleTreeItem_s item;
+         item.key = idx;
+         rval = jsw_rberase(gOssFileHandleTree, &item);
       }
 
       pthread_mutex_unlock(&gOssFileHandleAccessMtx);
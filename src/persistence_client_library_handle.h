@@ -21,6 +21,7 @@
  */
 
 #include "persistence_client_library_data_organization.h"
+#include "../include/persistence_client_library.h"
 
 
 /// key handle structure definition
@@ -41,6 +42,8 @@ typedef struct _PersistenceKeyHandle_s
 typedef struct _PersList_item_s
 {
   int fd;
+  /// the flush priority, see ::PCL_FLUSH_PRIO_CRITICAL
+  int priority;
   struct _PersList_item_s *next;
 } PersList_item_s;
 
@@ -401,6 +404,16 @@ int list_item_get_data(PersList_item_s** list, int fd);
 int  list_item_remove(PersList_item_s** list, int fd);
 
 
+/**
+ * @brief set the flush priority of a list item, the default is ::PCL_FLUSH_PRIO_NORMAL
+ *
+ * @param list the list
+ * @param fd the file handle
+ * @param priority the flush priority
+ */
+void list_item_set_priority(PersList_item_s** list, int fd, int priority);
+
+
 /**
  * @brief destroy a list (free all items)
  *
@@ -417,5 +430,15 @@ void list_destroy(PersList_item_s** list);
  */
 void list_iterate(PersList_item_s** list, int(*callback)(int a));
 
+
+/**
+ * @brief get the number of items of a list
+ *
+ * @param list the list
+ *
+ * @return the number of items
+ */
+int list_get_size(PersList_item_s** list);
+
 #endif /* PERSISTENCY_CLIENT_LIBRARY_HANDLE_H */
 
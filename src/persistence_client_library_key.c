@@ -22,8 +22,13 @@
 #include "persistence_client_library_pas_interface.h"
 #include "persistence_client_library_prct_access.h"
 #include "persistence_client_library_db_access.h"
+#include "persistence_client_library_key_async.h"
+#include "persistence_client_library_write_elision.h"
+#include "persistence_client_library_value_ref.h"
+#include "persistence_client_library_key_cache.h"
 
 #include <dlt.h>
+#include <stdlib.h>
 
 DLT_IMPORT_CONTEXT(gPclDLTContext);
 
@@ -31,7 +36,7 @@ DLT_IMPORT_CONTEXT(gPclDLTContext);
 static int gMaxKeyValDataSize = PERS_DB_MAX_SIZE_KEY_DATA;
 
 static pthread_mutex_t gKeyAPIHandleAccessMtx = PTHREAD_MUTEX_INITIALIZER;
-static pthread_mutex_t gKeyAPIAccessMtx = PTHREAD_MUTEX_INITIALIZER;
+pthread_mutex_t gKeyAPIAccessMtx = PTHREAD_MUTEX_INITIALIZER;
 
 // function declaration
 static int handleRegNotifyOnChange(int key_handle, pclChangeNotifyCallback_t callback, PersNotifyRegPolicy_e regPolicy);
@@ -534,6 +539,76 @@ int pclKeyDelete(unsigned int ldbid, const char* resource_id, unsigned int user_
 
 
 
+int pclKeyDeleteUser(unsigned int ldbid, unsigned int user_no, unsigned int seat_no)
+{
+   int rval = EPERS_NOT_INITIALIZED;
+
+   DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("pclKeyDeleteUser - ldbid:"), DLT_UINT(ldbid), DLT_STRING(" user: "), DLT_UINT(user_no));
+
+   if(__sync_add_and_fetch(&gPclInitCounter, 0) > 0)
+   {
+      int lock = pthread_mutex_lock(&gKeyAPIAccessMtx);
+      if(lock == 0)
+      {
+#if USE_APPCHECK
+         if(doAppcheck() == 1)
+         {
+#endif
+            if(AccessNoLock != isAccessLocked() ) // check if access to persistent data is locked
+            {
+               if(user_no != 0)     // user 0 is the node
+               {
+                  PersistenceInfo_s dbContext;
+
+                  memset(&dbContext, 0, sizeof(dbContext));
+                  dbContext.context.ldbid   = ldbid;
+                  dbContext.context.seat_no = seat_no;
+                  dbContext.context.user_no = user_no;
+
+                  // keys only held in the write back cache are not in the key list
+                  if(key_cache_flush() == 0)
+                  {
+                     rval = persistence_delete_user(&dbContext);
+                  }
+                  else
+                  {
+                     DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("pclKeyDeleteUser - write back of cached keys failed"));
+                     rval = EPERS_DB_ERROR_INTERNAL;
+                  }
+               }
+               else
+               {
+                  rval = EPERS_COMMON;
+               }
+            }
+            else
+            {
+               rval = EPERS_LOCKFS;
+            }
+#if USE_APPCHECK
+         }
+         else
+         {
+            rval = EPERS_SHUTDOWN_NO_TRUSTED;
+         }
+#endif
+         pthread_mutex_unlock(&gKeyAPIAccessMtx);
+      }
+      else
+      {
+         DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("pclKeyDeleteUser - mutex lock failed:"), DLT_INT(lock));
+      }
+   }
+   else
+   {
+      DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("pclKeyDeleteUser - not initialized"));
+   }
+
+   return rval;
+}
+
+
+
 int pclKeyGetSize(unsigned int ldbid, const char* resource_id, unsigned int user_no, unsigned int seat_no)
 {
    int data_size = EPERS_NOT_INITIALIZED;
@@ -679,6 +754,194 @@ int pclKeyReadData(unsigned int ldbid, const char* resource_id, unsigned int use
 
 
 
+int pclKeyReadRef(unsigned int ldbid, const char* resource_id, unsigned int user_no, unsigned int seat_no,
+                  const unsigned char** data)
+{
+   int data_size = EPERS_NOT_INITIALIZED;
+
+   DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("pclKeyReadRef - ldbid:"), DLT_UINT(ldbid), DLT_STRING(" res: "),DLT_STRING(resource_id));
+
+   if(__sync_add_and_fetch(&gPclInitCounter, 0) > 0 && data != NULL)
+   {
+      int lock = pthread_mutex_lock(&gKeyAPIAccessMtx);
+      if(lock == 0)
+      {
+#if USE_APPCHECK
+         if(doAppcheck() == 1)
+         {
+#endif
+            if(AccessNoLock != isAccessLocked() ) // check if access to persistent data is locked
+            {
+               PersistenceInfo_s dbContext;
+
+               char dbKey[PERS_DB_MAX_LENGTH_KEY_NAME]   = {0};       // database key
+               char dbPath[PERS_ORG_MAX_LENGTH_PATH_FILENAME] = {0};       // database location
+
+               dbContext.context.ldbid   = ldbid;
+               dbContext.context.seat_no = seat_no;
+               dbContext.context.user_no = user_no;
+
+               // get database context: database path and database key
+               data_size = get_db_context(&dbContext, resource_id, ResIsNoFile, dbKey, dbPath);
+               if(   (data_size >= 0)
+                  && (dbContext.configKey.type == PersistenceResourceType_key) )
+               {
+                  if(dbContext.configKey.storage < PersistenceStorage_LastEntry)   // check if store policy is valid
+                  {
+                     data_size = persistence_get_data_ref(dbPath, dbKey, resource_id, &dbContext, data);
+                  }
+                  else
+                  {
+                     data_size = EPERS_BADPOL;
+                  }
+               }
+               else
+               {
+                  DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("keyReadRef - no db context or res not a key"));
+               }
+            }
+            else
+            {
+               data_size = EPERS_LOCKFS;
+            }
+#if USE_APPCHECK
+         }
+         else
+         {
+            data_size = EPERS_SHUTDOWN_NO_TRUSTED;
+         }
+#endif
+         pthread_mutex_unlock(&gKeyAPIAccessMtx);
+      }
+      else
+      {
+         DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("pclKeyReadRef - mutex lock failed:"), DLT_INT(lock));
+      }
+   }
+   else
+   {
+      DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("keyReadRef - not initialized"));
+   }
+
+   return data_size;
+}
+
+
+
+int pclKeyReleaseRef(const unsigned char* data)
+{
+   return value_ref_release(data);
+}
+
+
+
+int pclKeyReadDataAlloc(unsigned int ldbid, const char* resource_id, unsigned int user_no, unsigned int seat_no,
+                        unsigned char** buffer)
+{
+   const unsigned char* data = NULL;
+   int data_size = EPERS_COMMON;
+
+   if(buffer != NULL)
+   {
+      data_size = pclKeyReadRef(ldbid, resource_id, user_no, seat_no, &data);
+      if(data_size >= 0)
+      {
+         *buffer = malloc((size_t)data_size + 1);
+         if(*buffer != NULL)
+         {
+            memcpy(*buffer, data, (size_t)data_size + 1);     // including the termination
+         }
+         else
+         {
+            data_size = EPERS_DESER_ALLOCMEM;
+         }
+         (void)value_ref_release(data);
+      }
+   }
+
+   return data_size;
+}
+
+
+
+int pclKeyIterate(unsigned int ldbid, unsigned int user_no, unsigned int seat_no, const char* prefix,
+                  pclKeyIterateCallback_t callback, void* user_data)
+{
+   int rval = EPERS_NOT_INITIALIZED;
+   PersKeyListChunk_s* list = NULL;
+
+   DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("pclKeyIterate - ldbid:"), DLT_UINT(ldbid));
+
+   if(__sync_add_and_fetch(&gPclInitCounter, 0) > 0 && callback != NULL)
+   {
+      int lock = pthread_mutex_lock(&gKeyAPIAccessMtx);
+      if(lock == 0)
+      {
+#if USE_APPCHECK
+         if(doAppcheck() == 1)
+         {
+#endif
+            if(AccessNoLock != isAccessLocked() ) // check if access to persistent data is locked
+            {
+               PersistenceInfo_s dbContext;
+
+               memset(&dbContext, 0, sizeof(dbContext));
+               dbContext.context.ldbid   = ldbid;
+               dbContext.context.seat_no = seat_no;
+               dbContext.context.user_no = user_no;
+
+               (void)key_cache_flush();      // keys only held in the write back cache are not in the key list
+
+               rval = persistence_get_key_list(&dbContext, (prefix != NULL) ? prefix : "", &list);
+            }
+            else
+            {
+               rval = EPERS_LOCKFS;
+            }
+#if USE_APPCHECK
+         }
+         else
+         {
+            rval = EPERS_SHUTDOWN_NO_TRUSTED;
+         }
+#endif
+         pthread_mutex_unlock(&gKeyAPIAccessMtx);
+      }
+      else
+      {
+         DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("pclKeyIterate - mutex lock failed:"), DLT_INT(lock));
+      }
+
+      if(rval >= 0)
+      {
+         // the callback is called without the lock, so it can access the keys
+         const PersKeyListChunk_s* chunk = NULL;
+         int stop = 0;
+
+         rval = 0;
+         for(chunk = list; chunk != NULL && stop == 0; chunk = chunk->next)
+         {
+            unsigned int i = 0;
+
+            for(i = 0; i < chunk->used && stop == 0; i += (unsigned int)strlen(&chunk->names[i]) + 1)
+            {
+               rval++;
+               stop = callback(&chunk->names[i], user_data);
+            }
+         }
+      }
+      persistence_free_key_list(list);
+   }
+   else
+   {
+      DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("pclKeyIterate - not initialized"));
+   }
+
+   return rval;
+}
+
+
+
 int pclKeyWriteData(unsigned int ldbid, const char* resource_id, unsigned int user_no, unsigned int seat_no,
                    unsigned char* buffer, int buffer_size)
 {
@@ -779,6 +1042,313 @@ int pclKeyWriteData(unsigned int ldbid, const char* resource_id, unsigned int us
 
 
 
+/* check the resource of a batch item, returns 0 if the item can be accessed */
+static int check_multi_item(PersCustomItem_s* item, int write)
+{
+   int rval = 0;
+
+   if(item->info.configKey.type != PersistenceResourceType_key)
+   {
+      DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("keyMulti - res not a key:"), DLT_STRING(item->resource_id));
+      rval = EPERS_COMMON;
+   }
+   else if(item->info.configKey.storage >= PersistenceStorage_LastEntry)   // check if store policy is valid
+   {
+      rval = EPERS_BADPOL;
+   }
+   else if(write == 1)
+   {
+      if(item->size > gMaxKeyValDataSize)
+      {
+         rval = EPERS_BUFLIMIT;
+      }
+      else if(item->info.configKey.permission == PersistencePermission_ReadOnly)
+      {
+         rval = EPERS_RESOURCE_READ_ONLY;
+      }
+      else if(   (item->info.configKey.storage == PersistenceStorage_shared)
+              && (0 != strncmp(item->info.configKey.reponsible, gAppId, PERS_RCT_MAX_LENGTH_RESPONSIBLE) ) )
+      {
+         rval = EPERS_NOT_RESP_APP;
+      }
+   }
+   return rval;
+}
+
+
+
+/* read or write several keys under one lock, custom storage items are passed to the plugins in one batch */
+static int key_access_multi(unsigned int ldbid, unsigned int user_no, unsigned int seat_no,
+                            pclKeyMultiItem_s* items, int count, int write)
+{
+   int rval = EPERS_NOT_INITIALIZED;
+
+   if(items == NULL || count <= 0)
+   {
+      rval = EPERS_COMMON;
+   }
+   else if(__sync_add_and_fetch(&gPclInitCounter, 0) > 0)
+   {
+      int lock = pthread_mutex_lock(&gKeyAPIAccessMtx);
+      if(lock == 0)
+      {
+#if USE_APPCHECK
+         if(doAppcheck() == 1)
+         {
+#endif
+            if(AccessNoLock != isAccessLocked() ) // check if access to persistent data is locked
+            {
+               PersCustomItem_s* custom = calloc((size_t)count, sizeof(PersCustomItem_s));
+               int* customIdx = malloc((size_t)count * sizeof(int));
+
+               if(custom != NULL && customIdx != NULL)
+               {
+                  int i = 0, numCustom = 0;
+
+                  for(i = 0; i < count; i++)
+                  {
+                     PersCustomItem_s* item = &custom[numCustom];
+
+                     item->info.context.ldbid   = ldbid;
+                     item->info.context.seat_no = seat_no;
+                     item->info.context.user_no = user_no;
+                     item->resource_id = items[i].resource_id;
+                     item->buffer      = items[i].buffer;
+                     item->size        = items[i].buffer_size;
+
+                     // get database context: database path and database key
+                     items[i].result = get_db_context(&item->info, items[i].resource_id, ResIsNoFile, item->dbKey, item->dbPath);
+                     if(items[i].result >= 0)
+                     {
+                        items[i].result = check_multi_item(item, write);
+                     }
+
+                     if(items[i].result >= 0)
+                     {
+                        if(item->info.configKey.storage == PersistenceStorage_custom)
+                        {
+                           customIdx[numCustom++] = i;      // keep the item for the plugin batch
+                        }
+                        else if(write == 1)
+                        {
+                           items[i].result = persistence_set_data(item->dbPath, item->dbKey, item->resource_id, &item->info, item->buffer, item->size);
+                        }
+                        else
+                        {
+                           items[i].result = persistence_get_data(item->dbPath, item->dbKey, item->resource_id, &item->info, item->buffer, item->size);
+                        }
+                     }
+                  }
+
+                  if(numCustom > 0)
+                  {
+                     if(write == 1)
+                        persistence_custom_set_data_multi(custom, numCustom);
+                     else
+                        persistence_custom_get_data_multi(custom, numCustom);
+
+                     for(i = 0; i < numCustom; i++)
+                     {
+                        items[customIdx[i]].result = custom[i].result;
+                     }
+                  }
+
+                  rval = 0;
+                  for(i = 0; i < count; i++)
+                  {
+                     if(items[i].result >= 0)
+                        rval++;
+                  }
+               }
+               else
+               {
+                  rval = EPERS_DESER_ALLOCMEM;
+               }
+               free(customIdx);
+               free(custom);
+            }
+            else
+            {
+               rval = EPERS_LOCKFS;
+            }
+#if USE_APPCHECK
+         }
+         else
+         {
+            rval = EPERS_SHUTDOWN_NO_TRUSTED;
+         }
+#endif
+         pthread_mutex_unlock(&gKeyAPIAccessMtx);
+      }
+      else
+      {
+         DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("keyMulti - mutex lock failed:"), DLT_INT(lock));
+      }
+   }
+   else
+   {
+      DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("keyMulti - not initialized"));
+   }
+
+   return rval;
+}
+
+
+
+int pclKeyReadDataMulti(unsigned int ldbid, unsigned int user_no, unsigned int seat_no, pclKeyMultiItem_s* items, int count)
+{
+   DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("pclKeyReadDataMulti - ldbid:"), DLT_UINT(ldbid), DLT_STRING(" count: "), DLT_INT(count));
+
+   return key_access_multi(ldbid, user_no, seat_no, items, count, 0);
+}
+
+
+
+int pclKeyWriteDataMulti(unsigned int ldbid, unsigned int user_no, unsigned int seat_no, pclKeyMultiItem_s* items, int count)
+{
+   DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("pclKeyWriteDataMulti - ldbid:"), DLT_UINT(ldbid), DLT_STRING(" count: "), DLT_INT(count));
+
+   return key_access_multi(ldbid, user_no, seat_no, items, count, 1);
+}
+
+
+
+int pclKeyWriteDataAsync(unsigned int ldbid, const char* resource_id, unsigned int user_no, unsigned int seat_no,
+                         unsigned char* buffer, int buffer_size, pclKeyWriteDoneCallback_t callback, void* user_data)
+{
+   int rval = EPERS_NOT_INITIALIZED;
+
+   if(__sync_add_and_fetch(&gPclInitCounter, 0) > 0)
+   {
+      if(buffer != NULL && buffer_size >= 0 && buffer_size <= gMaxKeyValDataSize)  // check data size
+      {
+         rval = key_async_write(ldbid, resource_id, user_no, seat_no, buffer, buffer_size, callback, user_data);
+      }
+      else
+      {
+         rval = EPERS_BUFLIMIT;
+         DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("pclKeyWriteDataAsync - invalid buffer, limit is [bytes]:"), DLT_INT(gMaxKeyValDataSize));
+      }
+   }
+   else
+   {
+      DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("pclKeyWriteDataAsync - not initialized"));
+   }
+
+   return rval;
+}
+
+
+
+int pclKeyReadDataAsync(unsigned int ldbid, const char* resource_id, unsigned int user_no, unsigned int seat_no,
+                        unsigned char* buffer, int buffer_size, pclKeyWriteDoneCallback_t callback, void* user_data)
+{
+   int rval = EPERS_NOT_INITIALIZED;
+
+   if(__sync_add_and_fetch(&gPclInitCounter, 0) > 0)
+   {
+      if(buffer != NULL && buffer_size > 0)
+      {
+         rval = key_async_read(ldbid, resource_id, user_no, seat_no, buffer, buffer_size, callback, user_data);
+      }
+      else
+      {
+         rval = EPERS_COMMON;
+         DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("pclKeyReadDataAsync - invalid buffer"));
+      }
+   }
+   else
+   {
+      DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("pclKeyReadDataAsync - not initialized"));
+   }
+
+   return rval;
+}
+
+
+
+int pclKeyAsyncGetFd(void)
+{
+   int rval = EPERS_NOT_INITIALIZED;
+
+   if(__sync_add_and_fetch(&gPclInitCounter, 0) > 0)
+   {
+      rval = key_async_get_fd();
+   }
+
+   return rval;
+}
+
+
+
+int pclKeyAsyncGetResult(int* result)
+{
+   int rval = EPERS_NOT_INITIALIZED;
+
+   if(__sync_add_and_fetch(&gPclInitCounter, 0) > 0 && result != NULL)
+   {
+      rval = key_async_get_result(result);
+   }
+
+   return rval;
+}
+
+
+
+int pclUserPrefetch(unsigned int user_no, unsigned int seat_no)
+{
+   int rval = EPERS_NOT_INITIALIZED;
+
+   if(__sync_add_and_fetch(&gPclInitCounter, 0) > 0)
+   {
+      rval = key_async_prefetch_user(PCL_LDBID_LOCAL, user_no, seat_no);
+      if(rval > 0)
+         rval = 0;
+   }
+
+   return rval;
+}
+
+
+
+int pclKeyGetCacheStats(pclCacheStats_s* stats)
+{
+   int rval = EPERS_NOT_INITIALIZED;
+
+   if(__sync_add_and_fetch(&gPclInitCounter, 0) > 0)
+   {
+      rval = EPERS_COMMON;
+      if(stats != NULL)
+      {
+         value_ref_get_stats(stats);
+         rval = 0;
+      }
+   }
+
+   return rval;
+}
+
+
+
+int pclKeyGetWriteElisionStats(pclWriteElisionStats_s* stats)
+{
+   int rval = EPERS_NOT_INITIALIZED;
+
+   if(__sync_add_and_fetch(&gPclInitCounter, 0) > 0)
+   {
+      rval = EPERS_COMMON;
+      if(stats != NULL)
+      {
+         write_elision_get_stats(stats);
+         rval = 0;
+      }
+   }
+
+   return rval;
+}
+
+
+
 int pclKeyUnRegisterNotifyOnChange( unsigned int  ldbid, const char *  resource_id, unsigned int  user_no, unsigned int  seat_no, pclChangeNotifyCallback_t  callback)
 {
    int rval = EPERS_NOT_INITIALIZED;
@@ -0,0 +1,889 @@
+/******************************************************************************
+ * Project         Persistency
+ * (c) copyright   2012
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+******************************************************************************/
+ /**
+ * @file           persistence_client_library_key_async.c
+ * @ingroup        Persistence client library
+ * @author         Ingo Huerner
+ * @brief          Implementation of the asynchronous key write queue.
+ *                 The I/O worker thread is started with the first request and
+ *                 executes the requests in FIFO order, writes with pclKeyWriteData.
+ *                 Requests to custom storage plugins providing non blocking access
+ *                 are passed to the plugin, the worker continues with the next request.
+ *                 Only one plugin request per path is in flight, further requests
+ *                 to the path wait until it has been completed.
+ * @see
+ */
+
+#include "persistence_client_library_key_async.h"
+#include "persistence_client_library_data_organization.h"
+#include "persistence_client_library_db_access.h"
+#include "persistence_client_library_pas_interface.h"
+#include "persistence_client_library_prct_access.h"
+#include "persistence_client_library_value_ref.h"
+
+#include <dlt.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+DLT_IMPORT_CONTEXT(gPclDLTContext);
+
+
+/// request types
+typedef enum _KeyAsyncType_e
+{
+   /// write a key
+   KeyAsync_Write    = 0,
+   /// prefetch the keys of a user
+   KeyAsync_Prefetch = 1,
+   /// read a key
+   KeyAsync_Read     = 2,
+   /// all requests queued before have been executed, see ::key_async_drain
+   KeyAsync_Barrier  = 3
+} KeyAsyncType_e;
+
+
+/// queued request, followed by the data of a write request
+typedef struct _KeyAsyncRequest_s
+{
+   /// next request in the queue or the completed list
+   struct _KeyAsyncRequest_s* next;
+   /// next request in the in flight list
+   struct _KeyAsyncRequest_s* inFlight;
+   /// next request to the same plugin path, started when this request has been completed
+   struct _KeyAsyncRequest_s* pending;
+   /// the request type
+   KeyAsyncType_e type;
+   /// the request ID
+   int id;
+   /// the size of the data
+   int size;
+   /// logical database ID
+   unsigned int ldbid;
+   /// the user ID
+   unsigned int user_no;
+   /// the seat number
+   unsigned int seat_no;
+   /// the completion callback or NULL
+   pclKeyWriteDoneCallback_t callback;
+   /// passed to the completion callback
+   void* user_data;
+   /// the buffer of a read request
+   unsigned char* buffer;
+   /// the resource, used for non blocking plugin access
+   PersCustomItem_s item;
+   /// the resource ID
+   char resource_id[PERS_DB_MAX_LENGTH_KEY_NAME];
+} KeyAsyncRequest_s;
+
+
+/// result of a completed request without callback
+typedef struct _KeyAsyncResult_s
+{
+   /// next result in the queue
+   struct _KeyAsyncResult_s* next;
+   /// the request ID
+   int id;
+   /// the result of pclKeyWriteData or pclKeyReadData
+   int result;
+} KeyAsyncResult_s;
+
+
+/// mutex protecting the request and the result queue
+static pthread_mutex_t gKeyAsyncMtx = PTHREAD_MUTEX_INITIALIZER;
+/// condition to wake up the I/O worker thread
+static pthread_cond_t gKeyAsyncCond = PTHREAD_COND_INITIALIZER;
+/// I/O worker thread
+static pthread_t gKeyAsyncThread;
+/// flag to indicate if the I/O worker thread is running
+static int gKeyAsyncThreadRunning = 0;
+/// flag to stop the I/O worker thread, no more requests will be accepted
+static int gKeyAsyncStop = 0;
+/// the last request ID
+static int gKeyAsyncLastId = 0;
+/// first and last request in the queue
+static KeyAsyncRequest_s* gKeyAsyncHead = NULL;
+static KeyAsyncRequest_s* gKeyAsyncTail = NULL;
+/// first and last completed request without callback
+static KeyAsyncResult_s* gKeyAsyncResultHead = NULL;
+static KeyAsyncResult_s* gKeyAsyncResultTail = NULL;
+/// eventfd signalled for completed requests without callback, -1 if not requested
+static int gKeyAsyncEventFd = -1;
+/// requests passed to a plugin, not yet completed
+static KeyAsyncRequest_s* gKeyAsyncInFlight = NULL;
+/// first and last request completed by a plugin, to be finished by the I/O worker thread
+static KeyAsyncRequest_s* gKeyAsyncDoneHead = NULL;
+static KeyAsyncRequest_s* gKeyAsyncDoneTail = NULL;
+/// ID of the last executed barrier request
+static int gKeyAsyncBarrierId = 0;
+/// signalled when a barrier request has been executed
+static pthread_cond_t gKeyAsyncBarrierCond = PTHREAD_COND_INITIALIZER;
+
+
+
+/* store the result of a request without callback and signal the eventfd, the mutex must be held */
+static void key_async_add_result(int id, int result)
+{
+   if(gKeyAsyncEventFd != -1)       // nobody is waiting for the result otherwise
+   {
+      KeyAsyncResult_s* entry = malloc(sizeof(KeyAsyncResult_s));
+
+      if(entry != NULL)
+      {
+         uint64_t one = 1;
+
+         entry->next   = NULL;
+         entry->id     = id;
+         entry->result = result;
+
+         if(gKeyAsyncResultTail != NULL)
+            gKeyAsyncResultTail->next = entry;
+         else
+            gKeyAsyncResultHead = entry;
+         gKeyAsyncResultTail = entry;
+
+         if(write(gKeyAsyncEventFd, &one, sizeof(one)) != (ssize_t)sizeof(one))
+         {
+            DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("keyAsync - Failed to signal eventfd"));
+         }
+      }
+      else
+      {
+         DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("keyAsync - Failed to store result of request:"), DLT_INT(id));
+      }
+   }
+}
+
+
+
+/* lock the key API, returns 0 if the library can be accessed */
+static int key_async_lock(void)
+{
+   int rval = EPERS_NOT_INITIALIZED;
+
+   if(__sync_add_and_fetch(&gPclInitCounter, 0) > 0 && pthread_mutex_lock(&gKeyAPIAccessMtx) == 0)
+   {
+      rval = 0;
+      if(AccessNoLock == isAccessLocked())      // the file system is locked
+      {
+         pthread_mutex_unlock(&gKeyAPIAccessMtx);
+         rval = EPERS_LOCKFS;
+      }
+   }
+   return rval;
+}
+
+
+
+/* load the keys of a user into the value cache.
+   The key list is taken under the key API mutex, the values are loaded in batches
+   of KeyPrefetchBatchSize keys, the application can access keys between the batches */
+static int key_async_prefetch(unsigned int ldbid, unsigned int user_no, unsigned int seat_no)
+{
+   int rval = 0, loaded = 0, i = 0;
+   static const int policies[] = { PersistencePolicy_wc, PersistencePolicy_wt };
+
+   for(i = 0; i < (int)(sizeof(policies) / sizeof(policies[0])) && rval >= 0; i++)
+   {
+      PersistenceInfo_s dbContext;
+      PersKeyListChunk_s* list = NULL;
+      const PersKeyListChunk_s* chunk = NULL;
+      int locked = -1, batch = 0, count = 0;
+
+      memset(&dbContext, 0, sizeof(dbContext));
+      dbContext.context.ldbid   = ldbid;
+      dbContext.context.seat_no = seat_no;
+      dbContext.context.user_no = user_no;
+
+      locked = key_async_lock();
+      if(locked == 0)
+      {
+         count = persistence_prefetch_keys(&dbContext, policies[i], &list);
+         pthread_mutex_unlock(&gKeyAPIAccessMtx);
+      }
+
+      for(chunk = list; chunk != NULL && count >= 0; chunk = chunk->next)
+      {
+         unsigned int k = 0;
+
+         for(k = 0; k < chunk->used && count >= 0; k += (unsigned int)strlen(&chunk->names[k]) + 1)
+         {
+            if(batch == 0)
+            {
+               locked = key_async_lock();
+               if(locked != 0)
+               {
+                  break;
+               }
+            }
+
+            if(persistence_prefetch_key(&dbContext, policies[i], &chunk->names[k]) == 1)
+            {
+               loaded++;
+            }
+
+            if(++batch == KeyPrefetchBatchSize)
+            {
+               pthread_mutex_unlock(&gKeyAPIAccessMtx);
+               batch = 0;
+            }
+         }
+         if(locked != 0)
+         {
+            break;
+         }
+      }
+
+      if(batch != 0)
+      {
+         pthread_mutex_unlock(&gKeyAPIAccessMtx);
+      }
+      persistence_free_key_list(list);
+
+      if(locked != 0)
+      {
+         rval = locked;
+      }
+      else if(count < 0)
+      {
+         rval = count;
+      }
+   }
+
+   value_ref_add_prefetched((unsigned int)loaded);
+   if(rval == 0)
+   {
+      rval = loaded;
+   }
+   DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("keyAsync - prefetched user:"), DLT_UINT(user_no), DLT_STRING("keys:"), DLT_INT(rval));
+
+   return rval;
+}
+
+
+
+/* call the completion callback or store the result and free the request */
+static void key_async_finish(KeyAsyncRequest_s* request, int result)
+{
+   if(request->callback != NULL)
+   {
+      request->callback(request->id, result, request->user_data);
+   }
+
+   pthread_mutex_lock(&gKeyAsyncMtx);
+   if(request->callback == NULL && request->type != KeyAsync_Prefetch)
+   {
+      key_async_add_result(request->id, result);
+   }
+   pthread_mutex_unlock(&gKeyAsyncMtx);
+
+   free(request);
+}
+
+
+
+/* completion callback of the plugins, may be called by any thread */
+static void key_async_plugin_done(int result, void* user_data)
+{
+   KeyAsyncRequest_s* request = (KeyAsyncRequest_s*)user_data;
+
+   pthread_mutex_lock(&gKeyAsyncMtx);
+
+   request->item.result = result;
+   request->next = NULL;
+   if(gKeyAsyncDoneTail != NULL)
+      gKeyAsyncDoneTail->next = request;
+   else
+      gKeyAsyncDoneHead = request;
+   gKeyAsyncDoneTail = request;
+
+   pthread_cond_signal(&gKeyAsyncCond);
+   pthread_mutex_unlock(&gKeyAsyncMtx);
+}
+
+
+
+/* pass a request to the plugin, the key API mutex must be held.
+   Returns 1 if the request will be completed by the plugin, 0 if the plugin has no non blocking access */
+static int key_async_dispatch(KeyAsyncRequest_s* request)
+{
+   int rval = 0;
+
+   pthread_mutex_lock(&gKeyAsyncMtx);
+   request->inFlight = gKeyAsyncInFlight;
+   gKeyAsyncInFlight = request;
+   pthread_mutex_unlock(&gKeyAsyncMtx);
+
+   rval = persistence_custom_start_async(&request->item, (request->type == KeyAsync_Write), key_async_plugin_done, request);
+   if(rval == EPERS_NOPLUGINFUNCT)
+   {
+      KeyAsyncRequest_s** entry = NULL;
+
+      pthread_mutex_lock(&gKeyAsyncMtx);
+      for(entry = &gKeyAsyncInFlight; *entry != NULL; entry = &(*entry)->inFlight)
+      {
+         if(*entry == request)
+         {
+            *entry = request->inFlight;
+            break;
+         }
+      }
+      pthread_mutex_unlock(&gKeyAsyncMtx);
+      rval = 0;
+   }
+   else if(rval < 0)
+   {
+      DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("keyAsync - plugin rejected request:"), DLT_STRING(request->resource_id), DLT_INT(rval));
+      key_async_plugin_done(rval, request);
+      rval = 1;
+   }
+   else
+   {
+      rval = 1;
+   }
+
+   return rval;
+}
+
+
+
+/* pass a read or write request of a custom storage resource to the plugin.
+   Returns 1 if the request will be completed by the plugin, 0 if it must be executed synchronously */
+static int key_async_start_custom(KeyAsyncRequest_s* request)
+{
+   int rval = 0;
+
+   if(__sync_add_and_fetch(&gPclInitCounter, 0) > 0 && pthread_mutex_lock(&gKeyAPIAccessMtx) == 0)
+   {
+      if(AccessNoLock != isAccessLocked())
+      {
+         PersCustomItem_s* item = &request->item;
+
+         memset(item, 0, sizeof(PersCustomItem_s));
+         item->info.context.ldbid   = request->ldbid;
+         item->info.context.seat_no = request->seat_no;
+         item->info.context.user_no = request->user_no;
+         item->resource_id = request->resource_id;
+         item->buffer      = (request->type == KeyAsync_Write) ? (unsigned char*)(request + 1) : request->buffer;
+         item->size        = request->size;
+
+         if(   get_db_context(&item->info, request->resource_id, ResIsNoFile, item->dbKey, item->dbPath) >= 0
+            && item->info.configKey.type    == PersistenceResourceType_key
+            && item->info.configKey.storage == PersistenceStorage_custom
+            && (request->type == KeyAsync_Read || item->info.configKey.permission != PersistencePermission_ReadOnly) )
+         {
+            KeyAsyncRequest_s* inFlight = NULL;
+
+            pthread_mutex_lock(&gKeyAsyncMtx);
+            for(inFlight = gKeyAsyncInFlight; inFlight != NULL; inFlight = inFlight->inFlight)
+            {
+               if(   inFlight->item.info.customLibId == item->info.customLibId
+                  && 0 == strncmp(inFlight->item.info.customKey, item->info.customKey, CUSTOM_KEY_SIZE) )
+               {
+                  while(inFlight->pending != NULL)    // keep the order of the requests to the path
+                     inFlight = inFlight->pending;
+                  inFlight->pending = request;
+                  rval = 1;
+                  break;
+               }
+            }
+            pthread_mutex_unlock(&gKeyAsyncMtx);
+
+            if(rval == 0)
+            {
+               rval = key_async_dispatch(request);
+            }
+         }
+      }
+      pthread_mutex_unlock(&gKeyAPIAccessMtx);
+   }
+   return rval;
+}
+
+
+
+/* put the requests waiting for a path back to the front of the queue in their order,
+   they have been queued before all requests still in the queue */
+static void key_async_requeue(KeyAsyncRequest_s* first)
+{
+   KeyAsyncRequest_s* last = first;
+
+   pthread_mutex_lock(&gKeyAsyncMtx);
+   while(last->pending != NULL)
+   {
+      last->next = last->pending;
+      last = last->pending;
+   }
+   last->next = gKeyAsyncHead;
+   if(gKeyAsyncHead == NULL)
+      gKeyAsyncTail = last;
+   gKeyAsyncHead = first;
+   pthread_mutex_unlock(&gKeyAsyncMtx);
+}
+
+
+
+/* finish a request completed by a plugin and start the next request to the same path */
+static void key_async_complete(KeyAsyncRequest_s* request)
+{
+   KeyAsyncRequest_s* next = NULL;
+   KeyAsyncRequest_s** entry = NULL;
+   int write = (request->type == KeyAsync_Write);
+
+   if(pthread_mutex_lock(&gKeyAPIAccessMtx) == 0)
+   {
+      persistence_custom_item_done(&request->item, write);
+
+      pthread_mutex_lock(&gKeyAsyncMtx);
+      for(entry = &gKeyAsyncInFlight; *entry != NULL; entry = &(*entry)->inFlight)
+      {
+         if(*entry == request)
+         {
+            *entry = request->inFlight;
+            break;
+         }
+      }
+      next = request->pending;
+      pthread_mutex_unlock(&gKeyAsyncMtx);
+
+      if(next != NULL && key_async_dispatch(next) == 0)
+      {
+         // no non blocking access for this request type, executed synchronously by the worker
+         key_async_requeue(next);
+      }
+      pthread_mutex_unlock(&gKeyAPIAccessMtx);
+   }
+
+   key_async_finish(request, request->item.result);
+}
+
+
+
+/* execute a request, requests to plugins with non blocking access are only started */
+static void key_async_execute(KeyAsyncRequest_s* request)
+{
+   if(request->type == KeyAsync_Barrier)
+   {
+      pthread_mutex_lock(&gKeyAsyncMtx);
+      gKeyAsyncBarrierId = request->id;
+      pthread_cond_broadcast(&gKeyAsyncBarrierCond);
+      pthread_mutex_unlock(&gKeyAsyncMtx);
+      free(request);
+   }
+   else if(request->type == KeyAsync_Prefetch)
+   {
+      key_async_finish(request, key_async_prefetch(request->ldbid, request->user_no, request->seat_no));
+   }
+   else if(key_async_start_custom(request) == 0)
+   {
+      int result = 0;
+
+      if(request->type == KeyAsync_Write)
+      {
+         result = pclKeyWriteData(request->ldbid, request->resource_id, request->user_no, request->seat_no,
+                                  (unsigned char*)(request + 1), request->size);
+      }
+      else
+      {
+         result = pclKeyReadData(request->ldbid, request->resource_id, request->user_no, request->seat_no,
+                                 request->buffer, request->size);
+      }
+      key_async_finish(request, result);
+   }
+}
+
+
+
+static void* key_async_worker(void* dummy)
+{
+   struct timespec deadline = {0, 0};
+   int waitForPlugins = 0;
+
+   (void)dummy;
+
+   pthread_mutex_lock(&gKeyAsyncMtx);
+
+   while(1)
+   {
+      KeyAsyncRequest_s* request = NULL;
+
+      if(gKeyAsyncDoneHead != NULL)
+      {
+         request = gKeyAsyncDoneHead;
+         gKeyAsyncDoneHead = request->next;
+         if(gKeyAsyncDoneHead == NULL)
+            gKeyAsyncDoneTail = NULL;
+
+         pthread_mutex_unlock(&gKeyAsyncMtx);
+         key_async_complete(request);
+         pthread_mutex_lock(&gKeyAsyncMtx);
+      }
+      else if(gKeyAsyncHead != NULL)
+      {
+         request = gKeyAsyncHead;
+         gKeyAsyncHead = request->next;
+         if(gKeyAsyncHead == NULL)
+            gKeyAsyncTail = NULL;
+         request->next    = NULL;
+         request->pending = NULL;
+
+         pthread_mutex_unlock(&gKeyAsyncMtx);
+         key_async_execute(request);
+         pthread_mutex_lock(&gKeyAsyncMtx);
+      }
+      else if(gKeyAsyncStop == 0)
+      {
+         pthread_cond_wait(&gKeyAsyncCond, &gKeyAsyncMtx);
+      }
+      else if(gKeyAsyncInFlight != NULL)     // wait for the plugins to complete their requests
+      {
+         if(waitForPlugins == 0)
+         {
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec  += CustomAsyncTimeoutMs / 1000;
+            deadline.tv_nsec += (CustomAsyncTimeoutMs % 1000) * 1000000L;
+            if(deadline.tv_nsec >= 1000000000L)
+            {
+               deadline.tv_sec++;
+               deadline.tv_nsec -= 1000000000L;
+            }
+            waitForPlugins = 1;
+         }
+
+         if(pthread_cond_timedwait(&gKeyAsyncCond, &gKeyAsyncMtx, &deadline) == ETIMEDOUT)
+         {
+            // the requests are not freed, the plugin may still call the completion callback
+            DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("keyAsync - plugin requests not completed in time"));
+            gKeyAsyncInFlight = NULL;
+         }
+      }
+      else
+      {
+         break;
+      }
+   }
+
+   pthread_mutex_unlock(&gKeyAsyncMtx);
+
+   return NULL;
+}
+
+
+
+/* add a request to the queue and start the I/O worker thread if needed, returns the request ID */
+static int key_async_queue(KeyAsyncRequest_s* request)
+{
+   int rval = EPERS_NOT_INITIALIZED;
+
+   if(pthread_mutex_lock(&gKeyAsyncMtx) == 0)
+   {
+      if(gKeyAsyncStop == 0)
+      {
+         if(gKeyAsyncThreadRunning == 0)
+         {
+            if(pthread_create(&gKeyAsyncThread, NULL, key_async_worker, NULL) == 0)
+            {
+               gKeyAsyncThreadRunning = 1;
+            }
+            else
+            {
+               DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("keyAsync - Failed to start I/O worker thread"));
+               rval = EPERS_COMMON;
+            }
+         }
+
+         if(gKeyAsyncThreadRunning == 1)
+         {
+            if(++gKeyAsyncLastId <= 0)      // wrap around, IDs are always greater than 0
+               gKeyAsyncLastId = 1;
+            request->id = gKeyAsyncLastId;
+            rval = request->id;
+
+            if(gKeyAsyncTail != NULL)
+               gKeyAsyncTail->next = request;
+            else
+               gKeyAsyncHead = request;
+            gKeyAsyncTail = request;
+
+            pthread_cond_signal(&gKeyAsyncCond);
+         }
+      }
+      pthread_mutex_unlock(&gKeyAsyncMtx);
+   }
+
+   return rval;
+}
+
+
+
+void key_async_init(void)
+{
+   pthread_mutex_lock(&gKeyAsyncMtx);
+   gKeyAsyncStop = 0;
+   pthread_mutex_unlock(&gKeyAsyncMtx);
+}
+
+
+
+int key_async_write(unsigned int ldbid, const char* resource_id, unsigned int user_no, unsigned int seat_no,
+                    const unsigned char* buffer, int buffer_size, pclKeyWriteDoneCallback_t callback, void* user_data)
+{
+   int rval = EPERS_NOT_INITIALIZED;
+   KeyAsyncRequest_s* request = NULL;
+
+   if(resource_id == NULL || strlen(resource_id) >= PERS_DB_MAX_LENGTH_KEY_NAME)
+   {
+      return EPERS_DB_KEY_SIZE;
+   }
+
+   request = malloc(sizeof(KeyAsyncRequest_s) + (size_t)buffer_size);
+   if(request == NULL)
+   {
+      return EPERS_DESER_ALLOCMEM;
+   }
+
+   request->next      = NULL;
+   request->pending   = NULL;
+   request->type      = KeyAsync_Write;
+   request->size      = buffer_size;
+   request->ldbid     = ldbid;
+   request->user_no   = user_no;
+   request->seat_no   = seat_no;
+   request->callback  = callback;
+   request->user_data = user_data;
+   request->buffer    = NULL;
+   strncpy(request->resource_id, resource_id, PERS_DB_MAX_LENGTH_KEY_NAME);
+   memcpy(request + 1, buffer, (size_t)buffer_size);
+
+   rval = key_async_queue(request);
+   if(rval < 0)
+   {
+      free(request);    // not queued
+   }
+
+   return rval;
+}
+
+
+
+int key_async_read(unsigned int ldbid, const char* resource_id, unsigned int user_no, unsigned int seat_no,
+                   unsigned char* buffer, int buffer_size, pclKeyWriteDoneCallback_t callback, void* user_data)
+{
+   int rval = EPERS_DESER_ALLOCMEM;
+   KeyAsyncRequest_s* request = NULL;
+
+   if(resource_id == NULL || strlen(resource_id) >= PERS_DB_MAX_LENGTH_KEY_NAME)
+   {
+      return EPERS_DB_KEY_SIZE;
+   }
+
+   request = calloc(1, sizeof(KeyAsyncRequest_s));
+   if(request != NULL)
+   {
+      request->type      = KeyAsync_Read;
+      request->size      = buffer_size;
+      request->ldbid     = ldbid;
+      request->user_no   = user_no;
+      request->seat_no   = seat_no;
+      request->callback  = callback;
+      request->user_data = user_data;
+      request->buffer    = buffer;
+      strncpy(request->resource_id, resource_id, PERS_DB_MAX_LENGTH_KEY_NAME);
+
+      rval = key_async_queue(request);
+      if(rval < 0)
+      {
+         free(request);    // not queued
+      }
+   }
+
+   return rval;
+}
+
+
+
+int key_async_prefetch_user(unsigned int ldbid, unsigned int user_no, unsigned int seat_no)
+{
+   int rval = EPERS_DESER_ALLOCMEM;
+   KeyAsyncRequest_s* request = calloc(1, sizeof(KeyAsyncRequest_s));
+
+   if(request != NULL)
+   {
+      request->type    = KeyAsync_Prefetch;
+      request->ldbid   = ldbid;
+      request->user_no = user_no;
+      request->seat_no = seat_no;
+
+      rval = key_async_queue(request);
+      if(rval < 0)
+      {
+         free(request);    // not queued
+      }
+   }
+
+   return rval;
+}
+
+
+
+int key_async_drain(int timeout_ms)
+{
+   int rval = 0, id = 0, running = 0;
+   KeyAsyncRequest_s* request = NULL;
+
+   pthread_mutex_lock(&gKeyAsyncMtx);
+   running = gKeyAsyncThreadRunning;
+   pthread_mutex_unlock(&gKeyAsyncMtx);
+
+   if(running == 0)
+   {
+      return 0;      // nothing has been queued
+   }
+
+   request = malloc(sizeof(KeyAsyncRequest_s));
+   if(request == NULL)
+   {
+      return EPERS_DESER_ALLOCMEM;
+   }
+   memset(request, 0, sizeof(KeyAsyncRequest_s));
+   request->type = KeyAsync_Barrier;
+
+   id = key_async_queue(request);
+   if(id < 0)
+   {
+      free(request);
+      return 0;      // stopped, the queue has already been executed
+   }
+
+   pthread_mutex_lock(&gKeyAsyncMtx);
+   if(gKeyAsyncBarrierId != id)
+   {
+      struct timespec deadline;
+
+      clock_gettime(CLOCK_REALTIME, &deadline);
+      deadline.tv_sec  += timeout_ms / 1000;
+      deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+      if(deadline.tv_nsec >= 1000000000L)
+      {
+         deadline.tv_sec++;
+         deadline.tv_nsec -= 1000000000L;
+      }
+
+      while(gKeyAsyncBarrierId != id && rval == 0)
+      {
+         if(pthread_cond_timedwait(&gKeyAsyncBarrierCond, &gKeyAsyncMtx, &deadline) == ETIMEDOUT)
+         {
+            DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("keyAsync - queue not drained in time"));
+            rval = EPERS_COMMON;
+         }
+      }
+   }
+   pthread_mutex_unlock(&gKeyAsyncMtx);
+
+   return rval;
+}
+
+
+
+int key_async_get_fd(void)
+{
+   int rval = EPERS_COMMON;
+
+   if(pthread_mutex_lock(&gKeyAsyncMtx) == 0)
+   {
+      if(gKeyAsyncEventFd == -1)
+      {
+         gKeyAsyncEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+         if(gKeyAsyncEventFd == -1)
+         {
+            DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("keyAsync - Failed to create eventfd"));
+         }
+      }
+      if(gKeyAsyncEventFd != -1)
+      {
+         rval = gKeyAsyncEventFd;
+      }
+      pthread_mutex_unlock(&gKeyAsyncMtx);
+   }
+
+   return rval;
+}
+
+
+
+int key_async_get_result(int* result)
+{
+   int id = 0;
+
+   if(pthread_mutex_lock(&gKeyAsyncMtx) == 0)
+   {
+      KeyAsyncResult_s* entry = gKeyAsyncResultHead;
+
+      if(entry != NULL)
+      {
+         gKeyAsyncResultHead = entry->next;
+         if(gKeyAsyncResultHead == NULL)
+            gKeyAsyncResultTail = NULL;
+
+         id = entry->id;
+         *result = entry->result;
+         free(entry);
+      }
+      pthread_mutex_unlock(&gKeyAsyncMtx);
+   }
+
+   return id;
+}
+
+
+
+void key_async_deinit(void)
+{
+   int running = 0;
+
+   if(pthread_mutex_lock(&gKeyAsyncMtx) == 0)
+   {
+      gKeyAsyncStop = 1;
+      running = gKeyAsyncThreadRunning;
+      pthread_cond_signal(&gKeyAsyncCond);
+      pthread_mutex_unlock(&gKeyAsyncMtx);
+   }
+
+   if(running == 1)
+   {
+      pthread_join(gKeyAsyncThread, NULL);     // the worker executes all queued requests before it ends
+      gKeyAsyncThreadRunning = 0;
+   }
+
+   if(pthread_mutex_lock(&gKeyAsyncMtx) == 0)
+   {
+      while(gKeyAsyncResultHead != NULL)
+      {
+         KeyAsyncResult_s* entry = gKeyAsyncResultHead;
+
+         gKeyAsyncResultHead = entry->next;
+         free(entry);
+      }
+      gKeyAsyncResultTail = NULL;
+
+      if(gKeyAsyncEventFd != -1)
+      {
+         close(gKeyAsyncEventFd);
+         gKeyAsyncEventFd = -1;
+      }
+      pthread_mutex_unlock(&gKeyAsyncMtx);
+   }
+}
@@ -0,0 +1,125 @@
+#ifndef PERSISTENCE_CLIENT_LIBRARY_KEY_ASYNC_H
+#define PERSISTENCE_CLIENT_LIBRARY_KEY_ASYNC_H
+
+/******************************************************************************
+ * Project         Persistency
+ * (c) copyright   2012
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+******************************************************************************/
+ /**
+ * @file           persistence_client_library_key_async.h
+ * @ingroup        Persistence client library
+ * @author         Ingo Huerner
+ * @brief          Header of the asynchronous key write queue.
+ *                 Write, read and prefetch requests are executed in order by one I/O worker thread,
+ *                 so writes to the same key are never reordered.
+ * @see
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "../include/persistence_client_library_key.h"
+
+
+/**
+ * @brief allow requests to be queued, called by pclInitLibrary
+ */
+void key_async_init(void);
+
+
+/**
+ * @brief queue a write request, the data will be copied
+ *
+ * @param ldbid logical database ID
+ * @param resource_id the resource ID
+ * @param user_no the user ID
+ * @param seat_no the seat number
+ * @param buffer the data to write
+ * @param buffer_size the size of the data
+ * @param callback the completion callback or NULL
+ * @param user_data passed to the completion callback
+ *
+ * @return the request ID (greater than 0) or a negative value on error
+ */
+int key_async_write(unsigned int ldbid, const char* resource_id, unsigned int user_no, unsigned int seat_no,
+                    const unsigned char* buffer, int buffer_size, pclKeyWriteDoneCallback_t callback, void* user_data);
+
+
+/**
+ * @brief queue a read request
+ *
+ * @param ldbid logical database ID
+ * @param resource_id the resource ID
+ * @param user_no the user ID
+ * @param seat_no the seat number
+ * @param buffer the buffer to read the data, must stay valid until the request has been completed
+ * @param buffer_size the size of the buffer
+ * @param callback the completion callback or NULL
+ * @param user_data passed to the completion callback
+ *
+ * @return the request ID (greater than 0) or a negative value on error
+ */
+int key_async_read(unsigned int ldbid, const char* resource_id, unsigned int user_no, unsigned int seat_no,
+                   unsigned char* buffer, int buffer_size, pclKeyWriteDoneCallback_t callback, void* user_data);
+
+
+/**
+ * @brief queue a prefetch of the keys of a user into the value cache
+ *
+ * @param ldbid logical database ID
+ * @param user_no the user ID
+ * @param seat_no the seat number
+ *
+ * @return the request ID (greater than 0) or a negative value on error
+ */
+int key_async_prefetch_user(unsigned int ldbid, unsigned int user_no, unsigned int seat_no);
+
+
+/**
+ * @brief wait until all requests queued before have been executed.
+ *        Requests to plugins with non blocking access may still be in progress.
+ *
+ * @param timeout_ms the max time to wait in milliseconds
+ *
+ * @return 0 if the requests have been executed, a negative value on error or timeout
+ */
+int key_async_drain(int timeout_ms);
+
+
+/**
+ * @brief get the eventfd signalled for completed requests without callback
+ *
+ * @return the file descriptor or a negative value on error
+ */
+int key_async_get_fd(void);
+
+
+/**
+ * @brief get the result of a completed request without callback
+ *
+ * @param result pointer to store the result of the request
+ *
+ * @return the request ID or 0 if there is no completed request
+ */
+int key_async_get_result(int* result);
+
+
+/**
+ * @brief execute all queued requests and stop the I/O worker thread.
+ *        Must be called while the library is still initialized.
+ */
+void key_async_deinit(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PERSISTENCE_CLIENT_LIBRARY_KEY_ASYNC_H */
@@ -0,0 +1,829 @@
+/******************************************************************************
+ * Project         Persistency
+ * (c) copyright   2012
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+******************************************************************************/
+ /**
+ * @file           persistence_client_library_key_cache.c
+ * @ingroup        Persistence client library
+ * @author         Ingo Huerner
+ * @brief          Implementation of the write back cache for keys.
+ *                 The cache only holds dirty data, a flushed key is removed
+ *                 from the cache and read from the database again.
+ *                 Every change is appended to a redo log first. The log is
+ *                 truncated when the databases have been closed after a flush
+ *                 (the cached database is written on close only) and replayed
+ *                 at startup, so cached data is not lost if the process crashes.
+ * @see
+ */
+
+#include "persistence_client_library_key_cache.h"
+#include "persistence_client_library_custom_loader.h"
+#include "persistence_client_library_pas_interface.h"
+#include "rbtree.h"
+#include "crc32.h"
+#include "../include/persistence_client_library.h"
+
+#include <persComErrors.h>
+
+#include <dlt.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+DLT_IMPORT_CONTEXT(gPclDLTContext);
+
+
+/// cached (dirty) key
+typedef struct _KeyCacheEntry_s
+{
+   /// the database handle
+   int handleDB;
+   /// the size of the data
+   int size;
+   /// the flush priority, see ::PCL_FLUSH_PRIO_CRITICAL
+   int priority;
+   /// the data
+   char* data;
+   /// the database key
+   char key[PERS_DB_MAX_LENGTH_KEY_NAME];
+} KeyCacheEntry_s;
+
+
+/// magic number of a redo log record ("PWAL")
+#define KEY_CACHE_LOG_MAGIC   (0x4C415750U)
+
+
+/// redo log record types
+typedef enum _KeyCacheLogType_e
+{
+   /// key has been written
+   KeyCacheLog_Write  = 1,
+   /// key has been deleted
+   KeyCacheLog_Delete = 2
+} KeyCacheLogType_e;
+
+
+/// header of a redo log record, followed by the database path, the key and the data
+typedef struct _KeyCacheLogRecord_s
+{
+   /// magic number, see ::KEY_CACHE_LOG_MAGIC
+   uint32_t magic;
+   /// crc32 of the record, starting after this field
+   uint32_t crc;
+   /// record type, see ::KeyCacheLogType_e
+   uint16_t type;
+   /// length of the database path including the termination
+   uint16_t pathLength;
+   /// length of the key including the termination
+   uint16_t keyLength;
+   /// unused
+   uint16_t reserved;
+   /// size of the data
+   uint32_t dataSize;
+} KeyCacheLogRecord_s;
+
+
+/// tree holding the dirty keys
+static jsw_rbtree_t* gKeyCacheTree = NULL;
+/// mutex protecting the cache, also held while the cache will be flushed
+static pthread_mutex_t gKeyCacheMtx = PTHREAD_MUTEX_INITIALIZER;
+/// condition to wake up the flusher thread
+static pthread_cond_t gKeyCacheCond;
+/// flusher thread
+static pthread_t gKeyCacheThread;
+/// flag to indicate if the flusher thread is running
+static int gKeyCacheThreadRunning = 0;
+/// flag to indicate if the condition has been initialized
+static int gKeyCacheCondInit = 0;
+/// flag to stop the flusher thread
+static int gKeyCacheStop = 0;
+/// size of all cached data
+static unsigned int gKeyCacheDataSize = 0;
+/// time [ms] the oldest dirty key has been written
+static unsigned long long gKeyCacheOldestDirty = 0;
+/// file descriptor of the redo log, -1 if there is no log
+static int gKeyCacheLogFd = -1;
+/// size of the redo log
+static off_t gKeyCacheLogSize = 0;
+/// 1 if the redo log has records of a previous lifecycle which could not be replayed
+static int gKeyCacheLogPending = 0;
+
+
+static unsigned long long key_cache_now_ms(void)
+{
+   struct timespec now;
+
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return (unsigned long long)now.tv_sec * 1000ULL + (unsigned long long)now.tv_nsec / 1000000ULL;
+}
+
+
+static int key_cache_cmp(const void *p1, const void *p2)
+{
+   const KeyCacheEntry_s* first  = (const KeyCacheEntry_s*)p1;
+   const KeyCacheEntry_s* second = (const KeyCacheEntry_s*)p2;
+   int rval = (first->handleDB > second->handleDB) - (first->handleDB < second->handleDB);
+
+   if(rval == 0)
+   {
+      rval = strcmp(first->key, second->key);
+   }
+   return (rval > 0) - (rval < 0);
+}
+
+
+/* append a record to the redo log, the cache mutex must be held */
+static int key_cache_log_append(KeyCacheLogType_e type, const char* dbPath, const char* key, const char* data, int size)
+{
+   int rval = 0;
+
+   if(gKeyCacheLogFd != -1)
+   {
+      KeyCacheLogRecord_s record;
+      size_t pathLength = strlen(dbPath) + 1;
+      size_t keyLength = strlen(key) + 1;
+      size_t recordSize = sizeof(KeyCacheLogRecord_s) + pathLength + keyLength + (size_t)size;
+      char* buffer = malloc(recordSize);
+
+      rval = -1;
+      if(buffer != NULL && pathLength <= PERS_ORG_MAX_LENGTH_PATH_FILENAME)
+      {
+         memset(&record, 0, sizeof(KeyCacheLogRecord_s));
+         record.magic      = KEY_CACHE_LOG_MAGIC;
+         record.type       = (uint16_t)type;
+         record.pathLength = (uint16_t)pathLength;
+         record.keyLength  = (uint16_t)keyLength;
+         record.dataSize   = (uint32_t)size;
+
+         memcpy(buffer, &record, sizeof(KeyCacheLogRecord_s));
+         memcpy(buffer + sizeof(KeyCacheLogRecord_s), dbPath, pathLength);
+         memcpy(buffer + sizeof(KeyCacheLogRecord_s) + pathLength, key, keyLength);
+         if(size > 0)
+         {
+            memcpy(buffer + sizeof(KeyCacheLogRecord_s) + pathLength + keyLength, data, (size_t)size);
+         }
+
+         record.crc = pclCrc32(0, (unsigned char*)buffer + 2*sizeof(uint32_t), recordSize - 2*sizeof(uint32_t));
+         memcpy(buffer + sizeof(uint32_t), &record.crc, sizeof(uint32_t));
+
+         // one write call per record, so a crash leaves at most one incomplete record at the end
+         if(write(gKeyCacheLogFd, buffer, recordSize) == (ssize_t)recordSize)
+         {
+            gKeyCacheLogSize += (off_t)recordSize;
+            rval = 0;
+         }
+         else
+         {
+            DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("keyCache - Failed to append to redo log"));
+         }
+      }
+      free(buffer);
+   }
+
+   return rval;
+}
+
+
+/* apply the redo log to the databases record by record, returns -1 if a record could not be applied.
+   validSize is set to the size of the complete records, a torn or corrupt record ends the log */
+static int key_cache_log_replay(int fd, off_t* validSize)
+{
+   int rval = 0, handleDB = -1, numRecords = 0;
+   char dbPath[PERS_ORG_MAX_LENGTH_PATH_FILENAME] = {0};
+   struct stat logStat;
+   KeyCacheLogRecord_s record;
+   char* buffer = NULL;
+   size_t bufferSize = 0;
+   off_t offset = 0;
+
+   if(fstat(fd, &logStat) != 0)
+   {
+      return -1;
+   }
+
+   while(   offset + (off_t)sizeof(KeyCacheLogRecord_s) <= logStat.st_size
+         && pread(fd, &record, sizeof(KeyCacheLogRecord_s), offset) == (ssize_t)sizeof(KeyCacheLogRecord_s))
+   {
+      size_t bodySize = (size_t)record.pathLength + record.keyLength + record.dataSize;
+      const char* key = NULL;
+      uint32_t crc = 0;
+      int ret = 0;
+
+      // stop at the first incomplete or corrupt record, it was written when the process crashed
+      if(   record.magic != KEY_CACHE_LOG_MAGIC
+         || record.pathLength == 0 || record.pathLength > PERS_ORG_MAX_LENGTH_PATH_FILENAME || record.keyLength == 0
+         || (off_t)bodySize > logStat.st_size - offset - (off_t)sizeof(KeyCacheLogRecord_s))
+      {
+         break;
+      }
+
+      if(bodySize > bufferSize)
+      {
+         char* newBuffer = realloc(buffer, bodySize);
+
+         if(newBuffer == NULL)
+         {
+            rval = -1;
+            offset = logStat.st_size;     // not checked, keep all
+            break;
+         }
+         buffer = newBuffer;
+         bufferSize = bodySize;
+      }
+
+      if(pread(fd, buffer, bodySize, offset + (off_t)sizeof(KeyCacheLogRecord_s)) != (ssize_t)bodySize)
+      {
+         break;
+      }
+      key = buffer + record.pathLength;
+
+      crc = pclCrc32(0, (unsigned char*)&record + 2*sizeof(uint32_t), sizeof(KeyCacheLogRecord_s) - 2*sizeof(uint32_t));
+      if(   buffer[record.pathLength-1] != '\0' || key[record.keyLength-1] != '\0'
+         || record.crc != pclCrc32(crc, (unsigned char*)buffer, bodySize))
+      {
+         break;
+      }
+
+      if(rval == 0)     // after a failure the records are only checked, they are kept for the next replay
+      {
+         if(handleDB < 0 || strcmp(dbPath, buffer) != 0)
+         {
+            if(handleDB >= 0 && (*plugin_persComDbClose == NULL || plugin_persComDbClose(handleDB) < 0))
+            {
+               ret = -1;      // the records written to the database are not durable
+            }
+
+            strcpy(dbPath, buffer);
+            handleDB = (*plugin_persComDbOpen != NULL) ? plugin_persComDbOpen(dbPath, 0x01) : EPERS_NO_PLUGIN_FUNCT;
+         }
+
+         if(ret < 0 || handleDB < 0 || *plugin_persComDbWriteKey == NULL || *plugin_persComDbDeleteKey == NULL)
+         {
+            ret = EPERS_NO_PLUGIN_FUNCT;
+         }
+         else if(record.type == KeyCacheLog_Write)
+         {
+            ret = plugin_persComDbWriteKey(handleDB, key, key + record.keyLength, (signed int)record.dataSize);
+         }
+         else if(record.type == KeyCacheLog_Delete)
+         {
+            ret = plugin_persComDbDeleteKey(handleDB, key);
+            ret = (ret == PERS_COM_ERR_NOT_FOUND) ? 0 : ret;
+         }
+
+         if(ret < 0)
+         {
+            DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("keyCache - Failed to replay key:"), DLT_STRING(key), DLT_INT(ret));
+            rval = -1;
+         }
+         else
+         {
+            numRecords++;
+         }
+      }
+      offset += (off_t)(sizeof(KeyCacheLogRecord_s) + bodySize);
+   }
+
+   *validSize = offset;
+
+   if(handleDB >= 0 && (*plugin_persComDbClose == NULL || plugin_persComDbClose(handleDB) < 0))
+   {
+      rval = -1;
+   }
+
+   DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("keyCache - redo log records replayed:"), DLT_INT(numRecords));
+   free(buffer);
+
+   return rval;
+}
+
+
+/* remove an entry from the cache, the cache mutex must be held */
+static int key_cache_remove_locked(KeyCacheEntry_s* search)
+{
+   int rval = 0;
+
+   if(gKeyCacheTree != NULL)
+   {
+      KeyCacheEntry_s* entry = jsw_rbfind(gKeyCacheTree, search);
+
+      if(entry != NULL)
+      {
+         gKeyCacheDataSize -= (unsigned int)entry->size;
+         free(entry->data);
+         jsw_rberase(gKeyCacheTree, search);
+         rval = 1;
+      }
+   }
+   return rval;
+}
+
+
+/* write all dirty keys to the databases in the order of their flush priority, the cache mutex must be held.
+   Keys which could not be written stay dirty, returns the number of them */
+static int key_cache_flush_locked(void)
+{
+   int failed = 0;
+
+   if(gKeyCacheTree != NULL)
+   {
+      jsw_rbtrav_t* trav = jsw_rbtnew();
+
+      if(trav != NULL)
+      {
+         jsw_rbtree_t* dirtyTree = NULL;
+         KeyCacheEntry_s* entry = NULL;
+         int priority = 0;
+
+         for(priority = PCL_FLUSH_PRIO_CRITICAL; priority < PCL_FLUSH_PRIO_LAST; priority++)
+         {
+            for(entry = jsw_rbtfirst(trav, gKeyCacheTree); entry != NULL; entry = jsw_rbtnext(trav))
+            {
+               if(entry->priority != priority)
+               {
+                  continue;
+               }
+               if(   (*plugin_persComDbWriteKey == NULL)
+                  || (plugin_persComDbWriteKey(entry->handleDB, entry->key, entry->data, entry->size) < 0))
+               {
+                  DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("keyCache - Failed to write back key:"), DLT_STRING(entry->key));
+                  failed++;
+
+                  if(dirtyTree == NULL)
+                  {
+                     dirtyTree = jsw_rbnew_intrusive(key_cache_cmp, sizeof(KeyCacheEntry_s), 0);
+                  }
+                  if(dirtyTree != NULL && jsw_rbinsert(dirtyTree, entry) == 1)
+                  {
+                     continue;      // the data has been moved to the new tree, retried with the next flush
+                  }
+               }
+               gKeyCacheDataSize -= (unsigned int)entry->size;
+               free(entry->data);
+               entry->data = NULL;
+            }
+         }
+         jsw_rbtdelete(trav);
+
+         jsw_rbdelete(gKeyCacheTree);
+         gKeyCacheTree = dirtyTree;
+         if(gKeyCacheTree != NULL)
+         {
+            gKeyCacheOldestDirty = key_cache_now_ms();
+         }
+         else
+         {
+            gKeyCacheDataSize = 0;
+         }
+      }
+   }
+
+   return failed;
+}
+
+
+/* discard the cached keys, their changes are still in the redo log, the cache mutex must be held */
+static void key_cache_discard_locked(void)
+{
+   if(gKeyCacheTree != NULL)
+   {
+      jsw_rbtrav_t* trav = jsw_rbtnew();
+
+      if(trav != NULL)
+      {
+         KeyCacheEntry_s* entry = NULL;
+
+         for(entry = jsw_rbtfirst(trav, gKeyCacheTree); entry != NULL; entry = jsw_rbtnext(trav))
+         {
+            free(entry->data);
+            entry->data = NULL;
+         }
+         jsw_rbtdelete(trav);
+      }
+      jsw_rbdelete(gKeyCacheTree);
+      gKeyCacheTree = NULL;
+      gKeyCacheDataSize = 0;
+   }
+}
+
+
+/* wait for a signal or until the deadline [ms], the cache mutex must be held */
+static void key_cache_wait_until(unsigned long long deadline)
+{
+   struct timespec timeout;
+
+   timeout.tv_sec  = (time_t)(deadline / 1000ULL);
+   timeout.tv_nsec = (long)(deadline % 1000ULL) * 1000000L;
+   pthread_cond_timedwait(&gKeyCacheCond, &gKeyCacheMtx, &timeout);
+}
+
+
+static void* key_cache_flusher(void* dummy)
+{
+   (void)dummy;
+
+   pthread_mutex_lock(&gKeyCacheMtx);
+
+   while(gKeyCacheStop == 0)
+   {
+      size_t dirty = (gKeyCacheTree != NULL) ? jsw_rbsize(gKeyCacheTree) : 0;
+
+      if(dirty == 0)
+      {
+         pthread_cond_wait(&gKeyCacheCond, &gKeyCacheMtx);
+      }
+      else if(   (dirty < KeyCacheDirtyMax)
+              && (gKeyCacheDataSize < KeyCacheMaxDataSize)
+              && (key_cache_now_ms() < gKeyCacheOldestDirty + KeyCacheMaxAgeMs))
+      {
+         // sleep until the oldest dirty key is too old
+         key_cache_wait_until(gKeyCacheOldestDirty + KeyCacheMaxAgeMs);
+      }
+      else if(AccessNoLock == isAccessLocked())
+      {
+         // the shutdown or the write back own the databases, they flush the cache themselves
+         key_cache_wait_until(key_cache_now_ms() + KeyCacheMaxAgeMs);
+      }
+      else
+      {
+         int failed = 0;
+
+         // same lock order as the key API, which holds the API mutex when it calls the cache
+         pthread_mutex_unlock(&gKeyCacheMtx);
+         pthread_mutex_lock(&gKeyAPIAccessMtx);
+         pthread_mutex_lock(&gKeyCacheMtx);
+
+         if(gKeyCacheStop == 0)
+         {
+            failed = key_cache_flush_locked();
+         }
+         pthread_mutex_unlock(&gKeyAPIAccessMtx);
+
+         if(failed > 0)
+         {
+            // don't retry the keys which could not be written before the maximum age
+            key_cache_wait_until(gKeyCacheOldestDirty + KeyCacheMaxAgeMs);
+         }
+      }
+   }
+
+   pthread_mutex_unlock(&gKeyCacheMtx);
+
+   return NULL;
+}
+
+
+/* start the flusher thread, the cache mutex must be held */
+static int key_cache_start_flusher(void)
+{
+   int rval = 0;
+
+   if(gKeyCacheCondInit == 0)
+   {
+      pthread_condattr_t attr;
+
+      pthread_condattr_init(&attr);
+      pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+      pthread_cond_init(&gKeyCacheCond, &attr);
+      pthread_condattr_destroy(&attr);
+      gKeyCacheCondInit = 1;
+   }
+
+   if(gKeyCacheThreadRunning == 0)
+   {
+      gKeyCacheStop = 0;
+      if(pthread_create(&gKeyCacheThread, NULL, key_cache_flusher, NULL) == 0)
+      {
+         gKeyCacheThreadRunning = 1;
+      }
+      else
+      {
+         DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("keyCache - Failed to start flusher thread"));
+         rval = -1;
+      }
+   }
+   return rval;
+}
+
+
+int key_cache_init(const char* logFilename)
+{
+   int rval = -1;
+
+   if(logFilename != NULL && pthread_mutex_lock(&gKeyCacheMtx) == 0)
+   {
+      if(gKeyCacheLogFd == -1)
+      {
+         int fd = open(logFilename, O_RDWR | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+
+         if(fd != -1)
+         {
+            off_t validSize = 0;
+
+            gKeyCacheLogPending = (key_cache_log_replay(fd, &validSize) == 0) ? 0 : 1;
+            if(gKeyCacheLogPending == 1)
+            {
+               // keep the records for the next replay, new records are appended, so they are replayed after them.
+               // Without the cache writes would go to the database directly and be overwritten by the next replay
+               DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("keyCache - Failed to replay redo log:"), DLT_STRING(logFilename));
+            }
+            else
+            {
+               validSize = 0;
+            }
+
+            // a torn record at the end is removed, records appended after it would not be replayed
+            if(ftruncate(fd, validSize) == 0)
+            {
+               gKeyCacheLogFd = fd;
+               gKeyCacheLogSize = validSize;
+               rval = 0;
+            }
+            else
+            {
+               DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("keyCache - Failed to truncate redo log:"), DLT_STRING(logFilename));
+               close(fd);
+            }
+         }
+         else
+         {
+            DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("keyCache - Failed to open redo log:"), DLT_STRING(logFilename));
+         }
+      }
+      pthread_mutex_unlock(&gKeyCacheMtx);
+   }
+
+   return rval;
+}
+
+
+int key_cache_write(const char* dbPath, int handleDB, const char* key, const char* data, int size, int priority)
+{
+   int rval = EPERS_COMMON;
+
+   if(   key != NULL && dbPath != NULL && strlen(key) < PERS_DB_MAX_LENGTH_KEY_NAME && size >= 0
+      && pthread_mutex_lock(&gKeyCacheMtx) == 0)
+   {
+      KeyCacheEntry_s search;
+
+      search.handleDB = handleDB;
+      strcpy(search.key, key);
+
+      if(gKeyCacheLogFd != -1 && key_cache_start_flusher() == 0)
+      {
+         char* newData = malloc((size_t)size + 1);
+
+         if(gKeyCacheTree == NULL)
+         {
+            gKeyCacheTree = jsw_rbnew_intrusive(key_cache_cmp, sizeof(KeyCacheEntry_s), 0);
+         }
+
+         if(   newData != NULL && gKeyCacheTree != NULL
+            && key_cache_log_append(KeyCacheLog_Write, dbPath, key, data, size) == 0)
+         {
+            KeyCacheEntry_s* entry = jsw_rbfind(gKeyCacheTree, &search);
+
+            memcpy(newData, data, (size_t)size);
+
+            if(entry != NULL)
+            {
+               gKeyCacheDataSize -= (unsigned int)entry->size;
+               free(entry->data);
+               entry->data = newData;
+               entry->size = size;
+               if(priority < entry->priority)
+                  entry->priority = priority;
+               rval = size;
+            }
+            else
+            {
+               search.data = newData;
+               search.size = size;
+               search.priority = priority;
+
+               if(jsw_rbinsert(gKeyCacheTree, &search) == 1)
+               {
+                  if(jsw_rbsize(gKeyCacheTree) == 1)
+                  {
+                     gKeyCacheOldestDirty = key_cache_now_ms();
+                     pthread_cond_signal(&gKeyCacheCond);     // start the age timer of the flusher
+                  }
+                  rval = size;
+               }
+               else
+               {
+                  free(newData);
+               }
+            }
+
+            if(rval >= 0)
+            {
+               gKeyCacheDataSize += (unsigned int)size;
+
+               if(   (jsw_rbsize(gKeyCacheTree) >= KeyCacheDirtyMax)
+                  || (gKeyCacheDataSize >= KeyCacheMaxDataSize))
+               {
+                  pthread_cond_signal(&gKeyCacheCond);
+               }
+            }
+         }
+         else
+         {
+            free(newData);
+         }
+      }
+
+      if(rval < 0 && gKeyCacheTree != NULL && jsw_rbfind(gKeyCacheTree, &search) != NULL)
+      {
+         // the caller writes directly, an older cached value must not overwrite it later
+         (void)key_cache_flush_locked();
+         (void)key_cache_remove_locked(&search);
+      }
+      pthread_mutex_unlock(&gKeyCacheMtx);
+   }
+
+   return rval;
+}
+
+
+int key_cache_read(int handleDB, const char* key, char* buffer, int size)
+{
+   int rval = EPERS_NOKEY;
+
+   if(key != NULL && strlen(key) < PERS_DB_MAX_LENGTH_KEY_NAME && pthread_mutex_lock(&gKeyCacheMtx) == 0)
+   {
+      if(gKeyCacheTree != NULL)
+      {
+         KeyCacheEntry_s search;
+         KeyCacheEntry_s* entry = NULL;
+
+         search.handleDB = handleDB;
+         strcpy(search.key, key);
+
+         entry = jsw_rbfind(gKeyCacheTree, &search);
+         if(entry != NULL)
+         {
+            rval = (entry->size < size) ? entry->size : size;
+            memcpy(buffer, entry->data, (size_t)rval);
+         }
+      }
+      pthread_mutex_unlock(&gKeyCacheMtx);
+   }
+
+   return rval;
+}
+
+
+int key_cache_get_size(int handleDB, const char* key)
+{
+   int rval = EPERS_NOKEY;
+
+   if(key != NULL && strlen(key) < PERS_DB_MAX_LENGTH_KEY_NAME && pthread_mutex_lock(&gKeyCacheMtx) == 0)
+   {
+      if(gKeyCacheTree != NULL)
+      {
+         KeyCacheEntry_s search;
+         KeyCacheEntry_s* entry = NULL;
+
+         search.handleDB = handleDB;
+         strcpy(search.key, key);
+
+         entry = jsw_rbfind(gKeyCacheTree, &search);
+         if(entry != NULL)
+         {
+            rval = entry->size;
+         }
+      }
+      pthread_mutex_unlock(&gKeyCacheMtx);
+   }
+
+   return rval;
+}
+
+
+int key_cache_delete(const char* dbPath, int handleDB, const char* key)
+{
+   int rval = 0;
+
+   if(key != NULL && strlen(key) < PERS_DB_MAX_LENGTH_KEY_NAME && pthread_mutex_lock(&gKeyCacheMtx) == 0)
+   {
+      KeyCacheEntry_s search;
+
+      search.handleDB = handleDB;
+      strcpy(search.key, key);
+
+      rval = key_cache_remove_locked(&search);
+      if(dbPath != NULL)
+      {
+         // otherwise a logged write would be replayed after a crash, even if it has already been flushed
+         (void)key_cache_log_append(KeyCacheLog_Delete, dbPath, key, NULL, 0);
+      }
+      pthread_mutex_unlock(&gKeyCacheMtx);
+   }
+
+   return rval;
+}
+
+
+int key_cache_flush(void)
+{
+   int failed = 0;
+
+   if(pthread_mutex_lock(&gKeyCacheMtx) == 0)
+   {
+      failed = key_cache_flush_locked();
+      pthread_mutex_unlock(&gKeyCacheMtx);
+   }
+   return failed;
+}
+
+
+int key_cache_log_full(void)
+{
+   int rval = 0;
+
+   if(pthread_mutex_lock(&gKeyCacheMtx) == 0)
+   {
+      rval = (gKeyCacheLogFd != -1 && gKeyCacheLogSize >= (off_t)KeyCacheLogMaxSize) ? 1 : 0;
+      pthread_mutex_unlock(&gKeyCacheMtx);
+   }
+   return rval;
+}
+
+
+void key_cache_databases_closed(int durable)
+{
+   if(pthread_mutex_lock(&gKeyCacheMtx) == 0)
+   {
+      if(gKeyCacheTree != NULL)
+      {
+         // the handles of the keys not written back are invalid now, the redo log still has their data
+         DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("keyCache - keys not written back, keep redo log:"),
+                                               DLT_UINT((unsigned int)jsw_rbsize(gKeyCacheTree)));
+         key_cache_discard_locked();
+      }
+      else if(durable == 1 && gKeyCacheLogFd != -1)
+      {
+         off_t validSize = 0;
+
+         // the records of a previous lifecycle which could not be replayed are retried now, the databases are closed
+         if(gKeyCacheLogPending == 1 && key_cache_log_replay(gKeyCacheLogFd, &validSize) != 0)
+         {
+            DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("keyCache - Failed to replay redo log, keep it"));
+         }
+         else if(ftruncate(gKeyCacheLogFd, 0) == 0)
+         {
+            gKeyCacheLogPending = 0;
+            gKeyCacheLogSize = 0;
+         }
+         else
+         {
+            DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("keyCache - Failed to truncate redo log"));
+         }
+      }
+      pthread_mutex_unlock(&gKeyCacheMtx);
+   }
+}
+
+
+void key_cache_deinit(void)
+{
+   int running = 0;
+
+   if(pthread_mutex_lock(&gKeyCacheMtx) == 0)
+   {
+      // the databases have been closed at the shutdown, keys still cached are replayed from the log
+      key_cache_discard_locked();
+
+      if(gKeyCacheLogFd != -1)
+      {
+         close(gKeyCacheLogFd);
+         gKeyCacheLogFd = -1;
+      }
+
+      running = gKeyCacheThreadRunning;
+      if(running == 1)
+      {
+         gKeyCacheStop = 1;
+         pthread_cond_signal(&gKeyCacheCond);
+      }
+      pthread_mutex_unlock(&gKeyCacheMtx);
+   }
+
+   if(running == 1)
+   {
+      pthread_join(gKeyCacheThread, NULL);
+      gKeyCacheThreadRunning = 0;
+   }
+}
@@ -0,0 +1,137 @@
+#ifndef PERSISTENCE_CLIENT_LIBRARY_KEY_CACHE_H
+#define PERSISTENCE_CLIENT_LIBRARY_KEY_CACHE_H
+
+/******************************************************************************
+ * Project         Persistency
+ * (c) copyright   2012
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+******************************************************************************/
+ /**
+ * @file           persistence_client_library_key_cache.h
+ * @ingroup        Persistence client library
+ * @author         Ingo Huerner
+ * @brief          Header of the write back cache for keys with the policy
+ *                 PersistencePolicy_wc. Written data is kept in memory and
+ *                 written to the database by a background flusher thread
+ *                 when too many keys are dirty, the oldest change is too old
+ *                 or when a flush is requested (PAS write back, shutdown).
+ *                 A redo log makes the cached data crash safe.
+ * @see
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * @brief replay the redo log of a previous lifecycle into the databases and enable the cache.
+ *        Must be called before the databases are opened. Without a redo log keys are not cached.
+ *        Records which could not be replayed are kept in the log and retried when the databases
+ *        have been closed, see ::key_cache_databases_closed.
+ *
+ * @param logFilename the name of the redo log file
+ *
+ * @return 0 if the cache is enabled, -1 if not
+ */
+int key_cache_init(const char* logFilename);
+
+
+/**
+ * @brief write data of a key into the cache, the flusher thread will be started if needed
+ *
+ * @param dbPath the path of the database, stored in the redo log
+ * @param handleDB the database handle
+ * @param key the database key
+ * @param data the data
+ * @param size the size of the data
+ * @param priority the flush priority of the resource, see ::PCL_FLUSH_PRIO_CRITICAL
+ *
+ * @return the number of bytes written or a negative value if the data could not be cached
+ */
+int key_cache_write(const char* dbPath, int handleDB, const char* key, const char* data, int size, int priority);
+
+
+/**
+ * @brief read data of a key from the cache
+ *
+ * @param handleDB the database handle
+ * @param key the database key
+ * @param buffer the buffer for the data
+ * @param size the size of the buffer
+ *
+ * @return the number of bytes read or EPERS_NOKEY if the key is not in the cache
+ */
+int key_cache_read(int handleDB, const char* key, char* buffer, int size);
+
+
+/**
+ * @brief get the data size of a key from the cache
+ *
+ * @param handleDB the database handle
+ * @param key the database key
+ *
+ * @return the data size or EPERS_NOKEY if the key is not in the cache
+ */
+int key_cache_get_size(int handleDB, const char* key);
+
+
+/**
+ * @brief remove a key from the cache, the unwritten data will be discarded
+ *
+ * @param dbPath the path of the database, stored in the redo log
+ * @param handleDB the database handle
+ * @param key the database key
+ *
+ * @return 1 if the key was in the cache, 0 if not
+ */
+int key_cache_delete(const char* dbPath, int handleDB, const char* key);
+
+
+/**
+ * @brief write all cached data to the databases in the order of the flush priority, blocks until finished.
+ *        Keys which could not be written stay in the cache.
+ *
+ * @return the number of keys which could not be written
+ */
+int key_cache_flush(void);
+
+
+/**
+ * @brief check if the redo log has reached ::KeyCacheLogMaxSize.
+ *        The cached databases must be closed and ::key_cache_databases_closed be called then,
+ *        so the log can be truncated.
+ *
+ * @return 1 if the redo log is full, 0 if not
+ */
+int key_cache_log_full(void);
+
+
+/**
+ * @brief truncate the redo log after the databases have been closed, the flushed data is durable now.
+ *        Records of a previous lifecycle which could not be replayed at startup are replayed first.
+ *        Keys still in the cache are discarded, their database handles are invalid, and the redo log is
+ *        kept to replay them at the next startup.
+ *
+ * @param durable 1 if all databases have been flushed and closed successfully, the redo log is kept if 0
+ */
+void key_cache_databases_closed(int durable);
+
+
+/**
+ * @brief discard the cache and stop the flusher thread, keys not written back are replayed from the
+ *        redo log at the next startup
+ */
+void key_cache_deinit(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PERSISTENCE_CLIENT_LIBRARY_KEY_CACHE_H */
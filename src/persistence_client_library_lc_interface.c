@@ -20,6 +20,7 @@
 #include "persistence_client_library_lc_interface.h"
 
 #include <errno.h>
+#include <time.h>
 #include <dlt.h>
 
 DLT_IMPORT_CONTEXT(gPclDLTContext);
@@ -32,13 +33,19 @@ int check_lc_request(unsigned int request, unsigned int requestID)
    switch(request)
    {
       case NsmShutdownNormal:
+      case NsmShutdownFast:
       {
       	MainLoopData_u data;
+      	struct timespec now;
+
+      	clock_gettime(CLOCK_MONOTONIC, &now);     // the shutdown flush is bounded by the lifecycle timeout
 
       	memset(&data, 0, sizeof(MainLoopData_u));
       	data.cmd = (uint32_t)CMD_LC_PREPARE_SHUTDOWN;
       	data.params[0] = request;
       	data.params[1] = requestID;
+      	data.params[2] = (uint32_t)now.tv_sec;
+      	data.params[3] = (uint32_t)now.tv_nsec;
       	data.string[0] = '\0'; 	// no string parameter, set to 0
 
          if(-1 == deliverToMainloop_NM(&data) )
@@ -18,6 +18,7 @@
  */
 
 #include "persistence_client_library_pas_interface.h"
+#include "persistence_client_library_shared_cache.h"
 
 #include <errno.h>
 #include <dlt.h>
@@ -79,6 +80,7 @@ int check_pas_request(unsigned int request, unsigned int requestID)
       case PasMsg_Unblock:
       {
          DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("chkPasReq - case PasMsg_Unblock"));
+         shared_cache_invalidate_all();   // the shared databases may have been changed
          pers_unlock_access();
          rval = PasErrorStatus_OK;
          break;
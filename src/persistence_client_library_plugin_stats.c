@@ -0,0 +1,81 @@
+/******************************************************************************
+ * Project         Persistency
+ * (c) copyright   2012
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+******************************************************************************/
+ /**
+ * @file           persistence_client_library_plugin_stats.c
+ * @ingroup        Persistence client library
+ * @author         Ingo Huerner
+ * @brief          Implementation of the latency and error statistics of the custom plugin calls.
+ *                 The counters are updated with atomic operations, no lock is taken.
+ * @see
+ */
+
+#include "persistence_client_library_plugin_stats.h"
+#include "persistence_client_library_custom_loader.h"
+
+#include <string.h>
+#include <time.h>
+
+
+/// statistics of all plugins and operations
+static pclPluginOpStats_s gPluginStats[PersCustomLib_LastEntry][PCL_PLUGIN_OP_LAST];
+
+
+
+uint64_t plugin_stats_start(void)
+{
+   struct timespec now;
+
+   clock_gettime(CLOCK_MONOTONIC, &now);
+
+   return (uint64_t)now.tv_sec * 1000000ULL + (uint64_t)now.tv_nsec / 1000ULL;
+}
+
+
+
+void plugin_stats_add(int lib, pclPluginOp_e op, uint64_t start, int result)
+{
+   if(lib >= 0 && lib < PersCustomLib_LastEntry && op < PCL_PLUGIN_OP_LAST)
+   {
+      pclPluginOpStats_s* stats = &gPluginStats[lib][op];
+      uint64_t duration = plugin_stats_start() - start;
+      unsigned int us = (duration > 0xFFFFFFFFULL) ? 0xFFFFFFFFU : (unsigned int)duration;
+      unsigned int max = stats->max_us;
+      int bucket = 0;
+
+      while(bucket < PCL_PLUGIN_LATENCY_BUCKETS - 1 && (us >> bucket) != 0)    // bucket i: less than 2^i us
+      {
+         bucket++;
+      }
+
+      (void)__sync_add_and_fetch(&stats->calls, 1);
+      if(result < 0)
+      {
+         (void)__sync_add_and_fetch(&stats->errors, 1);
+      }
+      (void)__sync_add_and_fetch(&stats->total_us, (unsigned long long)us);
+      (void)__sync_add_and_fetch(&stats->histogram[bucket], 1);
+
+      while(us > max && __sync_bool_compare_and_swap(&stats->max_us, max, us) == 0)
+      {
+         max = stats->max_us;
+      }
+   }
+}
+
+
+
+void plugin_stats_get(int lib, pclPluginOpStats_s stats[PCL_PLUGIN_OP_LAST])
+{
+   if(lib >= 0 && lib < PersCustomLib_LastEntry)
+   {
+      memcpy(stats, gPluginStats[lib], sizeof(gPluginStats[lib]));
+   }
+}
@@ -0,0 +1,64 @@
+#ifndef PERSISTENCE_CLIENT_LIBRARY_PLUGIN_STATS_H
+#define PERSISTENCE_CLIENT_LIBRARY_PLUGIN_STATS_H
+
+/******************************************************************************
+ * Project         Persistency
+ * (c) copyright   2012
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+******************************************************************************/
+ /**
+ * @file           persistence_client_library_plugin_stats.h
+ * @ingroup        Persistence client library
+ * @author         Ingo Huerner
+ * @brief          Header of the latency and error statistics of the custom plugin calls.
+ *                 Every call is counted per plugin and operation in a log2 latency histogram.
+ * @see
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "../include/persistence_client_library.h"
+
+#include <stdint.h>
+
+
+/**
+ * @brief get the start time of a plugin call
+ *
+ * @return the time in microseconds
+ */
+uint64_t plugin_stats_start(void);
+
+
+/**
+ * @brief count a completed plugin call
+ *
+ * @param lib the plugin, see ::PersistenceCustomLibs_e
+ * @param op the operation, see ::pclPluginOp_e
+ * @param start the start time of the call, see ::plugin_stats_start
+ * @param result the result of the call, a negative value is counted as error
+ */
+void plugin_stats_add(int lib, pclPluginOp_e op, uint64_t start, int result);
+
+
+/**
+ * @brief get the statistics of a plugin
+ *
+ * @param lib the plugin, see ::PersistenceCustomLibs_e
+ * @param stats pointer to store the statistics of the operations
+ */
+void plugin_stats_get(int lib, pclPluginOpStats_s stats[PCL_PLUGIN_OP_LAST]);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PERSISTENCE_CLIENT_LIBRARY_PLUGIN_STATS_H */
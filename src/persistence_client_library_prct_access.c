@@ -19,15 +19,29 @@
 
 #include "persistence_client_library_prct_access.h"
 #include "persistence_client_library_custom_loader.h"
+#include "persistence_client_library_rct_index.h"
 #include <dlt.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 DLT_IMPORT_CONTEXT(gPclDLTContext);
 
 
 /// pointer to resource table database
 static int gResource_table[PrctDbTableSize] = {[0 ... PrctDbTableSize-1] = -1};
-/// array to hold the information of database is already open
+/// state of the resource table: 0 not open, 1 open, 2 closing (a close still running must not be reused)
 static int gResourceOpen[PrctDbTableSize] = { [0 ... PrctDbTableSize-1] = 0 };
+/// in memory index of the resource table, loaded once when the table will be opened
+static PersRctIndex_s* gResourceIndex[PrctDbTableSize] = { [0 ... PrctDbTableSize-1] = NULL };
+/// size of the mapped precompiled index image, 0 if the index has been allocated
+static size_t gResourceIndexMapSize[PrctDbTableSize] = { [0 ... PrctDbTableSize-1] = 0 };
+/// flag to indicate if the index is owned by the warm start snapshot
+static int gResourceIndexShared[PrctDbTableSize] = { [0 ... PrctDbTableSize-1] = 0 };
+/// plugin IDs of the index entries, resolved when the index is loaded, the index itself stays read only
+static int32_t* gResourcePluginIds[PrctDbTableSize] = { [0 ... PrctDbTableSize-1] = NULL };
 
 
 /// persistence resource config table type definition
@@ -45,6 +59,13 @@ typedef enum _PersistenceRCT_e
 } PersistenceRCT_e;
 
 
+/* plugin ID of a custom storage resource, resolved once when the index is loaded */
+static int rct_plugin_id(const char* custom_name)
+{
+   return (int)custom_client_name_to_id(custom_name, 1);
+}
+
+
 PersistenceRCT_e get_table_id(unsigned int ldbid, int* groupId)
 {
    PersistenceRCT_e rctType = PersistenceRCT_LastEntry;
@@ -93,10 +114,277 @@ void invalidate_resource_cfg_table(int i)
    {
       gResource_table[i] = -1;
       gResourceOpen[i] = 0;
+      free(gResourcePluginIds[i]);
+      gResourcePluginIds[i] = NULL;
+
+      if(gResourceIndexShared[i] != 0)
+      {
+         gResourceIndexShared[i] = 0;     // released by the owner
+      }
+      else if(gResourceIndexMapSize[i] != 0)
+      {
+         munmap(gResourceIndex[i], gResourceIndexMapSize[i]);
+         gResourceIndexMapSize[i] = 0;
+      }
+      else
+      {
+         free(gResourceIndex[i]);
+      }
+      gResourceIndex[i] = NULL;
+   }
+}
+
+
+
+void close_resource_cfg_table_begin(int i)
+{
+   if(i >= 0 && i < PrctDbTableSize && gResourceOpen[i] == 1)
+   {
+      gResourceOpen[i] = 2;
+   }
+}
+
+
+
+int set_resource_cfg_index(int i, const PersRctIndex_s* index)
+{
+   int rval = -1;
+
+   if(i >= 0 && i < PrctDbTableSize && gResourceOpen[i] == 0)
+   {
+      gResourceIndex[i] = (PersRctIndex_s*)index;
+      gResourcePluginIds[i] = rct_index_resolve_plugins(index, rct_plugin_id);
+      gResourceIndexShared[i] = 1;
+      gResourceOpen[i] = 1;      // no need to open the resource configuration table itself
+      rval = 0;
+   }
+   return rval;
+}
+
+
+
+void unset_resource_cfg_index(int i, const PersRctIndex_s* index)
+{
+   if(i >= 0 && i < PrctDbTableSize && gResourceIndexShared[i] != 0 && gResourceIndex[i] == index)
+   {
+      invalidate_resource_cfg_table(i);
    }
 }
 
 
+/**
+ * @brief load all entries of a resource configuration table into an in memory index
+ *
+ * @param handleRCT the handle of the opened resource configuration table
+ *
+ * @return the index or NULL if the backend does not support listing the resources
+ */
+static PersRctIndex_s* load_resource_cfg_index(int handleRCT)
+{
+   PersRctIndex_s* index = NULL;
+   int listSize = 0;
+
+   if(   (*plugin_persComRctGetSizeResourcesList == NULL)
+      || (*plugin_persComRctGetResourcesList == NULL)
+      || (*plugin_persComRctRead == NULL))
+   {
+      return NULL;
+   }
+
+   listSize = plugin_persComRctGetSizeResourcesList(handleRCT);
+   if(listSize >= 0)
+   {
+      char* list = malloc((size_t)listSize + 1);
+      const char** names = NULL;
+      PersistenceConfigurationKey_s* configs = NULL;
+      uint32_t count = 0, numNames = 0;
+      int i = 0;
+
+      if(list != NULL)
+      {
+         if(listSize > 0)
+         {
+            listSize = plugin_persComRctGetResourcesList(handleRCT, list, listSize);
+         }
+         if(listSize >= 0)
+         {
+            list[listSize] = '\0';
+
+            for(i = 0; i < listSize; i++)        // resource IDs are separated by '\0'
+            {
+               if(list[i] == '\0' && (i == 0 || list[i-1] != '\0'))
+                  numNames++;
+            }
+            if(listSize > 0 && list[listSize-1] != '\0')
+               numNames++;
+
+            names   = malloc((numNames + 1) * sizeof(char*));
+            configs = malloc((numNames + 1) * sizeof(PersistenceConfigurationKey_s));
+         }
+      }
+
+      if(names != NULL && configs != NULL)
+      {
+         int rval = 0;
+
+         for(i = 0; i < listSize && rval == 0; i += (int)strlen(&list[i]) + 1)
+         {
+            if(list[i] != '\0')
+            {
+               rval = plugin_persComRctRead(handleRCT, &list[i], &configs[count]);
+               if(rval == sizeof(PersistenceConfigurationKey_s))
+               {
+                  names[count++] = &list[i];
+                  rval = 0;
+               }
+            }
+         }
+
+         if(rval == 0)
+         {
+            index = rct_index_create(count, names, configs);
+         }
+         else
+         {
+            DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("gRCT - failed to read entry for index:"), DLT_INT(rval));
+         }
+      }
+
+      free(configs);
+      free(names);
+      free(list);
+   }
+
+   return index;
+}
+
+
+/**
+ * @brief map a precompiled index image (see tools/persistence_rct_compiler) of a resource configuration table
+ *
+ * @param arrayIdx the resource configuration table index
+ * @param rctFilename the name of the resource configuration table
+ *
+ * @return 0 if the image has been mapped, -1 if there is no valid and up to date image
+ */
+static int map_resource_cfg_index(unsigned int arrayIdx, const char* rctFilename)
+{
+   int rval = -1, fd = -1;
+   char filename[PERS_ORG_MAX_LENGTH_PATH_FILENAME] = {0};
+   struct stat imageStat, rctStat;
+
+   snprintf(filename, PERS_ORG_MAX_LENGTH_PATH_FILENAME, "%s%s", rctFilename, PERS_RCT_INDEX_SUFFIX);
+
+   fd = open(filename, O_RDONLY | O_CLOEXEC);
+   if(fd != -1)
+   {
+      if(fstat(fd, &imageStat) == 0 && imageStat.st_size >= (off_t)sizeof(PersRctIndex_s))
+      {
+         // an image older than its resource configuration table is outdated, compared with nanoseconds
+         // as the table may be changed in the same second the image has been written
+         if(   stat(rctFilename, &rctStat) == 0
+            && (   (rctStat.st_mtim.tv_sec > imageStat.st_mtim.tv_sec)
+                || (   rctStat.st_mtim.tv_sec == imageStat.st_mtim.tv_sec
+                    && rctStat.st_mtim.tv_nsec > imageStat.st_mtim.tv_nsec)))
+         {
+            DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("gRCT - index image outdated:"), DLT_STRING(filename));
+         }
+         else
+         {
+            // read only, the page cache pages are shared with the other processes mapping the image
+            void* image = mmap(NULL, (size_t)imageStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if(image != MAP_FAILED)
+            {
+               if(rct_index_verify((PersRctIndex_s*)image, (size_t)imageStat.st_size) == 1)
+               {
+                  gResourcePluginIds[arrayIdx] = rct_index_resolve_plugins((PersRctIndex_s*)image, rct_plugin_id);
+                  gResourceIndex[arrayIdx] = (PersRctIndex_s*)image;
+                  gResourceIndexMapSize[arrayIdx] = (size_t)imageStat.st_size;
+                  rval = 0;
+               }
+               else
+               {
+                  DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("gRCT - invalid index image:"), DLT_STRING(filename));
+                  munmap(image, (size_t)imageStat.st_size);
+               }
+            }
+         }
+      }
+      close(fd);
+   }
+
+   return rval;
+}
+
+
+/**
+ * @brief create the file name of a resource configuration table
+ *
+ * @param rct the resource configuration table type
+ * @param group the group id
+ * @param filename the buffer of size PERS_ORG_MAX_LENGTH_PATH_FILENAME to store the name
+ */
+static void get_resource_cfg_table_name(PersistenceRCT_e rct, int group, char* filename)
+{
+   switch(rct)    // create db name
+   {
+   case PersistenceRCT_local:
+      snprintf(filename, PERS_ORG_MAX_LENGTH_PATH_FILENAME, getLocalWtPathKey(), gAppId, plugin_gResTableCfg);
+      break;
+   case PersistenceRCT_shared_public:
+      snprintf(filename, PERS_ORG_MAX_LENGTH_PATH_FILENAME, getSharedPublicWtPathKey(), gAppId, plugin_gResTableCfg);
+      break;
+   case PersistenceRCT_shared_group:
+      snprintf(filename, PERS_ORG_MAX_LENGTH_PATH_FILENAME, getSharedWtPathKey(), gAppId, group, plugin_gResTableCfg);
+      break;
+   default:
+      DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("gRCT - no valid PersistenceRCT_e"));
+      break;
+   }
+}
+
+
+void init_resource_cfg_index(void)
+{
+   unsigned int arrayIdx = PersistenceRCT_local;
+
+   if(gResourceOpen[arrayIdx] == 0 && plugin_gResTableCfg != NULL)
+   {
+      char filename[PERS_ORG_MAX_LENGTH_PATH_FILENAME] = { [0 ... PERS_ORG_MAX_LENGTH_PATH_FILENAME-1] = 0};
+
+      get_resource_cfg_table_name(PersistenceRCT_local, 0, filename);
+
+      if(map_resource_cfg_index(arrayIdx, filename) == 0)
+      {
+         gResourceOpen[arrayIdx] = 1;     // no need to open the resource configuration table itself
+      }
+   }
+}
+
+
+const PersRctIndex_s* get_resource_cfg_index(int i, char* filename)
+{
+   const PersRctIndex_s* index = NULL;
+
+   if(i >= 0 && i < PrctDbTableSize && gResourceIndexMapSize[i] == 0 && gResourceIndex[i] != NULL)
+   {
+      // the array index is the table type plus the group
+      if(i < PersistenceRCT_shared_group)
+      {
+         get_resource_cfg_table_name((PersistenceRCT_e)i, 0, filename);
+      }
+      else
+      {
+         get_resource_cfg_table_name(PersistenceRCT_shared_group, i - PersistenceRCT_shared_group, filename);
+      }
+      index = gResourceIndex[i];
+   }
+   return index;
+}
+
+
+
 int get_resource_cfg_table(PersistenceRCT_e rct, int group)
 {
    unsigned int arrayIdx = 0;
@@ -107,27 +395,24 @@ int get_resource_cfg_table(PersistenceRCT_e rct, int group)
 
    if(arrayIdx < PrctDbTableSize)
    {
+      if(gResourceOpen[arrayIdx] == 2)
+      {
+         // the close started at shutdown has not finished, the handle may be invalid at any time
+         DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("gRCT - RCT still closing"), DLT_UINT(arrayIdx));
+         return EPERS_NOPRCTABLE;
+      }
+
       if(gResourceOpen[arrayIdx] == 0)   // check if database is already open
       {
          char filename[PERS_ORG_MAX_LENGTH_PATH_FILENAME] = { [0 ... PERS_ORG_MAX_LENGTH_PATH_FILENAME-1] = 0};
 
-         switch(rct)    // create db name
+         get_resource_cfg_table_name(rct, group, filename);
+
+         if(map_resource_cfg_index(arrayIdx, filename) == 0)
          {
-         case PersistenceRCT_local:
-            snprintf(filename, PERS_ORG_MAX_LENGTH_PATH_FILENAME, getLocalWtPathKey(), gAppId, plugin_gResTableCfg);
-            break;
-         case PersistenceRCT_shared_public:
-            snprintf(filename, PERS_ORG_MAX_LENGTH_PATH_FILENAME, getSharedPublicWtPathKey(), gAppId, plugin_gResTableCfg);
-            break;
-         case PersistenceRCT_shared_group:
-            snprintf(filename, PERS_ORG_MAX_LENGTH_PATH_FILENAME, getSharedWtPathKey(), gAppId, group, plugin_gResTableCfg);
-            break;
-         default:
-            DLT_LOG(gPclDLTContext, DLT_LOG_ERROR, DLT_STRING("gRCT - no valid PersistenceRCT_e"));
-            break;
+            gResourceOpen[arrayIdx] = 1;  // precompiled index available, no need to open the resource configuration table
          }
-
-         if(*plugin_persComRctOpen != NULL)
+         else if(*plugin_persComRctOpen != NULL)
          {
             gResource_table[arrayIdx] = plugin_persComRctOpen(filename, 0x04);   // 0x04 ==> open in read only mode
 
@@ -139,6 +424,17 @@ int get_resource_cfg_table(PersistenceRCT_e rct, int group)
             else
             {
                 gResourceOpen[arrayIdx] = 1 ;
+
+                // the whole table is read once, later resolution does not touch the backend anymore
+                gResourceIndex[arrayIdx] = load_resource_cfg_index(gResource_table[arrayIdx]);
+                if(gResourceIndex[arrayIdx] == NULL)
+                {
+                   DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("gRCT - no index, read entries from RCT"));
+                }
+                else
+                {
+                   gResourcePluginIds[arrayIdx] = rct_index_resolve_plugins(gResourceIndex[arrayIdx], rct_plugin_id);
+                }
             }
          }
          else
@@ -148,7 +444,14 @@ int get_resource_cfg_table(PersistenceRCT_e rct, int group)
          }
       }
 
-      rval = gResource_table[arrayIdx];
+      if(gResourceIndexMapSize[arrayIdx] != 0 || gResourceIndexShared[arrayIdx] != 0)
+      {
+         rval = 0;      // resources are resolved from the mapped index only, there is no RCT handle
+      }
+      else
+      {
+         rval = gResource_table[arrayIdx];
+      }
    }
 
    return rval;
@@ -156,45 +459,110 @@ int get_resource_cfg_table(PersistenceRCT_e rct, int group)
 
 
 
+int open_resource_cfg_table(unsigned int ldbid)
+{
+   int groupId = 0;
+   PersistenceRCT_e rct = get_table_id(ldbid, &groupId);
+
+   return get_resource_cfg_table(rct, groupId);
+}
+
+
+
+/* set the plugin and the plugin key of a custom storage resource, the key is prefixed with the
+   logical database ID as "0x%08X" (see ::custom_client_resolve) */
+static void set_custom_key(PersistenceInfo_s* info, int customLibId, const char* key)
+{
+   static const char hex[] = "0123456789ABCDEF";
+   size_t len = strlen(key);
+   int i = 0;
+
+   info->customLibId = customLibId;
+   info->customKey[0] = '0';
+   info->customKey[1] = 'x';
+   for(i = 0; i < 8; i++)
+   {
+      info->customKey[2 + i] = hex[(info->context.ldbid >> (28 - 4 * i)) & 0x0F];
+   }
+   if(len > CUSTOM_KEY_SIZE - 11)
+   {
+      len = CUSTOM_KEY_SIZE - 11;      // truncated like snprintf
+   }
+   memcpy(&info->customKey[10], key, len);
+   info->customKey[10 + len] = '\0';
+}
+
+
+
 int get_db_context(PersistenceInfo_s* dbContext, const char* resource_id, unsigned int isFile, char dbKey[], char dbPath[])
 {
    int rval = 0, resourceFound = 0, groupId = 0, handleRCT = 0;
    PersistenceRCT_e rct = PersistenceRCT_LastEntry;
 
+   dbContext->customLibId  = PersCustomLib_LastEntry;
+   dbContext->customKey[0] = '\0';
+
    rct = get_table_id(dbContext->context.ldbid, &groupId);
 
    handleRCT = get_resource_cfg_table(rct, groupId);    // get resource configuration table
 
    if(handleRCT >= 0)
    {
-      if(*plugin_persComRctRead != NULL)
-      {
-         PersistenceConfigurationKey_s sRctEntry ;
+      const PersRctIndex_s* index = gResourceIndex[(unsigned int)rct + (unsigned int)groupId];
+      const int32_t* pluginIds = gResourcePluginIds[(unsigned int)rct + (unsigned int)groupId];
+      const PersRctIndexEntry_s* indexEntry = NULL;
+      const PersistenceConfigurationKey_s* rctEntry = NULL;
+      PersistenceConfigurationKey_s sRctEntry ;
 
+      if(index != NULL)
+      {
+         // resolve from the in memory index, no backend access
+         indexEntry = rct_index_find_entry(index, resource_id);
+         rctEntry = (indexEntry != NULL) ? &indexEntry->config : NULL;
+      }
+      else if(*plugin_persComRctRead != NULL)
+      {
          // check if resouce id is in write through table
          int iErrCode = plugin_persComRctRead(handleRCT, resource_id, &sRctEntry) ;
 
          if(sizeof(PersistenceConfigurationKey_s) == iErrCode)
          {
-            memcpy(&dbContext->configKey, &sRctEntry, sizeof(dbContext->configKey)) ;
-            if(sRctEntry.storage != PersistenceStorage_custom )
+            rctEntry = &sRctEntry;
+         }
+      }
+
+      if(rctEntry != NULL)
+      {
+         memcpy(&dbContext->configKey, rctEntry, sizeof(dbContext->configKey)) ;
+         if(rctEntry->storage != PersistenceStorage_custom )
+         {
+            rval = get_db_path_and_key(dbContext, resource_id, dbKey, dbPath);
+         }
+         else
+         {
+            // if customer storage, we use the custom name as dbPath
+            strncpy(dbPath, dbContext->configKey.custom_name, strlen(dbContext->configKey.custom_name));
+
+            strncpy(dbKey, resource_id, strlen(resource_id));     // and resource_id as dbKey
+
+            int customLibId = (indexEntry != NULL && pluginIds != NULL) ? pluginIds[rct_index_entry_slot(index, indexEntry)] : -1;
+
+            if(customLibId >= 0 && rct_index_custom_key(index, indexEntry) != NULL)
             {
-               rval = get_db_path_and_key(dbContext, resource_id, dbKey, dbPath);
+               // plugin and plugin key have been resolved when the index has been loaded
+               set_custom_key(dbContext, customLibId, rct_index_custom_key(index, indexEntry));
             }
             else
             {
-               // if customer storage, we use the custom name as dbPath
-               strncpy(dbPath, dbContext->configKey.custom_name, strlen(dbContext->configKey.custom_name));
-
-               strncpy(dbKey, resource_id, strlen(resource_id));     // and resource_id as dbKey
+               custom_client_resolve(dbContext, resource_id);     // plugin and plugin key are needed for every access
             }
-            resourceFound = 1;
-         }
-         else
-         {
-            DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("gDBCtx - RCT: no value for key:"), DLT_STRING(resource_id) );
-            rval = EPERS_NOKEYDATA;
          }
+         resourceFound = 1;
+      }
+      else if(index != NULL || *plugin_persComRctRead != NULL)
+      {
+         DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("gDBCtx - RCT: no value for key:"), DLT_STRING(resource_id) );
+         rval = EPERS_NOKEYDATA;
       }
       else
       {
@@ -21,6 +21,7 @@
  */
 
 #include "persistence_client_library_data_organization.h"
+#include "persistence_client_library_rct_index.h"
 
 /**
  * @brief Create database search key and database location path
@@ -60,6 +61,32 @@ int get_db_context(PersistenceInfo_s* dbContext, const char* resource_id, unsign
 int get_resource_cfg_table_by_idx(int i);
 
 
+/**
+ * @brief open the resource configuration table of a logical database, if not already open
+ *
+ * @param ldbid the logical database id
+ *
+ * @return the handle of the table (0 if only a precompiled index image is used) or a negative value
+ */
+int open_resource_cfg_table(unsigned int ldbid);
+
+
+/**
+ * @brief map the precompiled index image of the local resource configuration table, if available.
+ *        The image will be created with the tool persistence_rct_compiler.
+ */
+void init_resource_cfg_index(void);
+
+
+/**
+ * @brief mark the resource configuration table as closing, it will not be used anymore
+ *        until ::invalidate_resource_cfg_table has been called after the close has finished
+ *
+ * @param i the index
+ */
+void close_resource_cfg_table_begin(int i);
+
+
 /**
  * @brief mark the resource configuration table as closed
  *
@@ -68,5 +95,37 @@ int get_resource_cfg_table_by_idx(int i);
 void invalidate_resource_cfg_table(int i);
 
 
+/**
+ * @brief use an index image owned by the caller (e.g. the warm start snapshot) for a resource
+ *        configuration table, the table itself will not be opened
+ *
+ * @param i the index
+ * @param index the index image, must stay valid until ::unset_resource_cfg_index has been called
+ *
+ * @return 0 if the image will be used, -1 if the table is already open
+ */
+int set_resource_cfg_index(int i, const PersRctIndex_s* index);
+
+
+/**
+ * @brief stop using an index image set with ::set_resource_cfg_index, the table will be opened again on next access
+ *
+ * @param i the index
+ * @param index the index image
+ */
+void unset_resource_cfg_index(int i, const PersRctIndex_s* index);
+
+
+/**
+ * @brief get the index image built from a resource configuration table
+ *
+ * @param i the index
+ * @param filename the buffer of size PERS_ORG_MAX_LENGTH_PATH_FILENAME to store the name of the table
+ *
+ * @return the index image or NULL if there is none or the index is a mapped precompiled image
+ */
+const PersRctIndex_s* get_resource_cfg_index(int i, char* filename);
+
+
 
 #endif /* PERSISTENCE_CLIENT_LIBRARY_ACCESS_HELPER_H */
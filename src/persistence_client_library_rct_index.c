@@ -0,0 +1,405 @@
+/******************************************************************************
+ * Project         Persistency
+ * (c) copyright   2012
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+******************************************************************************/
+ /**
+ * @file           persistence_client_library_rct_index.c
+ * @ingroup        Persistence client library
+ * @author         Ingo Huerner
+ * @brief          Implementation of the resource configuration table index.
+ *                 The minimal perfect hash uses the "hash and displace" scheme:
+ *                 every key is put into a bucket by a first hash, and for each
+ *                 bucket a displacement is searched that maps all its keys to
+ *                 free slots. Buckets with a single key point directly to a slot.
+ * @see
+ */
+
+#include "persistence_client_library_rct_index.h"
+
+#include <stdlib.h>
+
+
+/// max displacement value tried for one bucket before giving up
+#define RCT_INDEX_MAX_SEED   (0x00FFFFFF)
+
+/// align image parts to 8 bytes
+#define RCT_INDEX_ALIGN(s)   (((s) + 7U) & ~7U)
+
+
+/// bucket of the perfect hash creation
+typedef struct _RctBucket_s
+{
+   uint32_t bucket;
+   uint32_t size;
+} RctBucket_s;
+
+
+static uint32_t rct_index_hash(uint32_t seed, const char* key)
+{
+   uint32_t h = 2166136261U ^ (seed * 0x9E3779B9U);   // FNV-1a with seeded offset basis
+
+   while(*key != '\0')
+   {
+      h ^= (uint8_t)*key++;
+      h *= 16777619U;
+   }
+
+   // final avalanche, so different seeds give independent slots
+   h ^= h >> 16;
+   h *= 0x85EBCA6BU;
+   h ^= h >> 13;
+   h *= 0xC2B2AE35U;
+   h ^= h >> 16;
+
+   return h;
+}
+
+
+/* the plugin key of a custom storage resource without the logical database ID, see ::custom_client_resolve */
+static size_t rct_custom_key(const char* name, const PersistenceConfigurationKey_s* config, char* key)
+{
+   const char* customID = config->customID;
+   size_t customIDLen = strnlen(customID, PERS_RCT_MAX_LENGTH_CUSTOM_ID);
+   size_t customNameLen = strnlen(config->custom_name, PERS_RCT_MAX_LENGTH_CUSTOM_NAME);
+   size_t len = 0;
+
+   if(config->storage != PersistenceStorage_custom)
+   {
+      return 0;
+   }
+
+   if(customID[0] == '\0')      // no custom ID, the resource ID is used
+   {
+      len = 1 + customNameLen + 1 + strlen(name);
+      if(key != NULL)
+      {
+         key[0] = '/';
+         memcpy(key + 1, config->custom_name, customNameLen);
+         key[1 + customNameLen] = '/';
+         strcpy(key + 2 + customNameLen, name);
+      }
+   }
+   else
+   {
+      len = 1 + customIDLen;
+      if(key != NULL)
+      {
+         key[0] = '/';
+         memcpy(key + 1, customID, customIDLen);
+         key[len] = '\0';
+      }
+   }
+   return len + 1;
+}
+
+
+static int rct_bucket_cmp(const void* p1, const void* p2)
+{
+   const RctBucket_s* first  = (const RctBucket_s*)p1;
+   const RctBucket_s* second = (const RctBucket_s*)p2;
+
+   // biggest buckets first
+   return (first->size < second->size) - (first->size > second->size);
+}
+
+
+PersRctIndex_s* rct_index_create(uint32_t count, const char** names, const PersistenceConfigurationKey_s* configs)
+{
+   PersRctIndex_s* index = NULL;
+   RctBucket_s* buckets  = NULL;
+   uint32_t* bucketStart = NULL;
+   uint32_t* bucketKeys  = NULL;
+   uint32_t* slotOfKey   = NULL;
+   uint32_t* trySlots    = NULL;
+   int32_t* seeds        = NULL;
+   uint8_t* slotUsed     = NULL;
+   size_t stringSize = 0;
+   uint32_t i = 0;
+   int rval = 0;
+
+   if(count == 0 || names == NULL || configs == NULL)
+   {
+      count = 0;  // create an empty index
+   }
+
+   for(i = 0; i < count; i++)
+   {
+      stringSize += strlen(names[i]) + 1 + rct_custom_key(names[i], &configs[i], NULL);
+   }
+
+   buckets     = calloc(count + 1, sizeof(RctBucket_s));
+   bucketStart = calloc(count + 2, sizeof(uint32_t));
+   bucketKeys  = calloc(count + 1, sizeof(uint32_t));
+   slotOfKey   = calloc(count + 1, sizeof(uint32_t));
+   trySlots    = calloc(count + 1, sizeof(uint32_t));
+   seeds       = calloc(count + 1, sizeof(int32_t));
+   slotUsed    = calloc(count + 1, sizeof(uint8_t));
+
+   if(   buckets == NULL || bucketStart == NULL || bucketKeys == NULL
+      || slotOfKey == NULL || trySlots == NULL || seeds == NULL || slotUsed == NULL)
+   {
+      rval = -1;
+   }
+
+   if(rval == 0 && count > 0)
+   {
+      uint32_t b = 0, freeSlot = 0;
+
+      // distribute the keys to the buckets (compressed bucket lists)
+      for(i = 0; i < count; i++)
+      {
+         bucketStart[rct_index_hash(0, names[i]) % count + 1]++;
+      }
+      for(b = 0; b < count; b++)
+      {
+         buckets[b].bucket = b;
+         buckets[b].size   = bucketStart[b+1];
+         bucketStart[b+1] += bucketStart[b];
+      }
+      for(i = 0; i < count; i++)
+      {
+         b = rct_index_hash(0, names[i]) % count;
+         bucketKeys[bucketStart[b] + trySlots[b]++] = i;
+      }
+
+      qsort(buckets, count, sizeof(RctBucket_s), rct_bucket_cmp);
+
+      for(b = 0; b < count && rval == 0 && buckets[b].size > 1; b++)
+      {
+         const uint32_t* keys = &bucketKeys[bucketStart[buckets[b].bucket]];
+         uint32_t seed = 1, k = 0;
+
+         for(seed = 1; seed <= RCT_INDEX_MAX_SEED; seed++)
+         {
+            for(k = 0; k < buckets[b].size; k++)
+            {
+               uint32_t n = 0;
+               trySlots[k] = rct_index_hash(seed, names[keys[k]]) % count;
+
+               if(slotUsed[trySlots[k]] != 0)
+                  break;
+
+               for(n = 0; n < k; n++)
+               {
+                  if(trySlots[n] == trySlots[k])
+                     break;
+               }
+               if(n < k)
+                  break;
+            }
+
+            if(k == buckets[b].size)
+               break;
+         }
+
+         if(seed <= RCT_INDEX_MAX_SEED)
+         {
+            for(k = 0; k < buckets[b].size; k++)
+            {
+               slotUsed[trySlots[k]] = 1;
+               slotOfKey[keys[k]] = trySlots[k];
+            }
+            seeds[buckets[b].bucket] = (int32_t)seed;
+         }
+         else
+         {
+            rval = -1;     // duplicate resource IDs
+         }
+      }
+
+      // buckets with one key are directly assigned to the remaining free slots
+      for( ; b < count && rval == 0 && buckets[b].size == 1; b++)
+      {
+         while(slotUsed[freeSlot] != 0)
+            freeSlot++;
+
+         slotUsed[freeSlot] = 1;
+         slotOfKey[bucketKeys[bucketStart[buckets[b].bucket]]] = freeSlot;
+         seeds[buckets[b].bucket] = -(int32_t)freeSlot - 1;
+      }
+   }
+
+   if(rval == 0)
+   {
+      size_t seedOffset   = RCT_INDEX_ALIGN(sizeof(PersRctIndex_s));
+      size_t entryOffset  = RCT_INDEX_ALIGN(seedOffset + count * sizeof(int32_t));
+      size_t stringOffset = entryOffset + count * sizeof(PersRctIndexEntry_s);
+      size_t imageSize    = RCT_INDEX_ALIGN(stringOffset + stringSize);
+
+      if(imageSize <= UINT32_MAX)
+      {
+         index = calloc(1, imageSize);
+      }
+
+      if(index != NULL)
+      {
+         PersRctIndexEntry_s* entries = (PersRctIndexEntry_s*)((char*)index + entryOffset);
+         char* strings = (char*)index + stringOffset;
+         uint32_t stringPos = 0;
+
+         index->magic        = PERS_RCT_INDEX_MAGIC;
+         index->version      = PERS_RCT_INDEX_VERSION;
+         index->entrySize    = (uint32_t)sizeof(PersRctIndexEntry_s);
+         index->count        = count;
+         index->imageSize    = (uint32_t)imageSize;
+         index->seedOffset   = (uint32_t)seedOffset;
+         index->entryOffset  = (uint32_t)entryOffset;
+         index->stringOffset = (uint32_t)stringOffset;
+
+         memcpy((char*)index + seedOffset, seeds, count * sizeof(int32_t));
+
+         for(i = 0; i < count; i++)
+         {
+            PersRctIndexEntry_s* entry = &entries[slotOfKey[i]];
+            size_t len = strlen(names[i]);
+
+            entry->nameOffset = stringPos;
+            entry->nameLength = (uint32_t)len;
+            memcpy(&entry->config, &configs[i], sizeof(PersistenceConfigurationKey_s));
+            memcpy(strings + stringPos, names[i], len + 1);
+            stringPos += (uint32_t)len + 1;
+
+            entry->customKeyOffset = UINT32_MAX;
+            len = rct_custom_key(names[i], &configs[i], strings + stringPos);
+            if(len > 0)
+            {
+               entry->customKeyOffset = stringPos;
+               stringPos += (uint32_t)len;
+            }
+         }
+      }
+   }
+
+   free(buckets);
+   free(bucketStart);
+   free(bucketKeys);
+   free(slotOfKey);
+   free(trySlots);
+   free(seeds);
+   free(slotUsed);
+
+   return index;
+}
+
+
+int rct_index_verify(const PersRctIndex_s* index, size_t size)
+{
+   int rval = 0;
+
+   if(   (index != NULL)
+      && (size >= sizeof(PersRctIndex_s))
+      && (index->magic     == PERS_RCT_INDEX_MAGIC)
+      && (index->version   == PERS_RCT_INDEX_VERSION)
+      && (index->entrySize == sizeof(PersRctIndexEntry_s))
+      && (index->imageSize == size))
+   {
+      size_t seedEnd  = (size_t)index->seedOffset  + (size_t)index->count * sizeof(int32_t);
+      size_t entryEnd = (size_t)index->entryOffset + (size_t)index->count * sizeof(PersRctIndexEntry_s);
+
+      if(   (index->seedOffset >= sizeof(PersRctIndex_s)) && (seedEnd <= index->entryOffset)
+         && (entryEnd <= index->stringOffset) && (index->stringOffset <= size)
+         && (index->seedOffset % sizeof(int32_t) == 0) && (index->entryOffset % sizeof(uint32_t) == 0))
+      {
+         const int32_t* seeds = (const int32_t*)((const char*)index + index->seedOffset);
+         uint32_t i = 0;
+
+         // the string pool must be terminated, so a lookup can never read beyond the image
+         if(index->count == 0 || (index->stringOffset < size && ((const char*)index)[size-1] == '\0'))
+         {
+            rval = 1;
+         }
+
+         // a negative seed is the slot of a bucket with one key, it must be a valid entry
+         for(i = 0; i < index->count && rval == 1; i++)
+         {
+            if(seeds[i] < 0 && (uint32_t)(-(seeds[i] + 1)) >= index->count)
+            {
+               rval = 0;
+            }
+         }
+      }
+   }
+
+   return rval;
+}
+
+
+const PersRctIndexEntry_s* rct_index_find_entry(const PersRctIndex_s* index, const char* resource_id)
+{
+   const PersRctIndexEntry_s* found = NULL;
+
+   if(index != NULL && resource_id != NULL && index->count > 0)
+   {
+      const int32_t* seeds = (const int32_t*)((const char*)index + index->seedOffset);
+      const PersRctIndexEntry_s* entry = NULL;
+      int32_t seed = seeds[rct_index_hash(0, resource_id) % index->count];
+      uint32_t slot = 0;
+
+      if(seed < 0)
+         slot = (uint32_t)(-(seed + 1));
+      else
+         slot = rct_index_hash((uint32_t)seed, resource_id) % index->count;
+
+      // the hash is only perfect for the stored keys, so compare the name
+      entry = (const PersRctIndexEntry_s*)((const char*)index + index->entryOffset) + slot;
+      if(   (slot < index->count)
+         && (entry->nameOffset < index->imageSize - index->stringOffset)
+         && (strcmp((const char*)index + index->stringOffset + entry->nameOffset, resource_id) == 0))
+      {
+         found = entry;
+      }
+   }
+
+   return found;
+}
+
+
+const char* rct_index_custom_key(const PersRctIndex_s* index, const PersRctIndexEntry_s* entry)
+{
+   const char* key = NULL;
+
+   if(entry->customKeyOffset < index->imageSize - index->stringOffset)
+   {
+      key = (const char*)index + index->stringOffset + entry->customKeyOffset;
+   }
+   return key;
+}
+
+
+uint32_t rct_index_entry_slot(const PersRctIndex_s* index, const PersRctIndexEntry_s* entry)
+{
+   return (uint32_t)(entry - (const PersRctIndexEntry_s*)((const char*)index + index->entryOffset));
+}
+
+
+int32_t* rct_index_resolve_plugins(const PersRctIndex_s* index, rct_index_plugin_id_f pluginId)
+{
+   const PersRctIndexEntry_s* entries = (const PersRctIndexEntry_s*)((const char*)index + index->entryOffset);
+   int32_t* pluginIds = malloc((index->count + 1) * sizeof(int32_t));
+   uint32_t i = 0;
+
+   for(i = 0; i < index->count && pluginIds != NULL; i++)
+   {
+      pluginIds[i] = -1;
+      if(entries[i].config.storage == PersistenceStorage_custom)
+      {
+         pluginIds[i] = (int32_t)pluginId(entries[i].config.custom_name);
+      }
+   }
+
+   return pluginIds;
+}
+
+
+const PersistenceConfigurationKey_s* rct_index_find(const PersRctIndex_s* index, const char* resource_id)
+{
+   const PersRctIndexEntry_s* entry = rct_index_find_entry(index, resource_id);
+
+   return (entry != NULL) ? &entry->config : NULL;
+}
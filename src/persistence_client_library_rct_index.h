@@ -0,0 +1,172 @@
+#ifndef PERSISTENCE_CLIENT_LIBRARY_RCT_INDEX_H
+#define PERSISTENCE_CLIENT_LIBRARY_RCT_INDEX_H
+
+/******************************************************************************
+ * Project         Persistency
+ * (c) copyright   2012
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+******************************************************************************/
+ /**
+ * @file           persistence_client_library_rct_index.h
+ * @ingroup        Persistence client library
+ * @author         Ingo Huerner
+ * @brief          Header of the resource configuration table index.
+ *                 The index is a single contiguous, read only memory image
+ *                 holding a minimal perfect hash over the resource IDs,
+ *                 the configuration records and a string pool.
+ *                 The image is never written after it has been created, so a
+ *                 precompiled image can be mapped read only and shared between processes.
+ * @see
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <persComRct.h>
+
+#include <stdint.h>
+#include <string.h>
+
+
+/// magic number of a resource configuration table index image ("PRCI")
+#define PERS_RCT_INDEX_MAGIC     (0x49435250U)
+/// version of the resource configuration table index image layout
+#define PERS_RCT_INDEX_VERSION   (0x00030000U)
+
+
+/// file name suffix of a precompiled index image, appended to the resource configuration table name
+#define PERS_RCT_INDEX_SUFFIX    ".idx"
+
+
+/// header of a resource configuration table index image
+typedef struct _PersRctIndex_s
+{
+   /// magic number, see ::PERS_RCT_INDEX_MAGIC
+   uint32_t magic;
+   /// image layout version, see ::PERS_RCT_INDEX_VERSION
+   uint32_t version;
+   /// size of one entry, used to detect a configuration record mismatch
+   uint32_t entrySize;
+   /// number of resources
+   uint32_t count;
+   /// size of the complete image in bytes
+   uint32_t imageSize;
+   /// offset of the displacement array (int32_t[count])
+   uint32_t seedOffset;
+   /// offset of the entry array (PersRctIndexEntry_s[count])
+   uint32_t entryOffset;
+   /// offset of the string pool
+   uint32_t stringOffset;
+} PersRctIndex_s;
+
+
+/// entry of a resource configuration table index image
+typedef struct _PersRctIndexEntry_s
+{
+   /// offset of the resource ID in the string pool
+   uint32_t nameOffset;
+   /// length of the resource ID without termination
+   uint32_t nameLength;
+   /// the resource configuration
+   PersistenceConfigurationKey_s config;
+   /// custom storage: offset of the plugin key in the string pool, without the logical database ID prefix
+   uint32_t customKeyOffset;
+} PersRctIndexEntry_s;
+
+
+/// plugin ID of a plugin name, see ::rct_index_resolve_plugins
+typedef int (*rct_index_plugin_id_f)(const char* custom_name);
+
+
+/**
+ * @brief create a resource configuration table index image
+ *
+ * @param count the number of resources
+ * @param names the resource IDs, must be unique
+ * @param configs the resource configurations, same order as names
+ *
+ * @return the image (release with free) or NULL if the index could not be created
+ */
+PersRctIndex_s* rct_index_create(uint32_t count, const char** names, const PersistenceConfigurationKey_s* configs);
+
+
+/**
+ * @brief check if a memory block holds a valid index image
+ *        (e.g. a precompiled index file mapped into memory)
+ *
+ * @param index the index image
+ * @param size the size of the memory block
+ *
+ * @return 1 if the image can be used, 0 if not
+ */
+int rct_index_verify(const PersRctIndex_s* index, size_t size);
+
+
+/**
+ * @brief find the entry of a resource
+ *
+ * @param index the index image
+ * @param resource_id the resource ID
+ *
+ * @return pointer to the entry inside the image or NULL if the resource is not available
+ */
+const PersRctIndexEntry_s* rct_index_find_entry(const PersRctIndex_s* index, const char* resource_id);
+
+
+/**
+ * @brief get the plugin key of a custom storage resource, created with the index
+ *
+ * @param index the index image
+ * @param entry the entry of the resource
+ *
+ * @return the plugin key without the logical database ID prefix or NULL if the resource has no custom storage
+ */
+const char* rct_index_custom_key(const PersRctIndex_s* index, const PersRctIndexEntry_s* entry);
+
+
+/**
+ * @brief get the position of an entry in the entry array, used to index the plugin IDs
+ *
+ * @param index the index image
+ * @param entry the entry returned by ::rct_index_find_entry
+ *
+ * @return the position of the entry
+ */
+uint32_t rct_index_entry_slot(const PersRctIndex_s* index, const PersRctIndexEntry_s* entry);
+
+
+/**
+ * @brief resolve the plugin IDs of the custom storage resources once, the plugin IDs
+ *        depend on the loaded plugins and are not stored in the image
+ *
+ * @param index the index image
+ * @param pluginId function to get the plugin ID of a plugin name
+ *
+ * @return the plugin ID of each entry, see ::rct_index_entry_slot, -1 if the entry has no custom storage
+ *         (release with free) or NULL if the memory could not be allocated
+ */
+int32_t* rct_index_resolve_plugins(const PersRctIndex_s* index, rct_index_plugin_id_f pluginId);
+
+
+/**
+ * @brief find the configuration of a resource
+ *
+ * @param index the index image
+ * @param resource_id the resource ID
+ *
+ * @return pointer to the configuration inside the image or NULL if the resource is not available
+ */
+const PersistenceConfigurationKey_s* rct_index_find(const PersRctIndex_s* index, const char* resource_id);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PERSISTENCE_CLIENT_LIBRARY_RCT_INDEX_H */
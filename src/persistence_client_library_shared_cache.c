@@ -0,0 +1,439 @@
+/******************************************************************************
+ * Project         Persistency
+ * (c) copyright   2012
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+******************************************************************************/
+ /**
+ * @file           persistence_client_library_shared_cache.c
+ * @ingroup        Persistence client library
+ * @author         Ingo Huerner
+ * @brief          Implementation of the cross process read cache of shared keys.
+ *                 A key is stored in the slot selected by the crc32 of its name,
+ *                 a key with the same slot replaces it.
+ *                 The sequence number of a slot is odd while the slot is locked.
+ *                 Values of an older generation of the segment are invalid.
+ *                 The segment is created by the first writer and is writable only
+ *                 by its user, readers map it read only.
+ * @see
+ */
+
+#include "persistence_client_library_shared_cache.h"
+#include "persistence_client_library_data_organization.h"
+#include "crc32.h"
+
+#include <dlt.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+DLT_IMPORT_CONTEXT(gPclDLTContext);
+
+
+/// magic number of a segment ("PSHC")
+#define SHARED_CACHE_MAGIC    (0x43485350U)
+
+/// number of shared logical databases (public and groups)
+#define SHARED_CACHE_MAX_LDBID   (0x80)
+
+
+/// header of a segment, followed by the slots
+typedef struct _SharedCacheHeader_s
+{
+   /// magic number, see ::SHARED_CACHE_MAGIC
+   uint32_t magic;
+   /// number of slots, see ::SharedCacheSlots
+   uint32_t slotCount;
+   /// size of a slot
+   uint32_t slotSize;
+   /// generation of the cached values
+   uint32_t generation;
+} SharedCacheHeader_s;
+
+
+/// slot holding the value of one key
+typedef struct _SharedCacheSlot_s
+{
+   /// sequence number, odd while the slot is locked
+   uint32_t seq;
+   /// process ID of the process holding the lock
+   int32_t pid;
+   /// generation of the segment the value has been stored with
+   uint32_t generation;
+   /// policy of the database
+   int32_t dbType;
+   /// the size of the value, negative if the slot is empty
+   int32_t size;
+   /// unused, keeps the data 8 byte aligned
+   int32_t reserved;
+   /// the database key
+   char key[PERS_DB_MAX_LENGTH_KEY_NAME];
+   /// the value
+   unsigned char data[SharedCacheMaxDataSize];
+} SharedCacheSlot_s;
+
+
+/// mapped segments, indexed by the logical database ID, read only [0] and writable [1]
+static SharedCacheHeader_s* gSharedCache[SHARED_CACHE_MAX_LDBID][2] = {{NULL}};
+/// segments which could not be mapped, read only [0] and writable [1]
+static int gSharedCacheFailed[SHARED_CACHE_MAX_LDBID][2] = {{0}};
+/// mutex protecting the mapping of the segments
+static pthread_mutex_t gSharedCacheMtx = PTHREAD_MUTEX_INITIALIZER;
+/// flag to indicate if reading from the shared cache is enabled
+static int gSharedCacheEnabled = 0;
+
+
+
+/* map the segment of a shared database writable, the segment is created by the first writer if create is 1.
+   Returns NULL and sets failed if the segment can't be used by this process */
+static SharedCacheHeader_s* shared_cache_map_write(unsigned int ldbid, int create, const char* name, int* failed)
+{
+   SharedCacheHeader_s* header = NULL;
+   const size_t segmentSize = sizeof(SharedCacheHeader_s) + SharedCacheSlots * sizeof(SharedCacheSlot_s);
+   int fd = (create == 1) ? shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0) : -1;
+
+   if(fd != -1)
+   {
+      // only the user of the writer may write, public data can be read by everyone, group data by the members of the group
+      (void)fchmod(fd, (ldbid == PCL_LDBID_PUBLIC) ? 0644 : 0640);
+   }
+   else if(create == 0 || errno == EEXIST)
+   {
+      fd = shm_open(name, O_RDWR, 0);
+   }
+
+   if(fd != -1)
+   {
+      struct stat st;
+
+      // the creator may not have resized the segment yet, resizing to the same size is harmless
+      if(fstat(fd, &st) == 0 && (st.st_size >= (off_t)segmentSize || ftruncate(fd, (off_t)segmentSize) == 0))
+      {
+         void* segment = mmap(NULL, segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+         if(segment != MAP_FAILED)
+         {
+            header = (SharedCacheHeader_s*)segment;
+
+            // all writers initialize the layout with the same values
+            (void)__sync_val_compare_and_swap(&header->slotCount, 0, SharedCacheSlots);
+            (void)__sync_val_compare_and_swap(&header->slotSize, 0, sizeof(SharedCacheSlot_s));
+            (void)__sync_val_compare_and_swap(&header->magic, 0, SHARED_CACHE_MAGIC);
+
+            if(   header->magic != SHARED_CACHE_MAGIC
+               || header->slotCount != SharedCacheSlots
+               || header->slotSize != sizeof(SharedCacheSlot_s))
+            {
+               DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("sharedCache - incompatible segment:"), DLT_STRING(name));
+               (void)munmap(segment, segmentSize);
+               header = NULL;
+            }
+         }
+      }
+      close(fd);
+   }
+
+   if(header == NULL && (create == 1 || errno == EACCES))
+   {
+      // e.g. the segment belongs to the user of another writer
+      DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("sharedCache - no writable segment:"), DLT_STRING(name), DLT_STRING(strerror(errno)));
+      *failed = 1;
+   }
+   return header;
+}
+
+
+
+/* map the segment of a shared database read only, the segment must have been created by a writer.
+   Returns NULL and sets failed if the segment can't be used by this process */
+static SharedCacheHeader_s* shared_cache_map_read(const char* name, int* failed)
+{
+   SharedCacheHeader_s* header = NULL;
+   const size_t segmentSize = sizeof(SharedCacheHeader_s) + SharedCacheSlots * sizeof(SharedCacheSlot_s);
+   int fd = shm_open(name, O_RDONLY, 0);
+
+   if(fd != -1)
+   {
+      struct stat st;
+
+      if(fstat(fd, &st) == 0 && st.st_size >= (off_t)segmentSize)
+      {
+         void* segment = mmap(NULL, segmentSize, PROT_READ, MAP_SHARED, fd, 0);
+
+         if(segment != MAP_FAILED)
+         {
+            header = (SharedCacheHeader_s*)segment;
+
+            if(__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) == 0)
+            {
+               (void)munmap(segment, segmentSize);      // not initialized by the writer yet, try again later
+               header = NULL;
+            }
+            else if(   header->magic != SHARED_CACHE_MAGIC
+                    || header->slotCount != SharedCacheSlots
+                    || header->slotSize != sizeof(SharedCacheSlot_s))
+            {
+               DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("sharedCache - incompatible segment:"), DLT_STRING(name));
+               (void)munmap(segment, segmentSize);
+               header = NULL;
+               *failed = 1;
+            }
+         }
+      }
+      close(fd);
+   }
+   else if(errno != ENOENT)      // no writer has created the segment yet otherwise
+   {
+      DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("sharedCache - no segment:"), DLT_STRING(name), DLT_STRING(strerror(errno)));
+      *failed = 1;
+   }
+   return header;
+}
+
+
+
+/* get the segment of a shared database, read only or writable.
+   A writable segment will be created if create is 1, otherwise only an existing segment will be mapped */
+static SharedCacheHeader_s* shared_cache_get(unsigned int ldbid, int write, int create)
+{
+   SharedCacheHeader_s* header = NULL;
+
+   if(ldbid < SHARED_CACHE_MAX_LDBID)
+   {
+      header = __atomic_load_n(&gSharedCache[ldbid][write], __ATOMIC_ACQUIRE);
+
+      if(header == NULL && gSharedCacheFailed[ldbid][write] == 0 && pthread_mutex_lock(&gSharedCacheMtx) == 0)
+      {
+         header = gSharedCache[ldbid][write];
+         if(header == NULL && gSharedCacheFailed[ldbid][write] == 0)
+         {
+            char name[NAME_MAX] = {0};
+
+            snprintf(name, NAME_MAX, "/pcl_shared_cache_%02X", ldbid);
+
+            if(write == 1)
+               header = shared_cache_map_write(ldbid, create, name, &gSharedCacheFailed[ldbid][write]);
+            else
+               header = shared_cache_map_read(name, &gSharedCacheFailed[ldbid][write]);
+
+            if(header != NULL)
+               __atomic_store_n(&gSharedCache[ldbid][write], header, __ATOMIC_RELEASE);
+         }
+         pthread_mutex_unlock(&gSharedCacheMtx);
+      }
+   }
+   return header;
+}
+
+
+
+static SharedCacheSlot_s* shared_cache_slot(SharedCacheHeader_s* header, int dbType, const char* key)
+{
+   SharedCacheSlot_s* slots = (SharedCacheSlot_s*)(header + 1);
+   unsigned int hash = pclCrc32((unsigned int)dbType, (const unsigned char*)key, strlen(key));
+
+   return &slots[hash % SharedCacheSlots];
+}
+
+
+
+/* try to lock a slot, returns the odd sequence number or 0 if the slot is locked by another writer */
+static uint32_t shared_cache_try_lock(SharedCacheSlot_s* slot)
+{
+   uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+
+   if((seq & 1) == 0 && __sync_bool_compare_and_swap(&slot->seq, seq, seq + 1))
+   {
+      slot->pid = (int32_t)getpid();
+      return seq + 1;
+   }
+   return 0;
+}
+
+
+
+/* store a value in a locked slot and unlock it */
+static void shared_cache_unlock(SharedCacheSlot_s* slot, uint32_t seq, uint32_t generation, int dbType,
+                                const char* key, const unsigned char* data, int size)
+{
+   slot->size = -1;
+   if(data != NULL && size >= 0 && size <= SharedCacheMaxDataSize)
+   {
+      if(data != slot->data)
+         memcpy(slot->data, data, (size_t)size);
+      strncpy(slot->key, key, PERS_DB_MAX_LENGTH_KEY_NAME - 1);
+      slot->key[PERS_DB_MAX_LENGTH_KEY_NAME - 1] = '\0';
+      slot->dbType = dbType;
+      slot->generation = generation;
+      slot->size = size;
+   }
+   slot->pid = 0;
+
+   // the lock has been taken over if the sequence number has changed, the value is invalid then
+   (void)__sync_bool_compare_and_swap(&slot->seq, seq, seq + 1);
+}
+
+
+
+void shared_cache_enable(int enable)
+{
+   __atomic_store_n(&gSharedCacheEnabled, enable, __ATOMIC_RELEASE);
+}
+
+
+
+int shared_cache_read(unsigned int ldbid, int dbType, const char* key, unsigned char* buffer, int buffer_size)
+{
+   int rval = EPERS_NOKEY;
+   SharedCacheHeader_s* header = NULL;
+
+   if(   __atomic_load_n(&gSharedCacheEnabled, __ATOMIC_ACQUIRE) == 1
+      && strlen(key) < PERS_DB_MAX_LENGTH_KEY_NAME
+      && (header = shared_cache_get(ldbid, 0, 0)) != NULL)
+   {
+      SharedCacheSlot_s* slot = shared_cache_slot(header, dbType, key);
+      int retry = 0;
+
+      for(retry = 0; retry < 3 && rval == EPERS_NOKEY; retry++)
+      {
+         uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+         int size = slot->size, copied = EPERS_NOKEY;
+
+         if((seq & 1) == 1)
+         {
+            break;      // locked by a writer, read the database
+         }
+
+         if(   size >= 0 && size <= SharedCacheMaxDataSize
+            && slot->dbType == dbType
+            && slot->generation == __atomic_load_n(&header->generation, __ATOMIC_ACQUIRE)
+            && strncmp(slot->key, key, PERS_DB_MAX_LENGTH_KEY_NAME) == 0)
+         {
+            copied = size;
+            if(buffer != NULL)
+            {
+               if(copied > buffer_size)
+                  copied = buffer_size;
+               memcpy(buffer, slot->data, (size_t)copied);
+            }
+         }
+         else
+         {
+            break;      // not cached
+         }
+
+         __atomic_thread_fence(__ATOMIC_ACQUIRE);
+         if(__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) == seq)
+         {
+            rval = copied;
+         }
+      }
+   }
+   return rval;
+}
+
+
+
+void shared_cache_begin_write(unsigned int ldbid, int dbType, const char* key, SharedCacheWrite_s* write)
+{
+   SharedCacheHeader_s* header = NULL;
+
+   memset(write, 0, sizeof(SharedCacheWrite_s));
+
+   if(strlen(key) < PERS_DB_MAX_LENGTH_KEY_NAME && (header = shared_cache_get(ldbid, 1, 1)) != NULL)
+   {
+      SharedCacheSlot_s* slot = shared_cache_slot(header, dbType, key);
+      int spin = 0;
+
+      write->segment = header;
+      write->dbType = dbType;
+      for(spin = 0; spin < SharedCacheLockSpins && write->seq == 0; spin++)
+      {
+         write->seq = shared_cache_try_lock(slot);
+         if(write->seq == 0)
+         {
+            uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+            pid_t pid = (pid_t)slot->pid;
+
+            // take over the lock of a process which died while holding it
+            if(   (seq & 1) == 1 && pid > 0 && kill(pid, 0) == -1 && errno == ESRCH
+               && __sync_bool_compare_and_swap(&slot->seq, seq, seq + 2))
+            {
+               slot->pid = (int32_t)getpid();
+               write->seq = seq + 2;
+            }
+            else
+            {
+               sched_yield();
+            }
+         }
+      }
+
+      if(write->seq != 0)
+      {
+         write->slot = slot;
+         write->generation = __atomic_load_n(&header->generation, __ATOMIC_ACQUIRE);
+      }
+      else
+      {
+         DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("sharedCache - slot locked, invalidate:"), DLT_STRING(key));
+      }
+   }
+}
+
+
+
+void shared_cache_end_write(SharedCacheWrite_s* write, const char* key, const unsigned char* data, int size)
+{
+   if(write->slot != NULL)
+   {
+      shared_cache_unlock((SharedCacheSlot_s*)write->slot, write->seq, write->generation, write->dbType, key, data, size);
+   }
+   else if(write->segment != NULL)
+   {
+      // the database has been written without the slot, values read before are invalid now
+      (void)__sync_add_and_fetch(&((SharedCacheHeader_s*)write->segment)->generation, 1);
+   }
+}
+
+
+
+void shared_cache_invalidate(unsigned int ldbid)
+{
+   SharedCacheHeader_s* header = shared_cache_get(ldbid, 1, 1);
+
+   if(header != NULL)
+   {
+      (void)__sync_add_and_fetch(&header->generation, 1);
+   }
+}
+
+
+
+void shared_cache_invalidate_all(void)
+{
+   unsigned int ldbid = 0;
+
+   // segments not used by this process may be used by other processes
+   for(ldbid = 0; ldbid < SHARED_CACHE_MAX_LDBID; ldbid++)
+   {
+      SharedCacheHeader_s* header = shared_cache_get(ldbid, 1, 0);
+
+      if(header != NULL)
+      {
+         (void)__sync_add_and_fetch(&header->generation, 1);
+      }
+   }
+}
@@ -0,0 +1,119 @@
+#ifndef PERSISTENCE_CLIENT_LIBRARY_SHARED_CACHE_H
+#define PERSISTENCE_CLIENT_LIBRARY_SHARED_CACHE_H
+
+/******************************************************************************
+ * Project         Persistency
+ * (c) copyright   2012
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+******************************************************************************/
+ /**
+ * @file           persistence_client_library_shared_cache.h
+ * @ingroup        Persistence client library
+ * @author         Ingo Huerner
+ * @brief          Header of the cross process read cache of shared keys.
+ *                 Every shared database (public and group) has a shared memory segment
+ *                 with a fixed number of seqlock protected slots.
+ *                 A writer locks the slot of a key before the database is written and
+ *                 stores the new value in the slot, readers copy the value without
+ *                 any lock or system call. Only writers update the slots, the segment
+ *                 is writable by the user of the first writer only and mapped read only
+ *                 by the readers, so all writers of a shared database must run with the same user.
+ *                 Writers always keep the segments up to date, reading from the segments
+ *                 is enabled with ::PCL_INIT_SHARED_CACHE.
+ * @see
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+
+/// write access to a slot, see ::shared_cache_begin_write
+typedef struct _SharedCacheWrite_s
+{
+   /// the segment of the database
+   void* segment;
+   /// the locked slot or NULL if the slot could not be locked
+   void* slot;
+   /// the sequence number of the locked slot
+   uint32_t seq;
+   /// the generation of the segment when the slot has been locked
+   uint32_t generation;
+   /// the policy of the database
+   int dbType;
+} SharedCacheWrite_s;
+
+
+/**
+ * @brief enable or disable reading from the shared cache
+ *
+ * @param enable 1 to enable, 0 to disable
+ */
+void shared_cache_enable(int enable);
+
+
+/**
+ * @brief read a value from the shared cache, no lock will be taken
+ *
+ * @param ldbid logical database ID of the shared database
+ * @param dbType the policy of the database
+ * @param key the database key
+ * @param buffer the buffer to store the value or NULL to get the size only
+ * @param buffer_size the size of the buffer
+ *
+ * @return the number of bytes copied, the size of the value if buffer is NULL
+ *         or EPERS_NOKEY if the value is not cached
+ */
+int shared_cache_read(unsigned int ldbid, int dbType, const char* key, unsigned char* buffer, int buffer_size);
+
+
+/**
+ * @brief lock the slot of a key before the database will be written, must be followed by ::shared_cache_end_write
+ *
+ * @param ldbid logical database ID of the shared database
+ * @param dbType the policy of the database
+ * @param key the database key
+ * @param write the write access to initialize
+ */
+void shared_cache_begin_write(unsigned int ldbid, int dbType, const char* key, SharedCacheWrite_s* write);
+
+
+/**
+ * @brief store the written value in the slot and unlock it
+ *
+ * @param write the write access of ::shared_cache_begin_write
+ * @param key the database key
+ * @param data the written data or NULL if the key has been deleted or the write failed
+ * @param size the size of the data
+ */
+void shared_cache_end_write(SharedCacheWrite_s* write, const char* key, const unsigned char* data, int size);
+
+
+/**
+ * @brief invalidate all cached values of a shared database, e.g. because the keys
+ *        of a user have been deleted
+ *
+ * @param ldbid logical database ID of the shared database
+ */
+void shared_cache_invalidate(unsigned int ldbid);
+
+
+/**
+ * @brief invalidate the cached values of all shared databases,
+ *        called when the administration service has changed the databases
+ */
+void shared_cache_invalidate_all(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PERSISTENCE_CLIENT_LIBRARY_SHARED_CACHE_H */
@@ -0,0 +1,311 @@
+/******************************************************************************
+ * Project         Persistency
+ * (c) copyright   2012
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+******************************************************************************/
+ /**
+ * @file           persistence_client_library_value_ref.c
+ * @ingroup        Persistence client library
+ * @author         Ingo Huerner
+ * @brief          Implementation of the reference counted value cache.
+ *                 The values are stored in an intrusive red black tree
+ *                 ordered by database handle and key.
+ * @see
+ */
+
+#include "persistence_client_library_value_ref.h"
+#include "persistence_client_library_data_organization.h"
+#include "rbtree.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/// magic number of a value ("PREF")
+#define VALUE_REF_MAGIC   (0x46455250U)
+
+
+/// header of a value, followed by the data
+typedef struct _ValueRefHeader_s
+{
+   /// magic number, see ::VALUE_REF_MAGIC
+   uint32_t magic;
+   /// number of references
+   int refCount;
+   /// the size of the data
+   int size;
+   /// unused, keeps the data 8 byte aligned
+   int reserved;
+} ValueRefHeader_s;
+
+
+/// cached value
+typedef struct _ValueRefEntry_s
+{
+   /// the database handle
+   int handleDB;
+   /// the data of the value, the cache holds one reference
+   unsigned char* data;
+   /// the database key
+   char key[PERS_DB_MAX_LENGTH_KEY_NAME];
+} ValueRefEntry_s;
+
+
+/// tree holding the cached values
+static jsw_rbtree_t* gValueRefTree = NULL;
+/// mutex protecting the tree and the statistics
+static pthread_mutex_t gValueRefMtx = PTHREAD_MUTEX_INITIALIZER;
+/// cache statistics
+static pclCacheStats_s gValueRefStats = {0};
+
+
+
+static ValueRefHeader_s* value_ref_header(const unsigned char* data)
+{
+   return (ValueRefHeader_s*)(uintptr_t)data - 1;
+}
+
+
+static int value_ref_cmp(const void *p1, const void *p2)
+{
+   const ValueRefEntry_s* first  = (const ValueRefEntry_s*)p1;
+   const ValueRefEntry_s* second = (const ValueRefEntry_s*)p2;
+   int rval = (first->handleDB > second->handleDB) - (first->handleDB < second->handleDB);
+
+   if(rval == 0)
+   {
+      rval = strcmp(first->key, second->key);
+   }
+   return (rval > 0) - (rval < 0);
+}
+
+
+unsigned char* value_ref_create(int size)
+{
+   unsigned char* data = NULL;
+   ValueRefHeader_s* header = malloc(sizeof(ValueRefHeader_s) + (size_t)size + 1);
+
+   if(header != NULL)
+   {
+      header->magic    = VALUE_REF_MAGIC;
+      header->refCount = 1;
+      header->size     = size;
+      header->reserved = 0;
+
+      data = (unsigned char*)(header + 1);
+      data[size] = '\0';
+   }
+   return data;
+}
+
+
+
+void value_ref_set_size(unsigned char* data, int size)
+{
+   value_ref_header(data)->size = size;
+   data[size] = '\0';
+}
+
+
+
+int value_ref_find(int handleDB, const char* key, const unsigned char** data)
+{
+   int size = EPERS_NOKEY;
+
+   if(strlen(key) < PERS_DB_MAX_LENGTH_KEY_NAME && pthread_mutex_lock(&gValueRefMtx) == 0)
+   {
+      if(gValueRefTree != NULL)
+      {
+         ValueRefEntry_s search;
+         const ValueRefEntry_s* entry = NULL;
+
+         search.handleDB = handleDB;
+         strcpy(search.key, key);
+
+         entry = jsw_rbfind(gValueRefTree, &search);
+         if(entry != NULL)
+         {
+            ValueRefHeader_s* header = value_ref_header(entry->data);
+
+            __sync_add_and_fetch(&header->refCount, 1);
+            *data = entry->data;
+            size = header->size;
+         }
+      }
+
+      if(size >= 0)
+         gValueRefStats.hits++;
+      else
+         gValueRefStats.misses++;
+
+      pthread_mutex_unlock(&gValueRefMtx);
+   }
+   return size;
+}
+
+
+
+int value_ref_contains(int handleDB, const char* key)
+{
+   int rval = 0;
+
+   if(strlen(key) < PERS_DB_MAX_LENGTH_KEY_NAME && pthread_mutex_lock(&gValueRefMtx) == 0)
+   {
+      if(gValueRefTree != NULL)
+      {
+         ValueRefEntry_s search;
+
+         search.handleDB = handleDB;
+         strcpy(search.key, key);
+
+         rval = (jsw_rbfind(gValueRefTree, &search) != NULL) ? 1 : 0;
+      }
+      pthread_mutex_unlock(&gValueRefMtx);
+   }
+   return rval;
+}
+
+
+
+int value_ref_insert(int handleDB, const char* key, unsigned char* data)
+{
+   int rval = 0;
+
+   if(strlen(key) < PERS_DB_MAX_LENGTH_KEY_NAME && pthread_mutex_lock(&gValueRefMtx) == 0)
+   {
+      if(gValueRefTree == NULL)
+      {
+         gValueRefTree = jsw_rbnew_intrusive(value_ref_cmp, sizeof(ValueRefEntry_s), 0);
+      }
+
+      if(gValueRefTree != NULL && jsw_rbsize(gValueRefTree) < ValueRefMaxKeys)
+      {
+         ValueRefEntry_s search;
+
+         search.handleDB = handleDB;
+         search.data     = data;
+         strcpy(search.key, key);
+
+         if(jsw_rbfind(gValueRefTree, &search) == NULL)
+         {
+            __sync_add_and_fetch(&value_ref_header(data)->refCount, 1);
+            if(jsw_rbinsert(gValueRefTree, &search) == 1)
+            {
+               rval = 1;
+            }
+            else
+            {
+               __sync_sub_and_fetch(&value_ref_header(data)->refCount, 1);
+            }
+         }
+      }
+      pthread_mutex_unlock(&gValueRefMtx);
+   }
+   return rval;
+}
+
+
+
+int value_ref_release(const unsigned char* data)
+{
+   int rval = EPERS_COMMON;
+
+   if(data != NULL)
+   {
+      ValueRefHeader_s* header = value_ref_header(data);
+
+      if(header->magic == VALUE_REF_MAGIC)
+      {
+         if(__sync_sub_and_fetch(&header->refCount, 1) == 0)
+         {
+            header->magic = 0;
+            free(header);
+         }
+         rval = 0;
+      }
+   }
+   return rval;
+}
+
+
+
+void value_ref_invalidate(int handleDB, const char* key)
+{
+   if(strlen(key) < PERS_DB_MAX_LENGTH_KEY_NAME && pthread_mutex_lock(&gValueRefMtx) == 0)
+   {
+      if(gValueRefTree != NULL)
+      {
+         ValueRefEntry_s search;
+         const ValueRefEntry_s* entry = NULL;
+
+         search.handleDB = handleDB;
+         strcpy(search.key, key);
+
+         entry = jsw_rbfind(gValueRefTree, &search);
+         if(entry != NULL)
+         {
+            unsigned char* data = entry->data;
+
+            (void)jsw_rberase(gValueRefTree, &search);
+            (void)value_ref_release(data);
+         }
+      }
+      pthread_mutex_unlock(&gValueRefMtx);
+   }
+}
+
+
+
+void value_ref_clear(void)
+{
+   if(pthread_mutex_lock(&gValueRefMtx) == 0)
+   {
+      if(gValueRefTree != NULL)
+      {
+         jsw_rbtrav_t* trav = jsw_rbtnew();
+
+         if(trav != NULL)
+         {
+            ValueRefEntry_s* entry = NULL;
+
+            for(entry = jsw_rbtfirst(trav, gValueRefTree); entry != NULL; entry = jsw_rbtnext(trav))
+            {
+               (void)value_ref_release(entry->data);
+            }
+            jsw_rbtdelete(trav);
+         }
+         jsw_rbdelete(gValueRefTree);
+         gValueRefTree = NULL;
+      }
+      pthread_mutex_unlock(&gValueRefMtx);
+   }
+}
+
+
+
+void value_ref_add_prefetched(unsigned int count)
+{
+   if(pthread_mutex_lock(&gValueRefMtx) == 0)
+   {
+      gValueRefStats.prefetched += count;
+      pthread_mutex_unlock(&gValueRefMtx);
+   }
+}
+
+
+
+void value_ref_get_stats(pclCacheStats_s* stats)
+{
+   if(pthread_mutex_lock(&gValueRefMtx) == 0)
+   {
+      *stats = gValueRefStats;
+      pthread_mutex_unlock(&gValueRefMtx);
+   }
+}
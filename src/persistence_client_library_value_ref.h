@@ -0,0 +1,130 @@
+#ifndef PERSISTENCE_CLIENT_LIBRARY_VALUE_REF_H
+#define PERSISTENCE_CLIENT_LIBRARY_VALUE_REF_H
+
+/******************************************************************************
+ * Project         Persistency
+ * (c) copyright   2012
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+******************************************************************************/
+ /**
+ * @file           persistence_client_library_value_ref.h
+ * @ingroup        Persistence client library
+ * @author         Ingo Huerner
+ * @brief          Header of the reference counted value cache used by pclKeyReadRef.
+ *                 A value is freed when the cache and all readers have released it,
+ *                 so a value can be invalidated while a reader still uses it.
+ * @see
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "../include/persistence_client_library_key.h"
+
+
+/**
+ * @brief allocate a value with a reference count of 1
+ *
+ * @param size the size of the value
+ *
+ * @return the data of the value or NULL, the data is terminated with an additional '\0'
+ */
+unsigned char* value_ref_create(int size);
+
+
+/**
+ * @brief set the size of a value after it has been read, must not be bigger than the allocated size
+ *
+ * @param data the data of the value
+ * @param size the size of the value
+ */
+void value_ref_set_size(unsigned char* data, int size);
+
+
+/**
+ * @brief find a cached value and acquire a reference, counts a cache hit or miss
+ *
+ * @param handleDB the database handle
+ * @param key the database key
+ * @param data pointer to store the data of the value
+ *
+ * @return the size of the value or EPERS_NOKEY if the value is not cached
+ */
+int value_ref_find(int handleDB, const char* key, const unsigned char** data);
+
+
+/**
+ * @brief check if a value is cached, does not count a cache hit or miss
+ *
+ * @param handleDB the database handle
+ * @param key the database key
+ *
+ * @return 1 if the value is cached, 0 if not
+ */
+int value_ref_contains(int handleDB, const char* key);
+
+
+/**
+ * @brief add a value to the cache, the cache acquires its own reference
+ *
+ * @param handleDB the database handle
+ * @param key the database key
+ * @param data the data of the value
+ *
+ * @return 1 if the value has been added, 0 if the key is already cached or the cache is full
+ */
+int value_ref_insert(int handleDB, const char* key, unsigned char* data);
+
+
+/**
+ * @brief release a reference, the value will be freed with the last reference
+ *
+ * @param data the data of the value
+ *
+ * @return 0 on success, EPERS_COMMON if data is not a value
+ */
+int value_ref_release(const unsigned char* data);
+
+
+/**
+ * @brief remove a value from the cache, e.g. because the key has been written
+ *
+ * @param handleDB the database handle
+ * @param key the database key
+ */
+void value_ref_invalidate(int handleDB, const char* key);
+
+
+/**
+ * @brief remove all values from the cache
+ */
+void value_ref_clear(void);
+
+
+/**
+ * @brief count values added to the cache by a prefetch
+ *
+ * @param count the number of values
+ */
+void value_ref_add_prefetched(unsigned int count);
+
+
+/**
+ * @brief get the cache statistics
+ *
+ * @param stats pointer to store the statistics
+ */
+void value_ref_get_stats(pclCacheStats_s* stats);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PERSISTENCE_CLIENT_LIBRARY_VALUE_REF_H */
@@ -0,0 +1,949 @@
+/******************************************************************************
+ * Project         Persistency
+ * (c) copyright   2012
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+******************************************************************************/
+ /**
+ * @file           persistence_client_library_warm_start.c
+ * @ingroup        Persistence client library
+ * @author         Ingo Huerner
+ * @brief          Implementation of the warm start snapshot.
+ *                 The image is written to a temporary file and renamed, so a
+ *                 crash while writing leaves no partial image. The header and all
+ *                 tables are protected by one crc32, the value data by a crc32 per value,
+ *                 which is checked when the value is read the first time.
+ * @see
+ */
+
+#include "persistence_client_library_warm_start.h"
+#include "persistence_client_library_prct_access.h"
+#include "persistence_client_library_db_access.h"
+#include "persistence_client_library_backup_filelist.h"
+#include "crc32.h"
+
+#include <dlt.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+DLT_IMPORT_CONTEXT(gPclDLTContext);
+
+
+/// state of a value of the image
+typedef enum _WarmStartValueState_e
+{
+   /// the value must not be used anymore
+   WarmStartValue_Invalid    = 0,
+   /// the crc of the value has not been checked yet
+   WarmStartValue_Unverified = 1,
+   /// the crc of the value has been checked
+   WarmStartValue_Verified   = 2
+} WarmStartValueState_e;
+
+
+/// local key read by the application
+typedef struct _WarmStartKey_s
+{
+   /// hash of the policy and the database key
+   uint32_t hash;
+   /// the persistence info of the key
+   PersistenceInfo_s info;
+   /// the database key
+   char key[PERS_DB_MAX_LENGTH_KEY_NAME];
+   /// the resource ID
+   char resourceID[PERS_DB_MAX_LENGTH_KEY_NAME];
+} WarmStartKey_s;
+
+
+/// collected value
+typedef struct _WarmStartItem_s
+{
+   /// the recorded key
+   const WarmStartKey_s* key;
+   /// size of the value or EPERS_NOKEY
+   int size;
+   /// the value data
+   unsigned char* data;
+} WarmStartItem_s;
+
+
+/// collected resource configuration table index
+typedef struct _WarmStartRctItem_s
+{
+   /// the resource configuration table index
+   uint32_t table;
+   /// copy of the index image
+   PersRctIndex_s* index;
+   /// the file name of the resource configuration table
+   char filename[PERS_ORG_MAX_LENGTH_PATH_FILENAME];
+} WarmStartRctItem_s;
+
+
+/// state collected before the databases are closed
+typedef struct _WarmStartCollect_s
+{
+   /// copy of the recorded keys
+   WarmStartKey_s* keys;
+   /// the values
+   WarmStartItem_s* values;
+   /// number of values
+   int valueCount;
+   /// the indexes
+   WarmStartRctItem_s* rct;
+   /// number of indexes
+   int rctCount;
+   /// the blacklist keys
+   uint32_t* blacklist;
+   /// number of blacklist keys, -1 if there is no blacklist
+   int blacklistCount;
+} WarmStartCollect_s;
+
+
+/// mutex protecting the image and the recorded keys
+static pthread_mutex_t gWarmStartMtx = PTHREAD_MUTEX_INITIALIZER;
+/// flag to indicate if the warm start snapshot is enabled
+static int gWarmStartEnabled = 0;
+/// file name of the image
+static char gWarmStartFilename[PERS_ORG_MAX_LENGTH_PATH_FILENAME] = {0};
+/// file name of the blacklist configuration file
+static char gWarmStartBlacklist[PERS_ORG_MAX_LENGTH_PATH_FILENAME] = {0};
+/// the mapped image or NULL
+static const PersWarmStart_s* gWarmStartImage = NULL;
+/// size of the mapped image
+static size_t gWarmStartImageSize = 0;
+/// state of the values of the image, see ::WarmStartValueState_e
+static unsigned char* gWarmStartValueState = NULL;
+/// keys read by the application in this lifecycle
+static WarmStartKey_s* gWarmStartKeys = NULL;
+/// number of recorded keys
+static int gWarmStartKeyCount = 0;
+/// state collected by ::warm_start_collect, only accessed by the shutdown
+static WarmStartCollect_s* gWarmStartCollected = NULL;
+
+
+
+static uint32_t warm_start_hash(int policy, const char* key)
+{
+   uint32_t value = (uint32_t)policy;
+
+   return pclCrc32(pclCrc32(0, (const unsigned char*)&value, sizeof(value)), (const unsigned char*)key, strlen(key));
+}
+
+
+static size_t warm_start_align(size_t size)
+{
+   return (size + 7) & ~(size_t)7;
+}
+
+
+static const char* warm_start_string(const PersWarmStart_s* image, uint32_t offset)
+{
+   return (const char*)image + offset;
+}
+
+
+/* check if a string of the image is terminated inside the tables */
+static int warm_start_string_valid(const PersWarmStart_s* image, uint32_t offset)
+{
+   return (   offset < image->dataOffset
+           && memchr((const char*)image + offset, '\0', image->dataOffset - offset) != NULL) ? 1 : 0;
+}
+
+
+static int warm_start_table_valid(const PersWarmStart_s* image, uint32_t offset, uint32_t count, size_t entrySize)
+{
+   return (   (offset % 8) == 0 && offset >= sizeof(PersWarmStart_s)
+           && (uint64_t)offset + (uint64_t)count * entrySize <= image->dataOffset) ? 1 : 0;
+}
+
+
+
+/* check the layout of an image, returns 1 if the image can be used */
+static int warm_start_verify(const PersWarmStart_s* image, size_t size)
+{
+   PersWarmStart_s header;
+   const PersWarmStartValue_s* values = NULL;
+   const PersWarmStartRct_s* rct = NULL;
+   const PersWarmStartStamp_s* stamps = NULL;
+   uint32_t i = 0;
+
+   if(   image->magic != PERS_WARM_START_MAGIC || image->version != PERS_WARM_START_VERSION
+      || image->imageSize != size || image->dataOffset > size || image->dataOffset < sizeof(PersWarmStart_s))
+   {
+      return 0;
+   }
+
+   memcpy(&header, image, sizeof(header));
+   header.crc = 0;
+   if(pclCrc32(pclCrc32(0, (const unsigned char*)&header, sizeof(header)),
+               (const unsigned char*)image + sizeof(header), image->dataOffset - sizeof(header)) != image->crc)
+   {
+      return 0;
+   }
+
+   if(   warm_start_table_valid(image, image->stampOffset, image->stampCount, sizeof(PersWarmStartStamp_s)) == 0
+      || warm_start_table_valid(image, image->rctOffset, image->rctCount, sizeof(PersWarmStartRct_s)) == 0
+      || warm_start_table_valid(image, image->valueOffset, image->valueCount, sizeof(PersWarmStartValue_s)) == 0
+      || (   image->blacklistCount != 0xFFFFFFFFU
+          && warm_start_table_valid(image, image->blacklistOffset, image->blacklistCount, sizeof(uint32_t)) == 0))
+   {
+      return 0;
+   }
+
+   stamps = (const PersWarmStartStamp_s*)((const char*)image + image->stampOffset);
+   for(i = 0; i < image->stampCount; i++)
+   {
+      if(warm_start_string_valid(image, stamps[i].pathOffset) == 0)
+         return 0;
+   }
+
+   rct = (const PersWarmStartRct_s*)((const char*)image + image->rctOffset);
+   for(i = 0; i < image->rctCount; i++)
+   {
+      if(   rct[i].table >= PrctDbTableSize
+         || warm_start_table_valid(image, rct[i].offset, 1, rct[i].size) == 0
+         || rct_index_verify((const PersRctIndex_s*)((const char*)image + rct[i].offset), rct[i].size) == 0)
+      {
+         return 0;
+      }
+   }
+
+   values = (const PersWarmStartValue_s*)((const char*)image + image->valueOffset);
+   for(i = 0; i < image->valueCount; i++)
+   {
+      if(   warm_start_string_valid(image, values[i].keyOffset) == 0
+         || (i > 0 && values[i].hash < values[i-1].hash)
+         || (values[i].size < 0 && values[i].size != EPERS_NOKEY)
+         || (   values[i].size >= 0
+             && (   values[i].dataOffset < image->dataOffset
+                 || (uint64_t)values[i].dataOffset + (uint64_t)values[i].size > size)))
+      {
+         return 0;
+      }
+   }
+
+   return 1;
+}
+
+
+
+static void warm_start_stamp(PersWarmStartStamp_s* stamp, const char* path)
+{
+   struct stat buf;
+
+   if(stat(path, &buf) == 0)
+   {
+      stamp->exists    = 1;
+      stamp->ino       = (uint64_t)buf.st_ino;
+      stamp->size      = (uint64_t)buf.st_size;
+      stamp->mtimeSec  = (int64_t)buf.st_mtim.tv_sec;
+      stamp->mtimeNsec = (int64_t)buf.st_mtim.tv_nsec;
+      stamp->ctimeSec  = (int64_t)buf.st_ctim.tv_sec;
+      stamp->ctimeNsec = (int64_t)buf.st_ctim.tv_nsec;
+   }
+}
+
+
+
+/* check if the files have not been changed since the image has been written */
+static int warm_start_stamps_valid(const PersWarmStart_s* image)
+{
+   const PersWarmStartStamp_s* stamps = (const PersWarmStartStamp_s*)((const char*)image + image->stampOffset);
+   uint32_t i = 0;
+
+   for(i = 0; i < image->stampCount; i++)
+   {
+      PersWarmStartStamp_s current;
+      const char* path = warm_start_string(image, stamps[i].pathOffset);
+
+      memset(&current, 0, sizeof(current));
+      current.pathOffset = stamps[i].pathOffset;
+      warm_start_stamp(&current, path);
+
+      if(memcmp(&current, &stamps[i], sizeof(current)) != 0)
+      {
+         DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("warmStart - changed since snapshot:"), DLT_STRING(path));
+         return 0;
+      }
+   }
+   return 1;
+}
+
+
+
+/* find a value of the image, must be called with the mutex locked, returns the index or -1 */
+static int warm_start_find(int policy, const char* key)
+{
+   int idx = -1;
+
+   if(gWarmStartImage != NULL)
+   {
+      const PersWarmStartValue_s* values = (const PersWarmStartValue_s*)((const char*)gWarmStartImage + gWarmStartImage->valueOffset);
+      uint32_t hash = warm_start_hash(policy, key);
+      uint32_t low = 0, high = gWarmStartImage->valueCount;
+
+      while(low < high)      // first value with the hash
+      {
+         uint32_t mid = low + (high - low) / 2;
+
+         if(values[mid].hash < hash)
+            low = mid + 1;
+         else
+            high = mid;
+      }
+
+      for(; low < gWarmStartImage->valueCount && values[low].hash == hash && idx == -1; low++)
+      {
+         if(   values[low].policy == (uint32_t)policy
+            && strcmp(warm_start_string(gWarmStartImage, values[low].keyOffset), key) == 0)
+         {
+            idx = (int)low;
+         }
+      }
+   }
+   return idx;
+}
+
+
+
+int warm_start_init(const char* filename, int enable)
+{
+   int rval = 0, fd = -1;
+   struct stat buf;
+
+   warm_start_deinit();
+
+   pthread_mutex_lock(&gWarmStartMtx);
+   gWarmStartEnabled = enable;
+   snprintf(gWarmStartFilename, PERS_ORG_MAX_LENGTH_PATH_FILENAME, "%s", filename);
+   gWarmStartBlacklist[0] = '\0';
+
+   if(enable == 1 && (fd = open(filename, O_RDONLY | O_CLOEXEC)) != -1)
+   {
+      if(   fstat(fd, &buf) == 0
+         && buf.st_size >= (off_t)sizeof(PersWarmStart_s) && buf.st_size <= (off_t)WarmStartMaxSize)
+      {
+         void* image = mmap(NULL, (size_t)buf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+         if(image != MAP_FAILED)
+         {
+            const PersWarmStart_s* header = (const PersWarmStart_s*)image;
+
+            if(warm_start_verify(header, (size_t)buf.st_size) == 0)
+            {
+               DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("warmStart - invalid snapshot:"), DLT_STRING(filename));
+            }
+            else if(warm_start_stamps_valid(header) == 1)
+            {
+               gWarmStartValueState = malloc(header->valueCount + 1);
+               if(gWarmStartValueState != NULL)
+               {
+                  const PersWarmStartRct_s* rct = (const PersWarmStartRct_s*)((const char*)image + header->rctOffset);
+                  uint32_t i = 0;
+
+                  memset(gWarmStartValueState, WarmStartValue_Unverified, header->valueCount + 1);
+                  for(i = 0; i < header->rctCount; i++)
+                  {
+                     (void)set_resource_cfg_index((int)rct[i].table, (const PersRctIndex_s*)((const char*)image + rct[i].offset));
+                  }
+
+                  gWarmStartImage = header;
+                  gWarmStartImageSize = (size_t)buf.st_size;
+                  rval = 1;
+
+                  DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("warmStart - using snapshot, values:"), DLT_UINT(header->valueCount),
+                                                        DLT_STRING("indexes:"), DLT_UINT(header->rctCount));
+               }
+            }
+
+            if(rval == 0)
+            {
+               munmap(image, (size_t)buf.st_size);
+               (void)unlink(filename);    // outdated, a new snapshot is written at the next full shutdown
+            }
+         }
+      }
+      close(fd);
+   }
+   pthread_mutex_unlock(&gWarmStartMtx);
+
+   return rval;
+}
+
+
+
+int warm_start_load_blacklist(const char* filename)
+{
+   int rval = 0;
+
+   pthread_mutex_lock(&gWarmStartMtx);
+   if(gWarmStartEnabled == 1)
+   {
+      snprintf(gWarmStartBlacklist, PERS_ORG_MAX_LENGTH_PATH_FILENAME, "%s", filename);
+
+      if(gWarmStartImage != NULL && gWarmStartImage->blacklistCount != 0xFFFFFFFFU)
+      {
+         const uint32_t* keys = (const uint32_t*)((const char*)gWarmStartImage + gWarmStartImage->blacklistOffset);
+
+         if(readBlacklistKeys(keys, gWarmStartImage->blacklistCount) == 0)
+         {
+            rval = 1;
+         }
+      }
+   }
+   pthread_mutex_unlock(&gWarmStartMtx);
+
+   return rval;
+}
+
+
+
+int warm_start_read(int policy, const char* key, unsigned char* buffer, int buffer_size, int* result)
+{
+   int rval = 0;
+
+   if(gWarmStartEnabled == 1)
+   {
+      int idx = -1;
+
+      pthread_mutex_lock(&gWarmStartMtx);
+      idx = warm_start_find(policy, key);
+      if(idx >= 0 && gWarmStartValueState[idx] != WarmStartValue_Invalid)
+      {
+         const PersWarmStartValue_s* value = (const PersWarmStartValue_s*)((const char*)gWarmStartImage + gWarmStartImage->valueOffset) + idx;
+         const unsigned char* data = (const unsigned char*)gWarmStartImage + value->dataOffset;
+
+         if(value->size >= 0 && gWarmStartValueState[idx] == WarmStartValue_Unverified)
+         {
+            if(pclCrc32(0, data, (size_t)value->size) == value->crc)
+            {
+               gWarmStartValueState[idx] = WarmStartValue_Verified;
+            }
+            else
+            {
+               DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("warmStart - checksum mismatch:"), DLT_STRING(key));
+               gWarmStartValueState[idx] = WarmStartValue_Invalid;
+            }
+         }
+
+         if(value->size < 0)
+         {
+            *result = value->size;
+            rval = 1;
+         }
+         else if(gWarmStartValueState[idx] == WarmStartValue_Verified && value->size <= buffer_size)
+         {
+            memcpy(buffer, data, (size_t)value->size);
+            *result = value->size;
+            rval = 1;
+         }
+         // otherwise the buffer is too small, the database decides what to return
+      }
+      pthread_mutex_unlock(&gWarmStartMtx);
+   }
+
+   return rval;
+}
+
+
+
+int warm_start_get_size(int policy, const char* key, int* result)
+{
+   int rval = 0;
+
+   if(gWarmStartEnabled == 1)
+   {
+      int idx = -1;
+
+      pthread_mutex_lock(&gWarmStartMtx);
+      idx = warm_start_find(policy, key);
+      if(idx >= 0 && gWarmStartValueState[idx] != WarmStartValue_Invalid)
+      {
+         *result = ((const PersWarmStartValue_s*)((const char*)gWarmStartImage + gWarmStartImage->valueOffset))[idx].size;
+         rval = 1;
+      }
+      pthread_mutex_unlock(&gWarmStartMtx);
+   }
+
+   return rval;
+}
+
+
+
+void warm_start_record(const PersistenceInfo_s* info, const char* key, const char* resourceID)
+{
+   if(   gWarmStartEnabled == 1
+      && strlen(key) < PERS_DB_MAX_LENGTH_KEY_NAME && strlen(resourceID) < PERS_DB_MAX_LENGTH_KEY_NAME)
+   {
+      uint32_t hash = warm_start_hash(info->configKey.policy, key);
+      int i = 0;
+
+      pthread_mutex_lock(&gWarmStartMtx);
+      if(gWarmStartKeys == NULL)
+      {
+         gWarmStartKeys = malloc(WarmStartMaxKeys * sizeof(WarmStartKey_s));
+      }
+
+      if(gWarmStartKeys != NULL && gWarmStartKeyCount < WarmStartMaxKeys)
+      {
+         for(i = 0; i < gWarmStartKeyCount; i++)
+         {
+            if(   gWarmStartKeys[i].hash == hash
+               && gWarmStartKeys[i].info.configKey.policy == info->configKey.policy
+               && strcmp(gWarmStartKeys[i].key, key) == 0)
+            {
+               break;
+            }
+         }
+
+         if(i == gWarmStartKeyCount)      // the keys read first in a lifecycle are kept
+         {
+            WarmStartKey_s* entry = &gWarmStartKeys[gWarmStartKeyCount++];
+
+            entry->hash = hash;
+            memcpy(&entry->info, info, sizeof(PersistenceInfo_s));
+            strcpy(entry->key, key);
+            strcpy(entry->resourceID, resourceID);
+         }
+      }
+      pthread_mutex_unlock(&gWarmStartMtx);
+   }
+}
+
+
+
+void warm_start_invalidate(int policy, const char* key)
+{
+   if(gWarmStartEnabled == 1)
+   {
+      int idx = -1;
+
+      pthread_mutex_lock(&gWarmStartMtx);
+      idx = warm_start_find(policy, key);
+      if(idx >= 0)
+      {
+         gWarmStartValueState[idx] = WarmStartValue_Invalid;
+      }
+      pthread_mutex_unlock(&gWarmStartMtx);
+   }
+}
+
+
+
+void warm_start_invalidate_all(void)
+{
+   pthread_mutex_lock(&gWarmStartMtx);
+   if(gWarmStartImage != NULL)
+   {
+      memset(gWarmStartValueState, WarmStartValue_Invalid, gWarmStartImage->valueCount + 1);
+   }
+   pthread_mutex_unlock(&gWarmStartMtx);
+}
+
+
+
+static void warm_start_free_collected(void)
+{
+   if(gWarmStartCollected != NULL)
+   {
+      int i = 0;
+
+      for(i = 0; i < gWarmStartCollected->valueCount; i++)
+      {
+         free(gWarmStartCollected->values[i].data);
+      }
+      for(i = 0; i < gWarmStartCollected->rctCount; i++)
+      {
+         free(gWarmStartCollected->rct[i].index);
+      }
+      free(gWarmStartCollected->values);
+      free(gWarmStartCollected->rct);
+      free(gWarmStartCollected->blacklist);
+      free(gWarmStartCollected->keys);
+      free(gWarmStartCollected);
+      gWarmStartCollected = NULL;
+   }
+}
+
+
+
+/* read the current value of a recorded key, returns 1 if the value can be stored */
+static int warm_start_collect_value(const WarmStartKey_s* key, WarmStartItem_s* item)
+{
+   PersistenceInfo_s info;
+   char dbPath[PERS_ORG_MAX_LENGTH_PATH_FILENAME] = {0};
+   int size = 0;
+
+   memcpy(&info, &key->info, sizeof(PersistenceInfo_s));
+   (void)get_db_path_and_key(&info, key->resourceID, NULL, dbPath);
+
+   item->key  = key;
+   item->data = NULL;
+   item->size = persistence_get_data_size(dbPath, (char*)key->key, key->resourceID, &info);
+
+   if(item->size >= 0 && item->size <= WarmStartMaxValueSize)
+   {
+      item->data = malloc((size_t)item->size + 1);
+      if(item->data != NULL)
+      {
+         size = persistence_get_data(dbPath, (char*)key->key, key->resourceID, &info, item->data, item->size);
+      }
+      if(item->data == NULL || size != item->size)
+      {
+         free(item->data);
+         item->data = NULL;
+         return 0;
+      }
+      return 1;
+   }
+
+   return (item->size == EPERS_NOKEY) ? 1 : 0;
+}
+
+
+
+void warm_start_collect(void)
+{
+   int i = 0, count = 0, rctCount = 0;
+
+   if(gWarmStartEnabled == 0)
+   {
+      return;
+   }
+
+   warm_start_free_collected();
+
+   // a write may be in progress, the snapshot must not hold a value older than the database
+   if(pthread_mutex_trylock(&gKeyAPIAccessMtx) != 0)
+   {
+      DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("warmStart - key access in progress, no snapshot"));
+      return;
+   }
+
+   gWarmStartCollected = calloc(1, sizeof(WarmStartCollect_s));
+   if(gWarmStartCollected != NULL)
+   {
+      WarmStartCollect_s* collected = gWarmStartCollected;
+
+      pthread_mutex_lock(&gWarmStartMtx);
+      count = gWarmStartKeyCount;
+      collected->keys = malloc(((size_t)count + 1) * sizeof(WarmStartKey_s));
+      if(collected->keys != NULL && count > 0)
+      {
+         memcpy(collected->keys, gWarmStartKeys, (size_t)count * sizeof(WarmStartKey_s));
+      }
+      pthread_mutex_unlock(&gWarmStartMtx);
+
+      for(i = 0; i < PrctDbTableSize; i++)
+      {
+         char filename[PERS_ORG_MAX_LENGTH_PATH_FILENAME] = {0};
+
+         rctCount += (get_resource_cfg_index(i, filename) != NULL) ? 1 : 0;
+      }
+
+      collected->values = malloc(((size_t)count + 1) * sizeof(WarmStartItem_s));
+      collected->rct    = malloc(((size_t)rctCount + 1) * sizeof(WarmStartRctItem_s));
+
+      if(collected->keys != NULL && collected->values != NULL && collected->rct != NULL)
+      {
+         for(i = 0; i < count; i++)     // the values are read with the mutex unlocked, reading records the keys
+         {
+            if(warm_start_collect_value(&collected->keys[i], &collected->values[collected->valueCount]) == 1)
+            {
+               collected->valueCount++;
+            }
+         }
+
+         for(i = 0; i < PrctDbTableSize && collected->rctCount < rctCount; i++)
+         {
+            WarmStartRctItem_s* item = &collected->rct[collected->rctCount];
+            const PersRctIndex_s* index = get_resource_cfg_index(i, item->filename);
+
+            if(index != NULL && (item->index = malloc(index->imageSize)) != NULL)
+            {
+               memcpy(item->index, index, index->imageSize);
+               item->table = (uint32_t)i;
+               collected->rctCount++;
+            }
+         }
+
+         collected->blacklistCount = getBlacklistKeys(&collected->blacklist);
+      }
+      else
+      {
+         warm_start_free_collected();
+      }
+   }
+
+   pthread_mutex_unlock(&gKeyAPIAccessMtx);
+}
+
+
+
+static int warm_start_item_cmp(const void* p1, const void* p2)
+{
+   uint32_t first  = ((const WarmStartItem_s*)p1)->key->hash;
+   uint32_t second = ((const WarmStartItem_s*)p2)->key->hash;
+
+   return (first > second) - (first < second);
+}
+
+
+
+/* write an image to a temporary file and rename it */
+static int warm_start_write_file(const char* filename, const unsigned char* image, size_t size)
+{
+   int rval = -1;
+   char tmpName[PERS_ORG_MAX_LENGTH_PATH_FILENAME] = {0};
+   int fd = -1;
+
+   snprintf(tmpName, PERS_ORG_MAX_LENGTH_PATH_FILENAME, "%s.tmp", filename);
+
+   fd = open(tmpName, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+   if(fd != -1)
+   {
+      size_t written = 0;
+      ssize_t ret = 0;
+
+      while(written < size && (ret = write(fd, image + written, size - written)) > 0)
+      {
+         written += (size_t)ret;
+      }
+
+      if(written == size && fdatasync(fd) == 0)
+      {
+         rval = 0;
+      }
+      close(fd);
+
+      if(rval == 0 && rename(tmpName, filename) != 0)
+      {
+         rval = -1;
+      }
+      if(rval != 0)
+      {
+         (void)unlink(tmpName);
+      }
+   }
+
+   return rval;
+}
+
+
+
+/* build the image of the collected state, the files are stamped now */
+static int warm_start_build(const WarmStartCollect_s* collected, const char* filename)
+{
+   char dbPaths[PersistenceDB_LastEntry][PERS_ORG_MAX_LENGTH_PATH_FILENAME];
+   const char* paths[PersistenceDB_LastEntry + PrctDbTableSize + 1];
+   size_t stringSize = 0, imageSize = 0, dataSize = 0, rctSize = 0;
+   size_t stampOffset = 0, rctOffset = 0, valueOffset = 0, blacklistOffset = 0, stringOffset = 0, dataOffset = 0;
+   uint32_t blacklistCount = (collected->blacklistCount < 0) ? 0 : (uint32_t)collected->blacklistCount;
+   int numPaths = 0, numValues = 0, i = 0, rval = -1;
+   unsigned char* image = NULL;
+
+   for(i = 0; i < PersistenceDB_LastEntry; i++)     // the local databases
+   {
+      database_get_local_path(i, dbPaths[i]);
+      if(dbPaths[i][0] != '\0')
+      {
+         paths[numPaths++] = dbPaths[i];
+      }
+   }
+   for(i = 0; i < collected->rctCount; i++)
+   {
+      paths[numPaths++] = collected->rct[i].filename;
+      rctSize += warm_start_align(collected->rct[i].index->imageSize);
+   }
+   if(gWarmStartBlacklist[0] != '\0')
+   {
+      paths[numPaths++] = gWarmStartBlacklist;
+   }
+   for(i = 0; i < numPaths; i++)
+   {
+      stringSize += strlen(paths[i]) + 1;
+   }
+
+   // the tables without the values, the values read first are kept if the image gets too big
+   imageSize = sizeof(PersWarmStart_s) + (size_t)numPaths * sizeof(PersWarmStartStamp_s)
+             + (size_t)collected->rctCount * sizeof(PersWarmStartRct_s) + blacklistCount * sizeof(uint32_t)
+             + stringSize + rctSize + 4 * 8;
+   for(numValues = 0; numValues < collected->valueCount; numValues++)
+   {
+      const WarmStartItem_s* item = &collected->values[numValues];
+      size_t valueSize = sizeof(PersWarmStartValue_s) + strlen(item->key->key) + 1 + (size_t)((item->size > 0) ? item->size : 0);
+
+      if(imageSize + valueSize > WarmStartMaxSize)
+         break;
+      imageSize += valueSize;
+      stringSize += strlen(item->key->key) + 1;
+      dataSize += (size_t)((item->size > 0) ? item->size : 0);
+   }
+
+   if(imageSize > WarmStartMaxSize)
+   {
+      DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("warmStart - snapshot too big:"), DLT_UINT((unsigned int)imageSize));
+      return -1;
+   }
+
+   stampOffset     = sizeof(PersWarmStart_s);
+   rctOffset       = warm_start_align(stampOffset + (size_t)numPaths * sizeof(PersWarmStartStamp_s));
+   valueOffset     = warm_start_align(rctOffset + (size_t)collected->rctCount * sizeof(PersWarmStartRct_s));
+   blacklistOffset = warm_start_align(valueOffset + (size_t)numValues * sizeof(PersWarmStartValue_s));
+   stringOffset    = blacklistOffset + blacklistCount * sizeof(uint32_t);
+   dataOffset      = warm_start_align(stringOffset + stringSize) + rctSize;
+   imageSize       = dataOffset + dataSize;
+
+   image = calloc(1, imageSize);
+   if(image != NULL)
+   {
+      PersWarmStart_s* header = (PersWarmStart_s*)image;
+      PersWarmStartStamp_s* stamps = (PersWarmStartStamp_s*)(image + stampOffset);
+      PersWarmStartRct_s* rct = (PersWarmStartRct_s*)(image + rctOffset);
+      PersWarmStartValue_s* values = (PersWarmStartValue_s*)(image + valueOffset);
+      WarmStartItem_s* sorted = malloc(((size_t)numValues + 1) * sizeof(WarmStartItem_s));
+      size_t strings = stringOffset, rctImages = warm_start_align(stringOffset + stringSize), data = dataOffset;
+
+      if(sorted != NULL)
+      {
+         header->magic          = PERS_WARM_START_MAGIC;
+         header->version        = PERS_WARM_START_VERSION;
+         header->imageSize      = (uint32_t)imageSize;
+         header->stampCount     = (uint32_t)numPaths;
+         header->stampOffset    = (uint32_t)stampOffset;
+         header->rctCount       = (uint32_t)collected->rctCount;
+         header->rctOffset      = (uint32_t)rctOffset;
+         header->valueCount     = (uint32_t)numValues;
+         header->valueOffset    = (uint32_t)valueOffset;
+         header->blacklistCount = (collected->blacklistCount < 0) ? 0xFFFFFFFFU : blacklistCount;
+         header->blacklistOffset = (uint32_t)blacklistOffset;
+         header->dataOffset     = (uint32_t)dataOffset;
+
+         for(i = 0; i < numPaths; i++)
+         {
+            stamps[i].pathOffset = (uint32_t)strings;
+            strcpy((char*)image + strings, paths[i]);
+            strings += strlen(paths[i]) + 1;
+            warm_start_stamp(&stamps[i], paths[i]);
+         }
+
+         for(i = 0; i < collected->rctCount; i++)
+         {
+            rct[i].table  = collected->rct[i].table;
+            rct[i].offset = (uint32_t)rctImages;
+            rct[i].size   = collected->rct[i].index->imageSize;
+            memcpy(image + rctImages, collected->rct[i].index, rct[i].size);
+            rctImages += warm_start_align(rct[i].size);
+         }
+
+         memcpy(sorted, collected->values, (size_t)numValues * sizeof(WarmStartItem_s));
+         qsort(sorted, (size_t)numValues, sizeof(WarmStartItem_s), warm_start_item_cmp);
+         for(i = 0; i < numValues; i++)
+         {
+            values[i].hash      = sorted[i].key->hash;
+            values[i].policy    = (uint32_t)sorted[i].key->info.configKey.policy;
+            values[i].keyOffset = (uint32_t)strings;
+            values[i].size      = sorted[i].size;
+            strcpy((char*)image + strings, sorted[i].key->key);
+            strings += strlen(sorted[i].key->key) + 1;
+
+            if(sorted[i].size >= 0)
+            {
+               values[i].dataOffset = (uint32_t)data;
+               values[i].crc        = pclCrc32(0, sorted[i].data, (size_t)sorted[i].size);
+               memcpy(image + data, sorted[i].data, (size_t)sorted[i].size);
+               data += (size_t)sorted[i].size;
+            }
+         }
+
+         if(blacklistCount > 0)
+         {
+            memcpy(image + blacklistOffset, collected->blacklist, blacklistCount * sizeof(uint32_t));
+         }
+
+         header->crc = pclCrc32(0, image, dataOffset);
+
+         rval = warm_start_write_file(filename, image, imageSize);
+         if(rval == 0)
+         {
+            DLT_LOG(gPclDLTContext, DLT_LOG_INFO, DLT_STRING("warmStart - snapshot written, values:"), DLT_INT(numValues),
+                                                  DLT_STRING("indexes:"), DLT_INT(collected->rctCount),
+                                                  DLT_STRING("size:"), DLT_UINT((unsigned int)imageSize));
+         }
+         else
+         {
+            DLT_LOG(gPclDLTContext, DLT_LOG_WARN, DLT_STRING("warmStart - failed to write snapshot:"), DLT_STRING(filename));
+         }
+         free(sorted);
+      }
+      free(image);
+   }
+
+   return rval;
+}
+
+
+
+int warm_start_write(int write)
+{
+   int rval = 0;
+
+   if(gWarmStartCollected != NULL)
+   {
+      if(write == 1)
+      {
+         rval = warm_start_build(gWarmStartCollected, gWarmStartFilename);
+      }
+      warm_start_free_collected();
+   }
+
+   return rval;
+}
+
+
+
+void warm_start_release(void)
+{
+   pthread_mutex_lock(&gWarmStartMtx);
+   if(gWarmStartImage != NULL)
+   {
+      const PersWarmStartRct_s* rct = (const PersWarmStartRct_s*)((const char*)gWarmStartImage + gWarmStartImage->rctOffset);
+      uint32_t i = 0;
+
+      for(i = 0; i < gWarmStartImage->rctCount; i++)      // the indexes are part of the image
+      {
+         unset_resource_cfg_index((int)rct[i].table, (const PersRctIndex_s*)((const char*)gWarmStartImage + rct[i].offset));
+      }
+
+      munmap((void*)gWarmStartImage, gWarmStartImageSize);
+      gWarmStartImage = NULL;
+      gWarmStartImageSize = 0;
+      free(gWarmStartValueState);
+      gWarmStartValueState = NULL;
+   }
+   pthread_mutex_unlock(&gWarmStartMtx);
+}
+
+
+
+void warm_start_deinit(void)
+{
+   warm_start_release();
+   warm_start_free_collected();
+
+   pthread_mutex_lock(&gWarmStartMtx);
+   free(gWarmStartKeys);
+   gWarmStartKeys = NULL;
+   gWarmStartKeyCount = 0;
+   gWarmStartEnabled = 0;
+   pthread_mutex_unlock(&gWarmStartMtx);
+}
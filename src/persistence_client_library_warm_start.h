@@ -0,0 +1,241 @@
+#ifndef PERSISTENCE_CLIENT_LIBRARY_WARM_START_H
+#define PERSISTENCE_CLIENT_LIBRARY_WARM_START_H
+
+/******************************************************************************
+ * Project         Persistency
+ * (c) copyright   2012
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+******************************************************************************/
+ /**
+ * @file           persistence_client_library_warm_start.h
+ * @ingroup        Persistence client library
+ * @author         Ingo Huerner
+ * @brief          Header of the warm start snapshot.
+ *                 At a full shutdown the resolved state of the application is written
+ *                 into one read only image: the resource configuration table indexes built
+ *                 from the tables, the values of the local keys read in the lifecycle and
+ *                 the parsed backup blacklist.
+ *                 The image is mapped by the next ::pclInitLibrary and used as long as the
+ *                 databases, tables and the blacklist have not been changed since the image
+ *                 has been written (size, inode and modification time of the files).
+ *                 Enabled with ::PCL_INIT_WARM_START.
+ * @see
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "persistence_client_library_data_organization.h"
+
+#include <stdint.h>
+
+
+/// magic number of a warm start image ("PCWS")
+#define PERS_WARM_START_MAGIC    (0x53574350U)
+/// version of the warm start image layout
+#define PERS_WARM_START_VERSION  (0x00010000U)
+
+
+/// header of a warm start image, all offsets are relative to the start of the image
+typedef struct _PersWarmStart_s
+{
+   /// magic number, see ::PERS_WARM_START_MAGIC
+   uint32_t magic;
+   /// image layout version, see ::PERS_WARM_START_VERSION
+   uint32_t version;
+   /// size of the complete image in bytes
+   uint32_t imageSize;
+   /// crc32 of the image up to dataOffset, calculated with crc set to 0
+   uint32_t crc;
+   /// number of file stamps
+   uint32_t stampCount;
+   /// offset of the file stamps (PersWarmStartStamp_s[stampCount])
+   uint32_t stampOffset;
+   /// number of resource configuration table indexes
+   uint32_t rctCount;
+   /// offset of the index entries (PersWarmStartRct_s[rctCount])
+   uint32_t rctOffset;
+   /// number of values
+   uint32_t valueCount;
+   /// offset of the value entries sorted by hash (PersWarmStartValue_s[valueCount])
+   uint32_t valueOffset;
+   /// number of blacklist keys, 0xFFFFFFFF if there was no blacklist
+   uint32_t blacklistCount;
+   /// offset of the blacklist keys (uint32_t[blacklistCount])
+   uint32_t blacklistOffset;
+   /// offset of the value data, the value data is protected by the crc of each value
+   uint32_t dataOffset;
+   /// reserved, 0
+   uint32_t reserved;
+} PersWarmStart_s;
+
+
+/// state of a file when the image has been written
+typedef struct _PersWarmStartStamp_s
+{
+   /// offset of the file name
+   uint32_t pathOffset;
+   /// 1 if the file existed, 0 if not
+   uint32_t exists;
+   /// inode number
+   uint64_t ino;
+   /// size of the file
+   uint64_t size;
+   /// modification time, seconds
+   int64_t mtimeSec;
+   /// modification time, nanoseconds
+   int64_t mtimeNsec;
+   /// status change time, seconds
+   int64_t ctimeSec;
+   /// status change time, nanoseconds
+   int64_t ctimeNsec;
+} PersWarmStartStamp_s;
+
+
+/// resource configuration table index of a warm start image
+typedef struct _PersWarmStartRct_s
+{
+   /// the resource configuration table index, see ::get_resource_cfg_table_by_idx
+   uint32_t table;
+   /// offset of the index image
+   uint32_t offset;
+   /// size of the index image
+   uint32_t size;
+   /// reserved, 0
+   uint32_t reserved;
+} PersWarmStartRct_s;
+
+
+/// key value of a warm start image
+typedef struct _PersWarmStartValue_s
+{
+   /// hash of the policy and the database key
+   uint32_t hash;
+   /// the policy of the database
+   uint32_t policy;
+   /// offset of the database key
+   uint32_t keyOffset;
+   /// size of the value or EPERS_NOKEY if the key had no value
+   int32_t size;
+   /// offset of the value data
+   uint32_t dataOffset;
+   /// crc32 of the value data
+   uint32_t crc;
+} PersWarmStartValue_s;
+
+
+/**
+ * @brief enable the warm start snapshot and map the image written at the last full shutdown.
+ *        Must be called before any database or resource configuration table will be opened.
+ *
+ * @param filename the file name of the image
+ * @param enable 1 to enable, 0 to disable
+ *
+ * @return 1 if the image is up to date and will be used, 0 if not
+ */
+int warm_start_init(const char* filename, int enable);
+
+
+/**
+ * @brief create the backup blacklist from the image, the blacklist file will be read if the image has no blacklist
+ *
+ * @param filename the file name of the blacklist configuration file
+ *
+ * @return 1 if the blacklist has been created from the image, 0 if the file has to be read
+ */
+int warm_start_load_blacklist(const char* filename);
+
+
+/**
+ * @brief read the value of a local key from the image, no backend will be accessed
+ *
+ * @param policy the policy of the database
+ * @param key the database key
+ * @param buffer the buffer to store the value
+ * @param buffer_size the size of the buffer
+ * @param result pointer to store the number of bytes read or EPERS_NOKEY
+ *
+ * @return 1 if the result has been taken from the image, 0 if the backend has to be read
+ */
+int warm_start_read(int policy, const char* key, unsigned char* buffer, int buffer_size, int* result);
+
+
+/**
+ * @brief get the size of the value of a local key from the image, no backend will be accessed
+ *
+ * @param policy the policy of the database
+ * @param key the database key
+ * @param result pointer to store the size of the value or EPERS_NOKEY
+ *
+ * @return 1 if the result has been taken from the image, 0 if the backend has to be read
+ */
+int warm_start_get_size(int policy, const char* key, int* result);
+
+
+/**
+ * @brief remember a local key read by the application, the value will be part of the next image
+ *
+ * @param info the persistence info of the key
+ * @param key the database key
+ * @param resourceID the resource ID
+ */
+void warm_start_record(const PersistenceInfo_s* info, const char* key, const char* resourceID);
+
+
+/**
+ * @brief don't use the value of a key from the image anymore, e.g. because the key has been written
+ *
+ * @param policy the policy of the database
+ * @param key the database key
+ */
+void warm_start_invalidate(int policy, const char* key);
+
+
+/**
+ * @brief don't use any value of the image anymore, e.g. because the default values have been changed
+ */
+void warm_start_invalidate_all(void);
+
+
+/**
+ * @brief read the current values of the recorded keys and copy the resource configuration table indexes,
+ *        must be called before the databases and tables will be closed.
+ *        Nothing will be collected if a key API call is in progress.
+ */
+void warm_start_collect(void);
+
+
+/**
+ * @brief write the collected state into a new image, must be called after the databases have been closed.
+ *        The collected state will be discarded if write is 0.
+ *
+ * @param write 1 to write the image, 0 to discard the collected state
+ *
+ * @return 0 on success or if nothing has been collected, -1 if the image could not be written
+ */
+int warm_start_write(int write);
+
+
+/**
+ * @brief unmap the image, called when the databases and tables will be closed
+ */
+void warm_start_release(void);
+
+
+/**
+ * @brief release the image, the recorded keys and the collected state
+ */
+void warm_start_deinit(void);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PERSISTENCE_CLIENT_LIBRARY_WARM_START_H */
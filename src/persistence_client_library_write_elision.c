@@ -0,0 +1,193 @@
+/******************************************************************************
+ * Project         Persistency
+ * (c) copyright   2012
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+******************************************************************************/
+ /**
+ * @file           persistence_client_library_write_elision.c
+ * @ingroup        Persistence client library
+ * @author         Ingo Huerner
+ * @brief          Implementation of the write elision.
+ *                 The known values are stored in an intrusive red black tree
+ *                 ordered by database handle and key.
+ * @see
+ */
+
+#include "persistence_client_library_write_elision.h"
+#include "persistence_client_library_data_organization.h"
+#include "rbtree.h"
+#include "crc32.h"
+
+#include <pthread.h>
+#include <string.h>
+
+
+/// last written value of a key
+typedef struct _WriteElisionEntry_s
+{
+   /// the database handle
+   int handleDB;
+   /// the size of the value
+   int size;
+   /// crc32 of the value
+   uint32_t crc;
+   /// the database key
+   char key[PERS_DB_MAX_LENGTH_KEY_NAME];
+} WriteElisionEntry_s;
+
+
+/// tree holding the last written values
+static jsw_rbtree_t* gWriteElisionTree = NULL;
+/// mutex protecting the tree and the statistics
+static pthread_mutex_t gWriteElisionMtx = PTHREAD_MUTEX_INITIALIZER;
+/// flag to indicate if the write elision is enabled
+static int gWriteElisionEnabled = 0;
+/// statistics of the skipped writes
+static pclWriteElisionStats_s gWriteElisionStats = {0};
+
+
+
+static int write_elision_cmp(const void *p1, const void *p2)
+{
+   const WriteElisionEntry_s* first  = (const WriteElisionEntry_s*)p1;
+   const WriteElisionEntry_s* second = (const WriteElisionEntry_s*)p2;
+   int rval = (first->handleDB > second->handleDB) - (first->handleDB < second->handleDB);
+
+   if(rval == 0)
+   {
+      rval = strcmp(first->key, second->key);
+   }
+   return (rval > 0) - (rval < 0);
+}
+
+
+
+void write_elision_enable(int enable)
+{
+   pthread_mutex_lock(&gWriteElisionMtx);
+   gWriteElisionEnabled = enable;
+   memset(&gWriteElisionStats, 0, sizeof(gWriteElisionStats));
+   if(gWriteElisionTree != NULL)
+   {
+      jsw_rbdelete(gWriteElisionTree);
+      gWriteElisionTree = NULL;
+   }
+   pthread_mutex_unlock(&gWriteElisionMtx);
+}
+
+
+
+int write_elision_check(int handleDB, const char* key, const unsigned char* data, int size, uint32_t* crc)
+{
+   int rval = 0;
+
+   if(gWriteElisionEnabled == 1 && size >= 0 && strlen(key) < PERS_DB_MAX_LENGTH_KEY_NAME)
+   {
+      WriteElisionEntry_s search;
+
+      *crc = pclCrc32(0, data, (size_t)size);
+
+      search.handleDB = handleDB;
+      strcpy(search.key, key);
+
+      pthread_mutex_lock(&gWriteElisionMtx);
+      if(gWriteElisionTree != NULL)
+      {
+         const WriteElisionEntry_s* entry = jsw_rbfind(gWriteElisionTree, &search);
+
+         if(entry != NULL && entry->size == size && entry->crc == *crc)
+         {
+            gWriteElisionStats.writes++;
+            gWriteElisionStats.bytes += (unsigned long long)size;
+            rval = 1;
+         }
+      }
+      pthread_mutex_unlock(&gWriteElisionMtx);
+   }
+
+   return rval;
+}
+
+
+
+void write_elision_update(int handleDB, const char* key, uint32_t crc, int size)
+{
+   if(gWriteElisionEnabled == 1 && strlen(key) < PERS_DB_MAX_LENGTH_KEY_NAME)
+   {
+      WriteElisionEntry_s search;
+
+      search.handleDB = handleDB;
+      search.size     = size;
+      search.crc      = crc;
+      strcpy(search.key, key);
+
+      pthread_mutex_lock(&gWriteElisionMtx);
+      if(gWriteElisionTree == NULL)
+      {
+         gWriteElisionTree = jsw_rbnew_intrusive(write_elision_cmp, sizeof(WriteElisionEntry_s), 0);
+      }
+
+      if(gWriteElisionTree != NULL)
+      {
+         WriteElisionEntry_s* entry = jsw_rbfind(gWriteElisionTree, &search);
+
+         if(entry != NULL)
+         {
+            entry->size = size;
+            entry->crc  = crc;
+         }
+         else if(jsw_rbsize(gWriteElisionTree) < WriteElisionMaxKeys)
+         {
+            (void)jsw_rbinsert(gWriteElisionTree, &search);
+         }
+      }
+      pthread_mutex_unlock(&gWriteElisionMtx);
+   }
+}
+
+
+
+void write_elision_remove(int handleDB, const char* key)
+{
+   if(gWriteElisionEnabled == 1 && strlen(key) < PERS_DB_MAX_LENGTH_KEY_NAME)
+   {
+      WriteElisionEntry_s search;
+
+      search.handleDB = handleDB;
+      strcpy(search.key, key);
+
+      pthread_mutex_lock(&gWriteElisionMtx);
+      if(gWriteElisionTree != NULL)
+      {
+         (void)jsw_rberase(gWriteElisionTree, &search);
+      }
+      pthread_mutex_unlock(&gWriteElisionMtx);
+   }
+}
+
+
+
+void write_elision_clear(void)
+{
+   pthread_mutex_lock(&gWriteElisionMtx);
+   if(gWriteElisionTree != NULL)
+   {
+      jsw_rbdelete(gWriteElisionTree);
+      gWriteElisionTree = NULL;
+   }
+   pthread_mutex_unlock(&gWriteElisionMtx);
+}
+
+
+
+void write_elision_get_stats(pclWriteElisionStats_s* stats)
+{
+   pthread_mutex_lock(&gWriteElisionMtx);
+   *stats = gWriteElisionStats;
+   pthread_mutex_unlock(&gWriteElisionMtx);
+}
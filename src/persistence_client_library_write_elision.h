@@ -0,0 +1,98 @@
+#ifndef PERSISTENCE_CLIENT_LIBRARY_WRITE_ELISION_H
+#define PERSISTENCE_CLIENT_LIBRARY_WRITE_ELISION_H
+
+/******************************************************************************
+ * Project         Persistency
+ * (c) copyright   2012
+ * Company         XS Embedded GmbH
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+******************************************************************************/
+ /**
+ * @file           persistence_client_library_write_elision.h
+ * @ingroup        Persistence client library
+ * @author         Ingo Huerner
+ * @brief          Header of the write elision.
+ *                 The crc32 and the size of the last value written to a key are
+ *                 kept in memory, writing the same value again is skipped.
+ *                 Only values written by this application are known, so the
+ *                 first write of a key after the database has been opened is
+ *                 never skipped. Shared keys are written by other applications
+ *                 too, their writes are never skipped.
+ * @see
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "../include/persistence_client_library_key.h"
+
+#include <stdint.h>
+
+
+/**
+ * @brief enable or disable the write elision, all known values and the statistics are discarded
+ *
+ * @param enable 1 to enable, 0 to disable
+ */
+void write_elision_enable(int enable);
+
+
+/**
+ * @brief check if the value of a key is the same as the last written value
+ *        and update the statistics if it is
+ *
+ * @param handleDB the database handle
+ * @param key the database key
+ * @param data the data to write
+ * @param size the size of the data
+ * @param crc pointer to store the crc32 of the data, used for ::write_elision_update
+ *
+ * @return 1 if the write can be skipped, 0 if not
+ */
+int write_elision_check(int handleDB, const char* key, const unsigned char* data, int size, uint32_t* crc);
+
+
+/**
+ * @brief remember the value written to a key
+ *
+ * @param handleDB the database handle
+ * @param key the database key
+ * @param crc the crc32 returned by ::write_elision_check
+ * @param size the size of the data
+ */
+void write_elision_update(int handleDB, const char* key, uint32_t crc, int size);
+
+
+/**
+ * @brief forget the value of a key, e.g. because the key has been deleted
+ *
+ * @param handleDB the database handle
+ * @param key the database key
+ */
+void write_elision_remove(int handleDB, const char* key);
+
+
+/**
+ * @brief forget all values, must be called when the databases will be closed
+ */
+void write_elision_clear(void);
+
+
+/**
+ * @brief get the statistics of the skipped writes
+ *
+ * @param stats pointer to store the statistics
+ */
+void write_elision_get_stats(pclWriteElisionStats_s* stats);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PERSISTENCE_CLIENT_LIBRARY_WRITE_ELISION_H */
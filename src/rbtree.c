@@ -44,18 +44,29 @@
 
 #ifdef __cplusplus
 #include <cstdlib>
+#include <cstring>
 
 using std::malloc;
 using std::free;
 using std::size_t;
+using std::memcpy;
 #else
 #include <stdlib.h>
+#include <string.h>
 #endif
 
 #ifndef HEIGHT_LIMIT
 #define HEIGHT_LIMIT 256 /* Tallest allowable tree */
 #endif
 
+#ifndef POOL_CHUNK
+#define POOL_CHUNK 32    /* Default number of nodes per pool block */
+#endif
+
+/* Round a size up so that embedded items are suitably aligned */
+typedef union jsw_rbalign { void *p; long l; double d; long double ld; } jsw_rbalign_t;
+#define ALIGN_UP(s) ( ( (s) + sizeof ( jsw_rbalign_t ) - 1 ) & ~( sizeof ( jsw_rbalign_t ) - 1 ) )
+
 
 typedef struct jsw_rbnode {
   int                red;     /* Color (1=red, 0=black) */
@@ -63,12 +74,21 @@ typedef struct jsw_rbnode {
   struct jsw_rbnode *link[2]; /* Left (0) and right (1) links */
 } jsw_rbnode_t;
 
+typedef struct jsw_rbblock {
+  struct jsw_rbblock *next;   /* Next pool block of the same tree */
+} jsw_rbblock_t;
+
 struct jsw_rbtree {
-  jsw_rbnode_t *root; /* Top of the tree */
-  cmp_f         cmp;  /* Compare two items */
-  dup_f         dup;  /* Clone an item (user-defined) */
-  rel_f         rel;  /* Destroy an item (user-defined) */
-  size_t        size; /* Number of items (user-defined) */
+  jsw_rbnode_t  *root;      /* Top of the tree */
+  cmp_f          cmp;       /* Compare two items */
+  dup_f          dup;       /* Clone an item (user-defined, may be NULL) */
+  rel_f          rel;       /* Destroy an item (user-defined, may be NULL) */
+  size_t         size;      /* Number of items (user-defined) */
+  size_t         item_size; /* Size of an embedded item (0 = item stored by pointer) */
+  size_t         node_size; /* Size of one pool slot (node + embedded item) */
+  size_t         chunk;     /* Number of nodes allocated per pool block */
+  jsw_rbnode_t  *free_list; /* Released nodes, linked through link[0] */
+  jsw_rbblock_t *blocks;    /* Pool blocks owned by this tree */
 };
 
 struct jsw_rbtrav {
@@ -136,6 +156,59 @@ static jsw_rbnode_t *jsw_double ( jsw_rbnode_t *root, int dir )
   return jsw_single ( root, dir );
 }
 
+/**
+  <summary>
+  Takes a node from the tree's node pool, allocating
+  a new pool block if no released node is available
+  <summary>
+  <param name="tree">The red black tree owning the pool</param>
+  <returns>A pointer to an uninitialized node, or NULL</returns>
+  <remarks>For jsw_rbtree.c internal use only</remarks>
+*/
+static jsw_rbnode_t *pool_get ( jsw_rbtree_t *tree )
+{
+  jsw_rbnode_t *rn = tree->free_list;
+
+  if ( rn == NULL ) {
+    size_t i;
+    size_t hdr = ALIGN_UP ( sizeof ( jsw_rbblock_t ) );
+    jsw_rbblock_t *block = (jsw_rbblock_t *)malloc ( hdr + tree->chunk * tree->node_size );
+
+    if ( block == NULL )
+      return NULL;
+
+    block->next = tree->blocks;
+    tree->blocks = block;
+
+    /* Chain all new slots into the free list */
+    for ( i = 0; i < tree->chunk; i++ ) {
+      jsw_rbnode_t *slot = (jsw_rbnode_t *)( (char *)block + hdr + i * tree->node_size );
+      slot->link[0] = tree->free_list;
+      tree->free_list = slot;
+    }
+
+    rn = tree->free_list;
+  }
+
+  tree->free_list = rn->link[0];
+
+  return rn;
+}
+
+/**
+  <summary>
+  Returns a node to the tree's node pool
+  <summary>
+  <param name="tree">The red black tree owning the pool</param>
+  <param name="node">The node to release</param>
+  <remarks>For jsw_rbtree.c internal use only</remarks>
+*/
+static void pool_put ( jsw_rbtree_t *tree, jsw_rbnode_t *node )
+{
+  node->link[0] = tree->free_list;
+  tree->free_list = node;
+}
+
 /**
   <summary>
   Creates an initializes a new red black node with a copy of
@@ -146,38 +219,54 @@ static jsw_rbnode_t *jsw_double ( jsw_rbnode_t *root, int dir )
   <returns>A pointer to the new node</returns>
   <remarks>
   For jsw_rbtree.c internal use only. The data for this node must
-  be freed using the same tree's rel function. The returned pointer
-  must be freed using C's free function
+  be freed using the same tree's rel function. The returned node
+  must be given back with pool_put.
+  For intrusive trees the item is copied into the node itself,
+  without a dup call; otherwise the item is duplicated with dup,
+  or stored as the given pointer if the tree has no dup function
   </remarks>
 */
 static jsw_rbnode_t *new_node ( jsw_rbtree_t *tree, void *data )
 {
-  jsw_rbnode_t *rn = (jsw_rbnode_t *)malloc ( sizeof *rn );
+  jsw_rbnode_t *rn = pool_get ( tree );
 
   if ( rn == NULL )
     return NULL;
 
   rn->red = 1;
-  rn->data = tree->dup ( data );
   rn->link[0] = rn->link[1] = NULL;
 
+  if ( tree->item_size != 0 ) {
+    rn->data = (char *)rn + ALIGN_UP ( sizeof ( jsw_rbnode_t ) );
+    memcpy ( rn->data, data, tree->item_size );
+  }
+  else if ( tree->dup != NULL ) {
+    rn->data = tree->dup ( data );
+
+    if ( rn->data == NULL ) {
+      pool_put ( tree, rn );
+      return NULL;
+    }
+  }
+  else
+    rn->data = data;
+
   return rn;
 }
 
 /**
   <summary>
-  Creates and initializes an empty red black tree with
-  user-defined comparison, data copy, and data release operations
+  Creates and initializes an empty red black tree
   <summary>
   <param name="cmp">User-defined data comparison function</param>
-  <param name="dup">User-defined data copy function</param>
-  <param name="rel">User-defined data release function</param>
+  <param name="dup">User-defined data copy function (may be NULL)</param>
+  <param name="rel">User-defined data release function (may be NULL)</param>
+  <param name="itemSize">Size of an embedded item, 0 to store items by pointer</param>
+  <param name="chunk">Number of nodes per pool block, 0 for the default</param>
   <returns>A pointer to the new tree</returns>
-  <remarks>
-  The returned pointer must be released with jsw_rbdelete
-  </remarks>
+  <remarks>For jsw_rbtree.c internal use only</remarks>
 */
-jsw_rbtree_t *jsw_rbnew ( cmp_f cmp, dup_f dup, rel_f rel )
+static jsw_rbtree_t *new_tree ( cmp_f cmp, dup_f dup, rel_f rel, size_t itemSize, size_t chunk )
 {
   jsw_rbtree_t *rt = (jsw_rbtree_t *)malloc ( sizeof *rt );
 
@@ -189,10 +278,74 @@ jsw_rbtree_t *jsw_rbnew ( cmp_f cmp, dup_f dup, rel_f rel )
   rt->dup = dup;
   rt->rel = rel;
   rt->size = 0;
+  rt->item_size = itemSize;
+  rt->node_size = ALIGN_UP ( sizeof ( jsw_rbnode_t ) ) + ALIGN_UP ( itemSize );
+  rt->chunk = chunk != 0 ? chunk : POOL_CHUNK;
+  rt->free_list = NULL;
+  rt->blocks = NULL;
 
   return rt;
 }
 
+/**
+  <summary>
+  Creates and initializes an empty red black tree with
+  user-defined comparison, data copy, and data release operations
+  <summary>
+  <param name="cmp">User-defined data comparison function</param>
+  <param name="dup">User-defined data copy function</param>
+  <param name="rel">User-defined data release function</param>
+  <returns>A pointer to the new tree</returns>
+  <remarks>
+  The returned pointer must be released with jsw_rbdelete
+  </remarks>
+*/
+jsw_rbtree_t *jsw_rbnew ( cmp_f cmp, dup_f dup, rel_f rel )
+{
+  return new_tree ( cmp, dup, rel, 0, 0 );
+}
+
+/**
+  <summary>
+  Creates and initializes an empty red black tree with
+  user-defined comparison, data copy, and data release operations
+  and an explicit number of nodes per pool block
+  <summary>
+  <param name="cmp">User-defined data comparison function</param>
+  <param name="dup">User-defined data copy function, NULL to store the item pointer</param>
+  <param name="rel">User-defined data release function, NULL for none</param>
+  <param name="chunk">Number of nodes allocated at once, 0 for the default</param>
+  <returns>A pointer to the new tree</returns>
+  <remarks>
+  The returned pointer must be released with jsw_rbdelete
+  </remarks>
+*/
+jsw_rbtree_t *jsw_rbnew_pool ( cmp_f cmp, dup_f dup, rel_f rel, size_t chunk )
+{
+  return new_tree ( cmp, dup, rel, 0, chunk );
+}
+
+/**
+  <summary>
+  Creates and initializes an empty intrusive red black tree.
+  Items of itemSize bytes are embedded in the pooled tree nodes,
+  so no dup/rel calls and no per item allocation take place
+  <summary>
+  <param name="cmp">User-defined data comparison function</param>
+  <param name="itemSize">Size of one item in bytes</param>
+  <param name="chunk">Number of nodes allocated at once, 0 for the default</param>
+  <returns>A pointer to the new tree</returns>
+  <remarks>
+  Pointers returned by jsw_rbfind stay valid and may be modified
+  in place (except for the compared key) until the item is erased.
+  The returned pointer must be released with jsw_rbdelete
+  </remarks>
+*/
+jsw_rbtree_t *jsw_rbnew_intrusive ( cmp_f cmp, size_t itemSize, size_t chunk )
+{
+  return new_tree ( cmp, NULL, NULL, itemSize, chunk );
+}
+
 
 /**
   <summary>
@@ -257,6 +410,7 @@ int jsw_rbinsert ( jsw_rbtree_t *tree, void *data )
 	  else {
 
 		jsw_rbnode_t head = {0, NULL, {NULL, NULL} }; /* False tree root */
+		jsw_rbnode_t *n = NULL;  /* Newly created node */
 		jsw_rbnode_t *g, *t;     /* Grandparent & parent */
 		jsw_rbnode_t *p, *q;     /* Iterator & parent */
 		int dir = 0, last = 0;
@@ -272,7 +426,7 @@ int jsw_rbinsert ( jsw_rbtree_t *tree, void *data )
 		  if ( q == NULL )
 		  {
 			/* Insert a new node at the first null link */
-			p->link[dir] = q = new_node ( tree, data );
+			p->link[dir] = q = n = new_node ( tree, data );
 
 			if ( q == NULL )
 			  return 0;
@@ -316,6 +470,13 @@ int jsw_rbinsert ( jsw_rbtree_t *tree, void *data )
 
 		/* Update the root (it may be different) */
 		tree->root = head.link[1];
+
+		/* Duplicates are not stored and not counted */
+		if ( n == NULL )
+		{
+		  tree->root->red = 0;
+		  return 1;
+		}
 	  }
 
 	  /* Make the root black for simplified logic */
@@ -354,8 +515,8 @@ void jsw_rbdelete ( jsw_rbtree_t *tree )
     if ( it->link[0] == NULL ) {
       /* No left links, just kill the node and move on */
       save = it->link[1];
-      tree->rel ( it->data );
-      free ( it );
+      if ( tree->rel != NULL )
+        tree->rel ( it->data );
     }
     else {
       /* Rotate away the left link and check again */
@@ -367,6 +528,13 @@ void jsw_rbdelete ( jsw_rbtree_t *tree )
     it = save;
   }
 
+  /* All nodes live in the pool blocks */
+  while ( tree->blocks != NULL ) {
+    jsw_rbblock_t *next = tree->blocks->next;
+    free ( tree->blocks );
+    tree->blocks = next;
+  }
+
   free ( tree );
 }
 
@@ -462,10 +630,35 @@ int jsw_rberase ( jsw_rbtree_t *tree, void *data )
     /* Replace and remove the saved node */
     if ( f != NULL )
     {
-      tree->rel( f->data );
-      f->data = q->data;
+      /* Unlink the in-order neighbour q */
       p->link[p->link[1] == q] = q->link[q->link[0] == NULL];
-      free ( q );
+
+      /*
+        Move node q into the place of f instead of copying
+        the data, so items of intrusive trees never move
+      */
+      if ( f != q )
+      {
+        jsw_rbnode_t *fp = &head;
+        int fdir = 1;
+
+        /* Locate the parent of f, f is still linked */
+        while ( fp->link[fdir] != f ) {
+          fp = fp->link[fdir];
+          fdir = tree->cmp ( fp->data, f->data ) < 0;
+        }
+
+        fp->link[fdir] = q;
+        q->red = f->red;
+        q->link[0] = f->link[0];
+        q->link[1] = f->link[1];
+      }
+
+      if ( tree->rel != NULL )
+        tree->rel ( f->data );
+
+      pool_put ( tree, f );
+      --tree->size;
     }
 
     /* Update the root (it may be different) */
@@ -475,10 +668,10 @@ int jsw_rberase ( jsw_rbtree_t *tree, void *data )
     if ( tree->root != NULL )
       tree->root->red = 0;
 
-    --tree->size;
+    return f != NULL;
   }
 
-  return 1;
+  return 0;
 }
 
 /**
@@ -492,7 +685,7 @@ size_t jsw_rbsize ( jsw_rbtree_t *tree )
 {
   return tree->size;
 }
-#if 0
+
 /**
   <summary>
   Create a new traversal object
@@ -646,6 +839,3 @@ void *jsw_rbtprev ( jsw_rbtrav_t *trav )
 {
   return move ( trav, 0 ); /* Toward smaller items */
 }
-
-
-#endif
@@ -77,6 +77,8 @@ typedef void  (*rel_f) ( void *p );
 
 /* Red Black tree functions */
 jsw_rbtree_t *jsw_rbnew ( cmp_f cmp, dup_f dup, rel_f rel );
+jsw_rbtree_t *jsw_rbnew_pool ( cmp_f cmp, dup_f dup, rel_f rel, size_t chunk );
+jsw_rbtree_t *jsw_rbnew_intrusive ( cmp_f cmp, size_t itemSize, size_t chunk );
 void          jsw_rbdelete ( jsw_rbtree_t *tree );
 void         *jsw_rbfind ( jsw_rbtree_t *tree, void *data );
 int           jsw_rbinsert ( jsw_rbtree_t *tree, void *data );
@@ -84,12 +86,12 @@ int           jsw_rberase ( jsw_rbtree_t *tree, void *data );
 size_t        jsw_rbsize ( jsw_rbtree_t *tree );
 
 /* Traversal functions */
-//jsw_rbtrav_t *jsw_rbtnew ( void );
-//void          jsw_rbtdelete ( jsw_rbtrav_t *trav );
-//void         *jsw_rbtfirst ( jsw_rbtrav_t *trav, jsw_rbtree_t *tree );
-//void         *jsw_rbtlast ( jsw_rbtrav_t *trav, jsw_rbtree_t *tree );
-//void         *jsw_rbtnext ( jsw_rbtrav_t *trav );
-//void         *jsw_rbtprev ( jsw_rbtrav_t *trav );
+jsw_rbtrav_t *jsw_rbtnew ( void );
+void          jsw_rbtdelete ( jsw_rbtrav_t *trav );
+void         *jsw_rbtfirst ( jsw_rbtrav_t *trav, jsw_rbtree_t *tree );
+void         *jsw_rbtlast ( jsw_rbtrav_t *trav, jsw_rbtree_t *tree );
+void         *jsw_rbtnext ( jsw_rbtrav_t *trav );
+void         *jsw_rbtprev ( jsw_rbtrav_t *trav );
 
 #ifdef __cplusplus
 }
@@ -17,6 +17,8 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <stddef.h>
 #include <string.h>
 #include <errno.h>
 #include <unistd.h>     /* exit */
@@ -26,10 +28,12 @@
 #include <dlt.h>
 #include <dlt_common.h>
 #include <pthread.h>
+#include <poll.h>
 
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/sendfile.h>
+#include <sys/wait.h>
 
 #include <dbus/dbus.h>
 
@@ -41,6 +45,10 @@
 #include "../include/persistence_client_library.h"
 #include "../include/persistence_client_library_error_def.h"
 
+#include "../src/persistence_client_library_flush.h"
+#include "../src/persistence_client_library_warm_start.h"
+#include "../src/persistence_client_library_rct_index.h"
+
 //#define SKIP_MULTITHREADED_TESTS 1
 
 #define BUF_SIZE        64
@@ -111,6 +119,17 @@ void data_setup_norct(void)
 }
 
 
+void data_setup_write_elision(void)
+{
+   int shutdownReg = PCL_SHUTDOWN_TYPE_FAST | PCL_SHUTDOWN_TYPE_NORMAL | PCL_INIT_WRITE_ELISION;
+   const char* envVariable = "PERS_CLIENT_LIB_CUSTOM_LOAD";
+
+   setenv(envVariable, "/etc/pclCustomLibConfigFileTest.cfg", 1);
+
+   (void)pclInitLibrary(gTheAppId, shutdownReg);
+}
+
+
 void data_teardown(void)
 {
    pclDeinitLibrary();
@@ -399,6 +418,143 @@ END_TEST
 
 
 
+static int gFlushOrder[4] = {0};
+static int gFlushOrderCount = 0;
+
+static int flushOrderJob(int arg)
+{
+   gFlushOrder[__sync_fetch_and_add(&gFlushOrderCount, 1)] = arg;
+   return 0;
+}
+
+/*
+ * Set the flush priority of a resource.
+ * The data written with a critical resource must be persisted at shutdown and
+ * the flush jobs of a critical resource must be started before all other jobs.
+ */
+START_TEST(test_FlushPriority)
+{
+   int ret = 0, i = 0;
+   unsigned char buffer[READ_SIZE] = {0};
+   const char* position = "WT_ critical last position";
+   const char* document = "WT_ normal open document";
+   FlushJob_s jobs[4];
+
+   DLT_LOG(gPcltDLTContext, DLT_LOG_INFO, DLT_STRING("PCL_TEST test_FlushPriority"));
+
+   ret = pclSetFlushPriority("posHandle/last_position", PCL_FLUSH_PRIO_CRITICAL);
+   fail_unless(ret == 1, "Failed to set flush priority");
+   ret = pclSetFlushPriority("posHandle/last_position", PCL_FLUSH_PRIO_LAST);
+   fail_unless(ret == EPERS_COMMON, "Invalid flush priority accepted");
+   ret = pclSetFlushPriority(NULL, PCL_FLUSH_PRIO_CRITICAL);
+   fail_unless(ret == EPERS_COMMON, "Invalid resource accepted");
+
+   ret = pclKeyWriteData(PCL_LDBID_LOCAL, "posHandle/last_position", 0, 0, (unsigned char*)position, strlen(position));
+   fail_unless(ret == strlen(position), "Wrong write size");
+   ret = pclKeyWriteData(PCL_LDBID_LOCAL, "status/open_document", 3, 2, (unsigned char*)document, strlen(document));
+   fail_unless(ret == strlen(document), "Wrong write size");
+
+   // the databases are flushed in the order of their priority at shutdown
+   pclDeinitLibrary();
+   data_setup();
+
+   ret = pclKeyReadData(PCL_LDBID_LOCAL, "posHandle/last_position", 0, 0, buffer, READ_SIZE);
+   fail_unless(ret == strlen(position) && strncmp((char*)buffer, position, strlen(position)) == 0, "Critical data not flushed");
+   memset(buffer, 0, READ_SIZE);
+   ret = pclKeyReadData(PCL_LDBID_LOCAL, "status/open_document", 3, 2, buffer, READ_SIZE);
+   fail_unless(ret == strlen(document) && strncmp((char*)buffer, document, strlen(document)) == 0, "Normal data not flushed");
+
+   // a critical job added last is started first, jobs of the same priority keep their order
+   memset(jobs, 0, sizeof(jobs));
+   for(i = 0; i < 4; i++)
+   {
+      jobs[i].func     = flushOrderJob;
+      jobs[i].arg      = i;
+      jobs[i].type     = "test";
+      jobs[i].priority = PCL_FLUSH_PRIO_NORMAL;
+   }
+   jobs[0].priority = PCL_FLUSH_PRIO_LOW;
+   jobs[3].priority = PCL_FLUSH_PRIO_CRITICAL;
+   gFlushOrderCount = 0;
+
+   ret = flush_run_jobs(jobs, 4, 0);
+   fail_unless(ret == 0, "Flush jobs failed");
+   fail_unless(gFlushOrderCount == 4, "Not all flush jobs executed");
+   fail_unless(jobs[0].arg == 3 && jobs[1].arg == 1 && jobs[2].arg == 2 && jobs[3].arg == 0, "Jobs not ordered by priority");
+   for(i = 0; i < 4; i++)
+   {
+      fail_unless(jobs[i].state == FlushJob_Done, "Flush job not finished");
+   }
+}
+END_TEST
+
+
+
+static int flushFailingJob(int arg)
+{
+   (void)arg;
+   return EPERS_COMMON;
+}
+
+static int flushSlowJob(int arg)
+{
+   usleep((useconds_t)arg * 1000);
+   return 0;
+}
+
+/*
+ * A shutdown bounded by a deadline reports the result of every resource:
+ * finished with success or error, still running at the deadline or not started.
+ */
+START_TEST(test_FlushDeadline)
+{
+   int ret = 0, i = 0, numRunning = 0, numNotStarted = 0;
+   FlushJob_s jobs[8];
+   uint64_t start = 0;
+
+   DLT_LOG(gPcltDLTContext, DLT_LOG_INFO, DLT_STRING("PCL_TEST test_FlushDeadline"));
+
+   memset(jobs, 0, sizeof(jobs));
+   jobs[0].func     = flushOrderJob;      // finished
+   jobs[0].priority = PCL_FLUSH_PRIO_CRITICAL;
+   jobs[1].func     = flushFailingJob;    // failed
+   jobs[1].priority = PCL_FLUSH_PRIO_CRITICAL;
+   for(i = 2; i < 6; i++)
+   {
+      jobs[i].func     = flushSlowJob;    // keep all workers busy beyond the deadline
+      jobs[i].arg      = 1000;
+      jobs[i].priority = PCL_FLUSH_PRIO_NORMAL;
+   }
+   jobs[6].func     = flushOrderJob;      // not started
+   jobs[6].priority = PCL_FLUSH_PRIO_LOW;
+   jobs[7].func     = flushOrderJob;
+   jobs[7].priority = PCL_FLUSH_PRIO_LOW;
+   for(i = 0; i < 8; i++)
+   {
+      jobs[i].type = "test";
+   }
+   gFlushOrderCount = 0;
+
+   start = flush_time_us();
+   ret = flush_run_jobs(jobs, 8, start + 200 * 1000);
+
+   fail_unless(flush_time_us() - start < 900 * 1000, "Deadline not kept");
+   fail_unless(jobs[0].func == flushOrderJob && jobs[0].state == FlushJob_Done && jobs[0].result == 0, "Job not finished");
+   fail_unless(jobs[1].func == flushFailingJob && jobs[1].state == FlushJob_Done && jobs[1].result == EPERS_COMMON, "Failed job not reported");
+   for(i = 2; i < 8; i++)
+   {
+      numRunning    += (jobs[i].func == flushSlowJob && jobs[i].state == FlushJob_Running) ? 1 : 0;
+      numNotStarted += (jobs[i].func == flushOrderJob && jobs[i].state == FlushJob_NotStarted) ? 1 : 0;
+   }
+   fail_unless(numRunning == 4, "Running jobs not reported: %d", numRunning);
+   fail_unless(numNotStarted == 2, "Jobs not started reported: %d", numNotStarted);
+   fail_unless(ret == 7, "Wrong number of failed or unfinished jobs: %d", ret);
+   fail_unless(gFlushOrderCount == 1, "Job started after the deadline");
+}
+END_TEST
+
+
+
 /**
  * Write data to a key using the key interface.
  * The key is not in the persistence resource table.
@@ -441,6 +597,81 @@ END_TEST
 
 
 
+/**
+ * Create the index of the resource configuration table of the test application.
+ * Every resource must be found with the configuration stored in the table,
+ * resources not in the table must not be found.
+ */
+START_TEST(test_RctIndex)
+{
+   int handle = -1, listSize = 0, i = 0, ret = 0;
+   uint32_t count = 0, n = 0;
+   char rctName[256] = {0};
+   char* list = NULL;
+   const char** names = NULL;
+   PersistenceConfigurationKey_s* configs = NULL;
+   PersRctIndex_s* index = NULL;
+
+   DLT_LOG(gPcltDLTContext, DLT_LOG_INFO, DLT_STRING("PCL_TEST test_RctIndex"));
+
+   snprintf(rctName, sizeof(rctName), "%s%s/resource-table-cfg.itz", WTPREFIX, gTheAppId);
+   handle = persComRctOpen(rctName, 0x0);
+   fail_unless(handle >= 0, "Failed to open the RCT: %d", handle);
+
+   listSize = persComRctGetSizeResourcesList(handle);
+   fail_unless(listSize > 0, "Empty RCT: %d", listSize);
+
+   list    = calloc((size_t)listSize + 1, 1);
+   names   = calloc((size_t)listSize / 2 + 1, sizeof(char*));
+   configs = calloc((size_t)listSize / 2 + 1, sizeof(PersistenceConfigurationKey_s));
+   fail_unless(list != NULL && names != NULL && configs != NULL, "No memory");
+
+   ret = persComRctGetResourcesList(handle, list, listSize);
+   fail_unless(ret >= 0, "Failed to get the resource list: %d", ret);
+
+   for(i = 0; i < listSize; i += (int)strlen(&list[i]) + 1)
+   {
+      if(list[i] != '\0')
+      {
+         ret = persComRctRead(handle, &list[i], &configs[count]);
+         fail_unless(ret == sizeof(PersistenceConfigurationKey_s), "Failed to read resource: %s", &list[i]);
+         names[count++] = &list[i];
+      }
+   }
+   (void)persComRctClose(handle);
+
+   index = rct_index_create(count, names, configs);
+   fail_unless(index != NULL, "Failed to create the index");
+   fail_unless(rct_index_verify(index, index->imageSize) == 1, "Invalid index image");
+   fail_unless(index->count == count, "Wrong number of resources");
+
+   for(n = 0; n < count; n++)
+   {
+      const PersRctIndexEntry_s* entry = rct_index_find_entry(index, names[n]);
+
+      fail_unless(entry != NULL, "Resource not found: %s", names[n]);
+      fail_unless(memcmp(&entry->config, &configs[n], sizeof(PersistenceConfigurationKey_s)) == 0, "Wrong configuration: %s", names[n]);
+      fail_unless(rct_index_entry_slot(index, entry) < count, "Invalid slot: %s", names[n]);
+      fail_unless(   (configs[n].storage == PersistenceStorage_custom && rct_index_custom_key(index, entry) != NULL)
+                  || (configs[n].storage != PersistenceStorage_custom && rct_index_custom_key(index, entry) == NULL), "Wrong custom key: %s", names[n]);
+   }
+
+   fail_unless(rct_index_find(index, "notInRCT") == NULL, "Resource not in the RCT found");
+   fail_unless(rct_index_find(index, "") == NULL, "Empty resource found");
+   fail_unless(rct_index_find(index, NULL) == NULL, "NULL resource found");
+
+   // a truncated image must not be used
+   fail_unless(rct_index_verify(index, index->imageSize - 1) == 0, "Truncated index image accepted");
+
+   free(index);
+   free(configs);
+   free(names);
+   free(list);
+}
+END_TEST
+
+
+
 /*
  * Test the key interface.
  * Read the size of a key.
@@ -467,6 +698,200 @@ START_TEST(test_GetDataSize)
 END_TEST
 
 
+static int gAsyncCallbackResult = 0;
+
+static void asyncWriteDone(int request_id, int result, void* user_data)
+{
+   (void)request_id;
+   *(int*)user_data = result;
+}
+
+/*
+ * Write data asynchronously with and without completion callback.
+ * The requests are executed in order, so the last write must be read back.
+ */
+START_TEST(test_WriteDataAsync)
+{
+   int ret = 0, fd = -1, id1 = 0, id2 = 0, result = 0;
+   uint64_t events = 0;
+   unsigned char buffer[READ_SIZE]  = {0};
+   const char* write1 = "ASYNC_ first value";
+   const char* write2 = "ASYNC_ second value";
+
+   DLT_LOG(gPcltDLTContext, DLT_LOG_INFO, DLT_STRING("PCL_TEST test_WriteDataAsync"));
+
+   fd = pclKeyAsyncGetFd();
+   fail_unless(fd >= 0, "Failed to get eventfd");
+
+   gAsyncCallbackResult = 0;
+   id1 = pclKeyWriteDataAsync(PCL_LDBID_LOCAL, "status/open_document", 3, 2, (unsigned char*)write1, strlen(write1),
+                              asyncWriteDone, &gAsyncCallbackResult);
+   fail_unless(id1 > 0, "Failed to queue first write");
+
+   id2 = pclKeyWriteDataAsync(PCL_LDBID_LOCAL, "status/open_document", 3, 2, (unsigned char*)write2, strlen(write2), NULL, NULL);
+   fail_unless(id2 > 0 && id2 != id1, "Failed to queue second write");
+
+   // wait for the completion of the second request, the first one has been completed before
+   while(read(fd, &events, sizeof(events)) != sizeof(events))
+   {
+      usleep(1000);
+   }
+
+   ret = pclKeyAsyncGetResult(&result);
+   fail_unless(ret == id2, "Wrong request ID");
+   fail_unless(result == strlen(write2), "Wrong write size");
+   fail_unless(gAsyncCallbackResult == strlen(write1), "Callback not called");
+   fail_unless(pclKeyAsyncGetResult(&result) == 0, "Unexpected result");
+
+   ret = pclKeyReadData(PCL_LDBID_LOCAL, "status/open_document", 3, 2, buffer, READ_SIZE);
+   fail_unless(ret == strlen(write2) && strncmp((char*)buffer, write2, strlen(write2)) == 0, "Writes not in order");
+
+   memset(buffer, 0, READ_SIZE);
+   gAsyncCallbackResult = 0;
+   id1 = pclKeyReadDataAsync(PCL_LDBID_LOCAL, "status/open_document", 3, 2, buffer, READ_SIZE, asyncWriteDone, &gAsyncCallbackResult);
+   fail_unless(id1 > 0, "Failed to queue read");
+   while(__sync_add_and_fetch(&gAsyncCallbackResult, 0) == 0)
+   {
+      usleep(1000);
+   }
+   fail_unless(gAsyncCallbackResult == strlen(write2) && strncmp((char*)buffer, write2, strlen(write2)) == 0, "Wrong data read");
+
+   ret = pclKeyWriteDataAsync(PCL_LDBID_LOCAL, "status/open_document", 3, 2, NULL, 10, NULL, NULL);
+   fail_unless(ret == EPERS_BUFLIMIT, "Invalid buffer accepted");
+}
+END_TEST
+
+
+
+static int iterateKeys(const char* resource_id, void* user_data)
+{
+   if(strcmp(resource_id, "status/open_document") == 0)
+   {
+      *(int*)user_data = 1;
+   }
+   return 0;
+}
+
+/*
+ * Iterate over the keys of a user and seat, only keys with the prefix must be returned.
+ */
+START_TEST(test_KeyIterate)
+{
+   int ret = 0, found = 0;
+
+   DLT_LOG(gPcltDLTContext, DLT_LOG_INFO, DLT_STRING("PCL_TEST test_KeyIterate"));
+
+   ret = pclKeyWriteData(PCL_LDBID_LOCAL, "status/open_document", 3, 2, (unsigned char*)"WT_ iterate", strlen("WT_ iterate"));
+   fail_unless(ret == strlen("WT_ iterate"), "Wrong write size");
+
+   ret = pclKeyIterate(PCL_LDBID_LOCAL, 3, 2, "status/", iterateKeys, &found);
+   fail_unless(ret >= 1, "No keys found");
+   fail_unless(found == 1, "Key not found");
+
+   found = 0;
+   ret = pclKeyIterate(PCL_LDBID_LOCAL, 3, 2, "no_such_prefix/", iterateKeys, &found);
+   fail_unless(ret == 0 && found == 0, "Prefix not respected");
+}
+END_TEST
+
+
+
+/*
+ * Read a key by reference and into an allocated buffer.
+ * A reference stays valid when the key is written, but is not returned anymore.
+ */
+START_TEST(test_KeyReadRef)
+{
+   int ret = 0;
+   const unsigned char* ref1 = NULL;
+   const unsigned char* ref2 = NULL;
+   const unsigned char* ref3 = NULL;
+   unsigned char* alloc = NULL;
+   unsigned char buffer[READ_SIZE] = {0};
+   pclCacheStats_s stats1, stats2;
+   const char* write1 = "WT_ read reference 1";
+   const char* write2 = "WT_ second read reference";
+
+   DLT_LOG(gPcltDLTContext, DLT_LOG_INFO, DLT_STRING("PCL_TEST test_KeyReadRef"));
+
+   ret = pclKeyWriteData(PCL_LDBID_LOCAL, "status/open_document", 3, 2, (unsigned char*)write1, strlen(write1));
+   fail_unless(ret == strlen(write1), "Wrong write size");
+
+   ret = pclKeyReadRef(PCL_LDBID_LOCAL, "status/open_document", 3, 2, &ref1);
+   fail_unless(ret == strlen(write1), "Wrong read size");
+   fail_unless(ref1 != NULL && strcmp((const char*)ref1, write1) == 0, "Reference not correctly read");
+
+   // the second read is served from the cache and returns the same data
+   fail_unless(pclKeyGetCacheStats(&stats1) == 0, "Failed to get cache stats");
+   ret = pclKeyReadRef(PCL_LDBID_LOCAL, "status/open_document", 3, 2, &ref2);
+   fail_unless(ret == strlen(write1) && ref2 == ref1, "Reference not cached");
+   fail_unless(pclKeyGetCacheStats(&stats2) == 0, "Failed to get cache stats");
+   fail_unless(stats2.hits == stats1.hits + 1, "Cache hit not counted");
+
+   // the write invalidates the cached value, the references still hold the old data
+   ret = pclKeyWriteData(PCL_LDBID_LOCAL, "status/open_document", 3, 2, (unsigned char*)write2, strlen(write2));
+   fail_unless(ret == strlen(write2), "Wrong write size");
+   fail_unless(strcmp((const char*)ref1, write1) == 0, "Reference changed by write");
+
+   ret = pclKeyReadRef(PCL_LDBID_LOCAL, "status/open_document", 3, 2, &ref3);
+   fail_unless(ret == strlen(write2), "Wrong read size");
+   fail_unless(ref3 != ref1 && strcmp((const char*)ref3, write2) == 0, "Invalidated reference returned");
+
+   fail_unless(pclKeyReleaseRef(ref1) == 0, "Failed to release reference");
+   fail_unless(strcmp((const char*)ref2, write1) == 0, "Reference released too early");
+   fail_unless(pclKeyReleaseRef(ref2) == 0, "Failed to release reference");
+   fail_unless(pclKeyReleaseRef(ref3) == 0, "Failed to release reference");
+
+   ret = pclKeyReadDataAlloc(PCL_LDBID_LOCAL, "status/open_document", 3, 2, &alloc);
+   fail_unless(ret == strlen(write2), "Wrong read size");
+   fail_unless(alloc != NULL && strcmp((char*)alloc, write2) == 0, "Buffer not correctly read");
+   free(alloc);
+
+   ret = pclKeyReadDataAlloc(PCL_LDBID_LOCAL, "status/open_document", 3, 2, NULL);
+   fail_unless(ret == EPERS_COMMON, "Invalid buffer accepted");
+
+   // only references returned by pclKeyReadRef can be released
+   fail_unless(pclKeyReleaseRef(buffer + READ_SIZE/2) == EPERS_COMMON, "Released a buffer not being a reference");
+   fail_unless(pclKeyReleaseRef(NULL) == EPERS_COMMON, "Released a NULL reference");
+}
+END_TEST
+
+
+
+START_TEST(test_KeyMulti)
+{
+   int ret = 0;
+   char buffer1[READ_SIZE] = {0};
+   char buffer2[READ_SIZE] = {0};
+   pclKeyMultiItem_s items[2];
+
+   DLT_LOG(gPcltDLTContext, DLT_LOG_INFO, DLT_STRING("PCL_TEST test_KeyMulti"));
+
+   items[0].resource_id = "70";
+   items[0].buffer      = (unsigned char*)"multi write 1";
+   items[0].buffer_size = (int)strlen("multi write 1");
+   items[1].resource_id = "key_70";
+   items[1].buffer      = (unsigned char*)"multi write 2";
+   items[1].buffer_size = (int)strlen("multi write 2");
+
+   ret = pclKeyWriteDataMulti(PCL_LDBID_LOCAL, 1, 2, items, 2);
+   fail_unless(ret == 2, "Wrong number of keys written");
+   fail_unless(items[1].result == (int)strlen("multi write 2"), "Wrong write size");
+
+   items[0].buffer      = (unsigned char*)buffer1;
+   items[0].buffer_size = READ_SIZE;
+   items[1].buffer      = (unsigned char*)buffer2;
+   items[1].buffer_size = READ_SIZE;
+
+   ret = pclKeyReadDataMulti(PCL_LDBID_LOCAL, 1, 2, items, 2);
+   fail_unless(ret == 2, "Wrong number of keys read");
+   fail_unless(strncmp(buffer1, "multi write 1", strlen("multi write 1")) == 0, "Buffer not correctly read");
+   fail_unless(strncmp(buffer2, "multi write 2", strlen("multi write 2")) == 0, "Buffer not correctly read");
+}
+END_TEST
+
+
+
 /*
  * Delete a key using the key value interface.
  * First read a from a key, the delte the key
@@ -508,6 +933,133 @@ START_TEST(test_DeleteData)
 END_TEST
 
 
+/*
+ * Delete all keys of a user.
+ * The keys of the other seats are kept if a seat is given, the keys of
+ * a user with the same leading digits (user 30) must never be deleted.
+ */
+START_TEST(test_DeleteUser)
+{
+   int ret = 0;
+   unsigned char buffer[READ_SIZE] = {0};
+   const char* user3  = "WT_ user 3";
+   const char* user30 = "WT_ user 30";
+
+   DLT_LOG(gPcltDLTContext, DLT_LOG_INFO, DLT_STRING("PCL_TEST test_DeleteUser"));
+
+   ret = pclKeyWriteData(PCL_LDBID_LOCAL, "status/open_document", 3, 2, (unsigned char*)user3, strlen(user3));
+   fail_unless(ret == strlen(user3), "Wrong write size");
+   ret = pclKeyWriteData(PCL_LDBID_LOCAL, "key_70", 3, 2, (unsigned char*)user3, strlen(user3));
+   fail_unless(ret == strlen(user3), "Wrong write size");
+   ret = pclKeyWriteData(PCL_LDBID_LOCAL, "key_70", 3, 1, (unsigned char*)user3, strlen(user3));
+   fail_unless(ret == strlen(user3), "Wrong write size");
+   ret = pclKeyWriteData(PCL_LDBID_LOCAL, "status/open_document", 30, 2, (unsigned char*)user30, strlen(user30));
+   fail_unless(ret == strlen(user30), "Wrong write size");
+   ret = pclKeyWriteData(PCL_LDBID_LOCAL, "key_70", 30, 2, (unsigned char*)user30, strlen(user30));
+   fail_unless(ret == strlen(user30), "Wrong write size");
+
+   // seat 2 of user 3 only
+   ret = pclKeyDeleteUser(PCL_LDBID_LOCAL, 3, 2);
+   fail_unless(ret >= 2, "Keys of user not deleted");
+
+   ret = pclKeyReadData(PCL_LDBID_LOCAL, "status/open_document", 3, 2, buffer, READ_SIZE);
+   fail_unless(ret == EPERS_NOKEY, "Key of user still available");
+   ret = pclKeyReadData(PCL_LDBID_LOCAL, "key_70", 3, 2, buffer, READ_SIZE);
+   fail_unless(ret == EPERS_NOKEY, "Key of user still available");
+   ret = pclKeyReadData(PCL_LDBID_LOCAL, "key_70", 3, 1, buffer, READ_SIZE);
+   fail_unless(ret == strlen(user3), "Key of other seat deleted");
+
+   // all seats of user 3
+   ret = pclKeyDeleteUser(PCL_LDBID_LOCAL, 3, 0);
+   fail_unless(ret >= 1, "Keys of user not deleted");
+   ret = pclKeyReadData(PCL_LDBID_LOCAL, "key_70", 3, 1, buffer, READ_SIZE);
+   fail_unless(ret == EPERS_NOKEY, "Key of user still available");
+
+   memset(buffer, 0, READ_SIZE);
+   ret = pclKeyReadData(PCL_LDBID_LOCAL, "status/open_document", 30, 2, buffer, READ_SIZE);
+   fail_unless(ret == strlen(user30) && strncmp((char*)buffer, user30, strlen(user30)) == 0, "Key of user 30 deleted");
+   memset(buffer, 0, READ_SIZE);
+   ret = pclKeyReadData(PCL_LDBID_LOCAL, "key_70", 30, 2, buffer, READ_SIZE);
+   fail_unless(ret == strlen(user30) && strncmp((char*)buffer, user30, strlen(user30)) == 0, "Key of user 30 deleted");
+
+   ret = pclKeyDeleteUser(PCL_LDBID_LOCAL, 0, 0);
+   fail_unless(ret == EPERS_COMMON, "Node data deleted");
+}
+END_TEST
+
+
+/*
+ * Write the same value twice with the write elision enabled.
+ * The second write must be skipped and counted, but not a write of
+ * the same value after the key has been deleted or the database has been closed.
+ */
+START_TEST(test_WriteElision)
+{
+   int ret = 0;
+   pclWriteElisionStats_s stats;
+   const char* write1 = "WT_ write elision";
+   const char* write2 = "WT_ write elision changed";
+
+   DLT_LOG(gPcltDLTContext, DLT_LOG_INFO, DLT_STRING("PCL_TEST test_WriteElision"));
+
+   memset(&stats, 0xFF, sizeof(stats));
+   ret = pclKeyGetWriteElisionStats(&stats);
+   fail_unless(ret == 0, "Failed to get write elision stats");
+   fail_unless(stats.writes == 0 && stats.signals == 0 && stats.bytes == 0, "Stats not reset at init");
+   fail_unless(pclKeyGetWriteElisionStats(NULL) == EPERS_COMMON, "Invalid stats accepted");
+
+   ret = pclKeyWriteData(PCL_LDBID_LOCAL, "status/open_document", 3, 2, (unsigned char*)write1, strlen(write1));
+   fail_unless(ret == strlen(write1), "Wrong write size");
+   (void)pclKeyGetWriteElisionStats(&stats);
+   fail_unless(stats.writes == 0, "First write skipped");
+
+   // identical value, skipped
+   ret = pclKeyWriteData(PCL_LDBID_LOCAL, "status/open_document", 3, 2, (unsigned char*)write1, strlen(write1));
+   fail_unless(ret == strlen(write1), "Wrong write size");
+   (void)pclKeyGetWriteElisionStats(&stats);
+   fail_unless(stats.writes == 1 && stats.bytes == strlen(write1), "Identical write not skipped");
+   fail_unless(stats.signals == 0, "Notification of a local key counted");
+
+   // changed value, written
+   ret = pclKeyWriteData(PCL_LDBID_LOCAL, "status/open_document", 3, 2, (unsigned char*)write2, strlen(write2));
+   fail_unless(ret == strlen(write2), "Wrong write size");
+   (void)pclKeyGetWriteElisionStats(&stats);
+   fail_unless(stats.writes == 1, "Changed value skipped");
+
+   // the value written before the delete must not be skipped
+   ret = pclKeyDelete(PCL_LDBID_LOCAL, "status/open_document", 3, 2);
+   fail_unless(ret >= 0, "Failed to delete key");
+   ret = pclKeyWriteData(PCL_LDBID_LOCAL, "status/open_document", 3, 2, (unsigned char*)write2, strlen(write2));
+   fail_unless(ret == strlen(write2), "Wrong write size");
+   (void)pclKeyGetWriteElisionStats(&stats);
+   fail_unless(stats.writes == 1, "Write after delete skipped");
+
+   // the databases may be changed while closed, the value must be written again
+   pclDeinitLibrary();
+   data_setup_write_elision();
+
+   ret = pclKeyWriteData(PCL_LDBID_LOCAL, "status/open_document", 3, 2, (unsigned char*)write2, strlen(write2));
+   fail_unless(ret == strlen(write2), "Wrong write size");
+   (void)pclKeyGetWriteElisionStats(&stats);
+   fail_unless(stats.writes == 0, "Write after close skipped");
+
+   ret = pclKeyWriteData(PCL_LDBID_LOCAL, "status/open_document", 3, 2, (unsigned char*)write2, strlen(write2));
+   fail_unless(ret == strlen(write2), "Wrong write size");
+   (void)pclKeyGetWriteElisionStats(&stats);
+   fail_unless(stats.writes == 1, "Identical write not skipped");
+
+   // disabled without PCL_INIT_WRITE_ELISION
+   pclDeinitLibrary();
+   data_setup();
+
+   ret = pclKeyWriteData(PCL_LDBID_LOCAL, "status/open_document", 3, 2, (unsigned char*)write2, strlen(write2));
+   fail_unless(ret == strlen(write2), "Wrong write size");
+   (void)pclKeyGetWriteElisionStats(&stats);
+   fail_unless(stats.writes == 0, "Write skipped without write elision");
+}
+END_TEST
+
+
 
 void data_setupBackup(void)
 {
@@ -661,6 +1213,24 @@ START_TEST(test_Plugin)
 
    ret = pclKeyDelete(PCL_LDBID_LOCAL, "custom3",   0, 0);
    fail_unless(ret == 13579, "Failed query custom data size"); // plugin should return 13579
+
+   // every plugin call above has been counted
+   {
+      pclPluginStats_s stats;
+      unsigned int gets = 0, deletes = 0;
+      int plugin = 0;
+
+      while((ret = pclGetPluginStats(plugin++, &stats)) >= 0)
+      {
+         if(ret == 1)
+         {
+            gets    += stats.op[PCL_PLUGIN_OP_GET].calls;
+            deletes += stats.op[PCL_PLUGIN_OP_DELETE].calls;
+         }
+      }
+      fail_unless(ret == EPERS_COMMON, "Invalid plugin number accepted");
+      fail_unless(gets >= 6 && deletes >= 1, "Plugin calls not counted");
+   }
 }
 END_TEST
 
@@ -829,6 +1399,315 @@ START_TEST(test_InitDeinit)
 END_TEST
 
 
+/*
+ * Initialize the library with PCL_INIT_ASYNC. Local keys can be read before the
+ * background initialization has finished, the ready descriptor becomes readable then.
+ */
+START_TEST(test_InitAsync)
+{
+   int ret = 0, fd = -1;
+   unsigned char buffer[READ_SIZE] = {0};
+   struct pollfd pfd;
+   const char* expected = "WT_ /var/opt/user_manual_climateControl.pdf";
+
+   DLT_LOG(gPcltDLTContext, DLT_LOG_INFO, DLT_STRING("PCL_TEST test_InitAsync"));
+
+   setenv("PERS_CLIENT_LIB_CUSTOM_LOAD", "/etc/pclCustomLibConfigFileTest.cfg", 1);
+   ret = pclInitLibrary(gTheAppId, PCL_SHUTDOWN_TYPE_FAST | PCL_SHUTDOWN_TYPE_NORMAL | PCL_INIT_ASYNC);
+   fail_unless(ret >= 0, "Failed to initialize: %d", ret);
+
+   // the default plugin has been loaded synchronously
+   ret = pclKeyReadData(PCL_LDBID_LOCAL, "status/open_document", 3, 2, buffer, READ_SIZE);
+   fail_unless(ret == strlen(expected) && strncmp((char*)buffer, expected, strlen(expected)) == 0, "Wrong data read before ready");
+
+   fd = pclGetInitReadyFd();
+   fail_unless(fd >= 0, "No ready descriptor: %d", fd);
+
+   pfd.fd = fd;
+   pfd.events = POLLIN;
+   pfd.revents = 0;
+   ret = poll(&pfd, 1, 3000);
+   fail_unless(ret == 1 && (pfd.revents & POLLIN) != 0, "Ready descriptor not readable");
+
+   ret = pclWaitInitReady(0);
+   fail_unless(ret == 1, "Not ready: %d", ret);
+   ret = pclWaitInitReady(-1);
+   fail_unless(ret == 1, "Not ready: %d", ret);
+
+   memset(buffer, 0, READ_SIZE);
+   ret = pclKeyReadData(PCL_LDBID_LOCAL, "status/open_document", 3, 2, buffer, READ_SIZE);
+   fail_unless(ret == strlen(expected) && strncmp((char*)buffer, expected, strlen(expected)) == 0, "Wrong data read after ready");
+
+   pclDeinitLibrary();
+
+   // ready immediately without PCL_INIT_ASYNC
+   data_setup();
+   fail_unless(pclWaitInitReady(0) == 1, "Not ready without PCL_INIT_ASYNC");
+   pclDeinitLibrary();
+
+   fail_unless(pclWaitInitReady(0) == EPERS_NOT_INITIALIZED, "Ready, but not initialized");
+}
+END_TEST
+
+
+static void warmStartInit(void)
+{
+   setenv("PERS_CLIENT_LIB_CUSTOM_LOAD", "/etc/pclCustomLibConfigFileTest.cfg", 1);
+
+   (void)pclInitLibrary(gTheAppId, PCL_SHUTDOWN_TYPE_FAST | PCL_SHUTDOWN_TYPE_NORMAL | PCL_INIT_WARM_START);
+}
+
+/* read the key and return the number of database reads needed for it */
+static unsigned int warmStartRead(const char* expected)
+{
+   int ret = 0;
+   unsigned char buffer[READ_SIZE] = {0};
+   pclCacheStats_s stats1, stats2;
+
+   (void)pclKeyGetCacheStats(&stats1);
+   ret = pclKeyReadData(PCL_LDBID_LOCAL, "status/open_document", 3, 2, buffer, READ_SIZE);
+   fail_unless(ret == strlen(expected) && strncmp((char*)buffer, expected, strlen(expected)) == 0, "Wrong data read");
+   (void)pclKeyGetCacheStats(&stats2);
+
+   return stats2.misses - stats1.misses;
+}
+
+/*
+ * Write the warm start snapshot at a full shutdown and use it at the next start.
+ * The snapshot must be removed and the database read if a database has been
+ * changed or the snapshot has been corrupted since it has been written.
+ */
+START_TEST(test_WarmStart)
+{
+   int ret = 0, fd = -1;
+   unsigned int i = 0;
+   char snapshot[256] = {0};
+   unsigned char* image = NULL;
+   const PersWarmStart_s* header = NULL;
+   const PersWarmStartStamp_s* stamp = NULL;
+   struct stat buf;
+   struct timespec times[2];
+   uint32_t reserved = 0xFFFFFFFFU;
+   const char* write1 = "WT_ warm start snapshot";
+
+   DLT_LOG(gPcltDLTContext, DLT_LOG_INFO, DLT_STRING("PCL_TEST test_WarmStart"));
+
+   snprintf(snapshot, sizeof(snapshot), "%s%s/WarmStart.snap", CACHEPREFIX, gTheAppId);
+   (void)unlink(snapshot);
+
+   // record the key, the snapshot is written at the full shutdown
+   warmStartInit();
+   ret = pclKeyWriteData(PCL_LDBID_LOCAL, "status/open_document", 3, 2, (unsigned char*)write1, strlen(write1));
+   fail_unless(ret == strlen(write1), "Wrong write size");
+   fail_unless(warmStartRead(write1) == 1, "Key not read from the database");
+   pclDeinitLibrary();
+   fail_unless(stat(snapshot, &buf) == 0, "Snapshot not written");
+
+   // served from the snapshot without a database read
+   warmStartInit();
+   fail_unless(warmStartRead(write1) == 0, "Key not read from the snapshot");
+   fail_unless(stat(snapshot, &buf) == 0, "Valid snapshot removed");
+   pclDeinitLibrary();
+
+   // change the modification time of a database stamped in the snapshot
+   fd = open(snapshot, O_RDONLY);
+   fail_unless(fd != -1, "Snapshot not written");
+   fail_unless(fstat(fd, &buf) == 0 && buf.st_size >= (off_t)sizeof(PersWarmStart_s), "Invalid snapshot size");
+   image = malloc((size_t)buf.st_size);
+   fail_unless(image != NULL && read(fd, image, (size_t)buf.st_size) == buf.st_size, "Failed to read snapshot");
+   close(fd);
+
+   header = (const PersWarmStart_s*)image;
+   for(i = 0; i < header->stampCount && stamp == NULL; i++)
+   {
+      const PersWarmStartStamp_s* current = (const PersWarmStartStamp_s*)(image + header->stampOffset) + i;
+
+      if(current->exists == 1 && strstr((const char*)image + current->pathOffset, ".itz") != NULL)
+      {
+         stamp = current;
+      }
+   }
+   fail_unless(stamp != NULL, "No database stamped in the snapshot");
+
+   times[0].tv_sec  = 0;
+   times[0].tv_nsec = UTIME_OMIT;
+   times[1].tv_sec  = (time_t)stamp->mtimeSec - 1;
+   times[1].tv_nsec = (long)stamp->mtimeNsec;
+   fail_unless(utimensat(AT_FDCWD, (const char*)image + stamp->pathOffset, times, 0) == 0, "Failed to change the database stamp");
+   free(image);
+
+   warmStartInit();
+   fail_unless(stat(snapshot, &buf) == -1, "Outdated snapshot not removed");
+   fail_unless(warmStartRead(write1) == 1, "Key read from an outdated snapshot");
+   pclDeinitLibrary();
+
+   // corrupt the header, the crc does not match anymore
+   fd = open(snapshot, O_RDWR);
+   fail_unless(fd != -1, "Snapshot not written");
+   ret = (int)pwrite(fd, &reserved, sizeof(reserved), (off_t)offsetof(PersWarmStart_s, reserved));
+   fail_unless(ret == sizeof(reserved), "Failed to corrupt the snapshot");
+   close(fd);
+
+   warmStartInit();
+   fail_unless(stat(snapshot, &buf) == -1, "Corrupted snapshot not removed");
+   fail_unless(warmStartRead(write1) == 1, "Key read from a corrupted snapshot");
+   pclDeinitLibrary();
+
+   // the snapshot is not used without PCL_INIT_WARM_START
+   data_setup();
+   fail_unless(warmStartRead(write1) == 1, "Snapshot used without warm start");
+   pclDeinitLibrary();
+}
+END_TEST
+
+
+/* name of the redo log of the write back key cache */
+static const char* keyCacheLogName(void)
+{
+   static char logName[256] = {0};
+
+   snprintf(logName, sizeof(logName), "%s%s/KeyCacheRedo.log", CACHEPREFIX, gTheAppId);
+
+   return logName;
+}
+
+/* size of the redo log, -1 if there is no log */
+static off_t keyCacheLogSize(void)
+{
+   struct stat buf;
+
+   return (stat(keyCacheLogName(), &buf) == 0) ? buf.st_size : -1;
+}
+
+/* write the keys in a child process which exits without pclDeinitLibrary, the keys remain in the redo log only */
+static void keyCacheWriteUnclean(const char* value1, const char* value2)
+{
+   int status = -1;
+   pid_t pid = fork();
+
+   if(pid == 0)
+   {
+      data_setup();
+      if(   pclKeyWriteData(PCL_LDBID_LOCAL, "keyCache/redo_1", 2, 2, (unsigned char*)value1, (int)strlen(value1)) != (int)strlen(value1)
+         || pclKeyWriteData(PCL_LDBID_LOCAL, "keyCache/redo_2", 2, 2, (unsigned char*)value2, (int)strlen(value2)) != (int)strlen(value2))
+      {
+         _exit(EXIT_FAILURE);
+      }
+      _exit(EXIT_SUCCESS);     // no flush, no truncation of the redo log
+   }
+
+   fail_unless(pid > 0, "Failed to fork");
+   fail_unless(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS, "Child failed to write");
+   fail_unless(keyCacheLogSize() > 0, "Keys not in the redo log");
+}
+
+static void keyCacheCheck(const char* key, const char* expected)
+{
+   int ret = 0;
+   unsigned char buffer[READ_SIZE] = {0};
+
+   ret = pclKeyReadData(PCL_LDBID_LOCAL, key, 2, 2, buffer, READ_SIZE);
+   fail_unless(ret == strlen(expected) && strncmp((char*)buffer, expected, strlen(expected)) == 0, "Wrong data read: %s", key);
+}
+
+/*
+ * Keys written to the write back cache are read back from the cache and written
+ * to the databases at a shutdown, the redo log is truncated then.
+ */
+START_TEST(test_KeyCache)
+{
+   int ret = 0;
+   unsigned char buffer[READ_SIZE] = {0};
+   const char* write1 = "KC_ cached value";
+   const char* write2 = "KC_ cached value, second version";
+
+   DLT_LOG(gPcltDLTContext, DLT_LOG_INFO, DLT_STRING("PCL_TEST test_KeyCache"));
+
+   setenv("PERS_CLIENT_LIB_CUSTOM_LOAD", "/etc/pclCustomLibConfigFileTest.cfg", 1);
+   (void)pclInitLibrary(gTheAppId, PCL_SHUTDOWN_TYPE_NONE);
+
+   // read your write, the flusher has not written the keys yet
+   ret = pclKeyWriteData(PCL_LDBID_LOCAL, "keyCache/read_your_write", 2, 2, (unsigned char*)write1, (int)strlen(write1));
+   fail_unless(ret == strlen(write1), "Wrong write size");
+   ret = pclKeyWriteData(PCL_LDBID_LOCAL, "keyCache/read_your_write", 2, 2, (unsigned char*)write2, (int)strlen(write2));
+   fail_unless(ret == strlen(write2), "Wrong write size");
+   fail_unless(keyCacheLogSize() > 0, "Key not in the redo log");
+
+   ret = pclKeyGetSize(PCL_LDBID_LOCAL, "keyCache/read_your_write", 2, 2);
+   fail_unless(ret == strlen(write2), "Wrong size read from the cache: %d", ret);
+   ret = pclKeyReadData(PCL_LDBID_LOCAL, "keyCache/read_your_write", 2, 2, buffer, READ_SIZE);
+   fail_unless(ret == strlen(write2) && strncmp((char*)buffer, write2, strlen(write2)) == 0, "Wrong data read from the cache");
+
+   // flushed and durable at the shutdown, the redo log is not needed anymore
+   ret = pclLifecycleSet(PCL_SHUTDOWN);
+   fail_unless(ret == 0, "failed pclLifecycleSet: %d", ret);
+   fail_unless(keyCacheLogSize() == 0, "Redo log not truncated at shutdown");
+
+   ret = pclLifecycleSet(PCL_SHUTDOWN_CANCEL);
+   fail_unless(ret == 0, "failed pclLifecycleSet: %d", ret);
+   keyCacheCheck("keyCache/read_your_write", write2);
+
+   pclDeinitLibrary();
+}
+END_TEST
+
+/*
+ * The redo log left by a process which exited without pclDeinitLibrary is replayed
+ * at the next start. A torn or corrupted record at the end of the log is ignored.
+ */
+START_TEST(test_KeyCacheReplay)
+{
+   int fd = -1;
+   off_t size = 0;
+   char last = 0;
+   const char* old2 = "KC_ written before";
+
+   DLT_LOG(gPcltDLTContext, DLT_LOG_INFO, DLT_STRING("PCL_TEST test_KeyCacheReplay"));
+
+   // the second key has a durable value, see the corrupted records below
+   data_setup();
+   fail_unless(pclKeyWriteData(PCL_LDBID_LOCAL, "keyCache/redo_2", 2, 2, (unsigned char*)old2, (int)strlen(old2)) == (int)strlen(old2), "Wrong write size");
+   pclDeinitLibrary();
+   fail_unless(keyCacheLogSize() == 0, "Redo log not truncated at deinit");
+
+   // both records are replayed
+   keyCacheWriteUnclean("KC_ replayed 1", "KC_ replayed 2");
+   data_setup();
+   fail_unless(keyCacheLogSize() == 0, "Redo log not truncated after the replay");
+   keyCacheCheck("keyCache/redo_1", "KC_ replayed 1");
+   keyCacheCheck("keyCache/redo_2", "KC_ replayed 2");
+   fail_unless(pclKeyWriteData(PCL_LDBID_LOCAL, "keyCache/redo_2", 2, 2, (unsigned char*)old2, (int)strlen(old2)) == (int)strlen(old2), "Wrong write size");
+   pclDeinitLibrary();
+
+   // torn record at the end, the last byte is missing
+   keyCacheWriteUnclean("KC_ torn 1", "KC_ torn 2");
+   size = keyCacheLogSize();
+   fail_unless(truncate(keyCacheLogName(), size - 1) == 0, "Failed to tear the redo log");
+
+   data_setup();
+   keyCacheCheck("keyCache/redo_1", "KC_ torn 1");
+   keyCacheCheck("keyCache/redo_2", old2);
+   pclDeinitLibrary();
+
+   // the crc of the last record does not match
+   keyCacheWriteUnclean("KC_ crc 1", "KC_ crc 2");
+   fd = open(keyCacheLogName(), O_RDWR);
+   fail_unless(fd != -1, "Failed to open the redo log");
+   size = lseek(fd, 0, SEEK_END);
+   fail_unless(pread(fd, &last, 1, size - 1) == 1, "Failed to read the redo log");
+   last ^= 0x01;
+   fail_unless(pwrite(fd, &last, 1, size - 1) == 1, "Failed to corrupt the redo log");
+   close(fd);
+
+   data_setup();
+   fail_unless(keyCacheLogSize() == 0, "Corrupted record not removed from the redo log");
+   keyCacheCheck("keyCache/redo_1", "KC_ crc 1");
+   keyCacheCheck("keyCache/redo_2", old2);
+   pclDeinitLibrary();
+}
+END_TEST
+
+
 
 START_TEST(test_NegHandle)
 {
@@ -913,6 +1792,50 @@ START_TEST(test_Notifications)
 END_TEST
 
 
+static int gSelfNotifyCount = 0;
+
+static int selfNotifyCallback(pclNotification_s * notifyStruct)
+{
+   if(   notifyStruct->resource_id != NULL && strcmp(notifyStruct->resource_id, "links/last_link2") == 0
+      && notifyStruct->pclKeyNotify_Status == pclNotifyStatus_changed)
+   {
+      __sync_add_and_fetch(&gSelfNotifyCount, 1);
+   }
+   return 1;
+}
+
+/*
+ * A subscribed shared key written by this process is notified exactly once,
+ * by the local notification, the own D-Bus signal must not be delivered again.
+ */
+START_TEST(test_NotifySelfWrite)
+{
+   int ret = 0, i = 0;
+   const char* write1 = "Test notify self write";
+
+   DLT_LOG(gPcltDLTContext, DLT_LOG_INFO, DLT_STRING("PCL_TEST test_NotifySelfWrite"));
+
+   ret = pclKeyRegisterNotifyOnChange(0x20, "links/last_link2", 2, 1, selfNotifyCallback);
+   fail_unless(ret == 0, "Failed to register");
+
+   gSelfNotifyCount = 0;
+   ret = pclKeyWriteData(0x20, "links/last_link2", 2, 1, (unsigned char*)write1, strlen(write1));
+   fail_unless(ret == strlen(write1), "Wrong write size");
+
+   for(i = 0; i < 200 && __sync_add_and_fetch(&gSelfNotifyCount, 0) == 0; i++)
+   {
+      usleep(10 * 1000);
+   }
+   usleep(500 * 1000);     // time for the own D-Bus signal to arrive
+
+   fail_unless(__sync_add_and_fetch(&gSelfNotifyCount, 0) == 1, "Wrong number of callbacks: %d", gSelfNotifyCount);
+
+   ret = pclKeyUnRegisterNotifyOnChange(0x20, "links/last_link2", 2, 1, selfNotifyCallback);
+   fail_unless(ret == 0, "Failed to unregister");
+}
+END_TEST
+
+
 #if USE_APPCHECK
 START_TEST(test_ValidApplication)
 {
@@ -1808,18 +2731,51 @@ static Suite * persistenceClientLib_suite()
    tcase_add_test(tc_persSetData, test_SetData);
    tcase_set_timeout(tc_persSetData, 3);
 
+   TCase * tc_persFlushPriority = tcase_create("FlushPriority");
+   tcase_add_test(tc_persFlushPriority, test_FlushPriority);
+   tcase_set_timeout(tc_persFlushPriority, 5);
+
+   TCase * tc_persFlushDeadline = tcase_create("FlushDeadline");
+   tcase_add_test(tc_persFlushDeadline, test_FlushDeadline);
+   tcase_set_timeout(tc_persFlushDeadline, 5);
+
    TCase * tc_persSetDataNoPRCT = tcase_create("SetDataNoPRCT");
    tcase_add_test(tc_persSetDataNoPRCT, test_SetDataNoPRCT);
    tcase_set_timeout(tc_persSetDataNoPRCT, 3);
 
+   TCase * tc_RctIndex = tcase_create("RctIndex");
+   tcase_add_test(tc_RctIndex, test_RctIndex);
+   tcase_set_timeout(tc_RctIndex, 3);
+
    TCase * tc_persGetDataSize = tcase_create("GetDataSize");
    tcase_add_test(tc_persGetDataSize, test_GetDataSize);
    tcase_set_timeout(tc_persGetDataSize, 3);
 
+   TCase * tc_persWriteDataAsync = tcase_create("WriteDataAsync");
+   tcase_add_test(tc_persWriteDataAsync, test_WriteDataAsync);
+
+   TCase * tc_persKeyIterate = tcase_create("KeyIterate");
+   tcase_add_test(tc_persKeyIterate, test_KeyIterate);
+
+   TCase * tc_persKeyReadRef = tcase_create("KeyReadRef");
+   tcase_add_test(tc_persKeyReadRef, test_KeyReadRef);
+   tcase_set_timeout(tc_persKeyReadRef, 3);
+
+   TCase * tc_persKeyMulti = tcase_create("KeyMulti");
+   tcase_add_test(tc_persKeyMulti, test_KeyMulti);
+
    TCase * tc_persDeleteData = tcase_create("DeleteData");
    tcase_add_test(tc_persDeleteData, test_DeleteData);
    tcase_set_timeout(tc_persDeleteData, 3);
 
+   TCase * tc_persDeleteUser = tcase_create("DeleteUser");
+   tcase_add_test(tc_persDeleteUser, test_DeleteUser);
+   tcase_set_timeout(tc_persDeleteUser, 3);
+
+   TCase * tc_persWriteElision = tcase_create("WriteElision");
+   tcase_add_test(tc_persWriteElision, test_WriteElision);
+   tcase_set_timeout(tc_persWriteElision, 5);
+
    TCase * tc_persGetDataHandle = tcase_create("GetDataHandle");
    tcase_add_test(tc_persGetDataHandle, test_GetDataHandle);
    tcase_set_timeout(tc_persGetDataHandle, 3);
@@ -1848,6 +2804,22 @@ static Suite * persistenceClientLib_suite()
    tcase_add_test(tc_InitDeinit, test_InitDeinit);
    tcase_set_timeout(tc_InitDeinit, 3);
 
+   TCase * tc_InitAsync = tcase_create("InitAsync");
+   tcase_add_test(tc_InitAsync, test_InitAsync);
+   tcase_set_timeout(tc_InitAsync, 10);
+
+   TCase * tc_WarmStart = tcase_create("WarmStart");
+   tcase_add_test(tc_WarmStart, test_WarmStart);
+   tcase_set_timeout(tc_WarmStart, 10);
+
+   TCase * tc_KeyCache = tcase_create("KeyCache");
+   tcase_add_test(tc_KeyCache, test_KeyCache);
+   tcase_set_timeout(tc_KeyCache, 10);
+
+   TCase * tc_KeyCacheReplay = tcase_create("KeyCacheReplay");
+   tcase_add_test(tc_KeyCacheReplay, test_KeyCacheReplay);
+   tcase_set_timeout(tc_KeyCacheReplay, 20);
+
    TCase * tc_NegHandle = tcase_create("NegHandle");
    tcase_add_test(tc_NegHandle, test_NegHandle);
    tcase_set_timeout(tc_NegHandle, 3);
@@ -1860,6 +2832,10 @@ static Suite * persistenceClientLib_suite()
    tcase_add_test(tc_Notifications, test_Notifications);
    tcase_set_timeout(tc_Notifications, 3);
 
+   TCase * tc_NotifySelfWrite = tcase_create("NotifySelfWrite");
+   tcase_add_test(tc_NotifySelfWrite, test_NotifySelfWrite);
+   tcase_set_timeout(tc_NotifySelfWrite, 10);
+
 #if USE_APPCHECK
    TCase * tc_ValidApplication = tcase_create("ValidApplication");
    tcase_add_test(tc_ValidApplication, test_ValidApplication);
@@ -1920,15 +2896,40 @@ static Suite * persistenceClientLib_suite()
    suite_add_tcase(s, tc_persGetDataHandle);
    tcase_add_checked_fixture(tc_persGetDataHandle, data_setup, data_teardown);
 
+   suite_add_tcase(s, tc_persFlushPriority);
+   tcase_add_checked_fixture(tc_persFlushPriority, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_persFlushDeadline);
+
    suite_add_tcase(s, tc_persSetDataNoPRCT);
    tcase_add_checked_fixture(tc_persSetDataNoPRCT, data_setup, data_teardown);
 
+   suite_add_tcase(s, tc_RctIndex);
+
    suite_add_tcase(s, tc_persGetDataSize);
    tcase_add_checked_fixture(tc_persGetDataSize, data_setup, data_teardown);
 
+   suite_add_tcase(s, tc_persWriteDataAsync);
+   tcase_add_checked_fixture(tc_persWriteDataAsync, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_persKeyIterate);
+   tcase_add_checked_fixture(tc_persKeyIterate, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_persKeyReadRef);
+   tcase_add_checked_fixture(tc_persKeyReadRef, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_persKeyMulti);
+   tcase_add_checked_fixture(tc_persKeyMulti, data_setup, data_teardown);
+
    suite_add_tcase(s, tc_persDeleteData);
    tcase_add_checked_fixture(tc_persDeleteData, data_setup, data_teardown);
 
+   suite_add_tcase(s, tc_persDeleteUser);
+   tcase_add_checked_fixture(tc_persDeleteUser, data_setup, data_teardown);
+
+   suite_add_tcase(s, tc_persWriteElision);
+   tcase_add_checked_fixture(tc_persWriteElision, data_setup_write_elision, data_teardown);
+
    suite_add_tcase(s, tc_persDataHandleOpen);
    tcase_add_checked_fixture(tc_persDataHandleOpen, data_setup, data_teardown);
 
@@ -1950,6 +2951,9 @@ static Suite * persistenceClientLib_suite()
    suite_add_tcase(s, tc_Notifications);
    tcase_add_checked_fixture(tc_Notifications, data_setup, data_teardown);
 
+   suite_add_tcase(s, tc_NotifySelfWrite);
+   tcase_add_checked_fixture(tc_NotifySelfWrite, data_setup, data_teardown);
+
    suite_add_tcase(s, tc_Plugin);
    tcase_add_checked_fixture(tc_Plugin, data_setup, data_teardown);
 
@@ -1964,6 +2968,14 @@ static Suite * persistenceClientLib_suite()
 
    suite_add_tcase(s, tc_InitDeinit);
 
+   suite_add_tcase(s, tc_InitAsync);
+
+   suite_add_tcase(s, tc_WarmStart);
+
+   suite_add_tcase(s, tc_KeyCache);
+
+   suite_add_tcase(s, tc_KeyCacheReplay);
+
    suite_add_tcase(s, tc_SharedData);
    tcase_add_checked_fixture(tc_SharedData, data_setup, data_teardown);
 
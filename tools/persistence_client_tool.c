@@ -143,6 +143,44 @@ int deletekey(char * resource_id, unsigned int user, unsigned int seat, unsigned
 
 
 
+void printPluginStats(void)
+{
+   static const char* opName[PCL_PLUGIN_OP_LAST] = { "init", "deinit", "get", "set", "getsize", "delete" };
+   pclPluginStats_s stats;
+   int plugin = 0, rval = 0;
+
+   printf("- %s -\n\n", __FUNCTION__);
+
+   while((rval = pclGetPluginStats(plugin, &stats)) >= 0)
+   {
+      if(rval == 1)
+      {
+         int op = 0, i = 0;
+
+         printf("   Plugin %d: %s\n", plugin, stats.name);
+         for(op = 0; op < PCL_PLUGIN_OP_LAST; op++)
+         {
+            if(stats.op[op].calls > 0)
+            {
+               printf("      %-8s calls: %u errors: %u avg: %llu us max: %u us\n", opName[op],
+                      stats.op[op].calls, stats.op[op].errors,
+                      stats.op[op].total_us / stats.op[op].calls, stats.op[op].max_us);
+               printf("               histogram [< 2^i us]:");
+               for(i = 0; i < PCL_PLUGIN_LATENCY_BUCKETS; i++)
+               {
+                  if(stats.op[op].histogram[i] > 0)
+                     printf(" %d:%u", i, stats.op[op].histogram[i]);
+               }
+               printf("\n");
+            }
+         }
+      }
+      plugin++;
+   }
+}
+
+
+
 int getkeysize(char * resource_id, unsigned int user, unsigned int seat, unsigned int ldbid)
 {
    int rval = 0;
@@ -254,13 +292,14 @@ int main(int argc, char *argv[])
 	unsigned int user_no = 0, seat_no = 0;
 	unsigned int ldbid = 0xFF;    // default value
 	unsigned int doHexdump = 0;
+	unsigned int doPluginStats = 0;
 
 	printf("\n");
    /// debug log and trace (DLT) setup
    DLT_REGISTER_APP("Ptool","persistence client library tools");
 
 
-	while ((opt = getopt(argc, argv, "hVo:a:u:s:r:-l:p:f:H")) != -1)
+	while ((opt = getopt(argc, argv, "hVo:a:u:s:r:-l:p:f:HS")) != -1)
 	{
 		switch (opt)
 		{
@@ -344,6 +383,9 @@ int main(int argc, char *argv[])
 		   case 'H':   // hexdump of data
 		      doHexdump = 1;
 		      break;
+		   case 'S':   // statistics of the custom plugins
+		      doPluginStats = 1;
+		      break;
 	   	case 'h':   // help
 	   	   printSynopsis();
 	         break;
@@ -422,6 +464,9 @@ int main(int argc, char *argv[])
             break;
       }
 
+      if(doPluginStats == 1)
+         printPluginStats();
+
       if(appName != NULL)
          free(appName);
 
@@ -459,7 +504,7 @@ int main(int argc, char *argv[])
 void printSynopsis()
 {
 	printf("Usage: persistence_client_tool [-o <action to do>] [-a <application name>] [-r <resource id>] [-l <logical db id>]\n");
-	printf("                       [-u <user no>] [-s <seat no>] [-f <file>] [-p <payload>] [-H] [-h] [-v]\n");
+	printf("                       [-u <user no>] [-s <seat no>] [-f <file>] [-p <payload>] [-H] [-S] [-h] [-v]\n");
 
 	printf("\n");
 	printf("-o, --option=<action to do>   The possible actions are:\n");
@@ -475,6 +520,7 @@ void printSynopsis()
 	printf("-u, --user_no=<user no>            The user number. If not specified the default value '0' is used\n");
 	printf("-s, --seat_no=<seat no>            The seat number. If not specified the default value '0' is used\n");
 	printf("-H, --forcehexdump                 Force print out a HexDump of the written/read data\n");
+	printf("-S, --pluginstats                  Print the latency and error statistics of the custom plugins\n");
 	printf("-h, --help                         Print help message\n");
 	printf("-V, --version                      Print program version\n");
 
@@ -492,5 +538,7 @@ void printSynopsis()
 	printf("    persistence_client_tool -o getkeysize -a MyApplication -r MyKey                optional parameters: [-l 0xFF -u 0 -s 0]\n");
 	printf("6.) Delete a key:\n");
 	printf("    persistence_client_tool -o deletekey -a MyApplication -r MyKey                 optional parameters: [-l 0xFF -u 0 -s 0]\n");
+	printf("7.) Read a Key and print the statistics of the custom plugins (e.g. the init time):\n");
+	printf("    persistence_client_tool -o readkey -a MyApplication -r MyKey -S                optional parameters: [-l 0xFF -u 0 -s 0]\n");
 }
 
@@ -0,0 +1,310 @@
+/******************************************************************************
+ * Project         Persistency
+ * (c) copyright   2016
+ * Company         Mentor Graphics
+ *****************************************************************************/
+/******************************************************************************
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0. If a  copy of the MPL was not distributed
+ * with this file, You can obtain one at http://mozilla.org/MPL/2.0/.
+******************************************************************************/
+ /**
+ * @file           persistence_rct_compiler.c
+ * @ingroup        Persistence client library tools
+ * @author         Ingo Huerner
+ * @brief          Compile a resource configuration table into a read only
+ *                 index image. The persistence client library maps the image
+ *                 in pclInitLibrary instead of reading the resource configuration table.
+ * @see
+ */
+
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <persComRct.h>
+
+#include "persistence_client_library_rct_index.h"
+
+
+#define STRING_SIZE    512
+#define APPNAME_SIZE    64
+
+
+static const char* gRctNameTemplate = "%s%s/resource-table-cfg.itz";
+
+
+
+/* read all resources of the resource configuration table and create the index image */
+static PersRctIndex_s* compileRCT(const char* rctFilename)
+{
+   int handle = -1, listSize = 0;
+   PersRctIndex_s* index = NULL;
+
+   handle = persComRctOpen(rctFilename, 0x0);   // don't create rct if not present
+   if(handle >= 0)
+   {
+      listSize = persComRctGetSizeResourcesList(handle);
+      if(listSize >= 0)
+      {
+         char* resourceList = (char*)calloc((size_t)listSize + 1, 1);
+         const char** names = (const char**)calloc((size_t)listSize/2 + 1, sizeof(char*));
+         PersistenceConfigurationKey_s* configs = (PersistenceConfigurationKey_s*)calloc((size_t)listSize/2 + 1, sizeof(PersistenceConfigurationKey_s));
+
+         if(resourceList != NULL && names != NULL && configs != NULL)
+         {
+            uint32_t numResources = 0;
+            int i = 0, ret = 0;
+
+            if(listSize > 0)
+            {
+               ret = persComRctGetResourcesList(handle, resourceList, listSize);
+            }
+
+            // the list is a sequence of '\0' terminated resource IDs
+            for(i = 0; i < listSize && ret >= 0; i += (int)strlen(&resourceList[i]) + 1)
+            {
+               if(resourceList[i] != '\0')
+               {
+                  if(persComRctRead(handle, &resourceList[i], &configs[numResources]) != (int)sizeof(PersistenceConfigurationKey_s))
+                  {
+                     printf("Failed to read resource: \"%s\"\n", &resourceList[i]);
+                     ret = -1;
+                  }
+                  names[numResources++] = &resourceList[i];
+               }
+            }
+
+            if(ret >= 0)
+            {
+               index = rct_index_create(numResources, names, configs);
+               if(index == NULL)
+               {
+                  printf("Failed to create index - duplicate resource IDs?\n");
+               }
+            }
+            else
+            {
+               printf("Failed to read the resource list: %d\n", ret);
+            }
+         }
+
+         free(configs);
+         free(names);
+         free(resourceList);
+      }
+      else
+      {
+         printf("Failed to get the resource list size: %d\n", listSize);
+      }
+
+      persComRctClose(handle);
+   }
+   else
+   {
+      printf("Failed to open: \"%s\"\n", rctFilename);
+   }
+
+   return index;
+}
+
+
+
+/* write the image to a temporary file and rename it, so a running application never maps a partial image */
+static int writeImage(const PersRctIndex_s* index, const char* imageFilename)
+{
+   int rval = -1, fd = -1;
+   char tmpFilename[STRING_SIZE] = {0};
+
+   snprintf(tmpFilename, STRING_SIZE, "%s.tmp", imageFilename);
+
+   fd = open(tmpFilename, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+   if(fd != -1)
+   {
+      ssize_t written = write(fd, index, index->imageSize);
+
+      if(written == (ssize_t)index->imageSize && fsync(fd) == 0)
+      {
+         rval = 0;
+      }
+      else
+      {
+         printf("Failed to write: \"%s\" - %s\n", tmpFilename, strerror(errno));
+      }
+      close(fd);
+
+      if(rval == 0 && rename(tmpFilename, imageFilename) != 0)
+      {
+         printf("Failed to rename: \"%s\" - %s\n", tmpFilename, strerror(errno));
+         rval = -1;
+      }
+
+      if(rval != 0)
+      {
+         unlink(tmpFilename);
+      }
+   }
+   else
+   {
+      printf("Failed to open: \"%s\" - %s\n", tmpFilename, strerror(errno));
+   }
+
+   return rval;
+}
+
+
+
+/* check an existing image against the resource configuration table */
+static int verifyImage(const char* rctFilename, const char* imageFilename)
+{
+   int rval = -1, fd = -1;
+   struct stat imageStat;
+
+   fd = open(imageFilename, O_RDONLY);
+   if(fd != -1 && fstat(fd, &imageStat) == 0 && imageStat.st_size > 0)
+   {
+      PersRctIndex_s* image = (PersRctIndex_s*)malloc((size_t)imageStat.st_size);
+      PersRctIndex_s* index = compileRCT(rctFilename);
+
+      if(image != NULL && index != NULL
+         && read(fd, image, (size_t)imageStat.st_size) == (ssize_t)imageStat.st_size)
+      {
+         if(rct_index_verify(image, (size_t)imageStat.st_size) == 0)
+         {
+            printf("Invalid image: \"%s\"\n", imageFilename);
+         }
+         else if(image->imageSize != index->imageSize || memcmp(image, index, index->imageSize) != 0)
+         {
+            printf("Image outdated: \"%s\"\n", imageFilename);
+         }
+         else
+         {
+            printf("Image valid: \"%s\" - %u resources\n", imageFilename, image->count);
+            rval = 0;
+         }
+      }
+
+      free(index);
+      free(image);
+   }
+   else
+   {
+      printf("Failed to open: \"%s\"\n", imageFilename);
+   }
+
+   if(fd != -1)
+      close(fd);
+
+   return rval;
+}
+
+
+
+void printAppManual()
+{
+   printf("\nNAME\n");
+   printf("   ./persistence_rct_compiler - compile a resource configuration table into an index image\n");
+
+   printf("\nSYNOPSIS\n");
+   printf("   persistence_rct_compiler [-p path] [-v] -n appname | -i rctfile [-o imagefile]\n");
+
+   printf("\nDESCRIPTION\n");
+   printf("   Create a read only index image of the resource configuration table of an application.\n");
+   printf("   The image is stored next to the resource configuration table (suffix \"%s\") and mapped by\n", PERS_RCT_INDEX_SUFFIX);
+   printf("   the persistence client library, so resources are resolved without reading the table.\n");
+   printf("   The image must be created again whenever the resource configuration table changes.\n");
+
+   printf("\nOPTIONS\n");
+   printf("   -p   Path to the persistence storage location [default location is \"/Data/mnt-wt/\"]\n");
+   printf("   -n   Name of the application\n");
+   printf("   -i   Resource configuration table file [instead of -n]\n");
+   printf("   -o   Image file [default is the resource configuration table file name + \"%s\"]\n", PERS_RCT_INDEX_SUFFIX);
+   printf("   -v   Verify an existing image instead of creating it\n");
+
+   printf("\n");
+}
+
+
+
+int main(int argc, char *argv[])
+{
+   int ret = 0, opt = 0, verify = 0;
+   static const char* defaultPersPath = "/Data/mnt-wt/";
+
+   char persPath[128] = {0};
+   char appName[APPNAME_SIZE] = {0};
+   char rctFilename[STRING_SIZE] = {0};
+   char imageFilename[STRING_SIZE] = {0};
+
+   strncpy(persPath, defaultPersPath, 128-1);
+
+   while ((opt = getopt(argc, argv, "p:n:i:o:v")) != -1)
+   {
+      switch (opt)
+      {
+         case 'p':
+            memset(persPath, 0, 128);
+            strncpy(persPath, optarg, 128-1);
+            break;
+         case 'n':
+            strncpy(appName, optarg, APPNAME_SIZE-1);
+            break;
+         case 'i':
+            strncpy(rctFilename, optarg, STRING_SIZE-1);
+            break;
+         case 'o':
+            strncpy(imageFilename, optarg, STRING_SIZE-1);
+            break;
+         case 'v':
+            verify = 1;
+            break;
+         default: /* '?' */
+            ret = -1;
+      }
+   }
+
+   if(rctFilename[0] == '\0' && appName[0] != '\0')
+   {
+      snprintf(rctFilename, STRING_SIZE, gRctNameTemplate, persPath, appName);
+   }
+
+   if(ret == -1 || rctFilename[0] == '\0')
+   {
+      printAppManual();
+      return -1;
+   }
+
+   if(imageFilename[0] == '\0')
+   {
+      snprintf(imageFilename, STRING_SIZE, "%s%s", rctFilename, PERS_RCT_INDEX_SUFFIX);
+   }
+
+   if(verify == 1)
+   {
+      ret = verifyImage(rctFilename, imageFilename);
+   }
+   else
+   {
+      PersRctIndex_s* index = compileRCT(rctFilename);
+
+      if(index != NULL)
+      {
+         ret = writeImage(index, imageFilename);
+         if(ret == 0)
+         {
+            printf("Created image: \"%s\" - %u resources, %u bytes\n", imageFilename, index->count, index->imageSize);
+         }
+         free(index);
+      }
+      else
+      {
+         ret = -1;
+      }
+   }
+
+   return ret;
+}